@@ -45,6 +45,11 @@ class stop_token {
 // https://en.cppreference.com/w/cpp/thread/stop_source
 class stop_source {
  public:
+  // Creates a stop_source with a new stop-state, owned by this object and its
+  // copies.  Unlike in the standard, the stop_tokens obtained from this object
+  // do not share ownership of the stop-state and must not outlive it.
+  stop_source();
+
   bool request_stop();
 
   bool stop_requested() const;
@@ -54,7 +59,9 @@ class stop_source {
  private:
   explicit stop_source(not_null<StopState*> stop_state);
 
-  not_null<StopState*> const stop_state_;
+  // Null if the stop-state is owned by a jthread.
+  std::shared_ptr<StopState> owned_stop_state_;
+  not_null<StopState*> stop_state_;
 
   friend class jthread;
 };
@@ -113,6 +120,12 @@ class jthread {
 template<typename Function, typename... Args>
 static jthread MakeStoppableThread(Function&& f, Args&&... args);
 
+// Calls |f| on the current thread, with |this_stoppable_thread| returning |st|
+// for the duration of the call.  This makes it possible to use
+// |RETURN_IF_STOPPED| in functions executed by a pool of threads.
+template<typename Function>
+void CallWithStopToken(stop_token const& st, Function&& f);
+
 class this_stoppable_thread {
  public:
   static stop_token get_stop_token();
@@ -122,6 +135,8 @@ class this_stoppable_thread {
 
   template<typename Function, typename... Args>
   friend jthread MakeStoppableThread(Function&& f, Args&&... args);
+  template<typename Function>
+  friend void CallWithStopToken(stop_token const& st, Function&& f);
 };
 
 #define RETURN_IF_STOPPED                                                   \
@@ -135,6 +150,7 @@ class this_stoppable_thread {
 
 }  // namespace internal_jthread
 
+using internal_jthread::CallWithStopToken;
 using internal_jthread::MakeStoppableThread;
 using internal_jthread::jthread;
 using internal_jthread::stop_callback;
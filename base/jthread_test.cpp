@@ -140,6 +140,23 @@ TEST(JThreadTest, ThisJThread) {
   EXPECT_TRUE(observed_stop);
 }
 
+TEST(JThreadTest, CallWithStopToken) {
+  stop_source source;
+  bool observed_stop = false;
+  auto const check_stop = [&observed_stop]() {
+    observed_stop = this_stoppable_thread::get_stop_token().stop_requested();
+  };
+
+  CallWithStopToken(source.get_token(), check_stop);
+  EXPECT_FALSE(observed_stop);
+  EXPECT_TRUE(source.request_stop());
+  CallWithStopToken(source.get_token(), check_stop);
+  EXPECT_TRUE(observed_stop);
+
+  // The token is only installed for the duration of the call.
+  EXPECT_FALSE(this_stoppable_thread::get_stop_token().stop_requested());
+}
+
 
 
 }  // namespace base
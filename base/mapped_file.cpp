@@ -0,0 +1,104 @@
+#include "base/mapped_file.hpp"
+
+#include "base/macros.hpp"
+#include "glog/logging.h"
+
+#if OS_WIN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace principia {
+namespace base {
+namespace internal_mapped_file {
+
+std::unique_ptr<MappedFile> MappedFile::Open(
+    std::filesystem::path const& path) {
+#if OS_WIN
+  // The file may be deleted while it is mapped, to make it possible to replace
+  // a stale file.
+  HANDLE const file = CreateFileW(path.c_str(),
+                                  GENERIC_READ,
+                                  FILE_SHARE_READ | FILE_SHARE_DELETE,
+                                  /*lpSecurityAttributes=*/nullptr,
+                                  OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL,
+                                  /*hTemplateFile=*/nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return nullptr;
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+    CloseHandle(file);
+    return nullptr;
+  }
+  HANDLE const mapping = CreateFileMappingW(file,
+                                            /*lpFileMappingAttributes=*/nullptr,
+                                            PAGE_READONLY,
+                                            /*dwMaximumSizeHigh=*/0,
+                                            /*dwMaximumSizeLow=*/0,
+                                            /*lpName=*/nullptr);
+  CloseHandle(file);
+  if (mapping == nullptr) {
+    return nullptr;
+  }
+  // The view keeps the mapping alive.
+  void const* const data = MapViewOfFile(mapping,
+                                         FILE_MAP_READ,
+                                         /*dwFileOffsetHigh=*/0,
+                                         /*dwFileOffsetLow=*/0,
+                                         /*dwNumberOfBytesToMap=*/0);
+  CloseHandle(mapping);
+  if (data == nullptr) {
+    return nullptr;
+  }
+  return std::unique_ptr<MappedFile>(new MappedFile(data, size.QuadPart));
+#else
+  int const file = open(path.c_str(), O_RDONLY);
+  if (file < 0) {
+    return nullptr;
+  }
+  struct stat status;
+  if (fstat(file, &status) != 0 || status.st_size == 0) {
+    close(file);
+    return nullptr;
+  }
+  // The mapping remains valid after the file is closed.
+  void* const data = mmap(/*addr=*/nullptr,
+                          status.st_size,
+                          PROT_READ,
+                          MAP_SHARED,
+                          file,
+                          /*offset=*/0);
+  close(file);
+  if (data == MAP_FAILED) {
+    return nullptr;
+  }
+  return std::unique_ptr<MappedFile>(new MappedFile(data, status.st_size));
+#endif
+}
+
+MappedFile::~MappedFile() {
+#if OS_WIN
+  CHECK(UnmapViewOfFile(data_));
+#else
+  CHECK_EQ(0, munmap(const_cast<void*>(data_), size_));
+#endif
+}
+
+Array<std::uint8_t const> MappedFile::bytes() const {
+  return Array<std::uint8_t const>(static_cast<std::uint8_t const*>(data_),
+                                   size_);
+}
+
+MappedFile::MappedFile(void const* const data, std::int64_t const size)
+    : data_(data),
+      size_(size) {}
+
+}  // namespace internal_mapped_file
+}  // namespace base
+}  // namespace principia
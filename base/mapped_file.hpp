@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+
+#include "base/array.hpp"
+
+namespace principia {
+namespace base {
+namespace internal_mapped_file {
+
+// A read-only mapping of the contents of a file in memory.  The pages are
+// loaded lazily by the operating system, and they are shared between the
+// processes that map the same file.  The file must not be modified while it is
+// mapped.
+class MappedFile final {
+ public:
+  // Returns null if the file at |path| cannot be opened or mapped, e.g.,
+  // because it doesn't exist or is empty.
+  static std::unique_ptr<MappedFile> Open(std::filesystem::path const& path);
+
+  ~MappedFile();
+
+  MappedFile(MappedFile const&) = delete;
+  MappedFile(MappedFile&&) = delete;
+  MappedFile& operator=(MappedFile const&) = delete;
+  MappedFile& operator=(MappedFile&&) = delete;
+
+  // The contents of the file.  The data are aligned on a page boundary.
+  Array<std::uint8_t const> bytes() const;
+
+ private:
+  MappedFile(void const* data, std::int64_t size);
+
+  void const* const data_;
+  std::int64_t const size_;
+};
+
+}  // namespace internal_mapped_file
+
+using internal_mapped_file::MappedFile;
+
+}  // namespace base
+}  // namespace principia
@@ -0,0 +1,54 @@
+#include "base/mapped_file.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace principia {
+namespace base {
+
+class MappedFileTest : public ::testing::Test {
+ protected:
+  MappedFileTest() : path_(TEMP_DIR / "mapped_file_test.generated.bin") {}
+
+  ~MappedFileTest() override {
+    std::filesystem::remove(path_);
+  }
+
+  void Write(std::string const& contents) {
+    std::ofstream file(path_, std::ios::binary);
+    CHECK(file.good()) << path_;
+    file.write(contents.data(), contents.size());
+  }
+
+  std::filesystem::path const path_;
+};
+
+TEST_F(MappedFileTest, Contents) {
+  std::string contents(10'000, '\0');
+  for (int i = 0; i < contents.size(); ++i) {
+    contents[i] = static_cast<char>(i * 7);
+  }
+  Write(contents);
+
+  auto const mapped_file = MappedFile::Open(path_);
+  ASSERT_NE(nullptr, mapped_file);
+  auto const bytes = mapped_file->bytes();
+  ASSERT_EQ(contents.size(), bytes.size);
+  EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(bytes.data) % 8);
+  EXPECT_EQ(contents,
+            std::string(reinterpret_cast<char const*>(bytes.data),
+                        bytes.size));
+}
+
+TEST_F(MappedFileTest, Errors) {
+  EXPECT_EQ(nullptr, MappedFile::Open(path_));
+  Write("");
+  EXPECT_EQ(nullptr, MappedFile::Open(path_));
+}
+
+}  // namespace base
+}  // namespace principia
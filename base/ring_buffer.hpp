@@ -0,0 +1,56 @@
+﻿
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "base/array.hpp"
+
+namespace principia {
+namespace base {
+namespace internal_ring_buffer {
+
+// A circular buffer of bytes through which a single thread, the producer,
+// passes data to a single other thread, the consumer.  None of the operations
+// take a lock.  The data is copied in and out of the buffer, so the producer
+// never waits for the consumer, unless the buffer is full.
+class RingBuffer final {
+ public:
+  // |capacity| must be a power of 2.
+  explicit RingBuffer(std::int64_t capacity);
+
+  RingBuffer(RingBuffer const&) = delete;
+  RingBuffer& operator=(RingBuffer const&) = delete;
+
+  std::int64_t capacity() const;
+
+  // Only called by the producer.  Copies as many of the |bytes| as fit in the
+  // buffer and returns their number, which may be less than |bytes.size|, and
+  // is 0 if the buffer is full.
+  std::int64_t Write(Array<std::uint8_t const> bytes);
+
+  // Only called by the consumer.  Copies at most |bytes.size| bytes out of the
+  // buffer, and returns their number, which is 0 if the buffer is empty.
+  std::int64_t Read(Array<std::uint8_t> bytes);
+
+  // May be called by either thread.  The result is only a snapshot.
+  bool empty() const;
+
+ private:
+  std::int64_t const mask_;
+  UniqueArray<std::uint8_t> const buffer_;
+  // The positions are monotonically increasing; they are reduced modulo the
+  // capacity when accessing |buffer_|.  They are written by different threads,
+  // so they live on different cache lines.
+  alignas(64) std::atomic<std::int64_t> read_position_ = 0;
+  alignas(64) std::atomic<std::int64_t> write_position_ = 0;
+};
+
+}  // namespace internal_ring_buffer
+
+using internal_ring_buffer::RingBuffer;
+
+}  // namespace base
+}  // namespace principia
+
+#include "base/ring_buffer_body.hpp"
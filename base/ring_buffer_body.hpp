@@ -0,0 +1,72 @@
+﻿
+#pragma once
+
+#include "base/ring_buffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "glog/logging.h"
+
+namespace principia {
+namespace base {
+namespace internal_ring_buffer {
+
+inline RingBuffer::RingBuffer(std::int64_t const capacity)
+    : mask_(capacity - 1),
+      buffer_(capacity) {
+  CHECK_LT(0, capacity);
+  CHECK_EQ(0, capacity & mask_) << capacity << " is not a power of 2";
+}
+
+inline std::int64_t RingBuffer::capacity() const {
+  return mask_ + 1;
+}
+
+inline std::int64_t RingBuffer::Write(Array<std::uint8_t const> const bytes) {
+  std::int64_t const write_position =
+      write_position_.load(std::memory_order_relaxed);
+  // Synchronizes with the release in |Read| so that we don't overwrite bytes
+  // that the consumer is still copying.
+  std::int64_t const read_position =
+      read_position_.load(std::memory_order_acquire);
+  std::int64_t const free = capacity() - (write_position - read_position);
+  std::int64_t const size = std::min(free, bytes.size);
+
+  // Copy in at most two pieces, depending on whether we wrap around.
+  std::int64_t const offset = write_position & mask_;
+  std::int64_t const first_size = std::min(size, capacity() - offset);
+  std::memcpy(&buffer_.data[offset], bytes.data, first_size);
+  std::memcpy(&buffer_.data[0], bytes.data + first_size, size - first_size);
+
+  write_position_.store(write_position + size, std::memory_order_release);
+  return size;
+}
+
+inline std::int64_t RingBuffer::Read(Array<std::uint8_t> const bytes) {
+  std::int64_t const read_position =
+      read_position_.load(std::memory_order_relaxed);
+  // Synchronizes with the release in |Write| so that we see the bytes that the
+  // producer has copied.
+  std::int64_t const write_position =
+      write_position_.load(std::memory_order_acquire);
+  std::int64_t const size =
+      std::min(write_position - read_position, bytes.size);
+
+  std::int64_t const offset = read_position & mask_;
+  std::int64_t const first_size = std::min(size, capacity() - offset);
+  std::memcpy(bytes.data, &buffer_.data[offset], first_size);
+  std::memcpy(bytes.data + first_size, &buffer_.data[0], size - first_size);
+
+  read_position_.store(read_position + size, std::memory_order_release);
+  return size;
+}
+
+inline bool RingBuffer::empty() const {
+  return read_position_.load(std::memory_order_acquire) ==
+         write_position_.load(std::memory_order_acquire);
+}
+
+}  // namespace internal_ring_buffer
+}  // namespace base
+}  // namespace principia
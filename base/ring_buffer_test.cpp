@@ -0,0 +1,70 @@
+﻿
+#include "base/ring_buffer.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "base/array.hpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace principia {
+namespace base {
+
+using ::testing::ElementsAre;
+
+class RingBufferTest : public ::testing::Test {};
+
+TEST_F(RingBufferTest, WrapAround) {
+  RingBuffer buffer(8);
+  EXPECT_TRUE(buffer.empty());
+
+  std::vector<std::uint8_t> const in = {1, 2, 3, 4, 5, 6};
+  std::vector<std::uint8_t> out(6);
+  EXPECT_EQ(6, buffer.Write(Array<std::uint8_t const>(in)));
+  EXPECT_EQ(4, buffer.Read(Array<std::uint8_t>(out.data(), 4)));
+  EXPECT_THAT(out, ElementsAre(1, 2, 3, 4, 0, 0));
+
+  // This write wraps around, and only 6 bytes fit.
+  std::vector<std::uint8_t> const more = {7, 8, 9, 10, 11, 12, 13};
+  EXPECT_EQ(6, buffer.Write(Array<std::uint8_t const>(more)));
+  EXPECT_EQ(0, buffer.Write(Array<std::uint8_t const>(more)));
+  std::vector<std::uint8_t> all(10);
+  EXPECT_EQ(8, buffer.Read(Array<std::uint8_t>(all)));
+  EXPECT_THAT(all, ElementsAre(5, 6, 7, 8, 9, 10, 11, 12, 0, 0));
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ(0, buffer.Read(Array<std::uint8_t>(all)));
+}
+
+// Checks that the bytes are transmitted in order when the threads race.
+TEST_F(RingBufferTest, ProducerConsumer) {
+  constexpr std::int64_t size = 1'000'000;
+  RingBuffer buffer(1 << 10);
+  std::vector<std::uint8_t> in(size);
+  for (std::int64_t i = 0; i < size; ++i) {
+    in[i] = static_cast<std::uint8_t>(i * 7);
+  }
+  std::vector<std::uint8_t> out(size);
+
+  std::thread consumer([&buffer, &out]() {
+    std::int64_t read = 0;
+    while (read < size) {
+      // Read in odd-sized chunks to exercise the wrap-around.
+      read += buffer.Read(
+          Array<std::uint8_t>(&out[read], std::min<std::int64_t>(size - read,
+                                                                 37)));
+    }
+  });
+  std::int64_t written = 0;
+  while (written < size) {
+    written += buffer.Write(Array<std::uint8_t const>(
+        &in[written], std::min<std::int64_t>(size - written, 100)));
+  }
+  consumer.join();
+  EXPECT_EQ(in, out);
+}
+
+}  // namespace base
+}  // namespace principia
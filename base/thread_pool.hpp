@@ -1,19 +1,16 @@
 #pragma once
 
-#include <deque>
 #include <functional>
 #include <future>
-#include <list>
-#include <thread>
 
-#include "absl/base/thread_annotations.h"
-#include "absl/synchronization/mutex.h"
+#include "base/work_stealing_executor.hpp"
 
 namespace principia {
 namespace base {
 
 // A pool of threads that are created at construction and to which functions can
-// be added for asynchronous execution.  This class is thread-safe.
+// be added for asynchronous execution.  The threads are those of a
+// |WorkStealingExecutor|.  This class is thread-safe.
 template<typename T>
 class ThreadPool final {
  public:
@@ -27,23 +24,13 @@ class ThreadPool final {
   // the result.
   std::future<T> Add(std::function<T()> function);
 
+  // Returns a batch executed by the threads of this pool.  Batches are much
+  // cheaper than futures when many small tasks must be executed and awaited.
+  // The batch must be joined before the pool is destroyed.
+  WorkStealingExecutor::Batch NewBatch();
+
  private:
-  // The queue element contains a |function| to execute and a |promise| used to
-  // communicate the result to the caller.
-  struct Call {
-    std::function<T()> function;
-    std::promise<T> promise;
-  };
-
-  // The loop executed on each thread to extract an element from the queue,
-  // execute it, and set its result in the promise.
-  void DequeueCallAndExecute();
-
-  absl::Mutex lock_;
-  bool shutdown_ GUARDED_BY(lock_) = false;
-  std::deque<Call> calls_ GUARDED_BY(lock_);
-
-  std::list<std::thread> threads_;
+  WorkStealingExecutor executor_;
 };
 
 }  // namespace base
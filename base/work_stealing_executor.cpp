@@ -0,0 +1,265 @@
+
+#include "base/work_stealing_executor.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include "glog/logging.h"
+
+namespace principia {
+namespace base {
+namespace internal_work_stealing_executor {
+
+thread_local WorkStealingExecutor const*
+    WorkStealingExecutor::current_executor_ = nullptr;
+thread_local std::int64_t WorkStealingExecutor::current_worker_ = -1;
+
+WorkStealingExecutor::WorkStealingExecutor(
+    std::int64_t const number_of_workers) {
+  CHECK_LT(0, number_of_workers);
+  // All the deques must exist before any worker starts stealing.
+  for (std::int64_t i = 0; i < number_of_workers; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  for (std::int64_t i = 0; i < number_of_workers; ++i) {
+    workers_[i]->thread = std::thread(&WorkStealingExecutor::Toil, this, i);
+  }
+}
+
+WorkStealingExecutor::~WorkStealingExecutor() {
+  {
+    absl::MutexLock l(&lock_);
+    shutdown_ = true;
+  }
+  for (auto const& worker : workers_) {
+    worker->thread.join();
+  }
+
+  // The workers are gone, so we may pop from their deques.
+  auto const discard = [](Job* const job) {
+    CHECK(job->batch == nullptr) << "Destroying an executor with pending "
+                                 << "batches";
+    delete job;
+  };
+  for (Job* const job : injected_jobs_) {
+    discard(job);
+  }
+  for (auto const& worker : workers_) {
+    while (Job* const job = worker->deque.Pop()) {
+      discard(job);
+    }
+  }
+}
+
+std::int64_t WorkStealingExecutor::number_of_workers() const {
+  return workers_.size();
+}
+
+void WorkStealingExecutor::Execute(Task task) {
+  Submit(new Job{std::move(task), /*batch=*/nullptr}, /*count=*/1);
+}
+
+void WorkStealingExecutor::Submit(Job* const first, std::int64_t const count) {
+  if (count == 0) {
+    return;
+  }
+  std::int64_t const worker = CurrentWorker();
+  if (worker >= 0) {
+    // A worker submitting jobs pushes them on its own deque, without locking.
+    auto& deque = workers_[worker]->deque;
+    for (std::int64_t i = 0; i < count; ++i) {
+      deque.Push(first + i);
+    }
+    number_of_queued_jobs_.fetch_add(count);
+    // Sleeping workers reevaluate their condition when the lock is released.
+    if (number_of_sleeping_workers_.load() > 0) {
+      absl::MutexLock l(&lock_);
+    }
+  } else {
+    absl::MutexLock l(&lock_);
+    for (std::int64_t i = 0; i < count; ++i) {
+      injected_jobs_.push_back(first + i);
+    }
+    number_of_injected_jobs_.store(injected_jobs_.size(),
+                                   std::memory_order_relaxed);
+    number_of_queued_jobs_.fetch_add(count);
+  }
+}
+
+WorkStealingExecutor::Job* WorkStealingExecutor::TryTakeJob(
+    std::int64_t const worker) {
+  Job* job = nullptr;
+  if (worker >= 0) {
+    job = workers_[worker]->deque.Pop();
+  }
+
+  if (job == nullptr &&
+      number_of_injected_jobs_.load(std::memory_order_relaxed) > 0) {
+    absl::MutexLock l(&lock_);
+    if (!injected_jobs_.empty()) {
+      job = injected_jobs_.front();
+      injected_jobs_.pop_front();
+      if (worker >= 0) {
+        // Move a share of the remaining jobs to our deque, where the other
+        // workers may steal them without locking.
+        std::int64_t const share = injected_jobs_.size() / workers_.size();
+        auto& deque = workers_[worker]->deque;
+        for (std::int64_t i = 0; i < share; ++i) {
+          deque.Push(injected_jobs_.front());
+          injected_jobs_.pop_front();
+        }
+      }
+      number_of_injected_jobs_.store(injected_jobs_.size(),
+                                     std::memory_order_relaxed);
+    }
+  }
+
+  if (job == nullptr) {
+    std::int64_t const number_of_workers = workers_.size();
+    for (std::int64_t i = 1; i <= number_of_workers && job == nullptr; ++i) {
+      std::int64_t const victim = (worker + i) % number_of_workers;
+      if (victim != worker) {
+        job = workers_[victim]->deque.Steal();
+      }
+    }
+  }
+
+  if (job != nullptr) {
+    number_of_queued_jobs_.fetch_sub(1);
+  }
+  return job;
+}
+
+WorkStealingExecutor::Job* WorkStealingExecutor::TryTakeJobOf(
+    Batch const& batch,
+    std::int64_t const worker) {
+  Job* job = nullptr;
+  if (worker >= 0) {
+    // The jobs of |batch| were pushed last on our deque, so they are at its
+    // bottom unless they have been popped or stolen.
+    auto& deque = workers_[worker]->deque;
+    job = deque.Pop();
+    if (job != nullptr && job->batch != &batch) {
+      deque.Push(job);
+      job = nullptr;
+    }
+  } else if (number_of_injected_jobs_.load(std::memory_order_relaxed) > 0) {
+    absl::MutexLock l(&lock_);
+    auto const it = std::find_if(
+        injected_jobs_.begin(),
+        injected_jobs_.end(),
+        [&batch](Job const* const job) { return job->batch == &batch; });
+    if (it != injected_jobs_.end()) {
+      job = *it;
+      injected_jobs_.erase(it);
+      number_of_injected_jobs_.store(injected_jobs_.size(),
+                                     std::memory_order_relaxed);
+    }
+  }
+
+  if (job != nullptr) {
+    number_of_queued_jobs_.fetch_sub(1);
+  }
+  return job;
+}
+
+void WorkStealingExecutor::Run(Job* const job) {
+  // Read the batch before running the task: once the batch has been notified,
+  // the job may be destroyed.
+  Batch* const batch = job->batch;
+  job->task();
+  if (batch == nullptr) {
+    delete job;
+  } else {
+    batch->Complete();
+  }
+}
+
+void WorkStealingExecutor::Toil(std::int64_t const worker) {
+  current_executor_ = this;
+  current_worker_ = worker;
+  for (;;) {
+    if (Job* const job = TryTakeJob(worker)) {
+      Run(job);
+      continue;
+    }
+
+    // Wait until either a job is submitted or this executor is shutting down.
+    absl::MutexLock l(&lock_);
+    number_of_sleeping_workers_.fetch_add(1);
+    auto const has_jobs_or_shutdown = [this] {
+      return shutdown_ || number_of_queued_jobs_.load() > 0;
+    };
+    lock_.Await(absl::Condition(&has_jobs_or_shutdown));
+    number_of_sleeping_workers_.fetch_sub(1);
+    if (shutdown_) {
+      break;
+    }
+  }
+}
+
+std::int64_t WorkStealingExecutor::CurrentWorker() const {
+  return current_executor_ == this ? current_worker_ : -1;
+}
+
+WorkStealingExecutor::Batch::Batch(WorkStealingExecutor& executor)
+    : executor_(executor) {}
+
+WorkStealingExecutor::Batch::~Batch() {
+  if (submitted_) {
+    Join();
+  }
+}
+
+void WorkStealingExecutor::Batch::Reserve(std::int64_t const count) {
+  jobs_.reserve(count);
+}
+
+void WorkStealingExecutor::Batch::Add(Task task) {
+  CHECK(!submitted_);
+  jobs_.push_back({std::move(task), this});
+}
+
+void WorkStealingExecutor::Batch::Submit() {
+  CHECK(!submitted_);
+  submitted_ = true;
+  number_of_pending_jobs_.store(jobs_.size());
+  if (jobs_.empty()) {
+    done_.Notify();
+  } else {
+    executor_.Submit(jobs_.data(), jobs_.size());
+  }
+}
+
+void WorkStealingExecutor::Batch::Join() {
+  CHECK(submitted_);
+  // Help with the execution of this batch instead of blocking.  Running the
+  // jobs of other clients could delay the caller indefinitely, e.g., the main
+  // thread of the game.
+  std::int64_t const worker = executor_.CurrentWorker();
+  while (!done_.HasBeenNotified()) {
+    Job* const job = executor_.TryTakeJobOf(*this, worker);
+    if (job == nullptr) {
+      // The remaining jobs of this batch are being executed by other threads.
+      break;
+    }
+    Run(job);
+  }
+  done_.WaitForNotification();
+}
+
+void WorkStealingExecutor::Batch::SubmitAndJoin() {
+  Submit();
+  Join();
+}
+
+void WorkStealingExecutor::Batch::Complete() {
+  if (number_of_pending_jobs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    done_.Notify();
+  }
+}
+
+}  // namespace internal_work_stealing_executor
+}  // namespace base
+}  // namespace principia
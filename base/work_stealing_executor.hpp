@@ -0,0 +1,272 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+
+namespace principia {
+namespace base {
+namespace internal_work_stealing_executor {
+
+// A move-only, type-erased nullary function returning void.  Unlike
+// |std::function|, this class does not require the callable to be copyable,
+// and it stores small callables (e.g., lambdas capturing a handful of pointers
+// or references) inline, without allocating.
+class Task final {
+ public:
+  // The size of the inline storage.  Callables that are larger, overaligned or
+  // that may throw when moved are stored on the heap.
+  static constexpr std::size_t inline_size = 64;
+
+  Task() = default;
+
+  template<typename Function,
+           typename = std::enable_if_t<
+               !std::is_same_v<std::decay_t<Function>, Task>>>
+  Task(Function&& function);  // NOLINT(runtime/explicit)
+
+  Task(Task&& other);
+  Task& operator=(Task&& other);
+  Task(Task const&) = delete;
+  Task& operator=(Task const&) = delete;
+
+  ~Task();
+
+  // Returns true if this object holds a callable.
+  explicit operator bool() const;
+
+  // Calls the callable, which must exist.
+  void operator()();
+
+ private:
+  struct Operations {
+    void (*invoke)(void* storage);
+    // Move-constructs the callable at |to| from the one at |from|, and destroys
+    // the latter.
+    void (*relocate)(void* from, void* to);
+    void (*destroy)(void* storage);
+  };
+
+  template<typename Callable>
+  static constexpr bool is_stored_inline =
+      sizeof(Callable) <= inline_size &&
+      alignof(Callable) <= alignof(std::max_align_t) &&
+      std::is_nothrow_move_constructible_v<Callable>;
+
+  template<typename Callable>
+  static Operations const* InlineOperations();
+  template<typename Callable>
+  static Operations const* HeapOperations();
+
+  void Reset();
+
+  alignas(std::max_align_t) std::byte storage_[inline_size];
+  // Null if this object doesn't hold a callable.
+  Operations const* operations_ = nullptr;
+};
+
+// A deque where a single thread, the owner, pushes and pops elements at the
+// bottom, and any number of other threads, the thieves, steal elements at the
+// top.  This is the Chase-Lev deque, with the memory orderings from [LPCZN13].
+// None of the operations take a lock.  |T| must be a pointer type.
+template<typename T>
+class WorkStealingDeque final {
+  static_assert(std::is_pointer_v<T>);
+
+ public:
+  WorkStealingDeque();
+
+  // Only called by the owner.
+  void Push(T element);
+
+  // Only called by the owner.  Returns the element most recently pushed, or
+  // null if the deque is empty.
+  T Pop();
+
+  // May be called by any thread.  Returns the element least recently pushed,
+  // or null if the deque is empty or if another thread won the race for that
+  // element.
+  T Steal();
+
+ private:
+  // A circular array whose capacity is a power of 2.
+  class Array final {
+   public:
+    explicit Array(std::int64_t capacity);
+
+    std::int64_t capacity() const;
+
+    T Load(std::int64_t index) const;
+    void Store(std::int64_t index, T element);
+
+    // Returns an array with twice the capacity of this one, holding the
+    // elements with indices in [top, bottom[.
+    std::unique_ptr<Array> Grow(std::int64_t top, std::int64_t bottom) const;
+
+   private:
+    std::int64_t const mask_;
+    std::unique_ptr<std::atomic<T>[]> elements_;
+  };
+
+  static constexpr std::int64_t initial_capacity = 256;
+
+  // |top_| and |bottom_| are written by different threads, so they live on
+  // different cache lines.
+  alignas(64) std::atomic<std::int64_t> top_ = 0;
+  alignas(64) std::atomic<std::int64_t> bottom_ = 0;
+  std::atomic<Array*> array_;
+  // All the arrays allocated by this deque, since a thief may still be reading
+  // from an array after the owner has replaced it.  Only accessed by the owner.
+  std::vector<std::unique_ptr<Array>> arrays_;
+};
+
+// An executor that runs tasks on a fixed number of worker threads.  Each worker
+// has its own deque of jobs, and idle workers steal jobs from busy ones, so
+// that workers rarely contend on a lock.  Tasks submitted from a thread that is
+// not a worker go through a shared queue, which is locked once per submission,
+// not once per task.  This class is thread-safe.
+class WorkStealingExecutor final {
+ public:
+  class Batch;
+
+  // Starts the given number of worker threads.
+  explicit WorkStealingExecutor(std::int64_t number_of_workers);
+
+  // Stops the workers after they have completed the tasks that they are
+  // currently executing.  The tasks that have not started are destroyed without
+  // being executed.  All the batches must have been joined.
+  ~WorkStealingExecutor();
+
+  std::int64_t number_of_workers() const;
+
+  // Executes |task| asynchronously.  The client is responsible for any
+  // synchronization with the completion of |task|; when there are many tasks,
+  // a |Batch| is more efficient.
+  void Execute(Task task) EXCLUDES(lock_);
+
+ private:
+  struct Job {
+    Task task;
+    // The batch to notify when the task has been executed, or null if the job
+    // is owned by the executor and must be deleted after execution.
+    Batch* batch = nullptr;
+  };
+
+  struct Worker {
+    WorkStealingDeque<Job*> deque;
+    std::thread thread;
+  };
+
+  // Makes the |count| jobs starting at |first| available to the workers.
+  void Submit(Job* first, std::int64_t count) EXCLUDES(lock_);
+
+  // Returns a job taken from the deque of the given worker, from the shared
+  // queue, or stolen from another worker, in that order.  |worker| is the index
+  // of the calling worker, or -1 if the caller is not a worker of this
+  // executor.  Returns null if no job was found.
+  Job* TryTakeJob(std::int64_t worker) EXCLUDES(lock_);
+
+  // Returns a job of |batch| taken from the bottom of the deque of the given
+  // worker if |worker| is nonnegative, or from the shared queue otherwise.
+  // Returns null if no job of |batch| is found there, in which case its
+  // remaining jobs have been taken by other threads.
+  Job* TryTakeJobOf(Batch const& batch, std::int64_t worker) EXCLUDES(lock_);
+
+  // Executes the task of |job| and disposes of |job|.
+  static void Run(Job* job);
+
+  // The loop executed by each worker thread.
+  void Toil(std::int64_t worker) EXCLUDES(lock_);
+
+  // Returns the index of the calling thread if it is a worker of this
+  // executor, -1 otherwise.
+  std::int64_t CurrentWorker() const;
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  absl::Mutex lock_;
+  bool shutdown_ GUARDED_BY(lock_) = false;
+  // The jobs submitted from threads that are not workers.
+  std::deque<Job*> injected_jobs_ GUARDED_BY(lock_);
+  // The size of |injected_jobs_|, readable without locking.
+  std::atomic<std::int64_t> number_of_injected_jobs_ = 0;
+  // The number of jobs that have been submitted but not yet taken.  May be
+  // transiently negative.
+  std::atomic<std::int64_t> number_of_queued_jobs_ = 0;
+  // The number of workers waiting on |lock_| for jobs to be submitted.
+  std::atomic<std::int64_t> number_of_sleeping_workers_ = 0;
+
+  static thread_local WorkStealingExecutor const* current_executor_;
+  static thread_local std::int64_t current_worker_;
+
+  static_assert(std::atomic<std::int64_t>::is_always_lock_free,
+                "int64_t not lock-free");
+};
+
+// A set of tasks that are submitted together to an executor, and whose
+// completion can be awaited without futures.  The tasks are stored in the batch
+// itself, so the only allocation is that of the vector holding them.  This
+// class is not thread-safe: all the member functions must be called from the
+// same thread.
+class WorkStealingExecutor::Batch final {
+ public:
+  explicit Batch(WorkStealingExecutor& executor);
+
+  Batch(Batch const&) = delete;
+  Batch(Batch&&) = delete;
+  Batch& operator=(Batch const&) = delete;
+  Batch& operator=(Batch&&) = delete;
+
+  // Joins the batch if it has been submitted.
+  ~Batch();
+
+  // Preallocates space for |count| tasks.
+  void Reserve(std::int64_t count);
+
+  // Adds a task to this batch.  Must be called before |Submit|.
+  void Add(Task task);
+
+  // Makes the tasks available to the executor.  May only be called once.
+  void Submit();
+
+  // Waits until all the tasks have been executed.  The calling thread executes
+  // the pending tasks of this batch while it waits, so it is safe to join a
+  // batch from a task executed by the same executor.  It never executes the
+  // tasks of other clients, which may take arbitrarily long.  Must be called
+  // after |Submit|, without submitting other tasks in between.
+  void Join();
+
+  // Equivalent to |Submit| followed by |Join|.
+  void SubmitAndJoin();
+
+ private:
+  // Called when the task of one of the jobs has been executed.
+  void Complete();
+
+  WorkStealingExecutor& executor_;
+  std::vector<Job> jobs_;
+  bool submitted_ = false;
+  std::atomic<std::int64_t> number_of_pending_jobs_ = 0;
+  absl::Notification done_;
+
+  friend class WorkStealingExecutor;
+};
+
+}  // namespace internal_work_stealing_executor
+
+using internal_work_stealing_executor::Task;
+using internal_work_stealing_executor::WorkStealingExecutor;
+
+}  // namespace base
+}  // namespace principia
+
+#include "base/work_stealing_executor_body.hpp"
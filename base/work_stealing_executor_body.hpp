@@ -0,0 +1,200 @@
+#pragma once
+
+#include "base/work_stealing_executor.hpp"
+
+#include <new>
+#include <utility>
+
+#include "glog/logging.h"
+
+namespace principia {
+namespace base {
+namespace internal_work_stealing_executor {
+
+template<typename Function, typename>
+Task::Task(Function&& function) {
+  using Callable = std::decay_t<Function>;
+  if constexpr (is_stored_inline<Callable>) {
+    new (storage_) Callable(std::forward<Function>(function));
+    operations_ = InlineOperations<Callable>();
+  } else {
+    new (storage_) Callable*(new Callable(std::forward<Function>(function)));
+    operations_ = HeapOperations<Callable>();
+  }
+}
+
+inline Task::Task(Task&& other) : operations_(other.operations_) {
+  if (operations_ != nullptr) {
+    operations_->relocate(other.storage_, storage_);
+    other.operations_ = nullptr;
+  }
+}
+
+inline Task& Task::operator=(Task&& other) {
+  if (this != &other) {
+    Reset();
+    operations_ = other.operations_;
+    if (operations_ != nullptr) {
+      operations_->relocate(other.storage_, storage_);
+      other.operations_ = nullptr;
+    }
+  }
+  return *this;
+}
+
+inline Task::~Task() {
+  Reset();
+}
+
+inline Task::operator bool() const {
+  return operations_ != nullptr;
+}
+
+inline void Task::operator()() {
+  DCHECK(operations_ != nullptr);
+  operations_->invoke(storage_);
+}
+
+template<typename Callable>
+Task::Operations const* Task::InlineOperations() {
+  static constexpr Operations operations{
+      /*invoke=*/[](void* const storage) {
+        (*std::launder(static_cast<Callable*>(storage)))();
+      },
+      /*relocate=*/[](void* const from, void* const to) {
+        Callable* const callable = std::launder(static_cast<Callable*>(from));
+        new (to) Callable(std::move(*callable));
+        callable->~Callable();
+      },
+      /*destroy=*/[](void* const storage) {
+        std::launder(static_cast<Callable*>(storage))->~Callable();
+      }};
+  return &operations;
+}
+
+template<typename Callable>
+Task::Operations const* Task::HeapOperations() {
+  // The storage holds a pointer to the callable.
+  static constexpr Operations operations{
+      /*invoke=*/[](void* const storage) {
+        (**std::launder(static_cast<Callable**>(storage)))();
+      },
+      /*relocate=*/[](void* const from, void* const to) {
+        new (to) Callable*(*std::launder(static_cast<Callable**>(from)));
+      },
+      /*destroy=*/[](void* const storage) {
+        delete *std::launder(static_cast<Callable**>(storage));
+      }};
+  return &operations;
+}
+
+inline void Task::Reset() {
+  if (operations_ != nullptr) {
+    operations_->destroy(storage_);
+    operations_ = nullptr;
+  }
+}
+
+template<typename T>
+WorkStealingDeque<T>::WorkStealingDeque() {
+  arrays_.push_back(std::make_unique<Array>(initial_capacity));
+  array_.store(arrays_.back().get(), std::memory_order_relaxed);
+}
+
+template<typename T>
+void WorkStealingDeque<T>::Push(T const element) {
+  std::int64_t const bottom = bottom_.load(std::memory_order_relaxed);
+  std::int64_t const top = top_.load(std::memory_order_acquire);
+  Array* array = array_.load(std::memory_order_relaxed);
+  if (bottom - top > array->capacity() - 1) {
+    arrays_.push_back(array->Grow(top, bottom));
+    array = arrays_.back().get();
+    array_.store(array, std::memory_order_release);
+  }
+  array->Store(bottom, element);
+  std::atomic_thread_fence(std::memory_order_release);
+  bottom_.store(bottom + 1, std::memory_order_relaxed);
+}
+
+template<typename T>
+T WorkStealingDeque<T>::Pop() {
+  std::int64_t const bottom = bottom_.load(std::memory_order_relaxed) - 1;
+  Array* const array = array_.load(std::memory_order_relaxed);
+  bottom_.store(bottom, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  std::int64_t top = top_.load(std::memory_order_relaxed);
+  if (top > bottom) {
+    // The deque was empty.
+    bottom_.store(bottom + 1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  T element = array->Load(bottom);
+  if (top == bottom) {
+    // This is the last element, race against the thieves for it.
+    if (!top_.compare_exchange_strong(top, top + 1,
+                                      std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      element = nullptr;
+    }
+    bottom_.store(bottom + 1, std::memory_order_relaxed);
+  }
+  return element;
+}
+
+template<typename T>
+T WorkStealingDeque<T>::Steal() {
+  std::int64_t top = top_.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  std::int64_t const bottom = bottom_.load(std::memory_order_acquire);
+  if (top >= bottom) {
+    return nullptr;
+  }
+  // [LPCZN13] uses a consume load here, which compilers implement as an
+  // acquire load anyway.
+  Array const* const array = array_.load(std::memory_order_acquire);
+  T const element = array->Load(top);
+  if (!top_.compare_exchange_strong(top, top + 1,
+                                    std::memory_order_seq_cst,
+                                    std::memory_order_relaxed)) {
+    return nullptr;
+  }
+  return element;
+}
+
+template<typename T>
+WorkStealingDeque<T>::Array::Array(std::int64_t const capacity)
+    : mask_(capacity - 1),
+      elements_(std::make_unique<std::atomic<T>[]>(capacity)) {
+  DCHECK_EQ(0, capacity & mask_) << capacity;
+}
+
+template<typename T>
+std::int64_t WorkStealingDeque<T>::Array::capacity() const {
+  return mask_ + 1;
+}
+
+template<typename T>
+T WorkStealingDeque<T>::Array::Load(std::int64_t const index) const {
+  return elements_[index & mask_].load(std::memory_order_relaxed);
+}
+
+template<typename T>
+void WorkStealingDeque<T>::Array::Store(std::int64_t const index,
+                                        T const element) {
+  elements_[index & mask_].store(element, std::memory_order_relaxed);
+}
+
+template<typename T>
+std::unique_ptr<typename WorkStealingDeque<T>::Array>
+WorkStealingDeque<T>::Array::Grow(std::int64_t const top,
+                                  std::int64_t const bottom) const {
+  auto grown = std::make_unique<Array>(2 * capacity());
+  for (std::int64_t i = top; i < bottom; ++i) {
+    grown->Store(i, Load(i));
+  }
+  return grown;
+}
+
+}  // namespace internal_work_stealing_executor
+}  // namespace base
+}  // namespace principia
@@ -0,0 +1,215 @@
+
+#include "base/work_stealing_executor.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace principia {
+namespace base {
+
+using internal_work_stealing_executor::WorkStealingDeque;
+
+class WorkStealingExecutorTest : public ::testing::Test {
+ protected:
+  WorkStealingExecutorTest() : executor_(std::thread::hardware_concurrency()) {}
+
+  WorkStealingExecutor executor_;
+};
+
+TEST_F(WorkStealingExecutorTest, Task) {
+  int calls = 0;
+  Task small([&calls]() { ++calls; });
+  EXPECT_TRUE(static_cast<bool>(small));
+  small();
+  EXPECT_EQ(1, calls);
+
+  // A callable too large to be stored inline, and one that is move-only.
+  std::array<int, 100> large_array{};
+  large_array[99] = 3;
+  Task large([&calls, large_array]() { calls += large_array[99]; });
+  auto pointer = std::make_unique<int>(5);
+  Task move_only([&calls, pointer = std::move(pointer)]() {
+    calls += *pointer;
+  });
+
+  Task moved = std::move(large);
+  EXPECT_FALSE(static_cast<bool>(large));
+  moved();
+  EXPECT_EQ(4, calls);
+  moved = std::move(move_only);
+  EXPECT_FALSE(static_cast<bool>(move_only));
+  moved();
+  EXPECT_EQ(9, calls);
+  EXPECT_FALSE(static_cast<bool>(Task()));
+}
+
+TEST_F(WorkStealingExecutorTest, Deque) {
+  WorkStealingDeque<int*> deque;
+  std::vector<int> elements(1000);
+  EXPECT_EQ(nullptr, deque.Pop());
+  EXPECT_EQ(nullptr, deque.Steal());
+  // Enough elements to cause the deque to grow.
+  for (int& element : elements) {
+    deque.Push(&element);
+  }
+  EXPECT_EQ(&elements[0], deque.Steal());
+  EXPECT_EQ(&elements[999], deque.Pop());
+  EXPECT_EQ(&elements[1], deque.Steal());
+  EXPECT_EQ(&elements[998], deque.Pop());
+}
+
+// Checks that each element is taken exactly once when the owner and thieves
+// race.
+TEST_F(WorkStealingExecutorTest, DequeRace) {
+  constexpr int number_of_elements = 100'000;
+  constexpr int number_of_thieves = 3;
+  WorkStealingDeque<int*> deque;
+  std::vector<int> elements(number_of_elements, 0);
+  std::atomic<int> taken = 0;
+
+  std::vector<std::thread> thieves;
+  for (int i = 0; i < number_of_thieves; ++i) {
+    thieves.emplace_back([&deque, &taken]() {
+      while (taken.load() < number_of_elements) {
+        if (int* const element = deque.Steal()) {
+          ++*element;
+          ++taken;
+        }
+      }
+    });
+  }
+  for (int& element : elements) {
+    deque.Push(&element);
+    if ((&element - elements.data()) % 3 == 0) {
+      if (int* const popped = deque.Pop()) {
+        ++*popped;
+        ++taken;
+      }
+    }
+  }
+  while (taken.load() < number_of_elements) {
+    if (int* const popped = deque.Pop()) {
+      ++*popped;
+      ++taken;
+    }
+  }
+  for (auto& thief : thieves) {
+    thief.join();
+  }
+  EXPECT_THAT(elements, ::testing::Each(1));
+}
+
+TEST_F(WorkStealingExecutorTest, Execute) {
+  constexpr int number_of_tasks = 10'000;
+  std::atomic<int> count = 0;
+  absl::Notification done;
+  for (int i = 0; i < number_of_tasks; ++i) {
+    executor_.Execute([&count, &done]() {
+      if (++count == number_of_tasks) {
+        done.Notify();
+      }
+    });
+  }
+  done.WaitForNotification();
+  EXPECT_EQ(number_of_tasks, count);
+}
+
+TEST_F(WorkStealingExecutorTest, Batch) {
+  constexpr int number_of_tasks = 100'000;
+  std::vector<int> results(number_of_tasks, 0);
+  absl::Mutex lock;
+  std::set<std::thread::id> thread_ids;
+
+  WorkStealingExecutor::Batch batch(executor_);
+  batch.Reserve(number_of_tasks);
+  for (int i = 0; i < number_of_tasks; ++i) {
+    batch.Add([i, &results, &lock, &thread_ids]() {
+      results[i] = 2 * i;
+      if (i % 1000 == 0) {
+        absl::MutexLock l(&lock);
+        thread_ids.insert(std::this_thread::get_id());
+      }
+    });
+  }
+  batch.SubmitAndJoin();
+
+  for (int i = 0; i < number_of_tasks; ++i) {
+    EXPECT_EQ(2 * i, results[i]);
+  }
+  EXPECT_LE(1, thread_ids.size());
+}
+
+TEST_F(WorkStealingExecutorTest, EmptyBatch) {
+  WorkStealingExecutor::Batch batch(executor_);
+  batch.SubmitAndJoin();
+}
+
+// Checks that a task may submit and join a batch without deadlocking, even if
+// all the workers do so.
+TEST_F(WorkStealingExecutorTest, NestedBatches) {
+  constexpr int outer_tasks = 100;
+  constexpr int inner_tasks = 100;
+  std::atomic<int> count = 0;
+  WorkStealingExecutor::Batch outer(executor_);
+  for (int i = 0; i < outer_tasks; ++i) {
+    outer.Add([this, &count]() {
+      WorkStealingExecutor::Batch inner(executor_);
+      for (int j = 0; j < inner_tasks; ++j) {
+        inner.Add([&count]() { ++count; });
+      }
+      inner.SubmitAndJoin();
+    });
+  }
+  outer.SubmitAndJoin();
+  EXPECT_EQ(outer_tasks * inner_tasks, count);
+}
+
+// Checks that joining a batch from a thread that is not a worker doesn't
+// execute the tasks of other clients.
+TEST_F(WorkStealingExecutorTest, JoinOnlyRunsItsBatch) {
+  absl::Notification release;
+  std::atomic<int> started = 0;
+  // Keep all the workers busy, and queue more tasks behind them.
+  int const blockers = 2 * executor_.number_of_workers();
+  for (int i = 0; i < blockers; ++i) {
+    executor_.Execute([&release, &started]() {
+      ++started;
+      release.WaitForNotification();
+    });
+  }
+
+  // Wait until the workers are blocked, so that they don't take any task of
+  // the batch.
+  while (started < executor_.number_of_workers()) {
+    std::this_thread::yield();
+  }
+
+  std::atomic<int> count = 0;
+  WorkStealingExecutor::Batch batch(executor_);
+  for (int i = 0; i < 100; ++i) {
+    batch.Add([&count]() { ++count; });
+  }
+  // This thread must run the batch by itself, without picking the blocking
+  // tasks.
+  batch.SubmitAndJoin();
+  EXPECT_EQ(100, count);
+  EXPECT_EQ(executor_.number_of_workers(), started);
+
+  release.Notify();
+  while (started < blockers) {
+    std::this_thread::yield();
+  }
+}
+
+}  // namespace base
+}  // namespace principia
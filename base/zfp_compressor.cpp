@@ -17,6 +17,50 @@ namespace zfp_compressor_internal {
 // parameters.
 static constexpr uint header_mask = ZFP_HEADER_MODE | ZFP_HEADER_MAGIC;
 
+namespace {
+
+std::unique_ptr<zfp_stream, std::function<void(zfp_stream*)>> NewZfpStream() {
+  return std::unique_ptr<zfp_stream, std::function<void(zfp_stream*)>>(
+      zfp_stream_open(/*stream=*/nullptr),
+      [](zfp_stream* const zfp) { zfp_stream_close(zfp); });
+}
+
+std::unique_ptr<bitstream, std::function<void(bitstream*)>> NewBitStream(
+    void* const buffer,
+    std::size_t const bytes) {
+  return std::unique_ptr<bitstream, std::function<void(bitstream*)>>(
+      check_not_null(stream_open(buffer, bytes)),
+      [](bitstream* const stream) { stream_close(stream); });
+}
+
+// A 1-dimensional field, used to describe the stream to the zfp functions that
+// require one.  It has no data.
+std::unique_ptr<zfp_field, std::function<void(zfp_field*)>> NewDescriptiveField(
+    std::int64_t const size) {
+  return std::unique_ptr<zfp_field, std::function<void(zfp_field*)>>(
+      zfp_field_1d(/*pointer=*/nullptr, zfp_type_double, /*nx=*/size),
+      [](zfp_field* const field) { zfp_field_free(field); });
+}
+
+// Sets the compression mode of |zfp| for the given |accuracy|.
+void SetAccuracy(double const accuracy, not_null<zfp_stream*> const zfp) {
+  if (accuracy == 0) {
+    zfp_stream_set_reversible(zfp);
+  } else {
+    zfp_stream_set_accuracy(zfp, accuracy);
+  }
+}
+
+std::size_t MaximumSize(double const accuracy, std::int64_t const size) {
+  CHECK_LT(0, size);
+  auto const zfp = NewZfpStream();
+  SetAccuracy(accuracy, zfp.get());
+  return zfp_stream_maximum_size(zfp.get(),
+                                 NewDescriptiveField(size).get());
+}
+
+}  // namespace
+
 ZfpCompressor::ZfpCompressor(double const accuracy) : accuracy_(accuracy) {}
 
 void ZfpCompressor::WriteToMessage(const zfp_field* const field,
@@ -61,6 +105,67 @@ void ZfpCompressor::ReadFromMessage(zfp_field* const field,
   message.remove_prefix(compressed_size);
 }
 
+ZfpStreamWriter::ZfpStreamWriter(double const accuracy,
+                                 std::int64_t const max_size)
+    : zfp_(NewZfpStream()),
+      buffer_(MaximumSize(accuracy, max_size)),
+      stream_(NewBitStream(buffer_.data.get(), buffer_.size)) {
+  SetAccuracy(accuracy, zfp_.get());
+  zfp_stream_set_bit_stream(zfp_.get(), stream_.get());
+  zfp_write_header(zfp_.get(),
+                   NewDescriptiveField(max_size).get(),
+                   header_mask);
+}
+
+void ZfpStreamWriter::Put(double const value) {
+  block_[block_size_] = value;
+  ++block_size_;
+  if (block_size_ == zfp_block_size) {
+    zfp_encode_block_double_1(zfp_.get(), block_.data());
+    block_size_ = 0;
+  }
+}
+
+void ZfpStreamWriter::WriteToMessage(not_null<std::string*> const message) {
+  if (block_size_ > 0) {
+    zfp_encode_partial_block_strided_double_1(
+        zfp_.get(), block_.data(), /*nx=*/block_size_, /*sx=*/1);
+    block_size_ = 0;
+  }
+  zfp_stream_flush(zfp_.get());
+  message->append(static_cast<char const*>(stream_data(stream_.get())),
+                  zfp_stream_compressed_size(zfp_.get()));
+}
+
+ZfpStreamReader::ZfpStreamReader(std::string_view const message,
+                                 std::int64_t const size)
+    : zfp_(NewZfpStream()),
+      stream_(NewBitStream(const_cast<char*>(message.data()), message.size())),
+      not_decompressed_(size) {
+  CHECK_LT(0, size);
+  zfp_stream_set_bit_stream(zfp_.get(), stream_.get());
+  std::size_t const header_bits = zfp_read_header(
+      zfp_.get(), NewDescriptiveField(size).get(), header_mask);
+  CHECK_LT(0, header_bits);
+}
+
+double ZfpStreamReader::Get() {
+  if (next_in_block_ == block_size_) {
+    CHECK_LT(0, not_decompressed_);
+    if (not_decompressed_ >= zfp_block_size) {
+      block_size_ = zfp_block_size;
+      zfp_decode_block_double_1(zfp_.get(), block_.data());
+    } else {
+      block_size_ = not_decompressed_;
+      zfp_decode_partial_block_strided_double_1(
+          zfp_.get(), block_.data(), /*nx=*/block_size_, /*sx=*/1);
+    }
+    not_decompressed_ -= block_size_;
+    next_in_block_ = 0;
+  }
+  return block_[next_in_block_++];
+}
+
 }  // namespace zfp_compressor_internal
 }  // namespace base
 }  // namespace principia
@@ -1,9 +1,15 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "base/array.hpp"
 #include "base/not_null.hpp"
 #include "zfp/zfp.h"
 
@@ -58,9 +64,57 @@ class ZfpCompressor {
   std::optional<double> const accuracy_;
 };
 
+// The number of doubles in a 1-dimensional zfp block.
+constexpr int zfp_block_size = 4;
+
+// Streaming 1-dimensional compression of a sequence of doubles, which are
+// passed one at a time and compressed by blocks of |zfp_block_size|, without
+// materializing the sequence.
+class ZfpStreamWriter final {
+ public:
+  // |accuracy| is as for |ZfpCompressor|.  |max_size| is a positive upper
+  // bound on the number of doubles passed to |Put|.
+  ZfpStreamWriter(double accuracy, std::int64_t max_size);
+
+  void Put(double value);
+
+  // Compresses the last block, if it is partial, and appends the compressed
+  // stream to |message|.  |Put| must not be called after this function.
+  void WriteToMessage(not_null<std::string*> message);
+
+ private:
+  std::unique_ptr<zfp_stream, std::function<void(zfp_stream*)>> const zfp_;
+  UniqueArray<std::uint8_t> const buffer_;
+  std::unique_ptr<bitstream, std::function<void(bitstream*)>> const stream_;
+  std::array<double, zfp_block_size> block_;
+  int block_size_ = 0;
+};
+
+// Decompression of a stream produced by |ZfpStreamWriter|, one double at a
+// time.  Only one block is decompressed at a time.
+class ZfpStreamReader final {
+ public:
+  // |size| is the positive number of doubles that were compressed in
+  // |message|, which must outlive this object.
+  ZfpStreamReader(std::string_view message, std::int64_t size);
+
+  // Must be called at most |size| times.
+  double Get();
+
+ private:
+  std::unique_ptr<zfp_stream, std::function<void(zfp_stream*)>> const zfp_;
+  std::unique_ptr<bitstream, std::function<void(bitstream*)>> const stream_;
+  std::array<double, zfp_block_size> block_;
+  int block_size_ = 0;
+  int next_in_block_ = 0;
+  std::int64_t not_decompressed_;
+};
+
 }  // namespace zfp_compressor_internal
 
 using zfp_compressor_internal::ZfpCompressor;
+using zfp_compressor_internal::ZfpStreamReader;
+using zfp_compressor_internal::ZfpStreamWriter;
 
 }  // namespace base
 }  // namespace principia
@@ -3,10 +3,22 @@
 
 #include "physics/discrete_trajectory.hpp"
 
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
 #include "base/not_null.hpp"
 #include "benchmark/benchmark.h"
 #include "geometry/frame.hpp"
 #include "ksp_plugin/frames.hpp"
+#include "physics/chunked_timeline.hpp"
+#include "physics/degrees_of_freedom.hpp"
+#include "quantities/elementary_functions.hpp"
+#include "quantities/quantities.hpp"
+#include "quantities/si.hpp"
+#include "serialization/physics.pb.h"
 
 namespace principia {
 namespace physics {
@@ -15,10 +27,18 @@ using base::make_not_null_unique;
 using base::not_null;
 using geometry::Frame;
 using geometry::Handedness;
+using geometry::Displacement;
 using geometry::Inertial;
 using geometry::Instant;
 using geometry::Velocity;
 using ksp_plugin::World;
+using quantities::AngularFrequency;
+using quantities::Cos;
+using quantities::Length;
+using quantities::Sin;
+using quantities::si::Kilo;
+using quantities::si::Metre;
+using quantities::si::Radian;
 using quantities::si::Second;
 
 namespace {
@@ -34,6 +54,28 @@ not_null<std::unique_ptr<DiscreteTrajectory<World>>> CreateTrajectory(
   return trajectory;
 }
 
+// Creates a downsampled trajectory with the given number of steps on a low
+// circular orbit, similar to the history of a vessel.
+not_null<std::unique_ptr<DiscreteTrajectory<World>>> CreateOrbitalTrajectory(
+    int const steps) {
+  Length const r = 700 * Kilo(Metre);
+  AngularFrequency const ω = 1.1e-3 * Radian / Second;
+  auto trajectory = make_not_null_unique<DiscreteTrajectory<World>>();
+  trajectory->SetDownsampling(/*max_dense_intervals=*/10'000,
+                              /*tolerance=*/10 * Metre);
+  Instant t = Instant() + 1e8 * Second;
+  for (int i = 0; i < steps; i++, t += 10 * Second) {
+    auto const θ = ω * (t - Instant());
+    trajectory->Append(
+        t,
+        {World::origin + Displacement<World>({r * Cos(θ), r * Sin(θ), 0 * r}),
+         Velocity<World>({-r * ω * Sin(θ) / Radian,
+                          r * ω * Cos(θ) / Radian,
+                          0 * r / Second})});
+  }
+  return trajectory;
+}
+
 // Forks |parent| at a position |pos| of the way through.
 // |parent| should be nonempty.
 // |pos| should be in [0, 1].
@@ -48,8 +90,150 @@ not_null<DiscreteTrajectory<World>*> ForkAt(DiscreteTrajectory<World>& parent,
   return parent.NewForkWithCopy(fork_it->time);
 }
 
+// An allocator that counts the bytes that it has allocated, used to measure the
+// memory footprint of a |std::map|.
+template<typename T>
+class CountingAllocator : public std::allocator<T> {
+ public:
+  template<typename U>
+  struct rebind {
+    using other = CountingAllocator<U>;
+  };
+
+  explicit CountingAllocator(not_null<std::int64_t*> const allocated_bytes)
+      : allocated_bytes_(allocated_bytes) {}
+
+  template<typename U>
+  CountingAllocator(CountingAllocator<U> const& other)  // NOLINT
+      : allocated_bytes_(other.allocated_bytes_) {}
+
+  T* allocate(std::size_t const n) {
+    *allocated_bytes_ += n * sizeof(T);
+    return std::allocator<T>::allocate(n);
+  }
+
+  void deallocate(T* const p, std::size_t const n) {
+    *allocated_bytes_ -= n * sizeof(T);
+    std::allocator<T>::deallocate(p, n);
+  }
+
+ private:
+  not_null<std::int64_t*> allocated_bytes_;
+
+  template<typename U>
+  friend class CountingAllocator;
+};
+
+// The timeline that |DiscreteTrajectory| used before it switched to
+// |ChunkedTimeline|.
+class MapTimeline {
+ public:
+  MapTimeline()
+      : map_(std::less<>(),
+             CountingAllocator<Map::value_type>(&allocated_bytes_)) {}
+
+  void Append(Instant const& time,
+              DegreesOfFreedom<World> const& degrees_of_freedom) {
+    map_.emplace_hint(map_.end(), time, degrees_of_freedom);
+  }
+
+  std::int64_t allocated_bytes() const {
+    return allocated_bytes_;
+  }
+
+  auto const& container() const {
+    return map_;
+  }
+
+ private:
+  using Map = std::map<Instant,
+                       DegreesOfFreedom<World>,
+                       std::less<>,
+                       CountingAllocator<std::pair<Instant const,
+                                                   DegreesOfFreedom<World>>>>;
+  std::int64_t allocated_bytes_ = 0;
+  Map map_;
+};
+
+class ChunkedTimelineAdapter {
+ public:
+  void Append(Instant const& time,
+              DegreesOfFreedom<World> const& degrees_of_freedom) {
+    timeline_.emplace_hint(timeline_.end(), time, degrees_of_freedom);
+  }
+
+  // The bookkeeping of the chunks is negligible.
+  std::int64_t allocated_bytes() const {
+    return timeline_.capacity() *
+           sizeof(ChunkedTimeline<DegreesOfFreedom<World>>::value_type);
+  }
+
+  auto const& container() const {
+    return timeline_;
+  }
+
+ private:
+  ChunkedTimeline<DegreesOfFreedom<World>> timeline_;
+};
+
+template<typename Timeline>
+std::unique_ptr<Timeline> CreateTimeline(int const steps) {
+  auto timeline = std::make_unique<Timeline>();
+  Instant t;
+  for (int i = 0; i < steps; i++, t += 1 * Second) {
+    timeline->Append(t, {World::origin, World::unmoving});
+  }
+  return timeline;
+}
+
 }  // namespace
 
+// Compares the timelines for the number of points appended per second, and
+// reports the memory footprint per point.
+template<typename Timeline>
+void BM_TimelineAppend(benchmark::State& state) {
+  int const steps = state.range(0);
+  std::int64_t allocated_bytes;
+  for (auto _ : state) {
+    auto const timeline = CreateTimeline<Timeline>(steps);
+    state.PauseTiming();
+    allocated_bytes = timeline->allocated_bytes();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * steps);
+  state.SetLabel(std::to_string(static_cast<double>(allocated_bytes) / steps) +
+                 " bytes/point");
+}
+
+template<typename Timeline>
+void BM_TimelineIterate(benchmark::State& state) {
+  int const steps = state.range(0);
+  auto const timeline = CreateTimeline<Timeline>(steps);
+  for (auto _ : state) {
+    Instant last;
+    for (auto const& pair : timeline->container()) {
+      last = pair.first;
+    }
+    benchmark::DoNotOptimize(last);
+  }
+  state.SetItemsProcessed(state.iterations() * steps);
+}
+
+template<typename Timeline>
+void BM_TimelineLowerBound(benchmark::State& state) {
+  int const steps = state.range(0);
+  auto const timeline = CreateTimeline<Timeline>(steps);
+  std::int64_t lookups = 0;
+  for (auto _ : state) {
+    for (int i = 0; i < steps; i += 997) {
+      benchmark::DoNotOptimize(
+          timeline->container().lower_bound(Instant() + (i + 0.5) * Second));
+    }
+    lookups += (steps + 996) / 997;
+  }
+  state.SetItemsProcessed(lookups);
+}
+
 void BM_DiscreteTrajectoryFront(benchmark::State& state) {
   not_null<std::unique_ptr<DiscreteTrajectory<World>>> const trajectory =
       CreateTrajectory(4);
@@ -157,6 +341,38 @@ void BM_DiscreteTrajectoryLowerBound(benchmark::State& state) {
   }
 }
 
+// Reports the size of the serialized trajectory per point.
+void BM_DiscreteTrajectorySerialization(benchmark::State& state) {
+  int const steps = state.range(0);
+  not_null<std::unique_ptr<DiscreteTrajectory<World>>> const trajectory =
+      CreateOrbitalTrajectory(steps);
+  std::int64_t bytes;
+  for (auto _ : state) {
+    serialization::DiscreteTrajectory message;
+    trajectory->WriteToMessage(&message, /*forks=*/{});
+    state.PauseTiming();
+    bytes = message.ByteSizeLong();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * trajectory->Size());
+  state.SetLabel(
+      std::to_string(static_cast<double>(bytes) / trajectory->Size()) +
+      " bytes/point");
+}
+
+void BM_DiscreteTrajectoryDeserialization(benchmark::State& state) {
+  int const steps = state.range(0);
+  not_null<std::unique_ptr<DiscreteTrajectory<World>>> const trajectory =
+      CreateOrbitalTrajectory(steps);
+  serialization::DiscreteTrajectory message;
+  trajectory->WriteToMessage(&message, /*forks=*/{});
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        DiscreteTrajectory<World>::ReadFromMessage(message, /*forks=*/{}));
+  }
+  state.SetItemsProcessed(state.iterations() * trajectory->Size());
+}
+
 BENCHMARK(BM_DiscreteTrajectoryFront);
 BENCHMARK(BM_DiscreteTrajectoryBack);
 BENCHMARK(BM_DiscreteTrajectoryBegin);
@@ -166,6 +382,16 @@ BENCHMARK(BM_DiscreteTrajectoryIterate)->Range(8, 1024);
 BENCHMARK(BM_DiscreteTrajectoryReverseIterate)->Range(8, 1024);
 BENCHMARK(BM_DiscreteTrajectoryFind)->Range(8, 1024);
 BENCHMARK(BM_DiscreteTrajectoryLowerBound)->Range(8, 1024);
+BENCHMARK(BM_DiscreteTrajectorySerialization)->Arg(100'000);
+BENCHMARK(BM_DiscreteTrajectoryDeserialization)->Arg(100'000);
+BENCHMARK_TEMPLATE(BM_TimelineAppend, MapTimeline)->Arg(1'000'000);
+BENCHMARK_TEMPLATE(BM_TimelineAppend, ChunkedTimelineAdapter)->Arg(1'000'000);
+BENCHMARK_TEMPLATE(BM_TimelineIterate, MapTimeline)->Arg(1'000'000);
+BENCHMARK_TEMPLATE(BM_TimelineIterate, ChunkedTimelineAdapter)
+    ->Arg(1'000'000);
+BENCHMARK_TEMPLATE(BM_TimelineLowerBound, MapTimeline)->Arg(1'000'000);
+BENCHMARK_TEMPLATE(BM_TimelineLowerBound, ChunkedTimelineAdapter)
+    ->Arg(1'000'000);
 
 }  // namespace physics
 }  // namespace principia
@@ -4,11 +4,17 @@
 #define GLOG_NO_ABBREVIATED_SEVERITIES
 
 #include <algorithm>
+#include <cstdint>
+#include <cstdlib>
 #include <functional>
+#include <limits>
+#include <new>
 #include <type_traits>
 #include <vector>
 
+#include "base/macros.hpp"
 #include "base/not_null.hpp"
+#include "base/status.hpp"
 #include "benchmark/benchmark.h"
 #include "geometry/frame.hpp"
 #include "geometry/grassmann.hpp"
@@ -19,12 +25,220 @@
 #include "glog/logging.h"
 #include "quantities/elementary_functions.hpp"
 #include "quantities/named_quantities.hpp"
+#include "quantities/numbers.hpp"
 #include "quantities/si.hpp"
 #include "serialization/physics.pb.h"
 #include "testing_utilities/integration.hpp"
 
+namespace {
+
+// While an |AllocationCounter| is alive on a thread, the replacements of the
+// global allocation functions below count the allocations made by that thread.
+// Otherwise they behave like the default ones, so the rest of the binary is
+// unaffected.  Note that on macOS the containers of Principia use a
+// |MallocAllocator| and are therefore not counted.
+thread_local std::int64_t* allocations_on_this_thread = nullptr;
+
+class AllocationCounter final {
+ public:
+  AllocationCounter() {
+    CHECK(allocations_on_this_thread == nullptr);
+    allocations_on_this_thread = &allocations_;
+  }
+
+  ~AllocationCounter() {
+    allocations_on_this_thread = nullptr;
+  }
+
+  std::int64_t allocations() const {
+    return allocations_;
+  }
+
+ private:
+  std::int64_t allocations_ = 0;
+};
+
+// Same as the default allocation functions, including the calls to the new
+// handler, with counting.  Memory allocated with an |alignment| must be freed
+// with |FreeAligned|.
+void* Allocate(std::size_t const size, std::nothrow_t const&) noexcept {
+  if (allocations_on_this_thread != nullptr) {
+    ++*allocations_on_this_thread;
+  }
+  for (;;) {
+    if (void* const pointer = std::malloc(size == 0 ? 1 : size)) {
+      return pointer;
+    }
+    std::new_handler const handler = std::get_new_handler();
+    if (handler == nullptr) {
+      return nullptr;
+    }
+    handler();
+  }
+}
+
+void* Allocate(std::size_t const size) {
+  if (void* const pointer = Allocate(size, std::nothrow)) {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+void Free(void* const pointer) noexcept {
+  std::free(pointer);
+}
+
+#if __cpp_aligned_new
+void* AllocateAligned(std::size_t const size,
+                      std::align_val_t const alignment,
+                      std::nothrow_t const&) noexcept {
+  if (allocations_on_this_thread != nullptr) {
+    ++*allocations_on_this_thread;
+  }
+  std::size_t const bytes = size == 0 ? 1 : size;
+  for (;;) {
+#if OS_WIN
+    void* const pointer =
+        _aligned_malloc(bytes, static_cast<std::size_t>(alignment));
+#else
+    void* pointer = nullptr;
+    if (posix_memalign(&pointer,
+                       std::max(static_cast<std::size_t>(alignment),
+                                sizeof(void*)),
+                       bytes) != 0) {
+      pointer = nullptr;
+    }
+#endif
+    if (pointer != nullptr) {
+      return pointer;
+    }
+    std::new_handler const handler = std::get_new_handler();
+    if (handler == nullptr) {
+      return nullptr;
+    }
+    handler();
+  }
+}
+
+void* AllocateAligned(std::size_t const size,
+                      std::align_val_t const alignment) {
+  if (void* const pointer = AllocateAligned(size, alignment, std::nothrow)) {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+void FreeAligned(void* const pointer) noexcept {
+#if OS_WIN
+  _aligned_free(pointer);
+#else
+  std::free(pointer);
+#endif
+}
+#endif
+
+}  // namespace
+
+void* operator new(std::size_t const size) {
+  return Allocate(size);
+}
+
+void* operator new[](std::size_t const size) {
+  return Allocate(size);
+}
+
+void* operator new(std::size_t const size,
+                   std::nothrow_t const& nothrow) noexcept {
+  return Allocate(size, nothrow);
+}
+
+void* operator new[](std::size_t const size,
+                     std::nothrow_t const& nothrow) noexcept {
+  return Allocate(size, nothrow);
+}
+
+void operator delete(void* const pointer) noexcept {
+  Free(pointer);
+}
+
+void operator delete[](void* const pointer) noexcept {
+  Free(pointer);
+}
+
+void operator delete(void* const pointer, std::size_t) noexcept {
+  Free(pointer);
+}
+
+void operator delete[](void* const pointer, std::size_t) noexcept {
+  Free(pointer);
+}
+
+void operator delete(void* const pointer, std::nothrow_t const&) noexcept {
+  Free(pointer);
+}
+
+void operator delete[](void* const pointer, std::nothrow_t const&) noexcept {
+  Free(pointer);
+}
+
+#if __cpp_aligned_new
+void* operator new(std::size_t const size, std::align_val_t const alignment) {
+  return AllocateAligned(size, alignment);
+}
+
+void* operator new[](std::size_t const size,
+                     std::align_val_t const alignment) {
+  return AllocateAligned(size, alignment);
+}
+
+void* operator new(std::size_t const size,
+                   std::align_val_t const alignment,
+                   std::nothrow_t const& nothrow) noexcept {
+  return AllocateAligned(size, alignment, nothrow);
+}
+
+void* operator new[](std::size_t const size,
+                     std::align_val_t const alignment,
+                     std::nothrow_t const& nothrow) noexcept {
+  return AllocateAligned(size, alignment, nothrow);
+}
+
+void operator delete(void* const pointer, std::align_val_t) noexcept {
+  FreeAligned(pointer);
+}
+
+void operator delete[](void* const pointer, std::align_val_t) noexcept {
+  FreeAligned(pointer);
+}
+
+void operator delete(void* const pointer,
+                     std::size_t,
+                     std::align_val_t) noexcept {
+  FreeAligned(pointer);
+}
+
+void operator delete[](void* const pointer,
+                       std::size_t,
+                       std::align_val_t) noexcept {
+  FreeAligned(pointer);
+}
+
+void operator delete(void* const pointer,
+                     std::align_val_t,
+                     std::nothrow_t const&) noexcept {
+  FreeAligned(pointer);
+}
+
+void operator delete[](void* const pointer,
+                       std::align_val_t,
+                       std::nothrow_t const&) noexcept {
+  FreeAligned(pointer);
+}
+#endif
+
 namespace principia {
 
+using base::Status;
 using geometry::Displacement;
 using geometry::Frame;
 using geometry::Inertial;
@@ -231,6 +445,77 @@ void BM_EmbeddedExplicitRungeKuttaNyströmIntegratorSolveHarmonicOscillator3D(
   state.SetLabel(ss.str());
 }
 
+// Integrates |state.range(0)| independent harmonic oscillators in bursts of one
+// period, reusing the same instance, as is done for the predictions and the
+// flight plans.  Reports the number of steps per second and the number of
+// allocations per step, which should be 0 once the workspace of the instance
+// has been allocated.
+template<typename Method>
+void BM_EmbeddedExplicitRungeKuttaNyströmIntegratorSolveBursts(
+    benchmark::State& state) {
+  using ODE = SpecialSecondOrderDifferentialEquation<Position<World>>;
+
+  int const dimension = state.range(0);
+  Instant const t_initial;
+  Time const burst = 2 * π * Second;
+  Length const length_tolerance = 1e-6 * Metre;
+  Speed const speed_tolerance = 1e-6 * Metre / Second;
+
+  ODE harmonic_oscillators;
+  harmonic_oscillators.compute_acceleration =
+      [](Instant const& t,
+         std::vector<Position<World>> const& q,
+         std::vector<Vector<Acceleration, World>>& result) {
+        for (std::size_t k = 0; k < q.size(); ++k) {
+          result[k] = (World::origin - q[k]) / (Second * Second);
+        }
+        return Status::OK;
+      };
+  std::vector<Position<World>> q_initial;
+  std::vector<Velocity<World>> v_initial;
+  for (int k = 0; k < dimension; ++k) {
+    q_initial.push_back(
+        World::origin +
+        Displacement<World>({(k + 1) * Metre, 0 * Metre, 0 * Metre}));
+    v_initial.push_back(Velocity<World>());
+  }
+  IntegrationProblem<ODE> problem;
+  problem.equation = harmonic_oscillators;
+  problem.initial_state = ODE::SystemState(q_initial, v_initial, t_initial);
+
+  std::int64_t steps = 0;
+  auto const append_state = [&steps](ODE::SystemState const& state) {
+    ++steps;
+  };
+
+  AdaptiveStepSizeIntegrator<ODE>::Parameters const parameters(
+      /*first_time_step=*/burst,
+      /*safety_factor=*/0.9,
+      /*max_steps=*/std::numeric_limits<std::int64_t>::max(),
+      /*last_step_is_exact=*/false);
+  auto const tolerance_to_error_ratio =
+      std::bind(HarmonicOscillatorToleranceRatio3D<ODE>,
+                _1, _2, length_tolerance, speed_tolerance);
+
+  auto const instance =
+      EmbeddedExplicitRungeKuttaNyströmIntegrator<Method, Position<World>>()
+          .NewInstance(problem,
+                       append_state,
+                       tolerance_to_error_ratio,
+                       parameters);
+  Instant t_final = t_initial;
+  std::int64_t allocations = 0;
+  for (auto _ : state) {
+    t_final += burst;
+    AllocationCounter const counter;
+    instance->Solve(t_final);
+    allocations += counter.allocations();
+  }
+  state.SetItemsProcessed(steps);
+  state.counters["allocations/step"] =
+      static_cast<double>(allocations) / std::max<std::int64_t>(1, steps);
+}
+
 // Keep each argument on a single line below, lest it breaks benchmark parsing.
 
 BENCHMARK_TEMPLATE2(
@@ -241,5 +526,9 @@ BENCHMARK_TEMPLATE2(
     BM_EmbeddedExplicitRungeKuttaNyströmIntegratorSolveHarmonicOscillator3D,
     methods::DormandالمكاوىPrince1986RKN434FM, Position<World>);
 
+BENCHMARK_TEMPLATE1(
+    BM_EmbeddedExplicitRungeKuttaNyströmIntegratorSolveBursts,
+    methods::DormandالمكاوىPrince1986RKN434FM)->Arg(1)->Arg(10)->Arg(100);
+
 }  // namespace integrators
 }  // namespace principia
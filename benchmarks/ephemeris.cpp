@@ -5,6 +5,8 @@
 #include <limits>
 #include <list>
 #include <memory>
+#include <optional>
+#include <random>
 #include <string>
 #include <vector>
 
@@ -149,9 +151,15 @@ void BM_EphemerisKSPSystem(benchmark::State& state) {
   state.SetLabel(quantities::DebugString(error / AstronomicalUnit) + " ua");
 }
 
+// The second argument is the number of threads used to compute the
+// accelerations between the massive bodies, 0 meaning sequential.
 template<SolarSystemFactory::Accuracy accuracy>
 void BM_EphemerisSolarSystem(benchmark::State& state) {
   Length error;
+  std::optional<ThreadPool<void>> pool;
+  if (state.range(1) > 0) {
+    pool.emplace(/*pool_size=*/state.range(1));
+  }
   while (state.KeepRunning()) {
     state.PauseTiming();
 
@@ -163,6 +171,9 @@ void BM_EphemerisSolarSystem(benchmark::State& state) {
                 FittingTolerance(state.range(0)),
                 accuracy),
             EphemerisParameters());
+    if (pool.has_value()) {
+      ephemeris->SetMassiveBodiesThreadPool(&*pool);
+    }
 
     state.ResumeTiming();
     ephemeris->Prolong(final_time);
@@ -400,6 +411,120 @@ void BM_EphemerisMultithreadingBenchmark(benchmark::State& state) {
   state.SetLabel(ss.str());
 }
 
+// Integrates |state.range(0)| probes in low Earth orbit as a single integrator
+// instance, as is done for the unloaded vessels of a pile-up.  Reports the
+// number of probe-steps per second, which shows how the computation of the
+// accelerations scales with the number of massless bodies.
+void BM_EphemerisMasslessBodiesThroughput(benchmark::State& state) {
+  auto const at_спутник_1_launch =
+      SolarSystemAtСпутник1Launch(SolarSystemFactory::Accuracy::MajorBodiesOnly);
+  Instant const epoch = at_спутник_1_launch->epoch();
+  auto const ephemeris =
+      at_спутник_1_launch->MakeEphemeris(
+          /*accuracy_parameters=*/{/*fitting_tolerance=*/1 * Milli(Metre),
+                                   /*geopotential_tolerance=*/0x1p-24},
+          EphemerisParameters());
+  std::string const& earth_name =
+      SolarSystemFactory::name(SolarSystemFactory::Earth);
+  auto const earth_massive_body =
+      at_спутник_1_launch->massive_body(*ephemeris, earth_name);
+  auto const earth_degrees_of_freedom =
+      at_спутник_1_launch->degrees_of_freedom(earth_name);
+
+  Time const step = 10 * Second;
+  int const steps_per_iteration = 1000;
+  ephemeris->Prolong(epoch + 1 * JulianYear);
+
+  MasslessBody probe;
+  std::list<DiscreteTrajectory<Barycentric>> trajectories;
+  std::vector<not_null<DiscreteTrajectory<Barycentric>*>> trajectory_pointers;
+  for (int i = 0; i < state.range(0); ++i) {
+    KeplerianElements<Barycentric> elements;
+    elements.eccentricity = 0;
+    elements.semimajor_axis = 7000 * Kilo(Metre) + i * 10 * Kilo(Metre);
+    elements.inclination = 0 * Radian;
+    elements.longitude_of_ascending_node = 0 * Radian;
+    elements.argument_of_periapsis = 0 * Radian;
+    elements.true_anomaly = i * Radian;
+    KeplerOrbit<Barycentric> const orbit(
+        *earth_massive_body, probe, elements, epoch);
+    trajectories.emplace_back();
+    auto& trajectory = trajectories.back();
+    trajectory.Append(epoch,
+                      earth_degrees_of_freedom + orbit.StateVectors(epoch));
+    trajectory_pointers.push_back(&trajectory);
+  }
+
+  auto const instance = ephemeris->NewInstance(
+      trajectory_pointers,
+      Ephemeris<Barycentric>::NoIntrinsicAccelerations,
+      Ephemeris<Barycentric>::FixedStepParameters(
+          SymmetricLinearMultistepIntegrator<Quinlan1999Order8A,
+                                             Position<Barycentric>>(),
+          step));
+  Instant final_time = epoch;
+  std::int64_t steps = 0;
+  while (state.KeepRunning()) {
+    final_time += steps_per_iteration * step;
+    CHECK_OK(ephemeris->FlowWithFixedStep(final_time, *instance));
+    steps += steps_per_iteration;
+    state.PauseTiming();
+    for (auto& trajectory : trajectories) {
+      trajectory.ForgetBefore(trajectory.back().time);
+    }
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(steps * state.range(0));
+}
+
+// Evaluates the positions of all the bodies of a solar system prolonged over
+// 10 years at pseudo-random times, as is done when integrating massless bodies
+// or plotting trajectories.  This measures the lookup and evaluation of the
+// polynomials of the continuous trajectories, which are mostly cache misses.
+void BM_EphemerisEvaluatePositions(benchmark::State& state) {
+  auto const at_спутник_1_launch = SolarSystemAtСпутник1Launch(
+      SolarSystemFactory::Accuracy::MinorAndMajorBodies);
+  Instant const epoch = at_спутник_1_launch->epoch();
+  Time const duration = 10 * JulianYear;
+  auto const ephemeris =
+      at_спутник_1_launch->MakeEphemeris(
+          SolarSystemFactory::MakeAccuracyParameters<Barycentric>(
+              FittingTolerance(state.range(0)),
+              SolarSystemFactory::Accuracy::MinorAndMajorBodies),
+          EphemerisParameters());
+  ephemeris->Prolong(epoch + duration);
+
+  std::mt19937_64 random(42);
+  std::uniform_real_distribution<> distribution(0, 1);
+  int const evaluations_per_iteration = 1000;
+  std::vector<Instant> times;
+  for (int i = 0; i < evaluations_per_iteration; ++i) {
+    times.push_back(epoch + distribution(random) * duration);
+  }
+
+  auto const& bodies = ephemeris->bodies();
+  double average_degree = 0;
+  for (auto const body : bodies) {
+    average_degree += ephemeris->trajectory(body)->average_degree();
+  }
+  average_degree /= bodies.size();
+
+  std::int64_t evaluations = 0;
+  Length sum;
+  while (state.KeepRunning()) {
+    for (Instant const& t : times) {
+      for (auto const body : bodies) {
+        sum += (ephemeris->trajectory(body)->EvaluatePosition(t) -
+                Barycentric::origin).Norm();
+      }
+    }
+    evaluations += evaluations_per_iteration * bodies.size();
+  }
+  benchmark::DoNotOptimize(sum);
+  state.SetItemsProcessed(evaluations);
+  state.SetLabel("average degree " + std::to_string(average_degree));
+}
+
 template<SolarSystemFactory::Accuracy accuracy, Flow* flow>
 void EphemerisL4ProbeBenchmark(Time const integration_duration,
                                benchmark::State& state) {
@@ -588,16 +713,34 @@ BENCHMARK(BM_EphemerisMultithreadingBenchmark)
     ->ArgPair(3, 3)
     ->ArgPair(3, 4)
     ->ArgPair(3, 5);
+BENCHMARK(BM_EphemerisMasslessBodiesThroughput)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(16)
+    ->Arg(64)
+    ->Arg(256)
+    ->Arg(1024);
+BENCHMARK(BM_EphemerisEvaluatePositions)->Arg(-3);
 BENCHMARK(BM_EphemerisKSPSystem)->Arg(-3);
 BENCHMARK_TEMPLATE(BM_EphemerisSolarSystem,
                    SolarSystemFactory::Accuracy::MajorBodiesOnly)
-    ->Arg(-3);
+    ->ArgPair(-3, 0)
+    ->ArgPair(-3, 2)
+    ->ArgPair(-3, 4)
+    ->ArgPair(-3, 8);
 BENCHMARK_TEMPLATE(BM_EphemerisSolarSystem,
                    SolarSystemFactory::Accuracy::MinorAndMajorBodies)
-    ->Arg(-3);
+    ->ArgPair(-3, 0)
+    ->ArgPair(-3, 2)
+    ->ArgPair(-3, 4)
+    ->ArgPair(-3, 8);
 BENCHMARK_TEMPLATE(BM_EphemerisSolarSystem,
                    SolarSystemFactory::Accuracy::AllBodiesAndDampedOblateness)
-    ->Arg(-3);
+    ->ArgPair(-3, 0)
+    ->ArgPair(-3, 2)
+    ->ArgPair(-3, 4)
+    ->ArgPair(-3, 8);
 BENCHMARK_TEMPLATE(BM_EphemerisL4Probe,
                    SolarSystemFactory::Accuracy::MajorBodiesOnly,
                    &FlowEphemerisWithAdaptiveStep)
@@ -0,0 +1,193 @@
+// .\Release\x64\benchmarks.exe --benchmark_repetitions=3 --benchmark_filter=FlightPlan  // NOLINT(whitespace/line_length)
+
+#include "ksp_plugin/flight_plan.hpp"
+
+#include <memory>
+#include <string>
+
+#include "astronomy/time_scales.hpp"
+#include "base/not_null.hpp"
+#include "benchmark/benchmark.h"
+#include "geometry/named_quantities.hpp"
+#include "integrators/methods.hpp"
+#include "integrators/symmetric_linear_multistep_integrator.hpp"
+#include "ksp_plugin/frames.hpp"
+#include "ksp_plugin/integrators.hpp"
+#include "ksp_plugin/manœuvre.hpp"
+#include "physics/body_centred_non_rotating_dynamic_frame.hpp"
+#include "physics/ephemeris.hpp"
+#include "physics/kepler_orbit.hpp"
+#include "physics/massive_body.hpp"
+#include "physics/massless_body.hpp"
+#include "physics/solar_system.hpp"
+#include "quantities/named_quantities.hpp"
+#include "quantities/quantities.hpp"
+#include "quantities/si.hpp"
+#include "testing_utilities/solar_system_factory.hpp"
+
+namespace principia {
+namespace ksp_plugin {
+
+using astronomy::operator""_TT;
+using base::make_not_null_unique;
+using base::not_null;
+using geometry::Instant;
+using geometry::Position;
+using geometry::Velocity;
+using integrators::SymmetricLinearMultistepIntegrator;
+using integrators::methods::QuinlanTremaine1990Order12;
+using physics::BodyCentredNonRotatingDynamicFrame;
+using physics::Ephemeris;
+using physics::Frenet;
+using physics::KeplerianElements;
+using physics::KeplerOrbit;
+using physics::MassiveBody;
+using physics::MasslessBody;
+using physics::SolarSystem;
+using quantities::Speed;
+using quantities::Time;
+using quantities::si::Degree;
+using quantities::si::Hour;
+using quantities::si::Kilo;
+using quantities::si::Metre;
+using quantities::si::Milli;
+using quantities::si::Minute;
+using quantities::si::Newton;
+using quantities::si::Second;
+using quantities::si::Tonne;
+using testing_utilities::SolarSystemFactory;
+
+namespace {
+
+constexpr int number_of_manœuvres = 10;
+constexpr Time time_between_manœuvres = 6 * Hour;
+
+// A flight plan for a vessel in low Earth orbit, with a small prograde burn
+// every |time_between_manœuvres|.
+class FlightPlanInLowEarthOrbit {
+ public:
+  FlightPlanInLowEarthOrbit()
+      : solar_system_(make_not_null_unique<SolarSystem<Barycentric>>(
+            SOLUTION_DIR / "astronomy" / "sol_gravity_model.proto.txt",
+            SOLUTION_DIR / "astronomy" /
+                "sol_initial_state_jd_2451545_000000000.proto.txt",
+            /*ignore_frame=*/true)),
+        ephemeris_(solar_system_->MakeEphemeris(
+            /*accuracy_parameters=*/{/*fitting_tolerance=*/1 * Milli(Metre),
+                                     /*geopotential_tolerance=*/0x1p-24},
+            Ephemeris<Barycentric>::FixedStepParameters(
+                SymmetricLinearMultistepIntegrator<QuinlanTremaine1990Order12,
+                                                   Position<Barycentric>>(),
+                /*step=*/10 * Minute))),
+        earth_(solar_system_->massive_body(
+            *ephemeris_,
+            SolarSystemFactory::name(SolarSystemFactory::Earth))),
+        earth_centred_inertial_(
+            std::make_shared<
+                BodyCentredNonRotatingDynamicFrame<Barycentric, Navigation>>(
+                ephemeris_.get(),
+                earth_)) {
+    KeplerianElements<Barycentric> low_earth_orbit;
+    low_earth_orbit.eccentricity = 0;
+    low_earth_orbit.semimajor_axis = 6783 * Kilo(Metre);
+    low_earth_orbit.inclination = 51.6 * Degree;
+    low_earth_orbit.longitude_of_ascending_node = 0 * Degree;
+    low_earth_orbit.argument_of_periapsis = 0 * Degree;
+    low_earth_orbit.mean_anomaly = 0 * Degree;
+    ephemeris_->Prolong(epoch);
+    KeplerOrbit<Barycentric> const orbit(
+        *earth_, MasslessBody{}, low_earth_orbit, epoch);
+
+    FlightPlan::MakeSynchronous();
+    flight_plan_ = std::make_unique<FlightPlan>(
+        /*initial_mass=*/10 * Tonne,
+        /*initial_time=*/epoch,
+        /*initial_degrees_of_freedom=*/
+        ephemeris_->trajectory(earth_)->EvaluateDegreesOfFreedom(epoch) +
+            orbit.StateVectors(epoch),
+        /*desired_final_time=*/epoch +
+            (number_of_manœuvres + 1) * time_between_manœuvres,
+        ephemeris_.get(),
+        DefaultPredictionParameters(),
+        DefaultBurnParameters());
+    for (int i = 0; i < number_of_manœuvres; ++i) {
+      CHECK_OK(flight_plan_->Insert(MakeBurn(i, 1 * Metre / Second), i));
+    }
+  }
+
+  NavigationManœuvre::Burn MakeBurn(int const index, Speed const& Δv) const {
+    NavigationManœuvre::Intensity intensity;
+    intensity.Δv = Velocity<Frenet<Navigation>>(
+        {Δv, 0 * Metre / Second, 0 * Metre / Second});
+    NavigationManœuvre::Timing timing;
+    timing.initial_time = epoch + (index + 1) * time_between_manœuvres;
+    return {intensity,
+            timing,
+            /*thrust=*/10 * Kilo(Newton),
+            /*specific_impulse=*/3 * Kilo(Newton) * Second / Tonne,
+            earth_centred_inertial_,
+            /*is_inertially_fixed=*/true};
+  }
+
+  FlightPlan& flight_plan() {
+    return *flight_plan_;
+  }
+
+ private:
+  static constexpr Instant epoch = "2000-01-01T12:00:00"_TT;
+
+  not_null<std::unique_ptr<SolarSystem<Barycentric>>> const solar_system_;
+  not_null<std::unique_ptr<Ephemeris<Barycentric>>> const ephemeris_;
+  not_null<MassiveBody const*> const earth_;
+  not_null<std::shared_ptr<NavigationFrame const>> const
+      earth_centred_inertial_;
+  std::unique_ptr<FlightPlan> flight_plan_;
+};
+
+}  // namespace
+
+// Simulates the interactive editing of the last burn of a flight plan, where
+// each frame nudges its Δv by a small amount.
+void BM_FlightPlanNudgeLastBurn(benchmark::State& state) {
+  FlightPlanInLowEarthOrbit fixture;
+  FlightPlan& flight_plan = fixture.flight_plan();
+  int const last = number_of_manœuvres - 1;
+  Speed Δv = 1 * Metre / Second;
+  for (auto _ : state) {
+    Δv += 1 * Milli(Metre) / Second;
+    CHECK_OK(flight_plan.Replace(fixture.MakeBurn(last, Δv), last));
+  }
+  state.SetLabel(std::to_string(flight_plan.number_of_segments()) +
+                 " segments");
+}
+
+// Same as above, but for the first burn, so that all the segments that follow
+// it change.
+void BM_FlightPlanNudgeFirstBurn(benchmark::State& state) {
+  FlightPlanInLowEarthOrbit fixture;
+  FlightPlan& flight_plan = fixture.flight_plan();
+  Speed Δv = 1 * Metre / Second;
+  for (auto _ : state) {
+    Δv += 1 * Milli(Metre) / Second;
+    CHECK_OK(flight_plan.Replace(fixture.MakeBurn(0, Δv), 0));
+  }
+  state.SetLabel(std::to_string(flight_plan.number_of_segments()) +
+                 " segments");
+}
+
+// Simulates the interactive extension of a flight plan.
+void BM_FlightPlanExtend(benchmark::State& state) {
+  FlightPlanInLowEarthOrbit fixture;
+  FlightPlan& flight_plan = fixture.flight_plan();
+  for (auto _ : state) {
+    CHECK_OK(flight_plan.SetDesiredFinalTime(flight_plan.desired_final_time() +
+                                             1 * Minute));
+  }
+}
+
+BENCHMARK(BM_FlightPlanNudgeLastBurn)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_FlightPlanNudgeFirstBurn)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_FlightPlanExtend)->Unit(benchmark::kMillisecond);
+
+}  // namespace ksp_plugin
+}  // namespace principia
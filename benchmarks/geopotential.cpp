@@ -45,6 +45,7 @@ using quantities::ParseQuantity;
 using quantities::Pow;
 using quantities::Quotient;
 using quantities::Sqrt;
+using quantities::Square;
 using quantities::si::Degree;
 using quantities::si::Kilo;
 using quantities::si::Metre;
@@ -146,6 +147,57 @@ void BM_ComputeGeopotentialCpp(benchmark::State& state) {
     }
     benchmark::DoNotOptimize(acceleration);
   }
+  state.SetItemsProcessed(state.iterations() * displacements.size());
+}
+
+// Compares the evaluation of the geopotential at many points for the same
+// instant, point by point (|state.range(1) == 0|) or with the per-instant work
+// shared between the points (|state.range(1) == 1|).  The points and their
+// norms are the same in both cases, so that the difference only measures the
+// sharing.
+void BM_ComputeGeopotentialCppBatched(benchmark::State& state) {
+  int const max_degree = state.range(0);
+  bool const share_per_instant_work = state.range(1) != 0;
+
+  SolarSystem<ICRS> solar_system_2000(
+            SOLUTION_DIR / "astronomy" / "sol_gravity_model.proto.txt",
+            SOLUTION_DIR / "astronomy" /
+                "sol_initial_state_jd_2451545_000000000.proto.txt");
+
+  auto const earth = MakeEarthBody(solar_system_2000, max_degree);
+  Geopotential<ICRS> const geopotential(&earth, /*tolerance=*/0);
+
+  std::mt19937_64 random(42);
+  std::uniform_real_distribution<> distribution(-1e7, 1e7);
+  std::vector<Displacement<ICRS>> displacements;
+  std::vector<Length> r_norms;
+  std::vector<Square<Length>> r²s;
+  std::vector<Exponentiation<Length, -3>> one_over_r³s;
+  for (int i = 0; i < 1e3; ++i) {
+    displacements.push_back(earth.FromSurfaceFrame<ITRS>(Instant())(
+        Displacement<ITRS>({distribution(random) * Metre,
+                            distribution(random) * Metre,
+                            distribution(random) * Metre})));
+    r²s.push_back(displacements.back().Norm²());
+    r_norms.push_back(Sqrt(r²s.back()));
+    one_over_r³s.push_back(r_norms.back() / (r²s.back() * r²s.back()));
+  }
+
+  std::vector<Vector<Exponentiation<Length, -2>, ICRS>> accelerations(
+      displacements.size());
+  while (state.KeepRunning()) {
+    if (share_per_instant_work) {
+      geopotential.GeneralSphericalHarmonicsAccelerations(
+          Instant(), displacements, r_norms, r²s, one_over_r³s, accelerations);
+    } else {
+      for (std::size_t i = 0; i < displacements.size(); ++i) {
+        accelerations[i] = geopotential.GeneralSphericalHarmonicsAcceleration(
+            Instant(), displacements[i], r_norms[i], r²s[i], one_over_r³s[i]);
+      }
+    }
+    benchmark::DoNotOptimize(accelerations);
+  }
+  state.SetItemsProcessed(state.iterations() * displacements.size());
 }
 
 void BM_ComputeGeopotentialDistance(benchmark::State& state) {
@@ -248,7 +300,14 @@ void BM_ComputeGeopotentialF90(benchmark::State& state) {
 
 #undef PRINCIPIA_CASE_COMPUTE_GEOPOTENTIAL_F90
 
-BENCHMARK(BM_ComputeGeopotentialCpp)->Arg(2)->Arg(3)->Arg(5)->Arg(10);
+BENCHMARK(BM_ComputeGeopotentialCpp)
+    ->Arg(2)->Arg(3)->Arg(5)->Arg(10)->Arg(30);
+BENCHMARK(BM_ComputeGeopotentialCppBatched)
+    ->Args({2, 0})->Args({2, 1})
+    ->Args({3, 0})->Args({3, 1})
+    ->Args({5, 0})->Args({5, 1})
+    ->Args({10, 0})->Args({10, 1})
+    ->Args({30, 0})->Args({30, 1});
 BENCHMARK(BM_ComputeGeopotentialF90)->Arg(2)->Arg(3)->Arg(5)->Arg(10);
 BENCHMARK(BM_ComputeGeopotentialDistance)
     ->Arg(150'000)     // C₂₂, S₂₂, J₂.
@@ -10,6 +10,7 @@
 #include "geometry/frame.hpp"
 #include "geometry/named_quantities.hpp"
 #include "geometry/orthogonal_map.hpp"
+#include "geometry/sphere_set.hpp"
 #include "quantities/elementary_functions.hpp"
 #include "quantities/si.hpp"
 #include "serialization/geometry.pb.h"
@@ -134,7 +135,8 @@ void BM_VisibleSegmentsOrbit(benchmark::State& state) {
                                 static_cast<double>(visible_segments_count)));
 }
 
-void BM_VisibleSegmentsOrbitMultipleSpheres(benchmark::State& state) {
+void OrbitMultipleSpheresBenchmark(bool const use_sphere_set,
+                                   benchmark::State& state) {
   // The camera is slightly above the x-y plane and looks towards the positive
   // x-axis.
   Position<World> const camera_origin(
@@ -181,12 +183,15 @@ void BM_VisibleSegmentsOrbitMultipleSpheres(benchmark::State& state) {
                                  0 * Metre})));
   }
 
+  SphereSet<World> const sphere_set(spheres);
+
   int visible_segments_count = 0;
   int visible_segments_size = 0;
   while (state.KeepRunning()) {
     for (auto const& segment : segments) {
       auto const visible_segments =
-          perspective.VisibleSegments(segment, spheres);
+          use_sphere_set ? perspective.VisibleSegments(segment, sphere_set)
+                         : perspective.VisibleSegments(segment, spheres);
       ++visible_segments_count;
       visible_segments_size += visible_segments.size();
     }
@@ -197,6 +202,14 @@ void BM_VisibleSegmentsOrbitMultipleSpheres(benchmark::State& state) {
                                 static_cast<double>(visible_segments_count)));
 }
 
+void BM_VisibleSegmentsOrbitMultipleSpheres(benchmark::State& state) {
+  OrbitMultipleSpheresBenchmark(/*use_sphere_set=*/false, state);
+}
+
+void BM_VisibleSegmentsOrbitMultipleSpheresSphereSet(benchmark::State& state) {
+  OrbitMultipleSpheresBenchmark(/*use_sphere_set=*/true, state);
+}
+
 void BM_VisibleSegmentsRandomEverywhere(benchmark::State& state) {
   // Generate random segments in the cube [-10, 10[³.
   std::uniform_real_distribution<> distribution(-10.0, 10.0);
@@ -217,7 +230,12 @@ void BM_VisibleSegmentsRandomNoIntersection(benchmark::State& state) {
 BENCHMARK(BM_VisibleSegmentsOrbit)->Arg(10)->Arg(100)->Arg(1000);
 BENCHMARK(BM_VisibleSegmentsRandomEverywhere)->Arg(1000);
 BENCHMARK(BM_VisibleSegmentsRandomNoIntersection)->Arg(1000);
-BENCHMARK(BM_VisibleSegmentsOrbitMultipleSpheres)->Args({1000, 20});
+BENCHMARK(BM_VisibleSegmentsOrbitMultipleSpheres)
+    ->Args({1000, 20})
+    ->Args({1000, 120});
+BENCHMARK(BM_VisibleSegmentsOrbitMultipleSpheresSphereSet)
+    ->Args({1000, 20})
+    ->Args({1000, 120});
 
 }  // namespace geometry
 }  // namespace principia
@@ -34,6 +34,7 @@ using ksp_plugin::Barycentric;
 using ksp_plugin::Navigation;
 using ksp_plugin::NavigationFrame;
 using ksp_plugin::Planetarium;
+using ksp_plugin::PlottingCache;
 using physics::BodyCentredNonRotatingDynamicFrame;
 using physics::DegreesOfFreedom;
 using physics::DiscreteTrajectory;
@@ -160,7 +161,8 @@ class Satellites {
   }
 
   Planetarium MakePlanetarium(
-      Perspective<Navigation, Camera> const& perspective) const {
+      Perspective<Navigation, Camera> const& perspective,
+      PlottingCache* const plotting_cache = nullptr) const {
     // No dark area, human visual acuity, wide field of view.
     Planetarium::Parameters parameters(
         /*sphere_radius_multiplier=*/1,
@@ -169,7 +171,8 @@ class Satellites {
     return Planetarium(parameters,
                        perspective,
                        ephemeris_.get(),
-                       earth_centred_inertial_.get());
+                       earth_centred_inertial_.get(),
+                       plotting_cache);
   }
 
  private:
@@ -233,6 +236,42 @@ void RunBenchmark(benchmark::State& state,
                  DebugString(min_y) + ", " + DebugString(max_y) + "]");
 }
 
+// Simulates the plotting of a psychohistory at each frame of the game: a new
+// planetarium is created for each frame, and the plotted interval moves forward
+// by one step of the trajectory.
+void RunSteadyStateBenchmark(benchmark::State& state,
+                             Perspective<Navigation, Camera> const& perspective,
+                             bool const cached) {
+  Satellites satellites;
+  PlottingCache plotting_cache;
+  auto const& trajectory = satellites.goes_8_trajectory();
+  constexpr Time history_length = 10 * Day;
+  Instant const first_now = trajectory.begin()->time + history_length;
+  Instant now = first_now;
+  RP2Lines<Length, Camera> lines;
+  int points = 0;
+  while (state.KeepRunning()) {
+    plotting_cache.NewFrame();
+    Planetarium const planetarium = satellites.MakePlanetarium(
+        perspective, cached ? &plotting_cache : nullptr);
+    auto const last = trajectory.LowerBound(now);
+    auto end = last;
+    ++end;
+    lines = planetarium.PlotMethod2(trajectory.LowerBound(now - history_length),
+                                    end,
+                                    now,
+                                    /*reverse=*/true);
+    for (auto const& line : lines) {
+      points += line.size();
+    }
+    now = last->time + 10 * Second;
+    if (now > trajectory.back().time) {
+      now = first_now;
+    }
+  }
+  state.SetItemsProcessed(points);
+}
+
 void BM_PlanetariumPlotMethod2NearPolarPerspective(benchmark::State& state) {
   RunBenchmark(state, PolarPerspective(near));
 }
@@ -251,10 +290,29 @@ void BM_PlanetariumPlotMethod2FarEquatorialPerspective(
   RunBenchmark(state, EquatorialPerspective(far));
 }
 
+// The argument is 1 to use a |PlottingCache|, 0 otherwise.
+void BM_PlanetariumPlotMethod2SteadyStateNearPolarPerspective(
+    benchmark::State& state) {
+  RunSteadyStateBenchmark(
+      state, PolarPerspective(near), /*cached=*/state.range(0) != 0);
+}
+
+void BM_PlanetariumPlotMethod2SteadyStateFarEquatorialPerspective(
+    benchmark::State& state) {
+  RunSteadyStateBenchmark(
+      state, EquatorialPerspective(far), /*cached=*/state.range(0) != 0);
+}
+
 BENCHMARK(BM_PlanetariumPlotMethod2NearPolarPerspective);
 BENCHMARK(BM_PlanetariumPlotMethod2FarPolarPerspective);
 BENCHMARK(BM_PlanetariumPlotMethod2NearEquatorialPerspective);
 BENCHMARK(BM_PlanetariumPlotMethod2FarEquatorialPerspective);
+BENCHMARK(BM_PlanetariumPlotMethod2SteadyStateNearPolarPerspective)
+    ->Arg(0)
+    ->Arg(1);
+BENCHMARK(BM_PlanetariumPlotMethod2SteadyStateFarEquatorialPerspective)
+    ->Arg(0)
+    ->Arg(1);
 
 }  // namespace geometry
 }  // namespace principia
@@ -97,6 +97,51 @@ void BM_ThreadPoolExclusiveLock(benchmark::State& state) {
   }
 }
 
+// Small tasks, where the cost of the scheduling dominates.  Reports the number
+// of tasks per second.
+constexpr int small_tasks = 100'000;
+constexpr std::int64_t small_task_work = 100;
+
+void BM_ThreadPoolSmallTasksFutures(benchmark::State& state) {
+  ThreadPool<void> pool(/*pool_size=*/state.range_x());
+  for (auto _ : state) {
+    std::vector<std::future<void>> futures;
+    futures.reserve(small_tasks);
+    for (int i = 0; i < small_tasks; ++i) {
+      futures.push_back(pool.Add([]() {
+        double result = 0;
+        for (int i = 0; i < small_task_work; ++i) {
+          result += std::sqrt(i);
+        }
+        benchmark::DoNotOptimize(result);
+      }));
+    }
+    for (auto const& future : futures) {
+      future.wait();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * small_tasks);
+}
+
+void BM_ThreadPoolSmallTasksBatch(benchmark::State& state) {
+  ThreadPool<void> pool(/*pool_size=*/state.range_x());
+  for (auto _ : state) {
+    auto batch = pool.NewBatch();
+    batch.Reserve(small_tasks);
+    for (int i = 0; i < small_tasks; ++i) {
+      batch.Add([]() {
+        double result = 0;
+        for (int i = 0; i < small_task_work; ++i) {
+          result += std::sqrt(i);
+        }
+        benchmark::DoNotOptimize(result);
+      });
+    }
+    batch.SubmitAndJoin();
+  }
+  state.SetItemsProcessed(state.iterations() * small_tasks);
+}
+
 BENCHMARK(BM_ThreadPoolNoLock)
     ->Arg(1)
     ->Arg(2)
@@ -124,6 +169,18 @@ BENCHMARK(BM_ThreadPoolExclusiveLock)
     ->Arg(6)
     ->Arg(7)
     ->Arg(8);
+BENCHMARK(BM_ThreadPoolSmallTasksFutures)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->Arg(16);
+BENCHMARK(BM_ThreadPoolSmallTasksBatch)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->Arg(16);
 
 }  // namespace base
 }  // namespace principia
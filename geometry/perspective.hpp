@@ -1,6 +1,7 @@
 ﻿
 #pragma once
 
+#include <cstdint>
 #include <optional>
 #include <utility>
 #include <vector>
@@ -12,6 +13,7 @@
 #include "geometry/point.hpp"
 #include "geometry/rp2_point.hpp"
 #include "geometry/sphere.hpp"
+#include "geometry/sphere_set.hpp"
 #include "quantities/quantities.hpp"
 
 namespace principia {
@@ -78,7 +80,21 @@ class Perspective final {
       Segment<FromFrame> const& segment,
       std::vector<Sphere<FromFrame>> const& spheres) const;
 
+  // Same as above, but the spheres whose tangent cone from the camera doesn't
+  // intersect the cone containing |segment| are culled in a vectorized pass
+  // before the exact computation, which is only done for the remaining ones.
+  Segments<FromFrame> VisibleSegments(
+      Segment<FromFrame> const& segment,
+      SphereSet<FromFrame> const& spheres) const;
+
  private:
+  // Applies the hiding by the spheres |sphere_at(0)|, ...,
+  // |sphere_at(number_of_spheres - 1)|, in that order, to |segment|.
+  template<typename SphereAt>
+  Segments<FromFrame> VisibleSegments(Segment<FromFrame> const& segment,
+                                      std::int64_t number_of_spheres,
+                                      SphereAt const& sphere_at) const;
+
   RigidTransformation<ToFrame, FromFrame> const from_camera_;
   RigidTransformation<FromFrame, ToFrame> const to_camera_;
   Position<FromFrame> const camera_;
@@ -359,6 +359,67 @@ template<typename FromFrame, typename ToFrame>
 Segments<FromFrame> Perspective<FromFrame, ToFrame>::VisibleSegments(
     Segment<FromFrame> const& segment,
     std::vector<Sphere<FromFrame>> const& spheres) const {
+  return VisibleSegments(
+      segment,
+      spheres.size(),
+      [&spheres](std::int64_t const i) -> Sphere<FromFrame> const& {
+        return spheres[i];
+      });
+}
+
+template<typename FromFrame, typename ToFrame>
+Segments<FromFrame> Perspective<FromFrame, ToFrame>::VisibleSegments(
+    Segment<FromFrame> const& segment,
+    SphereSet<FromFrame> const& spheres) const {
+  if (spheres.empty()) {
+    return {segment};
+  }
+
+  // The segment AB is contained in the cone whose apex is the camera K, whose
+  // axis is the bisector of the angle AKB, and whose half-angle θ is half of
+  // that angle.  If a and b are the unit vectors along KA and KB, a + b is
+  // along the axis and has norm 2 cos θ, and a - b has norm 2 sin θ.
+  std::vector<int> indices;
+  Displacement<FromFrame> const KA = segment.first - camera_;
+  Displacement<FromFrame> const KB = segment.second - camera_;
+  auto const KA_norm = KA.Norm();
+  auto const KB_norm = KB.Norm();
+  Vector<double, FromFrame> const a = KA / KA_norm;
+  Vector<double, FromFrame> const b = KB / KB_norm;
+  Vector<double, FromFrame> const a_plus_b = a + b;
+  double const a_plus_b_norm = a_plus_b.Norm();
+  double const cos_θ = 0.5 * a_plus_b_norm;
+  double const sin_θ = 0.5 * (a - b).Norm();
+  // If the camera is on the segment or at one of its extremities, there is no
+  // such cone, and all the spheres must be considered.  The comparison is
+  // false for NaNs.
+  if (cos_θ > 0) {
+    indices.reserve(spheres.size());
+    spheres.SelectSpheresIntersectingCone(
+        camera_, a_plus_b / a_plus_b_norm, cos_θ, sin_θ, indices);
+  } else {
+    indices.resize(spheres.size());
+    for (int i = 0; i < indices.size(); ++i) {
+      indices[i] = i;
+    }
+  }
+
+  auto const& all_spheres = spheres.spheres();
+  return VisibleSegments(
+      segment,
+      indices.size(),
+      [&all_spheres, &indices](std::int64_t const i)
+          -> Sphere<FromFrame> const& {
+        return all_spheres[indices[i]];
+      });
+}
+
+template<typename FromFrame, typename ToFrame>
+template<typename SphereAt>
+Segments<FromFrame> Perspective<FromFrame, ToFrame>::VisibleSegments(
+    Segment<FromFrame> const& segment,
+    std::int64_t const number_of_spheres,
+    SphereAt const& sphere_at) const {
   // This algorithm takes the input segment, applies the hiding by the first
   // sphere (which can result in 0, 1, or 2 segments), applies the hiding by the
   // second sphere to the resulting segments, and so on.  To reduce memory
@@ -366,7 +427,7 @@ Segments<FromFrame> Perspective<FromFrame, ToFrame>::VisibleSegments(
   // reserve the maximum possible size.  As hiding proceeds, segments are taken
   // from the vector and replaced or appended as needed.
   Segments<FromFrame> segments;
-  segments.reserve(spheres.size() + 1);
+  segments.reserve(number_of_spheres + 1);
   segments.push_back(segment);
 
   // The range [in_begin, in_end[ contains the segments that have been produced
@@ -389,7 +450,8 @@ Segments<FromFrame> Perspective<FromFrame, ToFrame>::VisibleSegments(
   // are stored in a contiguous slice of the vector segments.  That slice
   // doesn't start at 0 iff at least one call to VisibleSegments returned 0
   // segments.
-  for (auto const& sphere : spheres) {
+  for (std::int64_t s = 0; s < number_of_spheres; ++s) {
+    Sphere<FromFrame> const& sphere = sphere_at(s);
     for (int i = in_end - 1; i >= in_begin; --i) {
       auto const& old_segment = segments[i];
       auto const new_segments_for_sphere = VisibleSegments(old_segment, sphere);
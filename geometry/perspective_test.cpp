@@ -1,5 +1,7 @@
 ﻿
 #include <limits>
+#include <random>
+#include <vector>
 
 #include "geometry/affine_map.hpp"
 #include "geometry/frame.hpp"
@@ -9,6 +11,7 @@
 #include "geometry/rotation.hpp"
 #include "geometry/rp2_point.hpp"
 #include "geometry/sphere.hpp"
+#include "geometry/sphere_set.hpp"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "quantities/elementary_functions.hpp"
@@ -618,6 +621,52 @@ TEST_F(VisibleSegmentsTest, MultipleSpheres) {
               SizeIs(3));
 }
 
+TEST_F(VisibleSegmentsTest, SphereSet) {
+  // Many spheres scattered around, some of which contain the camera.
+  std::mt19937_64 random(42);
+  std::uniform_real_distribution<> coordinate_distribution(-20.0, 20.0);
+  std::uniform_real_distribution<> radius_distribution(0.1, 3.0);
+  auto const random_position = [&coordinate_distribution, &random]() {
+    return World::origin +
+           Displacement<World>({coordinate_distribution(random) * Metre,
+                                coordinate_distribution(random) * Metre,
+                                coordinate_distribution(random) * Metre});
+  };
+  std::vector<Sphere<World>> spheres;
+  for (int i = 0; i < 101; ++i) {
+    spheres.emplace_back(random_position(),
+                         radius_distribution(random) * Metre);
+  }
+  spheres.emplace_back(camera_origin_, /*radius=*/1 * Metre);
+  SphereSet<World> const sphere_set(spheres);
+
+  // The culling doesn't change the result.
+  int hidden = 0;
+  for (int i = 0; i < 1000; ++i) {
+    Segment<World> const segment{random_position(), random_position()};
+    auto const visible_segments =
+        perspective_.VisibleSegments(segment, spheres);
+    EXPECT_EQ(visible_segments,
+              perspective_.VisibleSegments(segment, sphere_set)) << i;
+    hidden += visible_segments.empty();
+  }
+  EXPECT_EQ(1000, hidden);
+
+  // Same without the sphere that contains the camera.
+  spheres.pop_back();
+  SphereSet<World> const outside_sphere_set(spheres);
+  hidden = 0;
+  for (int i = 0; i < 1000; ++i) {
+    Segment<World> const segment{random_position(), random_position()};
+    auto const visible_segments =
+        perspective_.VisibleSegments(segment, spheres);
+    EXPECT_EQ(visible_segments,
+              perspective_.VisibleSegments(segment, outside_sphere_set)) << i;
+    hidden += visible_segments.empty();
+  }
+  EXPECT_GT(1000, hidden);
+}
+
 }  // namespace internal_perspective
 }  // namespace geometry
 }  // namespace principia
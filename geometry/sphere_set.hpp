@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "geometry/grassmann.hpp"
+#include "geometry/named_quantities.hpp"
+#include "geometry/sphere.hpp"
+
+namespace principia {
+namespace geometry {
+namespace internal_sphere_set {
+
+// A set of spheres with a structure-of-arrays copy of their centres and radii.
+// The coordinates are stored as SI magnitudes in separate arrays so that a
+// test may be applied to several spheres at once.
+template<typename Frame>
+class SphereSet final {
+ public:
+  SphereSet() = default;
+  explicit SphereSet(std::vector<Sphere<Frame>> spheres);
+
+  std::vector<Sphere<Frame>> const& spheres() const;
+  std::size_t size() const;
+  bool empty() const;
+
+  // Appends to |indices|, in increasing order, the indices of the spheres that
+  // may intersect the cone with the given |apex|, unit |axis| and half-angle θ,
+  // which must be at most π / 2.  The test is conservative: a sphere that is
+  // not selected is entirely outside of the cone, with some margin for
+  // rounding errors.  The spheres that contain the |apex| are always selected.
+  void SelectSpheresIntersectingCone(Position<Frame> const& apex,
+                                     Vector<double, Frame> const& axis,
+                                     double cos_θ,
+                                     double sin_θ,
+                                     std::vector<int>& indices) const;
+
+ private:
+  std::vector<Sphere<Frame>> spheres_;
+  // The coordinates of the centres and the radii, in metres.
+  std::vector<double> x_;
+  std::vector<double> y_;
+  std::vector<double> z_;
+  std::vector<double> radius_;
+};
+
+// The frame-independent kernel.  Processes the |size| spheres whose centres
+// and radii are given by |x|, |y|, |z|, |radius|, and appends to |indices|
+// those that may intersect the cone with apex |apex_x|, |apex_y|, |apex_z|,
+// unit axis |axis_x|, |axis_y|, |axis_z| and half-angle θ.  All quantities are
+// SI magnitudes.
+inline void SelectSpheresIntersectingConeKernel(double apex_x,
+                                                double apex_y,
+                                                double apex_z,
+                                                double axis_x,
+                                                double axis_y,
+                                                double axis_z,
+                                                double cos_θ,
+                                                double sin_θ,
+                                                std::size_t size,
+                                                double const* x,
+                                                double const* y,
+                                                double const* z,
+                                                double const* radius,
+                                                std::vector<int>& indices);
+
+}  // namespace internal_sphere_set
+
+using internal_sphere_set::SphereSet;
+
+}  // namespace geometry
+}  // namespace principia
+
+#include "geometry/sphere_set_body.hpp"
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "geometry/sphere_set.hpp"
+
+#include <pmmintrin.h>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "base/macros.hpp"
+#include "quantities/si.hpp"
+
+namespace principia {
+namespace geometry {
+namespace internal_sphere_set {
+
+using quantities::Length;
+namespace si = quantities::si;
+
+// The relative margin by which a sphere must be outside of a cone to be
+// rejected.  This is much larger than the rounding errors of the kernel, and
+// of those of the exact computations done by the clients on the selected
+// spheres.
+constexpr double cone_tolerance = 0x1.0p-30;
+
+template<typename Frame>
+SphereSet<Frame>::SphereSet(std::vector<Sphere<Frame>> spheres)
+    : spheres_(std::move(spheres)) {
+  x_.reserve(spheres_.size());
+  y_.reserve(spheres_.size());
+  z_.reserve(spheres_.size());
+  radius_.reserve(spheres_.size());
+  for (auto const& sphere : spheres_) {
+    auto const centre = (sphere.centre() - Frame::origin).coordinates();
+    x_.push_back(centre.x / si::Unit<Length>);
+    y_.push_back(centre.y / si::Unit<Length>);
+    z_.push_back(centre.z / si::Unit<Length>);
+    radius_.push_back(sphere.radius() / si::Unit<Length>);
+  }
+}
+
+template<typename Frame>
+std::vector<Sphere<Frame>> const& SphereSet<Frame>::spheres() const {
+  return spheres_;
+}
+
+template<typename Frame>
+std::size_t SphereSet<Frame>::size() const {
+  return spheres_.size();
+}
+
+template<typename Frame>
+bool SphereSet<Frame>::empty() const {
+  return spheres_.empty();
+}
+
+template<typename Frame>
+void SphereSet<Frame>::SelectSpheresIntersectingCone(
+    Position<Frame> const& apex,
+    Vector<double, Frame> const& axis,
+    double const cos_θ,
+    double const sin_θ,
+    std::vector<int>& indices) const {
+  auto const a = (apex - Frame::origin).coordinates();
+  auto const u = axis.coordinates();
+  SelectSpheresIntersectingConeKernel(a.x / si::Unit<Length>,
+                                      a.y / si::Unit<Length>,
+                                      a.z / si::Unit<Length>,
+                                      u.x, u.y, u.z,
+                                      cos_θ,
+                                      sin_θ,
+                                      x_.size(),
+                                      x_.data(), y_.data(), z_.data(),
+                                      radius_.data(),
+                                      indices);
+}
+
+inline void SelectSpheresIntersectingConeKernel(double const apex_x,
+                                                double const apex_y,
+                                                double const apex_z,
+                                                double const axis_x,
+                                                double const axis_y,
+                                                double const axis_z,
+                                                double const cos_θ,
+                                                double const sin_θ,
+                                                std::size_t const size,
+                                                double const* const x,
+                                                double const* const y,
+                                                double const* const z,
+                                                double const* const radius,
+                                                std::vector<int>& indices) {
+  // Let K be the apex, C the centre of a sphere of radius R, d = |KC|, and ɑ
+  // the half-angle of the cone tangent to the sphere with apex K, such that
+  // sin ɑ = R / d.  The sphere is outside of the cone of half-angle θ iff the
+  // angle φ between the axis and KC is greater than θ + ɑ, which is at most π.
+  // Multiplying the cosines by d, this is equivalent to:
+  //   axis·KC < h cos θ - R sin θ
+  // where h = √(d² - R²) is the distance from K to the horizon of the sphere.
+  // The margin is proportional to h + R ≥ d.  When d ≤ R, the apex is inside
+  // of the sphere, h² ≤ 0, and the sphere is always selected.
+  std::size_t i = 0;
+
+#if PRINCIPIA_USE_SSE3_INTRINSICS
+  // Two spheres per iteration.  SSE2 is part of x86-64, so no runtime dispatch
+  // is needed.  The comparisons are negated so that NaNs cause the spheres to
+  // be selected, like in the scalar loop below.
+  __m128d const apex_x_128d = _mm_set1_pd(apex_x);
+  __m128d const apex_y_128d = _mm_set1_pd(apex_y);
+  __m128d const apex_z_128d = _mm_set1_pd(apex_z);
+  __m128d const axis_x_128d = _mm_set1_pd(axis_x);
+  __m128d const axis_y_128d = _mm_set1_pd(axis_y);
+  __m128d const axis_z_128d = _mm_set1_pd(axis_z);
+  __m128d const cos_θ_128d = _mm_set1_pd(cos_θ);
+  __m128d const sin_θ_128d = _mm_set1_pd(sin_θ);
+  __m128d const tolerance_128d = _mm_set1_pd(cone_tolerance);
+  __m128d const zero_128d = _mm_setzero_pd();
+  for (; i + 2 <= size; i += 2) {
+    __m128d const KCx = _mm_sub_pd(_mm_loadu_pd(x + i), apex_x_128d);
+    __m128d const KCy = _mm_sub_pd(_mm_loadu_pd(y + i), apex_y_128d);
+    __m128d const KCz = _mm_sub_pd(_mm_loadu_pd(z + i), apex_z_128d);
+    __m128d const R = _mm_loadu_pd(radius + i);
+
+    __m128d const KC² = _mm_add_pd(
+        _mm_add_pd(_mm_mul_pd(KCx, KCx), _mm_mul_pd(KCy, KCy)),
+        _mm_mul_pd(KCz, KCz));
+    __m128d const h² = _mm_sub_pd(KC², _mm_mul_pd(R, R));
+    __m128d const h = _mm_sqrt_pd(_mm_max_pd(h², zero_128d));
+    __m128d const axisKC = _mm_add_pd(
+        _mm_add_pd(_mm_mul_pd(axis_x_128d, KCx), _mm_mul_pd(axis_y_128d, KCy)),
+        _mm_mul_pd(axis_z_128d, KCz));
+
+    __m128d const lhs = _mm_add_pd(
+        axisKC, _mm_mul_pd(tolerance_128d, _mm_add_pd(h, R)));
+    __m128d const rhs = _mm_sub_pd(_mm_mul_pd(h, cos_θ_128d),
+                                   _mm_mul_pd(R, sin_θ_128d));
+    int const selected = _mm_movemask_pd(
+        _mm_or_pd(_mm_cmpngt_pd(h², zero_128d), _mm_cmpnlt_pd(lhs, rhs)));
+    if (selected & 0b01) {
+      indices.push_back(i);
+    }
+    if (selected & 0b10) {
+      indices.push_back(i + 1);
+    }
+  }
+#endif
+
+  for (; i < size; ++i) {
+    double const KCx = x[i] - apex_x;
+    double const KCy = y[i] - apex_y;
+    double const KCz = z[i] - apex_z;
+    double const R = radius[i];
+
+    double const KC² = KCx * KCx + KCy * KCy + KCz * KCz;
+    double const h² = KC² - R * R;
+    double const h = std::sqrt(std::max(h², 0.0));
+    double const axisKC = axis_x * KCx + axis_y * KCy + axis_z * KCz;
+
+    double const lhs = axisKC + cone_tolerance * (h + R);
+    double const rhs = h * cos_θ - R * sin_θ;
+    if (!(h² > 0) || !(lhs < rhs)) {
+      indices.push_back(i);
+    }
+  }
+}
+
+}  // namespace internal_sphere_set
+}  // namespace geometry
+}  // namespace principia
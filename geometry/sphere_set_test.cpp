@@ -0,0 +1,134 @@
+#include "geometry/sphere_set.hpp"
+
+#include <random>
+#include <vector>
+
+#include "geometry/frame.hpp"
+#include "geometry/grassmann.hpp"
+#include "geometry/named_quantities.hpp"
+#include "geometry/sphere.hpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "quantities/elementary_functions.hpp"
+#include "quantities/numbers.hpp"
+#include "quantities/quantities.hpp"
+#include "quantities/si.hpp"
+
+namespace principia {
+namespace geometry {
+
+using quantities::Angle;
+using quantities::ArcSin;
+using quantities::Cos;
+using quantities::Length;
+using quantities::Sin;
+using quantities::si::Metre;
+using quantities::si::Radian;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+class SphereSetTest : public ::testing::Test {
+ protected:
+  using World = Frame<enum class WorldTag, Inertial>;
+
+  Position<World> RandomPosition() {
+    std::uniform_real_distribution<> distribution(-100.0, 100.0);
+    return World::origin +
+           Displacement<World>({distribution(random_) * Metre,
+                                distribution(random_) * Metre,
+                                distribution(random_) * Metre});
+  }
+
+  std::mt19937_64 random_{42};
+};
+
+TEST_F(SphereSetTest, Empty) {
+  SphereSet<World> const sphere_set;
+  EXPECT_TRUE(sphere_set.empty());
+  std::vector<int> indices;
+  sphere_set.SelectSpheresIntersectingCone(
+      World::origin,
+      Vector<double, World>({1, 0, 0}),
+      /*cos_θ=*/1,
+      /*sin_θ=*/0,
+      indices);
+  EXPECT_THAT(indices, IsEmpty());
+}
+
+TEST_F(SphereSetTest, Simple) {
+  // A cone along the x-axis with a half-angle of 45°.
+  std::vector<Sphere<World>> spheres;
+  // In the cone.
+  spheres.emplace_back(
+      World::origin + Displacement<World>({10 * Metre, 0 * Metre, 0 * Metre}),
+      /*radius=*/1 * Metre);
+  // Behind the apex.
+  spheres.emplace_back(
+      World::origin + Displacement<World>({-10 * Metre, 0 * Metre, 0 * Metre}),
+      /*radius=*/1 * Metre);
+  // Contains the apex.
+  spheres.emplace_back(
+      World::origin + Displacement<World>({-1 * Metre, 0 * Metre, 0 * Metre}),
+      /*radius=*/2 * Metre);
+  // Outside of the cone, but intersecting the plane orthogonal to the axis.
+  spheres.emplace_back(
+      World::origin + Displacement<World>({1 * Metre, 10 * Metre, 0 * Metre}),
+      /*radius=*/2 * Metre);
+  // Straddling the boundary of the cone.
+  spheres.emplace_back(
+      World::origin + Displacement<World>({10 * Metre, 11 * Metre, 0 * Metre}),
+      /*radius=*/1 * Metre);
+  SphereSet<World> const sphere_set(spheres);
+  EXPECT_EQ(5, sphere_set.size());
+
+  std::vector<int> indices;
+  sphere_set.SelectSpheresIntersectingCone(
+      World::origin,
+      Vector<double, World>({1, 0, 0}),
+      /*cos_θ=*/Cos(π / 4 * Radian),
+      /*sin_θ=*/Sin(π / 4 * Radian),
+      indices);
+  EXPECT_THAT(indices, ElementsAre(0, 2, 4));
+}
+
+TEST_F(SphereSetTest, Random) {
+  std::uniform_real_distribution<> radius_distribution(0.1, 30.0);
+  std::uniform_real_distribution<> angle_distribution(0.0, π / 2);
+  std::vector<Sphere<World>> spheres;
+  for (int i = 0; i < 101; ++i) {
+    spheres.emplace_back(RandomPosition(),
+                         radius_distribution(random_) * Metre);
+  }
+  SphereSet<World> const sphere_set(spheres);
+
+  // The selection is conservative, and only keeps the spheres that are close
+  // to the cone.
+  for (int i = 0; i < 100; ++i) {
+    Position<World> const apex = RandomPosition();
+    Vector<double, World> const axis = Normalize(RandomPosition() - apex);
+    Angle const θ = angle_distribution(random_) * Radian;
+    std::vector<int> indices;
+    sphere_set.SelectSpheresIntersectingCone(
+        apex, axis, Cos(θ), Sin(θ), indices);
+    int j = 0;
+    for (int k = 0; k < spheres.size(); ++k) {
+      Displacement<World> const KC = spheres[k].centre() - apex;
+      Length const d = KC.Norm();
+      bool const contains_apex = d <= spheres[k].radius();
+      Angle const φ = AngleBetween(axis, KC);
+      if (j < indices.size() && indices[j] == k) {
+        ++j;
+        EXPECT_TRUE(contains_apex ||
+                    φ <= θ + ArcSin(spheres[k].radius() / d) + 1e-6 * Radian)
+            << i << " " << k;
+      } else {
+        EXPECT_FALSE(contains_apex) << i << " " << k;
+        EXPECT_GT(φ, θ + ArcSin(spheres[k].radius() / d)) << i << " " << k;
+      }
+    }
+    EXPECT_EQ(indices.size(), j);
+  }
+}
+
+}  // namespace geometry
+}  // namespace principia
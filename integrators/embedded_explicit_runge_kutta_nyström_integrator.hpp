@@ -116,6 +116,20 @@ class EmbeddedExplicitRungeKuttaNyströmIntegrator
              EmbeddedExplicitRungeKuttaNyströmIntegrator const& integrator);
 
     EmbeddedExplicitRungeKuttaNyströmIntegrator const& integrator_;
+
+    // The buffers used by |Solve|.  They are kept across calls so that, once
+    // they have been sized for the dimension of the problem, |Solve| doesn't
+    // allocate.  Their contents are meaningless between calls.
+    std::vector<typename ODE::Displacement> Δq̂_;
+    std::vector<typename ODE::Velocity> Δv̂_;
+    typename ODE::SystemStateError error_estimate_;
+    std::vector<Position> q_stage_;
+    // TODO(egg): this is a rectangular container, use something more
+    // appropriate.
+    std::vector<std::vector<typename ODE::Acceleration>> g_;
+    // The state before the last, truncated step.
+    typename ODE::SystemState final_state_;
+
     friend class EmbeddedExplicitRungeKuttaNyströmIntegrator;
   };
 
@@ -9,6 +9,8 @@
 #include "base/get_line.hpp"
 #include "base/hexadecimal.hpp"
 #include "base/version.hpp"
+#include "gipfeli/gipfeli.h"
+#include "google/protobuf/io/coded_stream.h"
 #include "journal/profiles.hpp"
 #include "glog/logging.h"
 
@@ -18,14 +20,56 @@ using base::GetLine;
 using base::Version;
 using base::HexadecimalEncoder;
 using base::UniqueArray;
+using google::protobuf::io::CodedInputStream;
 using interface::principia__ActivatePlayer;
 
 namespace journal {
 
+namespace {
+
+// The size of the reads from uncompressed binary journals.
+constexpr std::size_t chunk_size = 1 << 16;
+
+// Reads a varint from |stream|.  Returns false at end of stream.
+bool ReadVarint32(std::ifstream& stream, std::uint32_t& value) {
+  value = 0;
+  for (int shift = 0;; shift += 7) {
+    CHECK_LT(shift, 32) << "Malformed varint";
+    int const byte = stream.get();
+    if (byte == std::ifstream::traits_type::eof()) {
+      CHECK_EQ(0, shift) << "Truncated varint";
+      return false;
+    }
+    value |= static_cast<std::uint32_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+}
+
+}  // namespace
+
 Player::Player(std::filesystem::path const& path)
-    : stream_(path, std::ios::in) {
+    : stream_(path, std::ios::in | std::ios::binary) {
   principia__ActivatePlayer();
-  CHECK(!stream_.fail());
+  CHECK(!stream_.fail()) << path;
+  if (stream_.peek() == binary_journal_magic.front()) {
+    std::string magic(binary_journal_magic.size(), '\0');
+    stream_.read(magic.data(), magic.size());
+    CHECK_EQ(binary_journal_magic, magic) << path;
+    format_ = static_cast<Recorder::Format>(stream_.get());
+    CHECK(format_ == Recorder::Format::Binary ||
+          format_ == Recorder::Format::CompressedBinary)
+        << static_cast<int>(format_);
+    if (format_ == Recorder::Format::CompressedBinary) {
+      compressor_ = google::compression::NewGipfeliCompressor();
+    }
+  } else {
+    // A hexadecimal journal was written in text mode.
+    stream_.close();
+    stream_.open(path, std::ios::in);
+    CHECK(!stream_.fail()) << path;
+  }
 }
 
 bool Player::Play(int const index) {
@@ -86,6 +130,14 @@ serialization::Method const& Player::last_method_out_return() const {
 }
 
 std::unique_ptr<serialization::Method> Player::Read() {
+  if (format_ == Recorder::Format::Hexadecimal) {
+    return ReadHexadecimal();
+  } else {
+    return ReadBinary();
+  }
+}
+
+std::unique_ptr<serialization::Method> Player::ReadHexadecimal() {
   std::string const line = GetLine(stream_);
   if (line.empty()) {
     return nullptr;
@@ -99,5 +151,58 @@ std::unique_ptr<serialization::Method> Player::Read() {
   return method;
 }
 
+std::unique_ptr<serialization::Method> Player::ReadBinary() {
+  for (;;) {
+    auto const* const data =
+        reinterpret_cast<std::uint8_t const*>(buffer_.data()) + buffer_position_;
+    int const available = static_cast<int>(buffer_.size() - buffer_position_);
+    CodedInputStream input(data, available);
+    std::uint32_t size;
+    if (input.ReadVarint32(&size) &&
+        input.CurrentPosition() + static_cast<std::int64_t>(size) <=
+            available) {
+      auto method = std::make_unique<serialization::Method>();
+      CHECK(method->ParseFromArray(data + input.CurrentPosition(),
+                                   static_cast<int>(size)));
+      buffer_position_ += input.CurrentPosition() + size;
+      return method;
+    }
+    // The buffer doesn't contain a complete message.
+    if (!FillBuffer()) {
+      // A journal may be truncated if the process crashed.
+      LOG_IF(ERROR, available > 0)
+          << "Ignoring " << available << " bytes at end of journal";
+      return nullptr;
+    }
+  }
+}
+
+bool Player::FillBuffer() {
+  buffer_.erase(0, buffer_position_);
+  buffer_position_ = 0;
+  if (format_ == Recorder::Format::CompressedBinary) {
+    std::uint32_t compressed_size;
+    if (!ReadVarint32(stream_, compressed_size)) {
+      return false;
+    }
+    std::string compressed(compressed_size, '\0');
+    stream_.read(compressed.data(), compressed_size);
+    if (stream_.gcount() != static_cast<std::streamsize>(compressed_size)) {
+      LOG(ERROR) << "Truncated block of size " << compressed_size;
+      return false;
+    }
+    std::string uncompressed;
+    CHECK(compressor_->Uncompress(compressed, &uncompressed));
+    buffer_.append(uncompressed);
+    return true;
+  } else {
+    std::size_t const size = buffer_.size();
+    buffer_.resize(size + chunk_size);
+    stream_.read(buffer_.data() + size, chunk_size);
+    buffer_.resize(size + stream_.gcount());
+    return stream_.gcount() > 0;
+  }
+}
+
 }  // namespace journal
 }  // namespace principia
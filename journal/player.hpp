@@ -5,7 +5,10 @@
 #include <fstream>
 #include <map>
 #include <memory>
+#include <string>
 
+#include "gipfeli/compression.h"
+#include "journal/recorder.hpp"
 #include "serialization/journal.pb.h"
 
 #define PRINCIPIA_PLAYER_ALLOW_VERSION_MISMATCH 0
@@ -17,6 +20,7 @@ class Player final {
  public:
   using PointerMap = std::map<std::uint64_t, void*>;
 
+  // The format of the journal is detected from its first bytes.
   explicit Player(std::filesystem::path const& path);
 
   // Replays the next message in the journal.  Returns false at end of journal.
@@ -30,14 +34,27 @@ class Player final {
  private:
   // Reads one message from the stream.  Returns a |nullptr| at end of stream.
   std::unique_ptr<serialization::Method> Read();
+  std::unique_ptr<serialization::Method> ReadHexadecimal();
+  std::unique_ptr<serialization::Method> ReadBinary();
+
+  // Appends bytes from the stream to |buffer_|, uncompressing them if needed.
+  // Returns false at end of stream.
+  bool FillBuffer();
 
   template<typename Profile>
   bool RunIfAppropriate(serialization::Method const& method_in,
                         serialization::Method const& method_out_return);
 
   PointerMap pointer_map_;
+  Recorder::Format format_ = Recorder::Format::Hexadecimal;
   std::ifstream stream_;
 
+  // Only used by the binary formats.  The bytes of |buffer_| before
+  // |buffer_position_| have already been parsed.
+  std::unique_ptr<google::compression::Compressor> compressor_;
+  std::string buffer_;
+  std::size_t buffer_position_ = 0;
+
   std::unique_ptr<serialization::Method> last_method_in_;
   std::unique_ptr<serialization::Method> last_method_out_return_;
 
@@ -1,26 +1,70 @@
 ﻿
 #include "journal/recorder.hpp"
 
+#include <chrono>
 #include <filesystem>
 
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "base/array.hpp"
 #include "base/hexadecimal.hpp"
 #include "base/serialization.hpp"
 #include "base/version.hpp"
+#include "gipfeli/gipfeli.h"
 #include "glog/logging.h"
+#include "google/protobuf/io/coded_stream.h"
 #include "journal/profiles.hpp"
 
 namespace principia {
 
+using base::Array;
 using base::HexadecimalEncoder;
+using base::RingBuffer;
 using base::SerializeAsBytes;
 using base::UniqueArray;
+using google::protobuf::io::CodedOutputStream;
 
 namespace journal {
 
-Recorder::Recorder(std::filesystem::path const& path)
-    : stream_(path, std::ios::out) {
+namespace {
+
+// Large enough that the calling threads practically never wait for the writer,
+// even when a plugin is serialized.
+constexpr std::int64_t ring_buffer_capacity = 1 << 24;
+// The size of the reads from the ring buffer.
+constexpr std::int64_t chunk_size = 1 << 16;
+// A compressed block is written when its uncompressed size reaches this value,
+// or when it has been pending for |block_period|.
+constexpr std::size_t block_size = 1 << 20;
+constexpr auto block_period = std::chrono::seconds(1);
+// How long the writer sleeps when the ring buffer is empty.
+constexpr absl::Duration drain_period = absl::Milliseconds(1);
+
+}  // namespace
+
+Recorder::Recorder(std::filesystem::path const& path, Format const format)
+    : format_(format),
+      stream_(path,
+              format == Format::Hexadecimal
+                  ? std::ios::out
+                  : std::ios::out | std::ios::binary) {
   CHECK(!stream_.fail()) << path;
+  if (format_ != Format::Hexadecimal) {
+    stream_.write(binary_journal_magic.data(), binary_journal_magic.size());
+    stream_.put(static_cast<char>(format_));
+    if (format_ == Format::CompressedBinary) {
+      compressor_ = google::compression::NewGipfeliCompressor();
+    }
+    ring_buffer_ = std::make_unique<RingBuffer>(ring_buffer_capacity);
+    writer_ = std::thread(&Recorder::Drain, this);
+  }
+}
+
+Recorder::~Recorder() {
+  if (writer_.joinable()) {
+    shutdown_ = true;
+    writer_.join();
+  }
 }
 
 void Recorder::WriteAtConstruction(serialization::Method const& method) {
@@ -62,6 +106,14 @@ bool Recorder::IsActivated() {
 }
 
 void Recorder::WriteLocked(serialization::Method const& method) {
+  if (format_ == Format::Hexadecimal) {
+    WriteHexadecimalLocked(method);
+  } else {
+    WriteBinaryLocked(method);
+  }
+}
+
+void Recorder::WriteHexadecimalLocked(serialization::Method const& method) {
   static auto* const encoder = new HexadecimalEncoder</*null_terminated=*/true>;
   CHECK_LT(0, method.ByteSize()) << method.DebugString();
   auto const hexadecimal = encoder->Encode(SerializeAsBytes(method).get());
@@ -69,6 +121,91 @@ void Recorder::WriteLocked(serialization::Method const& method) {
   stream_.flush();
 }
 
+void Recorder::WriteBinaryLocked(serialization::Method const& method) {
+  int const size = method.ByteSize();
+  CHECK_LT(0, size) << method.DebugString();
+  std::size_t const delimited_size =
+      CodedOutputStream::VarintSize32(static_cast<std::uint32_t>(size)) + size;
+  if (serialized_method_.size() < delimited_size) {
+    serialized_method_.resize(delimited_size);
+  }
+  std::uint8_t* const message = CodedOutputStream::WriteVarint32ToArray(
+      static_cast<std::uint32_t>(size), serialized_method_.data());
+  CHECK(method.SerializeToArray(message, size));
+
+  // Messages larger than the ring buffer go through it in pieces.  The writer
+  // never waits for us, so yielding is enough when the buffer is full.
+  Array<std::uint8_t const> bytes(serialized_method_.data(), delimited_size);
+  for (;;) {
+    std::int64_t const written = ring_buffer_->Write(bytes);
+    bytes.data += written;
+    bytes.size -= written;
+    if (bytes.size == 0) {
+      break;
+    }
+    std::this_thread::yield();
+  }
+}
+
+void Recorder::Drain() {
+  std::vector<std::uint8_t> chunk(chunk_size);
+  auto last_block_time = std::chrono::steady_clock::now();
+  for (;;) {
+    // Read |shutdown_| before draining, so that the bytes written before it
+    // was set are not lost.
+    bool const shutdown = shutdown_;
+
+    bool wrote = false;
+    for (;;) {
+      std::int64_t const size = ring_buffer_->Read(Array<std::uint8_t>(chunk));
+      if (size == 0) {
+        break;
+      }
+      if (format_ == Format::Binary) {
+        stream_.write(reinterpret_cast<char const*>(chunk.data()), size);
+        wrote = true;
+      } else {
+        uncompressed_block_.append(reinterpret_cast<char const*>(chunk.data()),
+                                   size);
+        if (uncompressed_block_.size() >= block_size) {
+          WriteBlock();
+          last_block_time = std::chrono::steady_clock::now();
+          wrote = true;
+        }
+      }
+    }
+
+    // The ring buffer is now empty, write what is left of a compressed block
+    // if it has been pending for too long.
+    if (!uncompressed_block_.empty() &&
+        (shutdown ||
+         std::chrono::steady_clock::now() - last_block_time >= block_period)) {
+      WriteBlock();
+      last_block_time = std::chrono::steady_clock::now();
+      wrote = true;
+    }
+    if (wrote) {
+      stream_.flush();
+    }
+
+    if (shutdown) {
+      break;
+    }
+    absl::SleepFor(drain_period);
+  }
+}
+
+void Recorder::WriteBlock() {
+  compressor_->Compress(uncompressed_block_, &compressed_block_);
+  // A varint32 takes at most 5 bytes.
+  std::uint8_t header[5];
+  std::uint8_t const* const header_end = CodedOutputStream::WriteVarint32ToArray(
+      static_cast<std::uint32_t>(compressed_block_.size()), header);
+  stream_.write(reinterpret_cast<char const*>(header), header_end - header);
+  stream_.write(compressed_block_.data(), compressed_block_.size());
+  uncompressed_block_.clear();
+}
+
 Recorder* Recorder::active_recorder_ = nullptr;
 
 }  // namespace journal
@@ -1,11 +1,20 @@
 ﻿
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 #include "absl/synchronization/mutex.h"
 #include "base/not_null.hpp"
+#include "base/ring_buffer.hpp"
+#include "gipfeli/compression.h"
 #include "serialization/journal.pb.h"
 
 namespace principia {
@@ -13,9 +22,34 @@ namespace journal {
 
 FORWARD_DECLARE_FROM(method, template<typename Profile> class, Method);
 
+// The first bytes of a journal in one of the binary formats.  They are
+// followed by one byte giving the |Recorder::Format|.  A journal in the
+// hexadecimal format cannot start with a null byte.
+constexpr std::string_view binary_journal_magic("\0PRINCIPIA", 10);
+
 class Recorder final {
  public:
-  explicit Recorder(std::filesystem::path const& path);
+  enum class Format : char {
+    // One hexadecimal-encoded message per line.  The messages are written and
+    // flushed by the calling thread, so the journal is complete even if the
+    // process crashes, but recording is slow.
+    Hexadecimal = 'H',
+    // Length-delimited binary messages.  The calling thread copies them to a
+    // ring buffer, and a background thread writes them to the file, flushing
+    // it whenever the buffer becomes empty.  If the process crashes, the
+    // messages recorded in the last millisecond or so may be lost.
+    Binary = 'B',
+    // Same as |Binary|, but the messages are grouped in blocks compressed with
+    // Gipfeli, which are written when they are large enough or at least every
+    // second.  Each block is preceded by its compressed size, as a varint.
+    CompressedBinary = 'C',
+  };
+
+  explicit Recorder(std::filesystem::path const& path,
+                    Format format = Format::Hexadecimal);
+
+  // Writes the messages that are still buffered.
+  ~Recorder();
 
   // Locking is used to ensure that the pairs of writes don't get intermixed.
   void WriteAtConstruction(serialization::Method const& method);
@@ -27,10 +61,33 @@ class Recorder final {
 
  private:
   void WriteLocked(serialization::Method const& method);
+  void WriteHexadecimalLocked(serialization::Method const& method);
+  void WriteBinaryLocked(serialization::Method const& method);
 
+  // The loop executed by |writer_|: moves the bytes from the |ring_buffer_| to
+  // the |stream_| until |shutdown_| is set and the |ring_buffer_| is empty.
+  void Drain();
+  // Compresses |uncompressed_block_| and writes it to the |stream_|.
+  void WriteBlock();
+
+  Format const format_;
   absl::Mutex lock_;
   std::ofstream stream_;
 
+  // The following members are only used by the binary formats.  When the
+  // recorder is in a binary format, the |stream_| is only accessed by the
+  // |writer_| after construction.
+  std::unique_ptr<base::RingBuffer> ring_buffer_;
+  // The serialization of the message being written, reused to avoid
+  // allocations.  Guarded by |lock_|.
+  std::vector<std::uint8_t> serialized_method_;
+  // Only accessed by the |writer_|.
+  std::unique_ptr<google::compression::Compressor> compressor_;
+  std::string uncompressed_block_;
+  std::string compressed_block_;
+  std::atomic<bool> shutdown_ = false;
+  std::thread writer_;
+
   static Recorder* active_recorder_;
 
   template<typename>
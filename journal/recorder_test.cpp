@@ -9,6 +9,7 @@
 #include "base/array.hpp"
 #include "base/hexadecimal.hpp"
 #include "base/version.hpp"
+#include "benchmark/benchmark.h"
 #include "gtest/gtest.h"
 #include "journal/method.hpp"
 #include "journal/profiles.hpp"
@@ -19,6 +20,27 @@
 namespace principia {
 namespace journal {
 
+// Measures the overhead of recording on the thread that makes the interface
+// calls.  In the binary formats the actual writing happens on another thread.
+void BM_RecordMethod(benchmark::State& state) {
+  auto const format = static_cast<Recorder::Format>(state.range(0));
+  std::unique_ptr<ksp_plugin::Plugin> plugin(
+      interface::principia__NewPlugin("MJD0", "MJD0", 0));
+  Recorder::Activate(new Recorder("BM_RecordMethod.journal", format));
+  for (auto _ : state) {
+    const ksp_plugin::Plugin* p = plugin.get();
+    Method<DeletePlugin> m({&p}, {&p});
+    m.Return();
+  }
+  Recorder::Deactivate();
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_RecordMethod)
+    ->Arg(static_cast<int>(Recorder::Format::Hexadecimal))
+    ->Arg(static_cast<int>(Recorder::Format::Binary))
+    ->Arg(static_cast<int>(Recorder::Format::CompressedBinary));
+
 class RecorderTest : public testing::Test {
  protected:
   RecorderTest()
@@ -143,5 +165,46 @@ TEST_F(RecorderTest, Recording) {
   }
 }
 
+TEST_F(RecorderTest, BinaryFormats) {
+  constexpr int iterations = 10'000;
+  // A message larger than the chunks in which binary journals are read.
+  std::string const long_epoch(100'000, '1');
+  Recorder::Deactivate();
+  for (auto const format : {Recorder::Format::Binary,
+                            Recorder::Format::CompressedBinary}) {
+    std::string const path =
+        test_name_ + "." + static_cast<char>(format) + ".journal";
+    Recorder::Activate(new Recorder(path, format));
+    for (int i = 0; i < iterations; ++i) {
+      const ksp_plugin::Plugin* plugin = plugin_.get();
+      Method<DeletePlugin> m({&plugin}, {&plugin});
+      m.Return();
+    }
+    {
+      Method<NewPlugin> m({long_epoch.c_str(), "2 s", 3});
+      m.Return(plugin_.get());
+    }
+    Recorder::Deactivate();
+
+    std::vector<serialization::Method> const methods = ReadAll(path);
+    ASSERT_EQ(2 * iterations + 4, methods.size());
+    EXPECT_TRUE(
+        methods.front().HasExtension(serialization::GetVersion::extension));
+    for (int i = 2; i < 2 * iterations + 2; ++i) {
+      EXPECT_TRUE(
+          methods[i].HasExtension(serialization::DeletePlugin::extension));
+    }
+    auto const& new_plugin =
+        methods[2 * iterations + 2].GetExtension(
+            serialization::NewPlugin::extension);
+    EXPECT_EQ(long_epoch, new_plugin.in().game_epoch());
+    EXPECT_TRUE(methods.back()
+                    .GetExtension(serialization::NewPlugin::extension)
+                    .has_return_());
+  }
+  // The fixture expects an active recorder.
+  Recorder::Activate(new Recorder(test_name_ + ".journal.hex"));
+}
+
 }  // namespace journal
 }  // namespace principia
@@ -2,13 +2,17 @@
 #include "ksp_plugin/flight_plan.hpp"
 
 #include <algorithm>
+#include <iterator>
 #include <optional>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include "base/jthread.hpp"
 #include "integrators/embedded_explicit_generalized_runge_kutta_nyström_integrator.hpp"
 #include "integrators/embedded_explicit_runge_kutta_nyström_integrator.hpp"
 #include "integrators/methods.hpp"
+#include "ksp_plugin/flight_plan_optimizer.hpp"
 #include "ksp_plugin/integrators.hpp"
 #include "testing_utilities/make_not_null.hpp"
 
@@ -19,6 +23,7 @@ namespace internal_flight_plan {
 using base::Error;
 using base::make_not_null_unique;
 using base::Status;
+using base::this_stoppable_thread;
 using geometry::Position;
 using geometry::Vector;
 using geometry::Velocity;
@@ -59,7 +64,9 @@ FlightPlan::FlightPlan(
       ephemeris_(ephemeris),
       adaptive_step_parameters_(std::move(adaptive_step_parameters)),
       generalized_adaptive_step_parameters_(
-          std::move(generalized_adaptive_step_parameters)) {
+          std::move(generalized_adaptive_step_parameters)),
+      recomputer_(PredictionService::Default(),
+                  [this]() { ComputeRequestedSegments(); }) {
   CHECK(desired_final_time_ >= initial_time_);
 
   // Set the (single) point of the root.
@@ -73,6 +80,8 @@ FlightPlan::FlightPlan(
   ComputeSegments(manœuvres_.begin(), manœuvres_.end());
 }
 
+FlightPlan::~FlightPlan() = default;
+
 Instant FlightPlan::initial_time() const {
   return initial_time_;
 }
@@ -113,23 +122,23 @@ Status FlightPlan::Insert(NavigationManœuvre::Burn const& burn,
                             start_of_burn(index))) {
     return DoesNotFit();
   }
+  CacheSegmentsAffectedByManœuvre(index);
   manœuvres_.insert(manœuvres_.begin() + index, manœuvre);
   coast_analysers_.insert(coast_analysers_.begin() + index + 1,
                           make_not_null_unique<OrbitAnalyser>(
                               ephemeris_, DefaultHistoryParameters()));
   UpdateInitialMassOfManœuvresAfter(index);
-  PopSegmentsAffectedByManœuvre(index);
-  return ComputeSegments(manœuvres_.begin() + index, manœuvres_.end());
+  return RecomputeSegmentsAffectedByManœuvre(index);
 }
 
 Status FlightPlan::Remove(int index) {
   CHECK_GE(index, 0);
   CHECK_LT(index, number_of_manœuvres());
+  CacheSegmentsAffectedByManœuvre(index);
   manœuvres_.erase(manœuvres_.begin() + index);
   coast_analysers_.erase(coast_analysers_.begin() + index + 1);
   UpdateInitialMassOfManœuvresAfter(index);
-  PopSegmentsAffectedByManœuvre(index);
-  return ComputeSegments(manœuvres_.begin() + index, manœuvres_.end());
+  return RecomputeSegmentsAffectedByManœuvre(index);
 }
 
 Status FlightPlan::Replace(NavigationManœuvre::Burn const& burn,
@@ -158,22 +167,22 @@ Status FlightPlan::Replace(NavigationManœuvre::Burn const& burn,
   // Replace the manœuvre at position |index| and rebuild all the ones that
   // follow as they may have a different initial mass.  Also pop the segments
   // that we'll recompute.
+  CacheSegmentsAffectedByManœuvre(index);
   manœuvres_[index] = manœuvre;
   UpdateInitialMassOfManœuvresAfter(index);
 
   // TODO(phl): Recompute as late as possible.
-  PopSegmentsAffectedByManœuvre(index);
-  return ComputeSegments(manœuvres_.begin() + index, manœuvres_.end());
+  return RecomputeSegmentsAffectedByManœuvre(index);
 }
 
 Status FlightPlan::SetDesiredFinalTime(Instant const& desired_final_time) {
   if (desired_final_time < start_of_last_coast()) {
     return BadDesiredFinalTime();
   }
+  CacheSegmentsAffectedByManœuvre(number_of_manœuvres());
   desired_final_time_ = desired_final_time;
   // Reset the last coast and recompute it.
-  ResetLastSegment();
-  return ComputeSegments(manœuvres_.end(), manœuvres_.end());
+  return RecomputeSegmentsAffectedByManœuvre(number_of_manœuvres());
 }
 
 Status FlightPlan::SetAdaptiveStepParameters(
@@ -183,7 +192,7 @@ Status FlightPlan::SetAdaptiveStepParameters(
         generalized_adaptive_step_parameters) {
   adaptive_step_parameters_ = adaptive_step_parameters;
   generalized_adaptive_step_parameters_ = generalized_adaptive_step_parameters;
-  return RecomputeAllSegments();
+  return RecomputeSegmentsAffectedByManœuvre(0);
 }
 
 Ephemeris<Barycentric>::AdaptiveStepParameters const&
@@ -235,6 +244,129 @@ double FlightPlan::progress_of_analysis(int coast_index) const {
   return coast_analysers_[coast_index]->progress_of_next_analysis();
 }
 
+void FlightPlan::RefreshSegments() {
+  std::vector<ComputedSegment> computed_segments;
+  std::int64_t recomputation_version;
+  {
+    absl::MutexLock l(&lock_);
+    std::swap(computed_segments, computed_segments_);
+    recomputation_version = recomputation_version_;
+  }
+  for (auto const& computed_segment : computed_segments) {
+    // Segments published by a cancelled recomputation are ignored.
+    if (recomputing_ &&
+        computed_segment.version == recomputation_version) {
+      AppendComputedSegment(computed_segment);
+    }
+  }
+  if (optimizer_ != nullptr) {
+    optimizer_->RefreshOptimization();
+  }
+}
+
+double FlightPlan::progress_of_recomputation() const {
+  return progress_of_recomputation_;
+}
+
+Status FlightPlan::recomputation_status() const {
+  if (anomalous_segments_ == 0 || recomputing_) {
+    return Status::OK;
+  } else {
+    return anomalous_status_;
+  }
+}
+
+StatusOr<FlightPlan::ManœuvreContext> FlightPlan::GetManœuvreContext(
+    int const index) const {
+  CHECK_LE(0, index);
+  CHECK_LT(index, number_of_manœuvres());
+  if (index >= number_of_manœuvres() - number_of_anomalous_manœuvres()) {
+    if (recomputing_) {
+      return Status(Error::UNAVAILABLE, "Manœuvre being recomputed");
+    } else {
+      return Status(Error::FAILED_PRECONDITION, "Anomalous manœuvre");
+    }
+  }
+  auto const fork = segments_[2 * index]->Fork();
+  std::optional<Instant> next_burn;
+  std::vector<NavigationManœuvre::Burn> next_burns;
+  if (index < number_of_manœuvres() - 1) {
+    next_burn = start_of_next_burn(index);
+  }
+  for (int i = index + 1; i < number_of_manœuvres(); ++i) {
+    next_burns.push_back(manœuvres_[i].burn());
+  }
+  return ManœuvreContext{
+      Ephemeris<Barycentric>::Guard(ephemeris_),
+      index,
+      NavigationManœuvre(manœuvres_[index].initial_mass(),
+                         manœuvres_[index].burn()),
+      fork->time,
+      fork->degrees_of_freedom,
+      next_burn,
+      std::move(next_burns),
+      desired_final_time_,
+      adaptive_step_parameters_,
+      generalized_adaptive_step_parameters_};
+}
+
+Status FlightPlan::ComputeTrajectoryWithBurn(
+    ManœuvreContext const& context,
+    NavigationManœuvre::Burn const& burn,
+    DiscreteTrajectory<Barycentric>& trajectory) const {
+  CHECK(trajectory.Empty());
+
+  // Same checks as in |Replace|, except that the flight plan is not extended.
+  NavigationManœuvre const manœuvre(context.manœuvre.initial_mass(), burn);
+  if (manœuvre.IsSingular()) {
+    return Singular();
+  }
+  if (context.start_of_next_burn.has_value()
+          ? !manœuvre.FitsBetween(context.first_time,
+                                  *context.start_of_next_burn)
+          : !manœuvre.IsAfter(context.first_time)) {
+    return DoesNotFit();
+  }
+  std::vector<NavigationManœuvre> manœuvres = {manœuvre};
+  for (auto const& next_burn : context.next_burns) {
+    manœuvres.emplace_back(manœuvres.back().final_mass(), next_burn);
+  }
+
+  // All the segments are integrated in the same trajectory, which is the
+  // coasting trajectory of all the manœuvres.
+  trajectory.Append(context.first_time, context.first_degrees_of_freedom);
+  for (auto& m : manœuvres) {
+    m.set_coasting_trajectory(&trajectory);
+    RETURN_IF_ERROR(CoastSegment(m.initial_time(),
+                                 &trajectory,
+                                 context.adaptive_step_parameters));
+    RETURN_IF_ERROR(BurnSegment(m,
+                                &trajectory,
+                                context.adaptive_step_parameters,
+                                context.generalized_adaptive_step_parameters));
+  }
+  return CoastSegment(
+      std::max(context.desired_final_time, trajectory.back().time),
+      &trajectory,
+      context.adaptive_step_parameters);
+}
+
+FlightPlanOptimizer& FlightPlan::optimizer() {
+  if (optimizer_ == nullptr) {
+    optimizer_ = std::make_unique<FlightPlanOptimizer>(this);
+    optimizer_->set_priority(priority_);
+  }
+  return *optimizer_;
+}
+
+void FlightPlan::set_priority(PredictionService::Priority const priority) {
+  priority_ = priority;
+  recomputer_.set_priority(priority);
+  if (optimizer_ != nullptr) {
+    optimizer_->set_priority(priority);
+  }
+}
+
 void FlightPlan::WriteToMessage(
     not_null<serialization::FlightPlan*> const message) const {
   initial_mass_.WriteToMessage(message->mutable_initial_mass());
@@ -311,6 +443,18 @@ std::unique_ptr<FlightPlan> FlightPlan::ReadFromMessage(
   return flight_plan;
 }
 
+void FlightPlan::MakeAsynchronous() {
+  synchronous_ = false;
+}
+
+void FlightPlan::MakeSynchronous() {
+  synchronous_ = true;
+}
+
+bool FlightPlan::IsSynchronous() {
+  return synchronous_;
+}
+
 FlightPlan::FlightPlan()
     : initial_degrees_of_freedom_(Barycentric::origin, Barycentric::unmoving),
       root_(make_not_null_unique<DiscreteTrajectory<Barycentric>>()),
@@ -328,9 +472,13 @@ FlightPlan::FlightPlan()
               Position<Barycentric>>(),
           /*max_steps=*/1,
           /*length_integration_tolerance=*/1 * Metre,
-          /*speed_integration_tolerance=*/1 * Metre / Second) {}
+          /*speed_integration_tolerance=*/1 * Metre / Second),
+      recomputer_(PredictionService::Default(),
+                  [this]() { ComputeRequestedSegments(); }) {}
 
 Status FlightPlan::RecomputeAllSegments() {
+  CancelRecomputation();
+  cached_segments_.clear();
   // It is important that the segments be destroyed in (reverse chronological)
   // order of the forks.
   while (segments_.size() > 1) {
@@ -340,9 +488,163 @@ Status FlightPlan::RecomputeAllSegments() {
   return ComputeSegments(manœuvres_.begin(), manœuvres_.end());
 }
 
+Status FlightPlan::RecomputeSegmentsAffectedByManœuvre(int index) {
+  if (recomputing_) {
+    // The segments that have not been published yet must be recomputed too,
+    // starting with the coast or burn of the first pending manœuvre.
+    index = std::min(index, (number_of_segments() - anomalous_segments_) / 2);
+  }
+  CancelRecomputation();
+  PopSegmentsAffectedByManœuvre(index);
+  // If the segments are preceded by an anomalous one there is nothing to
+  // compute, so we might as well do it synchronously.
+  if (synchronous_ || anomalous_segments_ > 0) {
+    Status const status =
+        ComputeSegments(manœuvres_.begin() + index, manœuvres_.end());
+    cached_segments_.clear();
+    return status;
+  }
+
+  // Give the affected segments the shape that they have when they follow an
+  // anomalous segment.
+  Instant const first_time = segments_.back()->back().time;
+  DegreesOfFreedom<Barycentric> const first_degrees_of_freedom =
+      segments_.back()->back().degrees_of_freedom;
+  anomalous_segments_ = 1;
+  anomalous_status_ = Status::OK;
+  recomputing_ = true;
+  for (int i = index; i < manœuvres_.size(); ++i) {
+    manœuvres_[i].set_coasting_trajectory(segments_.back());
+    AddLastSegment();
+    AddLastSegment();
+  }
+
+  {
+    absl::MutexLock l(&lock_);
+    ++recomputation_version_;
+    progress_of_recomputation_ = 0;
+    recomputation_request_ = RecomputationRequest{
+        Ephemeris<Barycentric>::Guard(ephemeris_),
+        recomputation_version_,
+        /*first_segment=*/2 * index,
+        first_time,
+        first_degrees_of_freedom,
+        desired_final_time_,
+        std::vector<NavigationManœuvre>(manœuvres_.begin() + index,
+                                        manœuvres_.end()),
+        adaptive_step_parameters_,
+        generalized_adaptive_step_parameters_,
+        std::move(cached_segments_)};
+  }
+  cached_segments_.clear();
+  recomputer_.Request();
+  return Status::OK;
+}
+
+void FlightPlan::CacheSegmentsAffectedByManœuvre(int const index) {
+  cached_segments_.clear();
+  // The anomalous segments are incomplete, or empty.
+  for (int i = 2 * index; i < number_of_segments() - anomalous_segments_; ++i) {
+    // Coasts are at even indices, burns at odd indices.
+    NavigationManœuvre const* const manœuvre =
+        i % 2 == 0 ? nullptr : &manœuvres_[i / 2];
+    auto const segment = segments_[i];
+    auto trajectory = make_not_null_unique<DiscreteTrajectory<Barycentric>>();
+    for (auto it = segment->Fork(); it != segment->end(); ++it) {
+      trajectory->Append(it->time, it->degrees_of_freedom);
+    }
+    cached_segments_.push_back(
+        CachedSegment{SegmentKey(manœuvre,
+                                 adaptive_step_parameters_,
+                                 generalized_adaptive_step_parameters_),
+                      std::move(trajectory)});
+  }
+}
+
+std::string FlightPlan::SegmentKey(
+    NavigationManœuvre const* const manœuvre,
+    Ephemeris<Barycentric>::AdaptiveStepParameters const&
+        adaptive_step_parameters,
+    Ephemeris<Barycentric>::GeneralizedAdaptiveStepParameters const&
+        generalized_adaptive_step_parameters) {
+  std::string key;
+  serialization::Ephemeris::AdaptiveStepParameters parameters;
+  if (manœuvre == nullptr || manœuvre->is_inertially_fixed()) {
+    adaptive_step_parameters.WriteToMessage(&parameters);
+  } else {
+    generalized_adaptive_step_parameters.WriteToMessage(&parameters);
+  }
+  parameters.AppendToString(&key);
+  if (manœuvre != nullptr) {
+    // This covers the initial mass, the timing, the intensity and the frame of
+    // the burn.
+    serialization::Manoeuvre message;
+    manœuvre->WriteToMessage(&message);
+    message.AppendToString(&key);
+  }
+  return key;
+}
+
+void FlightPlan::AppendCachedSegment(
+    std::vector<CachedSegment> const& cached_segments,
+    NavigationManœuvre const* const manœuvre,
+    Ephemeris<Barycentric>::AdaptiveStepParameters const&
+        adaptive_step_parameters,
+    Ephemeris<Barycentric>::GeneralizedAdaptiveStepParameters const&
+        generalized_adaptive_step_parameters,
+    Instant const& final_time,
+    not_null<DiscreteTrajectory<Barycentric>*> const segment) {
+  if (cached_segments.empty()) {
+    return;
+  }
+  bool const is_generalized =
+      manœuvre != nullptr && !manœuvre->is_inertially_fixed();
+  Length const length_integration_tolerance =
+      is_generalized
+          ? generalized_adaptive_step_parameters.length_integration_tolerance()
+          : adaptive_step_parameters.length_integration_tolerance();
+  Speed const speed_integration_tolerance =
+      is_generalized
+          ? generalized_adaptive_step_parameters.speed_integration_tolerance()
+          : adaptive_step_parameters.speed_integration_tolerance();
+  std::string const key = SegmentKey(manœuvre,
+                                     adaptive_step_parameters,
+                                     generalized_adaptive_step_parameters);
+  Instant const first_time = segment->back().time;
+  DegreesOfFreedom<Barycentric> const first_degrees_of_freedom =
+      segment->back().degrees_of_freedom;
+
+  for (auto const& cached_segment : cached_segments) {
+    auto const& trajectory = *cached_segment.trajectory;
+    auto const& cached_first_point = trajectory.front();
+    // A change of the initial state below the integration tolerances is
+    // indistinguishable from the integration error, so the cached segment is
+    // as good as a new one.
+    if (cached_segment.key != key ||
+        cached_first_point.time != first_time ||
+        (cached_first_point.degrees_of_freedom.position() -
+         first_degrees_of_freedom.position()).Norm() >
+            length_integration_tolerance ||
+        (cached_first_point.degrees_of_freedom.velocity() -
+         first_degrees_of_freedom.velocity()).Norm() >
+            speed_integration_tolerance) {
+      continue;
+    }
+    auto it = trajectory.begin();
+    for (++it; it != trajectory.end() && it->time <= final_time; ++it) {
+      segment->Append(it->time, it->degrees_of_freedom);
+    }
+    return;
+  }
+}
+
 Status FlightPlan::BurnSegment(
     NavigationManœuvre const& manœuvre,
-    not_null<DiscreteTrajectory<Barycentric>*> const segment) {
+    not_null<DiscreteTrajectory<Barycentric>*> const segment,
+    Ephemeris<Barycentric>::AdaptiveStepParameters const&
+        adaptive_step_parameters,
+    Ephemeris<Barycentric>::GeneralizedAdaptiveStepParameters const&
+        generalized_adaptive_step_parameters) const {
   Instant const final_time = manœuvre.final_time();
   if (manœuvre.initial_time() < final_time) {
     if (manœuvre.is_inertially_fixed()) {
@@ -350,14 +652,14 @@ Status FlightPlan::BurnSegment(
                              segment,
                              manœuvre.InertialIntrinsicAcceleration(),
                              final_time,
-                             adaptive_step_parameters_,
+                             adaptive_step_parameters,
                              max_ephemeris_steps_per_frame);
     } else {
       return ephemeris_->FlowWithAdaptiveStep(
                              segment,
                              manœuvre.FrenetIntrinsicAcceleration(),
                              final_time,
-                             generalized_adaptive_step_parameters_,
+                             generalized_adaptive_step_parameters,
                              max_ephemeris_steps_per_frame);
     }
   } else {
@@ -367,12 +669,14 @@ Status FlightPlan::BurnSegment(
 
 Status FlightPlan::CoastSegment(
     Instant const& desired_final_time,
-    not_null<DiscreteTrajectory<Barycentric>*> const segment) {
+    not_null<DiscreteTrajectory<Barycentric>*> const segment,
+    Ephemeris<Barycentric>::AdaptiveStepParameters const&
+        adaptive_step_parameters) const {
   return ephemeris_->FlowWithAdaptiveStep(
                          segment,
                          Ephemeris<Barycentric>::NoIntrinsicAcceleration,
                          desired_final_time,
-                         adaptive_step_parameters_,
+                         adaptive_step_parameters,
                          max_ephemeris_steps_per_frame);
 }
 
@@ -390,7 +694,15 @@ Status FlightPlan::ComputeSegments(
     manœuvre.set_coasting_trajectory(coast);
 
     if (anomalous_segments_ == 0) {
-      Status const status = CoastSegment(manœuvre.initial_time(), coast);
+      AppendCachedSegment(cached_segments_,
+                          /*manœuvre=*/nullptr,
+                          adaptive_step_parameters_,
+                          generalized_adaptive_step_parameters_,
+                          manœuvre.initial_time(),
+                          coast);
+      Status const status = CoastSegment(manœuvre.initial_time(),
+                                         coast,
+                                         adaptive_step_parameters_);
       if (!status.ok()) {
         overall_status.Update(status);
         anomalous_segments_ = 1;
@@ -408,7 +720,16 @@ Status FlightPlan::ComputeSegments(
 
     if (anomalous_segments_ == 0) {
       auto& burn = segments_.back();
-      Status const status = BurnSegment(manœuvre, burn);
+      AppendCachedSegment(cached_segments_,
+                          &manœuvre,
+                          adaptive_step_parameters_,
+                          generalized_adaptive_step_parameters_,
+                          manœuvre.final_time(),
+                          burn);
+      Status const status = BurnSegment(manœuvre,
+                                        burn,
+                                        adaptive_step_parameters_,
+                                        generalized_adaptive_step_parameters_);
       if (!status.ok()) {
         overall_status.Update(status);
         anomalous_segments_ = 1;
@@ -431,7 +752,15 @@ Status FlightPlan::ComputeSegments(
              segments_.back()->Fork()->degrees_of_freedom,
          .mission_duration =
              desired_final_time_ - segments_.back()->Fork()->time});
-    Status const status = CoastSegment(desired_final_time_, segments_.back());
+    AppendCachedSegment(cached_segments_,
+                        /*manœuvre=*/nullptr,
+                        adaptive_step_parameters_,
+                        generalized_adaptive_step_parameters_,
+                        desired_final_time_,
+                        segments_.back());
+    Status const status = CoastSegment(desired_final_time_,
+                                       segments_.back(),
+                                       adaptive_step_parameters_);
     if (!status.ok()) {
       overall_status.Update(status);
       anomalous_segments_ = 1;
@@ -441,6 +770,209 @@ Status FlightPlan::ComputeSegments(
   return overall_status;
 }
 
+Status FlightPlan::ComputeRequestedSegments() {
+  std::optional<RecomputationRequest> request;
+  {
+    absl::MutexLock l(&lock_);
+    if (!recomputation_request_.has_value()) {
+      return Status::OK;
+    }
+    // The request is current, since |CancelRecomputation| clears it.  A stop
+    // requested before we got here was therefore meant for the cancelled
+    // recomputation, and the |Request| that followed it makes the
+    // |recomputer_| run again: leave the request for that run.
+    if (this_stoppable_thread::get_stop_token().stop_requested()) {
+      return Status(Error::CANCELLED, "Recomputation postponed");
+    }
+    std::swap(request, recomputation_request_);
+  }
+  Status const status = ComputeSegmentsAsynchronously(*request);
+  if (this_stoppable_thread::get_stop_token().stop_requested()) {
+    absl::MutexLock l(&lock_);
+    // Only a stale request may be dropped.  If the request is current, the
+    // stop was not meant for it: put it back.  If a cancellation is in
+    // progress, it will clear it.
+    if (request->version == recomputation_version_ &&
+        !recomputation_request_.has_value()) {
+      std::swap(request, recomputation_request_);
+    }
+  }
+  return status;
+}
+
+Status FlightPlan::ComputeSegmentsAsynchronously(
+    RecomputationRequest& request) {
+  // The segments are standalone trajectories, not forks: each of them starts
+  // with the last point of the previous one.  They are kept until the end of
+  // the computation because the manœuvres refer to their coasts.
+  std::vector<not_null<std::unique_ptr<DiscreteTrajectory<Barycentric>>>>
+      segments;
+  auto const add_segment = [&segments](Instant const& time,
+                                       DegreesOfFreedom<Barycentric> const&
+                                           degrees_of_freedom) {
+    auto& segment = segments.emplace_back(
+        make_not_null_unique<DiscreteTrajectory<Barycentric>>());
+    segment->Append(time, degrees_of_freedom);
+    return segment.get();
+  };
+  Instant const final_time =
+      request.manœuvres.empty()
+          ? request.desired_final_time
+          : std::max(request.desired_final_time,
+                     request.manœuvres.back().final_time());
+  // Publishes a copy of the last segment; returns its |status|, or |CANCELLED|
+  // if the recomputation was cancelled.
+  auto const publish = [this, &request, &segments, &final_time](
+                           Status const& status) -> Status {
+    RETURN_IF_STOPPED;
+    auto const& segment = segments.back();
+    auto copy = make_not_null_unique<DiscreteTrajectory<Barycentric>>();
+    for (auto const& [time, degrees_of_freedom] : *segment) {
+      copy->Append(time, degrees_of_freedom);
+    }
+    absl::MutexLock l(&lock_);
+    // A cancelled recomputation may still be running if it didn't notice the
+    // stop request in time; it must not publish anything.
+    if (request.version != recomputation_version_) {
+      return Status(Error::CANCELLED, "Recomputation cancelled");
+    }
+    computed_segments_.push_back(
+        ComputedSegment{request.version,
+                        request.first_segment +
+                            static_cast<int>(segments.size()) - 1,
+                        std::move(copy),
+                        status});
+    progress_of_recomputation_ =
+        status.ok() ? std::min(1.0,
+                               (segment->back().time - request.first_time) /
+                                   (final_time - request.first_time))
+                    : 1.0;
+    return status;
+  };
+
+  auto const append_cached_segment =
+      [&request](NavigationManœuvre const* const manœuvre,
+                 Instant const& final_time,
+                 not_null<DiscreteTrajectory<Barycentric>*> const segment) {
+        AppendCachedSegment(request.cached_segments,
+                            manœuvre,
+                            request.adaptive_step_parameters,
+                            request.generalized_adaptive_step_parameters,
+                            final_time,
+                            segment);
+      };
+
+  add_segment(request.first_time, request.first_degrees_of_freedom);
+  for (auto& manœuvre : request.manœuvres) {
+    auto const coast = segments.back().get();
+    manœuvre.set_coasting_trajectory(coast);
+    append_cached_segment(/*manœuvre=*/nullptr, manœuvre.initial_time(), coast);
+    RETURN_IF_ERROR(publish(CoastSegment(manœuvre.initial_time(),
+                                         coast,
+                                         request.adaptive_step_parameters)));
+    auto const burn = add_segment(coast->back().time,
+                                  coast->back().degrees_of_freedom);
+    append_cached_segment(&manœuvre, manœuvre.final_time(), burn);
+    RETURN_IF_ERROR(
+        publish(BurnSegment(manœuvre,
+                            burn,
+                            request.adaptive_step_parameters,
+                            request.generalized_adaptive_step_parameters)));
+    add_segment(burn->back().time, burn->back().degrees_of_freedom);
+  }
+  // See |ComputeSegments| for the extension of the desired final time.
+  auto const coast = segments.back().get();
+  Instant const desired_final_time =
+      std::max(request.desired_final_time, coast->back().time);
+  append_cached_segment(/*manœuvre=*/nullptr, desired_final_time, coast);
+  RETURN_IF_ERROR(publish(CoastSegment(desired_final_time,
+                                       coast,
+                                       request.adaptive_step_parameters)));
+  absl::MutexLock l(&lock_);
+  if (request.version == recomputation_version_) {
+    progress_of_recomputation_ = 1;
+  }
+  return Status::OK;
+}
+
+void FlightPlan::CancelRecomputation() {
+  if (!recomputing_) {
+    return;
+  }
+  // Don't wait for the running computation: the integrations stop at their
+  // next step, and the version prevents anything from being published.
+  recomputer_.RequestStop();
+  absl::MutexLock l(&lock_);
+  ++recomputation_version_;
+  recomputation_request_.reset();
+  computed_segments_.clear();
+  recomputing_ = false;
+  progress_of_recomputation_ = 1;
+}
+
+void FlightPlan::AppendComputedSegment(
+    ComputedSegment const& computed_segment) {
+  // The first segment being recomputed is the first anomalous one.  It only
+  // contains its fork point.
+  int const number_of_segments = this->number_of_segments();
+  int const index = number_of_segments - anomalous_segments_;
+  CHECK_EQ(index, computed_segment.index);
+  while (this->number_of_segments() > index + 1) {
+    PopLastSegment();
+  }
+  auto const segment = segments_.back();
+  auto const& trajectory = *computed_segment.trajectory;
+  CHECK_EQ(segment->back().time, trajectory.front().time);
+  auto it = trajectory.begin();
+  for (++it; it != trajectory.end(); ++it) {
+    segment->Append(it->time, it->degrees_of_freedom);
+  }
+
+  // Coasts are at even indices.  See |ComputeSegments| for the analyses.
+  if (index % 2 == 0) {
+    int const coast_index = index / 2;
+    if (coast_index < manœuvres_.size()) {
+      manœuvres_[coast_index].set_coasting_trajectory(segment);
+      coast_analysers_[coast_index]->RequestAnalysis(
+          {.first_time = segment->Fork()->time,
+           .first_degrees_of_freedom = segment->Fork()->degrees_of_freedom,
+           .mission_duration = segment->back().time - segment->Fork()->time,
+           .extended_mission_duration =
+               desired_final_time_ - segment->Fork()->time});
+    } else {
+      desired_final_time_ =
+          std::max(desired_final_time_, segment->Fork()->time);
+      coast_analysers_.back()->RequestAnalysis(
+          {.first_time = segment->Fork()->time,
+           .first_degrees_of_freedom = segment->Fork()->degrees_of_freedom,
+           .mission_duration = desired_final_time_ - segment->Fork()->time});
+    }
+  }
+
+  if (computed_segment.status.ok()) {
+    anomalous_segments_ = 0;
+    if (index + 1 == number_of_segments) {
+      recomputing_ = false;
+      return;
+    }
+    AddLastSegment();
+    anomalous_segments_ = 1;
+  } else {
+    // This segment remains the first anomalous one, as it would in
+    // |ComputeSegments|, and nothing will be published after it.
+    anomalous_status_ = computed_segment.status;
+    recomputing_ = false;
+  }
+  // Restore the empty segments that follow, and make the manœuvres that refer
+  // to them point to their new incarnation.
+  while (this->number_of_segments() < number_of_segments) {
+    AddLastSegment();
+  }
+  for (int i = index / 2 + 1; i < manœuvres_.size(); ++i) {
+    manœuvres_[i].set_coasting_trajectory(segments_[2 * i]);
+  }
+}
+
 void FlightPlan::AddLastSegment() {
   segments_.emplace_back(segments_.back()->NewForkAtLast());
   if (anomalous_segments_ > 0) {
@@ -503,6 +1035,14 @@ Instant FlightPlan::start_of_previous_coast(int const index) const {
   return index == 0 ? initial_time_ : manœuvres_[index - 1].final_time();
 }
 
+// Compute the flight plan in both synchronous and asynchronous mode in tests to
+// avoid code rot.
+#if defined(_DEBUG)
+std::atomic_bool FlightPlan::synchronous_(true);
+#else
+std::atomic_bool FlightPlan::synchronous_(false);
+#endif
+
 }  // namespace internal_flight_plan
 }  // namespace ksp_plugin
 }  // namespace principia
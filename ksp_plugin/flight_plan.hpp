@@ -1,15 +1,24 @@
 ﻿
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
 #include <vector>
 
+#include "absl/synchronization/mutex.h"
+#include "base/macros.hpp"
 #include "base/not_null.hpp"
 #include "base/status.hpp"
+#include "base/status_or.hpp"
 #include "geometry/named_quantities.hpp"
 #include "integrators/ordinary_differential_equations.hpp"
 #include "ksp_plugin/frames.hpp"
 #include "ksp_plugin/manœuvre.hpp"
 #include "ksp_plugin/orbit_analyser.hpp"
+#include "ksp_plugin/prediction_service.hpp"
 #include "physics/degrees_of_freedom.hpp"
 #include "physics/discrete_trajectory.hpp"
 #include "physics/ephemeris.hpp"
@@ -19,11 +28,15 @@
 
 namespace principia {
 namespace ksp_plugin {
+
+FORWARD_DECLARE_FROM(flight_plan_optimizer, class, FlightPlanOptimizer);
+
 namespace internal_flight_plan {
 
 using base::Error;
 using base::not_null;
 using base::Status;
+using base::StatusOr;
 using geometry::Instant;
 using integrators::AdaptiveStepSizeIntegrator;
 using physics::DegreesOfFreedom;
@@ -35,6 +48,13 @@ using quantities::Speed;
 
 // A chain of trajectories obtained by executing the corresponding
 // |NavigationManœuvre|s.
+// In asynchronous mode, the functions that change the manœuvres or the
+// parameters only check their arguments and request the recomputation of the
+// affected segments on a thread of the |PredictionService|.  Each change
+// cancels the recomputation in progress, if any.  Until they have been
+// recomputed the affected segments are anomalous and empty.  The segments are
+// published as they are computed and become visible after a call to
+// |RefreshSegments|.
 class FlightPlan {
  public:
   // Creates a |FlightPlan| with no burns starting at |initial_time| with
@@ -51,7 +71,7 @@ class FlightPlan {
                  adaptive_step_parameters,
              Ephemeris<Barycentric>::GeneralizedAdaptiveStepParameters
                  generalized_adaptive_step_parameters);
-  virtual ~FlightPlan() = default;
+  virtual ~FlightPlan();
 
   // Construction parameters.
   virtual Instant initial_time() const;
@@ -78,7 +98,8 @@ class FlightPlan {
   // must be in [0, number_of_manœuvres()].  Returns an error and has no effect
   // if the given |burn| cannot fit between the preceding burn and the following
   // one or the end of the flight plan.  Otherwise, updates the flight plan and
-  // returns the integration status.
+  // returns the integration status (or OK in asynchronous mode, see
+  // |recomputation_status|); the same applies to the functions below.
   virtual Status Insert(NavigationManœuvre::Burn const& burn, int index);
 
   // Removes the manœuvre with the given |index|, which must be in
@@ -125,6 +146,69 @@ class FlightPlan {
   virtual OrbitAnalyser::Analysis* analysis(int coast_index);
   double progress_of_analysis(int coast_index) const;
 
+  // Makes visible the segments published by the asynchronous recomputation
+  // since the last call, and applies the result of the |optimizer()|, if any.
+  // Must be called on the main thread.
+  virtual void RefreshSegments();
+
+  // The result is in [0, 1]; it tracks the progress of the asynchronous
+  // recomputation requested by the last change to this flight plan, and is 1
+  // once all its segments have been published.
+  virtual double progress_of_recomputation() const;
+
+  // The integration status of the segments visible in this flight plan.  In
+  // asynchronous mode, an error is only reported once the anomalous segment
+  // has been published.
+  virtual Status recomputation_status() const;
+
+  // Sets the priority of the asynchronous computations of this flight plan
+  // (the recomputation and the optimization) with respect to those of the
+  // other vessels.
+  void set_priority(PredictionService::Priority priority);
+
+  // The state of a flight plan needed to compute the trajectory that follows
+  // the coast preceding one of its manœuvres.  It does not refer to the flight
+  // plan, so that such trajectories may be computed on other threads while the
+  // flight plan changes.
+  struct ManœuvreContext {
+    Ephemeris<Barycentric>::Guard guard;
+    int index;
+    // Not attached to a coasting trajectory.
+    NavigationManœuvre manœuvre;
+    // The beginning of the coast preceding the manœuvre.
+    Instant first_time;
+    DegreesOfFreedom<Barycentric> first_degrees_of_freedom;
+    // The beginning of the following burn, if any.
+    std::optional<Instant> start_of_next_burn;
+    std::vector<NavigationManœuvre::Burn> next_burns;
+    Instant desired_final_time;
+    Ephemeris<Barycentric>::AdaptiveStepParameters adaptive_step_parameters;
+    Ephemeris<Barycentric>::GeneralizedAdaptiveStepParameters
+        generalized_adaptive_step_parameters;
+  };
+
+  // Returns the context of the manœuvre with the given |index|, which must be
+  // in [0, number_of_manœuvres()[, or an error if the manœuvre is anomalous or
+  // is being recomputed.
+  StatusOr<ManœuvreContext> GetManœuvreContext(int index) const;
+
+  // Computes the trajectory that the flight plan described by |context| would
+  // have if its manœuvre were replaced with one using |burn|.  The |trajectory|
+  // must be empty; it starts at the beginning of the coast preceding that
+  // manœuvre and ends at the end of the flight plan.  Returns an error if
+  // |burn| could not replace the manœuvre or if an integration fails.  This
+  // function only uses the |context| and the ephemeris, so it may be called
+  // concurrently from multiple threads, even while this object changes.
+  virtual Status ComputeTrajectoryWithBurn(
+      ManœuvreContext const& context,
+      NavigationManœuvre::Burn const& burn,
+      DiscreteTrajectory<Barycentric>& trajectory) const;
+
+  // The optimizer of the manœuvres of this flight plan, created on first use.
+  // The results of its asynchronous optimizations are applied by
+  // |RefreshSegments|.
+  FlightPlanOptimizer& optimizer();
+
   void WriteToMessage(not_null<serialization::FlightPlan*> message) const;
 
   // This may return a null pointer if the flight plan contained in the
@@ -133,6 +217,10 @@ class FlightPlan {
       serialization::FlightPlan const& message,
       not_null<Ephemeris<Barycentric>*> ephemeris);
 
+  static void MakeAsynchronous();
+  static void MakeSynchronous();
+  static bool IsSynchronous();
+
   static constexpr std::int64_t max_ephemeris_steps_per_frame = 1000;
 
   static constexpr Error bad_desired_final_time = Error::OUT_OF_RANGE;
@@ -144,18 +232,94 @@ class FlightPlan {
   FlightPlan();
 
  private:
+  // A segment computed for a previous version of this flight plan, which may be
+  // reused if the same computation is requested from (nearly) the same initial
+  // state.
+  struct CachedSegment {
+    // Identifies the computation, see |SegmentKey|.
+    std::string key;
+    // Starts at the fork point of the segment.
+    not_null<std::unique_ptr<DiscreteTrajectory<Barycentric>>> trajectory;
+  };
+
+  // The parameters of an asynchronous recomputation.
+  struct RecomputationRequest {
+    Ephemeris<Barycentric>::Guard guard;
+    std::int64_t version;
+    // The index in |segments_| of the first segment to recompute, which is the
+    // coast preceding |manœuvres.front()|, if any.
+    int first_segment;
+    Instant first_time;
+    DegreesOfFreedom<Barycentric> first_degrees_of_freedom;
+    Instant desired_final_time;
+    std::vector<NavigationManœuvre> manœuvres;
+    Ephemeris<Barycentric>::AdaptiveStepParameters adaptive_step_parameters;
+    Ephemeris<Barycentric>::GeneralizedAdaptiveStepParameters
+        generalized_adaptive_step_parameters;
+    std::vector<CachedSegment> cached_segments;
+  };
+
+  // A segment published by the asynchronous recomputation.  Its |trajectory|
+  // starts at the fork point of the segment.
+  struct ComputedSegment {
+    std::int64_t version;
+    int index;
+    not_null<std::unique_ptr<DiscreteTrajectory<Barycentric>>> trajectory;
+    Status status;
+  };
+
   // Clears and recomputes all trajectories in |segments_|.
   Status RecomputeAllSegments();
 
+  // Recomputes the segments affected by a change to |manœuvres_[index]|,
+  // synchronously or not.  |index| must be in [0, number_of_manœuvres()].
+  Status RecomputeSegmentsAffectedByManœuvre(int index);
+
+  // Copies the segments that would be recomputed after a change to
+  // |manœuvres_[index]| to |cached_segments_|.  Must be called before the
+  // change.
+  void CacheSegmentsAffectedByManœuvre(int index);
+
+  // Returns a string that identifies the integration of a coast, if |manœuvre|
+  // is null, or of the burn of |manœuvre| with the given parameters.
+  static std::string SegmentKey(
+      NavigationManœuvre const* manœuvre,
+      Ephemeris<Barycentric>::AdaptiveStepParameters const&
+          adaptive_step_parameters,
+      Ephemeris<Barycentric>::GeneralizedAdaptiveStepParameters const&
+          generalized_adaptive_step_parameters);
+
+  // If |cached_segments| has a segment with the same key that starts from a
+  // state within the integration tolerances of the last point of |segment|,
+  // appends its points up to |final_time| to |segment|; the integration then
+  // only needs to cover the rest of the segment, if any.
+  static void AppendCachedSegment(
+      std::vector<CachedSegment> const& cached_segments,
+      NavigationManœuvre const* manœuvre,
+      Ephemeris<Barycentric>::AdaptiveStepParameters const&
+          adaptive_step_parameters,
+      Ephemeris<Barycentric>::GeneralizedAdaptiveStepParameters const&
+          generalized_adaptive_step_parameters,
+      Instant const& final_time,
+      not_null<DiscreteTrajectory<Barycentric>*> segment);
+
   // Flows the given |segment| for the duration of |manœuvre| using its
   // intrinsic acceleration.
-  Status BurnSegment(NavigationManœuvre const& manœuvre,
-                     not_null<DiscreteTrajectory<Barycentric>*> segment);
+  Status BurnSegment(
+      NavigationManœuvre const& manœuvre,
+      not_null<DiscreteTrajectory<Barycentric>*> segment,
+      Ephemeris<Barycentric>::AdaptiveStepParameters const&
+          adaptive_step_parameters,
+      Ephemeris<Barycentric>::GeneralizedAdaptiveStepParameters const&
+          generalized_adaptive_step_parameters) const;
 
   // Flows the given |segment| until |desired_final_time| with no intrinsic
   // acceleration.
-  Status CoastSegment(Instant const& desired_final_time,
-                      not_null<DiscreteTrajectory<Barycentric>*> segment);
+  Status CoastSegment(
+      Instant const& desired_final_time,
+      not_null<DiscreteTrajectory<Barycentric>*> segment,
+      Ephemeris<Barycentric>::AdaptiveStepParameters const&
+          adaptive_step_parameters) const;
 
   // Computes new trajectories and appends them to |segments_|.  This updates
   // the last coast of |segments_| and then appends one coast and one burn for
@@ -167,6 +331,25 @@ class FlightPlan {
   Status ComputeSegments(std::vector<NavigationManœuvre>::iterator begin,
                          std::vector<NavigationManœuvre>::iterator end);
 
+  // Run by the |recomputer_| on a thread of the |PredictionService|; computes
+  // the segments using the latest |recomputation_request_|, if any.  A stop
+  // request only cancels the computation if its request is stale, i.e., if its
+  // version is not the current one; otherwise the request is put back for the
+  // next run.
+  Status ComputeRequestedSegments();
+
+  // Computes the segments described by |request|, publishing each of them in
+  // |computed_segments_| when it is complete.  Stops at the first anomalous
+  // segment.
+  Status ComputeSegmentsAsynchronously(RecomputationRequest& request);
+
+  // Cancels the asynchronous recomputation in progress, if any, and forgets
+  // the segments that it published.
+  void CancelRecomputation();
+
+  // Replaces the first segment being recomputed with |computed_segment|.
+  void AppendComputedSegment(ComputedSegment const& computed_segment);
+
   // Adds a trajectory to |segments_|, forked at the end of the last one.  If
   // there are already anomalous trajectories, the newly created trajectory is
   // anomalous too.
@@ -213,8 +396,10 @@ class FlightPlan {
   // case they are empty.
   int anomalous_segments_ = 0;
   // The status of the first anomalous segment.  Set and used exclusively by
-  // |ComputeSegments|.
+  // |ComputeSegments| and |AppendComputedSegment|.
   Status anomalous_status_;
+  // True while the anomalous segments are being recomputed asynchronously.
+  bool recomputing_ = false;
 
   std::vector<NavigationManœuvre> manœuvres_;
   std::vector<not_null<std::unique_ptr<OrbitAnalyser>>> coast_analysers_;
@@ -222,6 +407,32 @@ class FlightPlan {
   Ephemeris<Barycentric>::AdaptiveStepParameters adaptive_step_parameters_;
   Ephemeris<Barycentric>::GeneralizedAdaptiveStepParameters
       generalized_adaptive_step_parameters_;
+
+  // The segments discarded by the last change, consumed by the recomputation
+  // that follows it.
+  std::vector<CachedSegment> cached_segments_;
+
+  mutable absl::Mutex lock_;
+  // Incremented by the main thread for each asynchronous recomputation and
+  // each cancellation.  A recomputation only publishes its segments if its
+  // version is the current one.
+  std::int64_t recomputation_version_ GUARDED_BY(lock_) = 0;
+  // Set by the main thread and cleared by the |recomputer_| when it starts a
+  // recomputation.
+  std::optional<RecomputationRequest> recomputation_request_ GUARDED_BY(lock_);
+  // Appended to by the |recomputer_|; consumed by |RefreshSegments|.
+  std::vector<ComputedSegment> computed_segments_ GUARDED_BY(lock_);
+  std::atomic<double> progress_of_recomputation_ = 1;
+
+  static std::atomic_bool synchronous_;
+
+  // Its computations only use the |ephemeris_|, so it may be destroyed after
+  // the |recomputer_|.
+  std::unique_ptr<FlightPlanOptimizer> optimizer_;
+  PredictionService::Priority priority_ = PredictionService::Priority::Other;
+
+  // Declared last so that it is destroyed, and therefore stopped, first.
+  PredictionService::Client recomputer_;
 };
 
 }  // namespace internal_flight_plan
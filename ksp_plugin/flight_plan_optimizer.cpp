@@ -0,0 +1,465 @@
+#include "ksp_plugin/flight_plan_optimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <list>
+#include <utility>
+#include <vector>
+
+#include "base/jthread.hpp"
+#include "geometry/grassmann.hpp"
+#include "geometry/named_quantities.hpp"
+#include "physics/apsides.hpp"
+#include "physics/degrees_of_freedom.hpp"
+#include "quantities/elementary_functions.hpp"
+#include "quantities/si.hpp"
+#include "serialization/ksp_plugin.pb.h"
+
+namespace principia {
+namespace ksp_plugin {
+namespace internal_flight_plan_optimizer {
+
+using base::CallWithStopToken;
+using base::Error;
+using base::stop_token;
+using base::this_stoppable_thread;
+using geometry::AngleBetween;
+using geometry::Bivector;
+using geometry::Instant;
+using geometry::Velocity;
+using geometry::Wedge;
+using physics::ComputeApsides;
+using physics::DegreesOfFreedom;
+using physics::Frenet;
+using physics::RelativeDegreesOfFreedom;
+using quantities::Pow;
+using quantities::si::Radian;
+
+// The maximum number of steps of the gradient descent.
+constexpr int max_iterations = 100;
+// The number of step lengths tried in parallel by the line search, each half
+// the previous one.
+constexpr int line_search_candidates = 4;
+// At the end of the optimization, the target is deemed unreachable if, were the
+// metric the square of an affine function of the argument, it would vanish
+// further than this number of tolerances away.
+constexpr double max_distance_to_target = 10;
+
+// Returns the degrees of freedom, relative to |celestial|, of the closest
+// approach to |celestial| of the trajectory between |begin| and |end|, or
+// nothing if that trajectory doesn't overlap that of |celestial|.  |begin| is
+// not a candidate: it is the end of the burn, which the optimization cannot
+// move much, so considering it would make the metric flat when the target
+// periapsis is above it.
+std::optional<RelativeDegreesOfFreedom<Barycentric>> ClosestApproach(
+    Celestial const& celestial,
+    DiscreteTrajectory<Barycentric>::Iterator const begin,
+    DiscreteTrajectory<Barycentric>::Iterator const end) {
+  auto const& reference = celestial.trajectory();
+  std::optional<RelativeDegreesOfFreedom<Barycentric>> closest_approach;
+  auto const consider = [&closest_approach, &reference](
+                            Instant const& time,
+                            DegreesOfFreedom<Barycentric> const&
+                                degrees_of_freedom) {
+    if (time < reference.t_min() || time > reference.t_max()) {
+      return;
+    }
+    RelativeDegreesOfFreedom<Barycentric> const relative =
+        degrees_of_freedom - reference.EvaluateDegreesOfFreedom(time);
+    if (!closest_approach.has_value() ||
+        relative.displacement().Norm²() <
+            closest_approach->displacement().Norm²()) {
+      closest_approach = relative;
+    }
+  };
+
+  if (begin == end) {
+    return std::nullopt;
+  }
+  // The closest approach is either a periapsis or the end of the trajectory.
+  DiscreteTrajectory<Barycentric> apoapsides;
+  DiscreteTrajectory<Barycentric> periapsides;
+  ComputeApsides(reference,
+                 begin,
+                 end,
+                 std::numeric_limits<int>::max(),
+                 apoapsides,
+                 periapsides);
+  for (auto const& [time, degrees_of_freedom] : periapsides) {
+    consider(time, degrees_of_freedom);
+  }
+  auto last = end;
+  --last;
+  consider(last->time, last->degrees_of_freedom);
+  return closest_approach;
+}
+
+FlightPlanOptimizer::Metric FlightPlanOptimizer::ForCelestialAltitude(
+    not_null<Celestial const*> const celestial,
+    Length const& target_altitude) {
+  return [celestial, target_altitude](
+             DiscreteTrajectory<Barycentric>::Iterator const begin,
+             DiscreteTrajectory<Barycentric>::Iterator const end) -> double {
+    auto const closest_approach = ClosestApproach(*celestial, begin, end);
+    if (!closest_approach.has_value()) {
+      return std::numeric_limits<double>::infinity();
+    }
+    Length const mean_radius = celestial->body()->mean_radius();
+    return Pow<2>((closest_approach->displacement().Norm() - mean_radius -
+                   target_altitude) / mean_radius);
+  };
+}
+
+FlightPlanOptimizer::Metric FlightPlanOptimizer::ForInclination(
+    not_null<Celestial const*> const celestial,
+    Angle const& target_inclination) {
+  return [celestial, target_inclination](
+             DiscreteTrajectory<Barycentric>::Iterator const begin,
+             DiscreteTrajectory<Barycentric>::Iterator const end) -> double {
+    auto const closest_approach = ClosestApproach(*celestial, begin, end);
+    if (!closest_approach.has_value()) {
+      return std::numeric_limits<double>::infinity();
+    }
+    // |Barycentric| is right-handed, so the bivector dual to the polar axis has
+    // the same coordinates.
+    Bivector<double, Barycentric> const equator(
+        celestial->body()->polar_axis().coordinates());
+    Angle const inclination =
+        AngleBetween(equator,
+                     Wedge(closest_approach->displacement(),
+                           closest_approach->velocity()));
+    return Pow<2>((inclination - target_inclination) / Radian);
+  };
+}
+
+FlightPlanOptimizer::Metric FlightPlanOptimizer::Sum(
+    std::vector<Metric> metrics) {
+  return [metrics = std::move(metrics)](
+             DiscreteTrajectory<Barycentric>::Iterator const begin,
+             DiscreteTrajectory<Barycentric>::Iterator const end) {
+    double sum = 0;
+    for (auto const& metric : metrics) {
+      sum += metric(begin, end);
+    }
+    return sum;
+  };
+}
+
+FlightPlanOptimizer::FlightPlanOptimizer(
+    not_null<FlightPlan*> const flight_plan)
+    : flight_plan_(flight_plan),
+      optimizer_(PredictionService::Default(),
+                 [this]() { OptimizeRequested(); }) {}
+
+Status FlightPlanOptimizer::RequestOptimization(Parameters parameters) {
+  StatusOr<FlightPlan::ManœuvreContext> context =
+      flight_plan_->GetManœuvreContext(parameters.index);
+  RETURN_IF_ERROR(context);
+  serialization::FlightPlan message;
+  flight_plan_->WriteToMessage(&message);
+  requested_flight_plan_ = message.SerializeAsString();
+  status_ = Status::OK;
+  progress_of_optimization_ = 0;
+  Optimization optimization{++version_,
+                            std::move(parameters),
+                            std::move(context).ValueOrDie()};
+
+  if (FlightPlan::IsSynchronous()) {
+    {
+      absl::MutexLock l(&lock_);
+      requested_optimization_.reset();
+      result_.reset();
+    }
+    Result const result{optimization.version,
+                        optimization.parameters.index,
+                        Optimize(optimization)};
+    progress_of_optimization_ = 1;
+    status_ = Apply(result);
+    return status_;
+  }
+
+  {
+    absl::MutexLock l(&lock_);
+    requested_optimization_ = std::move(optimization);
+  }
+  optimizer_.Request();
+  return Status::OK;
+}
+
+void FlightPlanOptimizer::RefreshOptimization() {
+  std::optional<Result> result;
+  {
+    absl::MutexLock l(&lock_);
+    std::swap(result, result_);
+  }
+  // The results of superseded optimizations are ignored.
+  if (result.has_value() && result->version == version_) {
+    status_ = Apply(*result);
+  }
+}
+
+double FlightPlanOptimizer::progress_of_optimization() const {
+  return progress_of_optimization_;
+}
+
+void FlightPlanOptimizer::set_priority(
+    PredictionService::Priority const priority) {
+  priority_ = priority;
+  optimizer_.set_priority(priority);
+}
+
+Status FlightPlanOptimizer::optimization_status() const {
+  return status_;
+}
+
+void FlightPlanOptimizer::OptimizeRequested() {
+  std::optional<Optimization> optimization;
+  {
+    absl::MutexLock l(&lock_);
+    std::swap(optimization, requested_optimization_);
+  }
+  if (!optimization.has_value()) {
+    return;
+  }
+  Result result{optimization->version,
+                optimization->parameters.index,
+                Optimize(*optimization)};
+  {
+    absl::MutexLock l(&lock_);
+    result_ = std::move(result);
+  }
+  if (optimization->version == version_) {
+    progress_of_optimization_ = 1;
+  }
+}
+
+StatusOr<NavigationManœuvre::Burn> FlightPlanOptimizer::Optimize(
+    Optimization const& optimization) {
+  Argument argument{};
+  StatusOr<double> const initial_value = Evaluate(optimization, argument);
+  RETURN_IF_ERROR(initial_value);
+  double value = initial_value.ValueOrDie();
+
+  // The norm of the gradient at |argument|, or close to it.
+  std::optional<double> gradient_norm;
+  for (int iteration = 0; iteration < max_iterations && value > 0;
+       ++iteration) {
+    RETURN_IF_ERROR(CheckNotCancelled(optimization));
+    if (optimization.version == version_) {
+      progress_of_optimization_ =
+          static_cast<double>(iteration) / max_iterations;
+    }
+    StatusOr<Argument> const status_or_gradient =
+        Gradient(optimization, argument, value);
+    if (!status_or_gradient.ok()) {
+      if (!gradient_norm.has_value()) {
+        return status_or_gradient.status();
+      }
+      break;
+    }
+    Argument const& gradient = status_or_gradient.ValueOrDie();
+    double gradient_norm² = 0;
+    for (double const g : gradient) {
+      gradient_norm² += g * g;
+    }
+    gradient_norm = std::sqrt(gradient_norm²);
+    if (gradient_norm² == 0) {
+      break;
+    }
+
+    // The first step would bring the metric to 0 if it were the square of an
+    // affine function, which is the case of the metrics above near their
+    // minimum.  The length of the steps is in units of the tolerances, so we
+    // stop when it falls below 1.
+    double step = 2 * value / gradient_norm²;
+    std::optional<double> best_step;
+    while (!best_step.has_value() && step * *gradient_norm >= 1) {
+      RETURN_IF_ERROR(CheckNotCancelled(optimization));
+      std::vector<Argument> candidates;
+      std::vector<double> candidate_steps;
+      for (int k = 0; k < line_search_candidates; ++k) {
+        Argument& candidate = candidates.emplace_back(argument);
+        for (int i = 0; i < candidate.size(); ++i) {
+          candidate[i] -= step * gradient[i];
+        }
+        candidate_steps.push_back(step);
+        step /= 2;
+      }
+      std::vector<StatusOr<double>> const values =
+          EvaluateAll(optimization, candidates);
+      for (int k = 0; k < line_search_candidates; ++k) {
+        if (values[k].ok() && values[k].ValueOrDie() < value) {
+          value = values[k].ValueOrDie();
+          best_step = candidate_steps[k];
+          argument = candidates[k];
+        }
+      }
+    }
+    if (!best_step.has_value() || *best_step * *gradient_norm < 1) {
+      break;
+    }
+  }
+
+  // If the metric is the square of an affine function e, its gradient is
+  // 2 e ∇e, so |e / ‖∇e‖| is |2 value / ‖∇value‖|: the distance to the target
+  // in units of the tolerances.  In particular, a flat metric that doesn't
+  // vanish means that the burn cannot reach the target.
+  if (value > 0 &&
+      2 * value > max_distance_to_target * gradient_norm.value_or(0)) {
+    return Status(Error::OUT_OF_RANGE, "Target cannot be reached");
+  }
+  return MakeBurn(optimization, argument);
+}
+
+Status FlightPlanOptimizer::Apply(Result const& result) {
+  RETURN_IF_ERROR(result.burn);
+  serialization::FlightPlan message;
+  flight_plan_->WriteToMessage(&message);
+  if (message.SerializeAsString() != requested_flight_plan_) {
+    return Status(Error::ABORTED, "Flight plan changed during optimization");
+  }
+  return flight_plan_->Replace(result.burn.ValueOrDie(), result.index);
+}
+
+Status FlightPlanOptimizer::CheckNotCancelled(
+    Optimization const& optimization) const {
+  RETURN_IF_STOPPED;
+  if (optimization.version != version_) {
+    return Status(Error::CANCELLED, "Optimization superseded");
+  }
+  return Status::OK;
+}
+
+NavigationManœuvre::Burn FlightPlanOptimizer::MakeBurn(
+    Optimization const& optimization,
+    Argument const& argument) {
+  auto const& manœuvre = optimization.context.manœuvre;
+  Speed const& Δv_tolerance = optimization.parameters.Δv_tolerance;
+  std::optional<Time> const& time_tolerance =
+      optimization.parameters.time_tolerance;
+  NavigationManœuvre::Burn burn = manœuvre.burn();
+  burn.intensity = {.Δv = manœuvre.Δv() +
+                          Velocity<Frenet<Navigation>>(
+                              {argument[0] * Δv_tolerance,
+                               argument[1] * Δv_tolerance,
+                               argument[2] * Δv_tolerance})};
+  if (time_tolerance.has_value()) {
+    Time const time_shift = argument[3] * *time_tolerance;
+    if (burn.timing.initial_time.has_value()) {
+      *burn.timing.initial_time += time_shift;
+    } else {
+      *burn.timing.time_of_half_Δv += time_shift;
+    }
+  }
+  return burn;
+}
+
+StatusOr<double> FlightPlanOptimizer::Evaluate(
+    Optimization const& optimization,
+    Argument const& argument) const {
+  NavigationManœuvre::Burn const burn = MakeBurn(optimization, argument);
+  DiscreteTrajectory<Barycentric> trajectory;
+  RETURN_IF_ERROR(flight_plan_->ComputeTrajectoryWithBurn(
+      optimization.context, burn, trajectory));
+  Instant const end_of_burn =
+      NavigationManœuvre(optimization.context.manœuvre.initial_mass(), burn)
+          .final_time();
+  double const value = optimization.parameters.metric(
+      trajectory.LowerBound(end_of_burn), trajectory.end());
+  if (!std::isfinite(value)) {
+    return Status(Error::OUT_OF_RANGE, "Metric cannot be evaluated");
+  }
+  return value;
+}
+
+std::vector<StatusOr<double>> FlightPlanOptimizer::EvaluateAll(
+    Optimization const& optimization,
+    std::vector<Argument> const& arguments) const {
+  // The evaluations are stopped together with the optimization.
+  stop_token const token = this_stoppable_thread::get_stop_token();
+  std::int64_t const size = arguments.size();
+  std::vector<StatusOr<double>> values(size);
+  std::atomic<std::int64_t> next_argument = 0;
+  absl::Mutex lock;
+  std::int64_t evaluated = 0;  // Guarded by |lock|.
+
+  // Evaluates the arguments that no thread has started yet.
+  auto const evaluate_remaining_arguments = [this,
+                                             &arguments,
+                                             &evaluated,
+                                             &lock,
+                                             &next_argument,
+                                             &optimization,
+                                             size,
+                                             token,
+                                             &values]() {
+    for (std::int64_t i = next_argument++; i < size; i = next_argument++) {
+      CallWithStopToken(token, [this, &arguments, i, &optimization, &values]() {
+        values[i] = Evaluate(optimization, arguments[i]);
+      });
+      absl::MutexLock l(&lock);
+      ++evaluated;
+    }
+  };
+
+  // The helpers are destroyed, and therefore stopped, before the variables
+  // that they reference.  Those that did not start are simply dequeued.
+  std::list<PredictionService::Client> helpers;
+  if (!FlightPlan::IsSynchronous()) {
+    for (std::int64_t i = 1; i < size; ++i) {
+      auto& helper = helpers.emplace_back(PredictionService::Default(),
+                                          evaluate_remaining_arguments);
+      helper.set_priority(priority_);
+      helper.Request();
+    }
+  }
+  evaluate_remaining_arguments();
+  {
+    absl::MutexLock l(&lock);
+    auto const all_evaluated = [&evaluated, size]() {
+      return evaluated == size;
+    };
+    lock.Await(absl::Condition(&all_evaluated));
+  }
+  return values;
+}
+
+StatusOr<FlightPlanOptimizer::Argument> FlightPlanOptimizer::Gradient(
+    Optimization const& optimization,
+    Argument const& argument,
+    double const value) const {
+  int const dimension =
+      optimization.parameters.time_tolerance.has_value() ? 4 : 3;
+  std::vector<Argument> arguments;
+  for (int i = 0; i < dimension; ++i) {
+    for (double const h : {1.0, -1.0}) {
+      Argument& shifted = arguments.emplace_back(argument);
+      shifted[i] += h;
+    }
+  }
+  std::vector<StatusOr<double>> const values =
+      EvaluateAll(optimization, arguments);
+
+  // Near the boundaries of the domain of |Evaluate|, for instance if the burn
+  // would overlap the next one, we fall back to a one-sided difference.
+  Argument gradient{};
+  for (int i = 0; i < dimension; ++i) {
+    auto const& forward = values[2 * i];
+    auto const& backward = values[2 * i + 1];
+    if (forward.ok() && backward.ok()) {
+      gradient[i] = (forward.ValueOrDie() - backward.ValueOrDie()) / 2;
+    } else if (forward.ok()) {
+      gradient[i] = forward.ValueOrDie() - value;
+    } else if (backward.ok()) {
+      gradient[i] = value - backward.ValueOrDie();
+    } else {
+      return forward.status();
+    }
+  }
+  return gradient;
+}
+
+}  // namespace internal_flight_plan_optimizer
+}  // namespace ksp_plugin
+}  // namespace principia
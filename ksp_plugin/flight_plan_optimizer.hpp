@@ -0,0 +1,204 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "base/not_null.hpp"
+#include "base/status.hpp"
+#include "base/status_or.hpp"
+#include "ksp_plugin/celestial.hpp"
+#include "ksp_plugin/flight_plan.hpp"
+#include "ksp_plugin/frames.hpp"
+#include "ksp_plugin/manœuvre.hpp"
+#include "ksp_plugin/prediction_service.hpp"
+#include "physics/discrete_trajectory.hpp"
+#include "quantities/quantities.hpp"
+
+namespace principia {
+namespace ksp_plugin {
+namespace internal_flight_plan_optimizer {
+
+using base::not_null;
+using base::Status;
+using base::StatusOr;
+using physics::DiscreteTrajectory;
+using quantities::Angle;
+using quantities::Length;
+using quantities::Speed;
+using quantities::Time;
+
+// Changes the Δv, and optionally the timing, of a manœuvre of a flight plan to
+// minimize a metric of the trajectory that follows it.  The optimization is a
+// gradient descent with a backtracking line search.  The gradient is estimated
+// using central differences; the trajectories needed for the differences, and
+// those tried by the line search, are integrated in parallel on the threads of
+// the |PredictionService|.
+class FlightPlanOptimizer {
+ public:
+  // A nonnegative function of the trajectory that follows the optimized burn,
+  // which vanishes when the target is reached and is infinite if it cannot be
+  // computed.  |begin| is the end of the burn and |end| is the end of the
+  // flight plan.
+  using Metric =
+      std::function<double(DiscreteTrajectory<Barycentric>::Iterator begin,
+                           DiscreteTrajectory<Barycentric>::Iterator end)>;
+
+  // Returns a metric that vanishes when the closest approach to |celestial| is
+  // at |target_altitude| above its mean radius.  This targets a periapsis if
+  // the trajectory orbits |celestial|, an encounter otherwise.  The end of the
+  // burn is not a candidate closest approach, since it barely depends on the
+  // burn.
+  static Metric ForCelestialAltitude(not_null<Celestial const*> celestial,
+                                     Length const& target_altitude);
+
+  // Returns a metric that vanishes when the inclination of the trajectory at
+  // its closest approach to |celestial|, with respect to the equator of
+  // |celestial|, is |target_inclination|.
+  static Metric ForInclination(not_null<Celestial const*> celestial,
+                               Angle const& target_inclination);
+
+  // Returns the sum of the given |metrics|.
+  static Metric Sum(std::vector<Metric> metrics);
+
+  // The parameters of an optimization.
+  struct Parameters {
+    // The index of the manœuvre to optimize.
+    int index;
+    Metric metric;
+    // The Δv is optimized with this resolution.
+    Speed Δv_tolerance;
+    // If set, the timing of the burn is also optimized with this resolution.
+    std::optional<Time> time_tolerance;
+  };
+
+  // The |flight_plan| must outlive this object.
+  explicit FlightPlanOptimizer(not_null<FlightPlan*> flight_plan);
+
+  // Starts replacing the manœuvre with index |parameters.index| with one that
+  // minimizes |parameters.metric|, superseding the optimization in progress,
+  // if any.  Returns an error if the manœuvre cannot be optimized, e.g.,
+  // because it is anomalous.  In asynchronous mode (see
+  // |FlightPlan::MakeAsynchronous|), the optimization runs on a thread of the
+  // |PredictionService| and its result is applied by |RefreshOptimization|;
+  // otherwise it is applied before this function returns.
+  Status RequestOptimization(Parameters parameters);
+
+  // If an optimization has completed since the last call, replaces the
+  // manœuvre with its result, unless the flight plan has changed since the
+  // optimization was requested.  Must be called on the main thread.
+  void RefreshOptimization();
+
+  // The result is in [0, 1]; it tracks the progress of the last requested
+  // optimization, and is 1 once its result is available.
+  double progress_of_optimization() const;
+
+  // Sets the priority of the optimization with respect to the other
+  // computations of the |PredictionService|.
+  void set_priority(PredictionService::Priority priority);
+
+  // The status of the last optimization once its result has been applied, OK
+  // before that.  It is an error, and the flight plan is unchanged, if the
+  // metric cannot be evaluated for the current manœuvre, if it cannot be
+  // brought close to 0 (i.e., the target is unreachable), or if the flight plan
+  // changed during the optimization.  Otherwise, it is the status of the final
+  // |Replace|.
+  Status optimization_status() const;
+
+ private:
+  // The changes to the Δv (in the Frenet frame of the manœuvre) and to the
+  // timing of the burn, in units of the tolerances.
+  using Argument = std::array<double, 4>;
+
+  // An optimization and all the data that it uses, which do not depend on the
+  // state of the flight plan.
+  struct Optimization {
+    std::int64_t version;
+    Parameters parameters;
+    FlightPlan::ManœuvreContext context;
+  };
+
+  // The outcome of an optimization.
+  struct Result {
+    std::int64_t version;
+    int index;
+    StatusOr<NavigationManœuvre::Burn> burn;
+  };
+
+  // Run by the |optimizer_| on a thread of the |PredictionService|; performs
+  // the latest |requested_optimization_|, if any.
+  void OptimizeRequested();
+
+  // Returns the burn that minimizes the metric of |optimization|, or an error
+  // if the metric cannot be evaluated or the target cannot be reached.
+  StatusOr<NavigationManœuvre::Burn> Optimize(
+      Optimization const& optimization);
+
+  // Replaces the manœuvre with the burn of |result|, if the flight plan has not
+  // changed since the optimization was requested.  Returns the status of the
+  // optimization.
+  Status Apply(Result const& result);
+
+  // Returns an error if |optimization| has been superseded or stopped.
+  Status CheckNotCancelled(Optimization const& optimization) const;
+
+  // Returns the burn of the manœuvre being optimized, changed by |argument|.
+  static NavigationManœuvre::Burn MakeBurn(Optimization const& optimization,
+                                           Argument const& argument);
+
+  // Returns the value of the metric for the given |argument|, or an error if
+  // the changed burn cannot replace the manœuvre being optimized.
+  StatusOr<double> Evaluate(Optimization const& optimization,
+                            Argument const& argument) const;
+
+  // Evaluates the metric for all the |arguments| in parallel.  The other
+  // threads of the |PredictionService| help with the evaluations, with the
+  // priority of this optimizer, and the calling thread evaluates the
+  // |arguments| that they have not started.
+  std::vector<StatusOr<double>> EvaluateAll(
+      Optimization const& optimization,
+      std::vector<Argument> const& arguments) const;
+
+  // Returns an estimate of the gradient of the metric at |argument|, where it
+  // has the given |value|, or an error if the metric cannot be evaluated on
+  // either side of |argument| along some dimension.
+  StatusOr<Argument> Gradient(Optimization const& optimization,
+                              Argument const& argument,
+                              double value) const;
+
+  not_null<FlightPlan*> const flight_plan_;
+
+  // The following members are only accessed by the main thread.
+  // The serialization of the flight plan when the last optimization was
+  // requested, used to detect changes.
+  std::string requested_flight_plan_;
+  Status status_;
+
+  mutable absl::Mutex lock_;
+  // Set by |RequestOptimization| and cleared by the |optimizer_| when it starts
+  // an optimization.
+  std::optional<Optimization> requested_optimization_ GUARDED_BY(lock_);
+  // Set by the |optimizer_| and cleared by |RefreshOptimization|.
+  std::optional<Result> result_ GUARDED_BY(lock_);
+  // The version of the last requested optimization; the optimizations with a
+  // smaller version are abandoned as soon as possible.
+  std::atomic<std::int64_t> version_ = 0;
+  std::atomic<double> progress_of_optimization_ = 1;
+  std::atomic<PredictionService::Priority> priority_ =
+      PredictionService::Priority::Other;
+
+  // Declared last so that it is destroyed, and therefore stopped, first.
+  PredictionService::Client optimizer_;
+};
+
+}  // namespace internal_flight_plan_optimizer
+
+using internal_flight_plan_optimizer::FlightPlanOptimizer;
+
+}  // namespace ksp_plugin
+}  // namespace principia
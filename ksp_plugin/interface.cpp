@@ -5,11 +5,14 @@
 #include <cmath>
 #include <cstring>
 #include <filesystem>
+#include <fstream>
 #include <iomanip>
+#include <iterator>
 #include <limits>
 #include <map>
 #include <memory>
 #include <optional>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
@@ -45,6 +48,7 @@
 #include "journal/method.hpp"
 #include "journal/profiles.hpp"
 #include "journal/recorder.hpp"
+#include "ksp_plugin/flight_plan.hpp"
 #include "ksp_plugin/frames.hpp"
 #include "ksp_plugin/identification.hpp"
 #include "ksp_plugin/iterators.hpp"
@@ -94,6 +98,7 @@ using integrators::ParseAdaptiveStepSizeIntegrator;
 using integrators::ParseFixedStepSizeIntegrator;
 using ksp_plugin::AliceSun;
 using ksp_plugin::Barycentric;
+using ksp_plugin::FlightPlan;
 using ksp_plugin::Part;
 using ksp_plugin::PartId;
 using ksp_plugin::RigidPart;
@@ -304,9 +309,83 @@ NewEncoder(std::string_view const encoder) {
   }
 }
 
+// The name of the file where the base of the incremental saves with the given
+// |base_id| is stored.
+std::string IncrementalSaveBaseName(std::uint64_t const base_id) {
+  std::stringstream name;
+  name << std::setw(16) << std::setfill('0') << std::hex << std::uppercase
+       << base_id;
+  return name.str();
+}
+
+std::filesystem::path IncrementalSaveBasePath(
+    std::string_view const base_directory,
+    std::uint64_t const base_id) {
+  return std::filesystem::path(base_directory) /
+         (IncrementalSaveBaseName(base_id) + ".proto.bin");
+}
+
+// Failing to write the base is not fatal: the save that starts the base
+// embeds it, and the next save starts a new base if this one is missing.
+base::Status WriteIncrementalSaveBase(serialization::Plugin const& base,
+                                      std::uint64_t const base_id,
+                                      std::string_view const compressor,
+                                      std::string_view const base_directory) {
+  std::string bytes = base.SerializeAsString();
+  auto const base_compressor = NewCompressor(compressor);
+  if (base_compressor != nullptr) {
+    std::string compressed_bytes;
+    base_compressor->Compress(bytes, &compressed_bytes);
+    bytes = std::move(compressed_bytes);
+  }
+  std::error_code error;
+  std::filesystem::create_directories(std::filesystem::path(base_directory),
+                                      error);
+  auto const path = IncrementalSaveBasePath(base_directory, base_id);
+  std::ofstream file(path, std::ios::binary);
+  file.write(bytes.data(), bytes.size());
+  file.close();
+  if (!file.good()) {
+    std::filesystem::remove(path, error);
+    return base::Status(base::Error::UNAVAILABLE,
+                        "Cannot write " + path.string());
+  }
+  return base::Status::OK;
+}
+
+base::Status ReadIncrementalSaveBase(
+    std::uint64_t const base_id,
+    std::string_view const compressor,
+    std::string_view const base_directory,
+    not_null<serialization::Plugin*> const base) {
+  auto const path = IncrementalSaveBasePath(base_directory, base_id);
+  std::ifstream file(path, std::ios::binary);
+  if (!file.good()) {
+    return base::Status(base::Error::NOT_FOUND,
+                        "Cannot read " + path.string());
+  }
+  std::string bytes((std::istreambuf_iterator<char>(file)),
+                    std::istreambuf_iterator<char>());
+  auto const base_compressor = NewCompressor(compressor);
+  if (base_compressor != nullptr) {
+    std::string uncompressed_bytes;
+    if (!base_compressor->Uncompress(bytes, &uncompressed_bytes)) {
+      return base::Status(base::Error::DATA_LOSS,
+                          "Cannot uncompress " + path.string());
+    }
+    bytes = std::move(uncompressed_bytes);
+  }
+  if (!base->ParseFromString(bytes) || !base->IsInitialized()) {
+    return base::Status(base::Error::DATA_LOSS,
+                        "Cannot parse " + path.string());
+  }
+  return base::Status::OK;
+}
+
 }  // namespace
 
 void __cdecl principia__ActivatePlayer() {
+  FlightPlan::MakeSynchronous();
   Vessel::MakeSynchronous();
 }
 
@@ -325,12 +404,24 @@ void __cdecl principia__ActivateRecorder(bool const activate) {
     std::tm* const localtime = std::localtime(&time);
     std::stringstream name;
     name << std::put_time(localtime, "JOURNAL.%Y%m%d-%H%M%S");
+    // The hexadecimal format is used by default because it is written
+    // synchronously, so the journal is complete when we crash, which is when
+    // it is most needed.  The binary formats are much faster, but may lose the
+    // last messages before a crash; they must be requested explicitly.
+    auto format = journal::Recorder::Format::Hexadecimal;
+    if (Flags::IsPresent("journal", "binary")) {
+      format = journal::Recorder::Format::Binary;
+    } else if (Flags::IsPresent("journal", "compressed")) {
+      format = journal::Recorder::Format::CompressedBinary;
+    }
     journal::Recorder* const recorder = new journal::Recorder(
-        std::filesystem::path("glog") / "Principia" / name.str());
+        std::filesystem::path("glog") / "Principia" / name.str(), format);
+    FlightPlan::MakeSynchronous();
     Vessel::MakeSynchronous();
     journal::Recorder::Activate(recorder);
   } else if (!activate && journal::Recorder::IsActivated()) {
     journal::Recorder::Deactivate();
+    FlightPlan::MakeAsynchronous();
     Vessel::MakeAsynchronous();
   }
 }
@@ -577,6 +668,82 @@ void __cdecl principia__DeserializePlugin(
   return m.Return();
 }
 
+// Same as |principia__DeserializePlugin|, but for the output of
+// |principia__SerializePluginIncrementally|.  The base of the save is read
+// from |base_directory|, unless it is embedded in the save.  If the base
+// cannot be read, an error is logged and |*plugin| is set to null; the caller
+// must then report that the save cannot be loaded.
+void __cdecl principia__DeserializePluginIncrementally(
+    char const* const serialization,
+    PushDeserializer** const deserializer,
+    Plugin const** const plugin,
+    char const* const compressor,
+    char const* const encoder,
+    char const* const base_directory) {
+  journal::Method<journal::DeserializePluginIncrementally> m(
+      {serialization,
+       deserializer,
+       plugin,
+       compressor,
+       encoder,
+       base_directory},
+      {deserializer,
+       plugin});
+  CHECK_NOTNULL(serialization);
+  CHECK_NOTNULL(deserializer);
+  CHECK_NOTNULL(plugin);
+  CHECK_NOTNULL(base_directory);
+
+  // Create and start a deserializer if the caller didn't provide one.
+  if (*deserializer == nullptr) {
+    LOG(INFO) << "Begin incremental plugin deserialization";
+    *deserializer = new PushDeserializer(chunk_size,
+                                         number_of_chunks,
+                                         NewCompressor(compressor));
+    CHECK_NOTNULL(arena);
+    not_null<serialization::IncrementalSave*> const message =
+        Arena::CreateMessage<serialization::IncrementalSave>(arena);
+    (*deserializer)->Start(
+        message,
+        [plugin,
+         compressor = std::string(compressor),
+         base_directory = std::string(base_directory)](
+            google::protobuf::Message const& message) {
+          auto const& save =
+              static_cast<serialization::IncrementalSave const&>(message);
+          not_null<serialization::Plugin*> const base =
+              Arena::CreateMessage<serialization::Plugin>(arena);
+          if (save.has_base()) {
+            base->CopyFrom(save.base());
+          } else {
+            base::Status const status = ReadIncrementalSaveBase(
+                save.base_id(), compressor, base_directory, base);
+            if (!status.ok()) {
+              LOG(ERROR) << "Missing base for incremental save: " << status;
+              *plugin = nullptr;
+              return;
+            }
+          }
+          *plugin = Plugin::ReadFromIncrementalSave(save, base).release();
+        });
+  }
+
+  // Decode the representation.
+  auto bytes = NewEncoder(encoder)->Decode({serialization,
+                                            std::strlen(serialization)});
+  auto const bytes_size = bytes.size;
+  (*deserializer)->Push(std::move(bytes));
+
+  // If the data was empty, delete the deserializer.  This ensures that
+  // |*plugin| is filled.
+  if (bytes_size == 0) {
+    LOG(INFO) << "End incremental plugin deserialization";
+    TakeOwnership(deserializer);
+    arena->Reset();
+  }
+  return m.Return();
+}
+
 // Calls |plugin->EndInitialization|.
 // |plugin| must not be null.  No transfer of ownership.
 void __cdecl principia__EndInitialization(Plugin* const plugin) {
@@ -1083,6 +1250,74 @@ char const* __cdecl principia__SerializePlugin(
   return m.Return(hexadecimal.data.release());
 }
 
+// Same as |principia__SerializePlugin|, but only serializes the changes since
+// the base of the incremental saves.  When a new base is started, it is written
+// to a file in |base_directory|, compressed with |compressor|, and embedded in
+// the save, so that the save is self-contained; this happens periodically, see
+// |SaveChain|.  A new base is also started if the file of the current one is
+// missing, e.g., because the saves were copied elsewhere.  Since older saves
+// may still refer to them, the files of the bases are never deleted.
+char const* __cdecl principia__SerializePluginIncrementally(
+    Plugin const* const plugin,
+    PullSerializer** const serializer,
+    char const* const compressor,
+    char const* const encoder,
+    char const* const base_directory) {
+  journal::Method<journal::SerializePluginIncrementally> m({plugin,
+                                                            serializer,
+                                                            compressor,
+                                                            encoder,
+                                                            base_directory},
+                                                           {serializer});
+  CHECK_NOTNULL(plugin);
+  CHECK_NOTNULL(serializer);
+  CHECK_NOTNULL(base_directory);
+
+  // Create and start a serializer if the caller didn't provide one.
+  if (*serializer == nullptr) {
+    LOG(INFO) << "Begin incremental plugin serialization";
+    *serializer = new PullSerializer(chunk_size,
+                                     number_of_chunks,
+                                     NewCompressor(compressor));
+    not_null<serialization::Plugin*> const base =
+        Arena::CreateMessage<serialization::Plugin>(arena);
+    not_null<serialization::IncrementalSave*> const message =
+        Arena::CreateMessage<serialization::IncrementalSave>(arena);
+    std::optional<std::uint64_t> const base_id =
+        plugin->IncrementalSaveBaseId();
+    std::error_code error;
+    bool const force_new_base =
+        !base_id.has_value() ||
+        !std::filesystem::exists(
+            IncrementalSaveBasePath(base_directory, *base_id), error);
+    if (plugin->WriteToIncrementalSave(force_new_base, message, base)) {
+      LOG(INFO) << "New base " << IncrementalSaveBaseName(message->base_id());
+      base::Status const status = WriteIncrementalSaveBase(
+          *base, message->base_id(), compressor, base_directory);
+      LOG_IF(ERROR, !status.ok()) << status;
+      message->mutable_base()->Swap(base);
+    }
+    (*serializer)->Start(message);
+  }
+
+  // Pull a chunk.
+  Array<std::uint8_t> bytes;
+  bytes = (*serializer)->Pull();
+
+  // If this is the end of the serialization, delete the serializer and return a
+  // nullptr.
+  if (bytes.size == 0) {
+    LOG(INFO) << "End incremental plugin serialization";
+    TakeOwnership(serializer);
+    arena->Reset();
+    return m.Return(nullptr);
+  }
+
+  // Encode and return to the client.
+  auto hexadecimal = NewEncoder(encoder)->Encode(bytes);
+  return m.Return(hexadecimal.data.release());
+}
+
 // Sets the maximum number of seconds which logs may be buffered for.
 void __cdecl principia__SetBufferDuration(int const seconds) {
   journal::Method<journal::SetBufferDuration> m({seconds});
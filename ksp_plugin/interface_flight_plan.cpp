@@ -1,12 +1,16 @@
 ﻿
 #include "ksp_plugin/interface.hpp"
 
+#include <cmath>
+#include <vector>
+
 #include "base/not_null.hpp"
 #include "geometry/named_quantities.hpp"
 #include "glog/logging.h"
 #include "journal/method.hpp"
 #include "journal/profiles.hpp"
 #include "ksp_plugin/flight_plan.hpp"
+#include "ksp_plugin/flight_plan_optimizer.hpp"
 #include "ksp_plugin/iterators.hpp"
 #include "ksp_plugin/vessel.hpp"
 #include "physics/barycentric_rotating_dynamic_frame.hpp"
@@ -30,6 +34,7 @@ using geometry::Vector;
 using geometry::Velocity;
 using ksp_plugin::Barycentric;
 using ksp_plugin::FlightPlan;
+using ksp_plugin::FlightPlanOptimizer;
 using ksp_plugin::Navigation;
 using ksp_plugin::NavigationManœuvre;
 using ksp_plugin::TypedIterator;
@@ -45,9 +50,11 @@ using physics::Ephemeris;
 using physics::Frenet;
 using quantities::Speed;
 using quantities::constants::StandardGravity;
+using quantities::si::Degree;
 using quantities::si::Kilo;
 using quantities::si::Kilogram;
 using quantities::si::Metre;
+using quantities::si::Milli;
 using quantities::si::Newton;
 using quantities::si::Second;
 using quantities::si::Tonne;
@@ -344,6 +351,46 @@ principia__FlightPlanGetManoeuvreFrenetTrihedron(Plugin const* const plugin,
   return m.Return(result);
 }
 
+double __cdecl principia__FlightPlanGetOptimizationProgress(
+    Plugin const* const plugin,
+    char const* const vessel_guid) {
+  journal::Method<journal::FlightPlanGetOptimizationProgress> m(
+      {plugin, vessel_guid});
+  CHECK_NOTNULL(plugin);
+  return m.Return(GetFlightPlan(*plugin, vessel_guid).
+                      optimizer().progress_of_optimization());
+}
+
+Status* __cdecl principia__FlightPlanGetOptimizationStatus(
+    Plugin const* const plugin,
+    char const* const vessel_guid) {
+  journal::Method<journal::FlightPlanGetOptimizationStatus> m(
+      {plugin, vessel_guid});
+  CHECK_NOTNULL(plugin);
+  return m.Return(ToNewStatus(GetFlightPlan(*plugin, vessel_guid).
+                                  optimizer().optimization_status()));
+}
+
+double __cdecl principia__FlightPlanGetRecomputationProgress(
+    Plugin const* const plugin,
+    char const* const vessel_guid) {
+  journal::Method<journal::FlightPlanGetRecomputationProgress> m(
+      {plugin, vessel_guid});
+  CHECK_NOTNULL(plugin);
+  return m.Return(
+      GetFlightPlan(*plugin, vessel_guid).progress_of_recomputation());
+}
+
+Status* __cdecl principia__FlightPlanGetRecomputationStatus(
+    Plugin const* const plugin,
+    char const* const vessel_guid) {
+  journal::Method<journal::FlightPlanGetRecomputationStatus> m(
+      {plugin, vessel_guid});
+  CHECK_NOTNULL(plugin);
+  return m.Return(ToNewStatus(
+      GetFlightPlan(*plugin, vessel_guid).recomputation_status()));
+}
+
 int __cdecl principia__FlightPlanNumberOfAnomalousManoeuvres(
     Plugin const* const plugin,
     char const* const vessel_guid) {
@@ -372,6 +419,40 @@ int __cdecl principia__FlightPlanNumberOfSegments(
   return m.Return(GetFlightPlan(*plugin, vessel_guid).number_of_segments());
 }
 
+Status* __cdecl principia__FlightPlanOptimizeManoeuvre(
+    Plugin const* const plugin,
+    char const* const vessel_guid,
+    int const index,
+    int const celestial_index,
+    double const target_altitude,
+    double const target_inclination_in_degrees) {
+  journal::Method<journal::FlightPlanOptimizeManoeuvre> m(
+      {plugin,
+       vessel_guid,
+       index,
+       celestial_index,
+       target_altitude,
+       target_inclination_in_degrees});
+  CHECK_NOTNULL(plugin);
+  auto const& celestial = plugin->GetCelestial(celestial_index);
+  // A NaN target is not optimized for.
+  std::vector<FlightPlanOptimizer::Metric> metrics;
+  if (!std::isnan(target_altitude)) {
+    metrics.push_back(FlightPlanOptimizer::ForCelestialAltitude(
+        check_not_null(&celestial), target_altitude * Metre));
+  }
+  if (!std::isnan(target_inclination_in_degrees)) {
+    metrics.push_back(FlightPlanOptimizer::ForInclination(
+        check_not_null(&celestial), target_inclination_in_degrees * Degree));
+  }
+  return m.Return(ToNewStatus(
+      GetFlightPlan(*plugin, vessel_guid).optimizer().RequestOptimization(
+          {.index = index,
+           .metric = FlightPlanOptimizer::Sum(std::move(metrics)),
+           .Δv_tolerance = 1 * Milli(Metre) / Second,
+           .time_tolerance = 10 * Milli(Second)})));
+}
+
 Status* __cdecl principia__FlightPlanRebase(Plugin const* const plugin,
                                          char const* const vessel_guid,
                                          double const mass_in_tonnes) {
@@ -410,6 +491,8 @@ void __cdecl principia__FlightPlanRenderedApsides(
   std::unique_ptr<DiscreteTrajectory<World>> rendered_apoapsides;
   std::unique_ptr<DiscreteTrajectory<World>> rendered_periapsides;
   plugin->ComputeAndRenderApsides(celestial_index,
+                                  vessel_guid,
+                                  Plugin::VesselTrajectory::FlightPlan,
                                   begin, end,
                                   FromXYZ<Position<World>>(sun_world_position),
                                   max_points,
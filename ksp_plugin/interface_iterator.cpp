@@ -51,6 +51,23 @@ QP __cdecl principia__IteratorGetDiscreteTrajectoryQP(
       }));
 }
 
+int __cdecl principia__IteratorGetDiscreteTrajectoryQPs(
+    Iterator* const iterator,
+    QP* const qps,
+    int const capacity) {
+  journal::Method<journal::IteratorGetDiscreteTrajectoryQPs> m(
+      {iterator, qps, capacity});
+  CHECK_NOTNULL(iterator);
+  auto const typed_iterator = check_not_null(
+      dynamic_cast<TypedIterator<DiscreteTrajectory<World>>*>(iterator));
+  return m.Return(typed_iterator->Fill<QP>(
+      [](DiscreteTrajectory<World>::Iterator const& iterator) -> QP {
+        return ToQP(iterator->degrees_of_freedom);
+      },
+      CHECK_NOTNULL(qps),
+      capacity));
+}
+
 double __cdecl principia__IteratorGetDiscreteTrajectoryTime(
     Iterator const* const iterator) {
   journal::Method<journal::IteratorGetDiscreteTrajectoryTime> m({iterator});
@@ -76,10 +93,37 @@ XYZ __cdecl principia__IteratorGetDiscreteTrajectoryXYZ(
       }));
 }
 
+int __cdecl principia__IteratorGetDiscreteTrajectoryXYZs(
+    Iterator* const iterator,
+    XYZ* const xyzs,
+    int const capacity) {
+  journal::Method<journal::IteratorGetDiscreteTrajectoryXYZs> m(
+      {iterator, xyzs, capacity});
+  CHECK_NOTNULL(iterator);
+  auto const typed_iterator = check_not_null(
+      dynamic_cast<TypedIterator<DiscreteTrajectory<World>>*>(iterator));
+  return m.Return(typed_iterator->Fill<XYZ>(
+      [](DiscreteTrajectory<World>::Iterator const& iterator) -> XYZ {
+        return ToXYZ(iterator->degrees_of_freedom.position());
+      },
+      CHECK_NOTNULL(xyzs),
+      capacity));
+}
+
 Iterator* __cdecl principia__IteratorGetRP2LinesIterator(
     Iterator const* const iterator) {
   journal::Method<journal::IteratorGetRP2LinesIterator> m({iterator});
   CHECK_NOTNULL(iterator);
+  // An iterator over a batch of |RP2Lines| yields an iterator over the lines
+  // of the current element.
+  auto const batch_iterator = dynamic_cast<
+      TypedIterator<std::vector<RP2Lines<Length, Camera>>> const*>(iterator);
+  if (batch_iterator != nullptr) {
+    return m.Return(batch_iterator->Get<Iterator*>(
+        [](RP2Lines<Length, Camera> const& rp2_lines) -> Iterator* {
+          return new TypedIterator<RP2Lines<Length, Camera>>(rp2_lines);
+        }));
+  }
   auto const typed_iterator = check_not_null(
       dynamic_cast<TypedIterator<RP2Lines<Length, Camera>> const*>(iterator));
   return m.Return(typed_iterator->Get<Iterator*>(
@@ -99,6 +143,22 @@ XY __cdecl principia__IteratorGetRP2LineXY(Iterator const* const iterator) {
       }));
 }
 
+int __cdecl principia__IteratorGetRP2LineXYs(Iterator* const iterator,
+                                              XY* const xys,
+                                              int const capacity) {
+  journal::Method<journal::IteratorGetRP2LineXYs> m(
+      {iterator, xys, capacity});
+  CHECK_NOTNULL(iterator);
+  auto const typed_iterator = check_not_null(
+      dynamic_cast<TypedIterator<RP2Line<Length, Camera>>*>(iterator));
+  return m.Return(typed_iterator->Fill<XY>(
+      [](RP2Point<Length, Camera> const& rp2_point) -> XY {
+        return ToXY(rp2_point);
+      },
+      CHECK_NOTNULL(xys),
+      capacity));
+}
+
 char const* __cdecl principia__IteratorGetVesselGuid(
     Iterator const* const iterator) {
   journal::Method<journal::IteratorGetVesselGuid> m({iterator});
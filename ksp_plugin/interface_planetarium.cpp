@@ -2,6 +2,10 @@
 #include "ksp_plugin/interface.hpp"
 
 #include <algorithm>
+#include <optional>
+#include <set>
+#include <utility>
+#include <vector>
 
 #include "geometry/affine_map.hpp"
 #include "geometry/grassmann.hpp"
@@ -203,7 +207,10 @@ Iterator* __cdecl principia__PlanetariumPlotPsychohistory(
   if (plugin->renderer().HasTargetVessel()) {
     return m.Return(new TypedIterator<RP2Lines<Length, Camera>>({}));
   } else {
-    auto const& psychohistory = plugin->GetVessel(vessel_guid)->psychohistory();
+    Vessel& vessel = *plugin->GetVessel(vessel_guid);
+    // The plot is incomplete until the history has been read and attached.
+    vessel.RequestHistory();
+    auto const& psychohistory = vessel.psychohistory();
     auto const rp2_lines =
         PlotMethodN(*planetarium,
                     method,
@@ -216,6 +223,92 @@ Iterator* __cdecl principia__PlanetariumPlotPsychohistory(
   }
 }
 
+// Returns an iterator over the rendered trajectories of all the celestials,
+// plotted concurrently.  For each celestial, in increasing order of index, the
+// iterator has two elements: the past trajectory, as plotted by
+// |PlanetariumPlotCelestialTrajectoryForPsychohistory|, and the future
+// trajectory, as plotted by
+// |PlanetariumPlotCelestialTrajectoryForPredictionOrFlightPlan|.  The latter is
+// empty if |vessel_guid| is null.  Each element is an iterator over |RP2Lines|,
+// which may be obtained by |IteratorGetRP2LinesIterator|.  The celestial
+// indices must be contiguous, starting at 0.  The celestials whose indices are
+// among the |number_of_hidden_celestials| elements of
+// |hidden_celestial_indices|, e.g., because they are fixed in the plotting
+// frame or invisible at the current zoom level, are not plotted: both their
+// elements are empty.
+Iterator* __cdecl principia__PlanetariumPlotCelestialTrajectories(
+    Planetarium const* const planetarium,
+    Plugin const* const plugin,
+    char const* const vessel_guid,
+    double const max_history_length,
+    int* const hidden_celestial_indices,
+    int const number_of_hidden_celestials) {
+  journal::Method<journal::PlanetariumPlotCelestialTrajectories>
+      m({planetarium,
+         plugin,
+         vessel_guid,
+         max_history_length,
+         hidden_celestial_indices,
+         number_of_hidden_celestials});
+  CHECK_NOTNULL(plugin);
+  CHECK_NOTNULL(planetarium);
+  CHECK(number_of_hidden_celestials == 0 ||
+        hidden_celestial_indices != nullptr);
+  std::set<int> const hidden_celestials(
+      hidden_celestial_indices,
+      hidden_celestial_indices + number_of_hidden_celestials);
+
+  Instant const now = plugin->CurrentTime();
+  // Do not plot the past when there is a target vessel as it is misleading.
+  bool const has_target_vessel = plugin->renderer().HasTargetVessel();
+  std::optional<Instant> final_time;
+  if (vessel_guid != nullptr && !has_target_vessel) {
+    auto const& vessel = *plugin->GetVessel(vessel_guid);
+    Instant const prediction_final_time = vessel.prediction().t_max();
+    final_time = vessel.has_flight_plan()
+                     ? std::max(vessel.flight_plan().actual_final_time(),
+                                prediction_final_time)
+                     : prediction_final_time;
+  }
+
+  // The trajectories to plot, and the position of their lines in the result.
+  std::vector<Planetarium::PlottedTrajectory> plotted_trajectories;
+  std::vector<int> positions;
+  int number_of_celestials = 0;
+  for (int celestial_index = 0;
+       plugin->HasCelestial(celestial_index);
+       ++celestial_index, ++number_of_celestials) {
+    if (has_target_vessel || hidden_celestials.count(celestial_index) > 0) {
+      continue;
+    }
+    auto const& celestial_trajectory =
+        plugin->GetCelestial(celestial_index).trajectory();
+    plotted_trajectories.push_back(
+        {&celestial_trajectory,
+         /*first_time=*/std::max(now - max_history_length * Second,
+                                 celestial_trajectory.t_min()),
+         /*last_time=*/now,
+         /*reverse=*/true});
+    positions.push_back(2 * celestial_index);
+    if (final_time.has_value()) {
+      plotted_trajectories.push_back({&celestial_trajectory,
+                                      /*first_time=*/now,
+                                      /*last_time=*/*final_time,
+                                      /*reverse=*/false});
+      positions.push_back(2 * celestial_index + 1);
+    }
+  }
+
+  auto plotted_lines = planetarium->PlotMethod2(plotted_trajectories, now);
+  std::vector<RP2Lines<Length, Camera>> rp2_lines(2 * number_of_celestials);
+  for (int i = 0; i < plotted_lines.size(); ++i) {
+    rp2_lines[positions[i]] = std::move(plotted_lines[i]);
+  }
+  return m.Return(
+      new TypedIterator<std::vector<RP2Lines<Length, Camera>>>(
+          std::move(rp2_lines)));
+}
+
 // Returns an iterator for the rendered past trajectory of the celestial with
 // the given index; the trajectory goes back |max_history_length| seconds before
 // the present time (or to the earliest time available if the relevant |t_min|
@@ -49,6 +49,8 @@ void __cdecl principia__RenderedPredictionApsides(
   std::unique_ptr<DiscreteTrajectory<World>> rendered_apoapsides;
   std::unique_ptr<DiscreteTrajectory<World>> rendered_periapsides;
   plugin->ComputeAndRenderApsides(celestial_index,
+                                  vessel_guid,
+                                  Plugin::VesselTrajectory::Prediction,
                                   prediction.Fork(),
                                   prediction.end(),
                                   FromXYZ<Position<World>>(sun_world_position),
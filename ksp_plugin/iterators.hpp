@@ -37,6 +37,18 @@ class TypedIterator : public Iterator {
       std::function<Interchange(typename Container::value_type const&)> const&
           convert) const;
 
+  // Converts the elements starting at the one denoted by this iterator to some
+  // |Interchange| type using |convert|, and stores them in |buffer|, which has
+  // room for |capacity| elements.  Advances this iterator past the elements
+  // stored.  Returns the number of elements stored, which is less than
+  // |capacity| only if the end of the container was reached.
+  template<typename Interchange>
+  int Fill(
+      std::function<Interchange(typename Container::value_type const&)> const&
+          convert,
+      Interchange* buffer,
+      int capacity);
+
   bool AtEnd() const override;
   void Increment() override;
   void Reset() override;
@@ -61,6 +73,14 @@ class TypedIterator<DiscreteTrajectory<World>> : public Iterator {
       std::function<Interchange(
           DiscreteTrajectory<World>::Iterator const&)> const& convert) const;
 
+  // Same as above, but for a contiguous range of points.
+  template<typename Interchange>
+  int Fill(
+      std::function<Interchange(
+          DiscreteTrajectory<World>::Iterator const&)> const& convert,
+      Interchange* buffer,
+      int capacity);
+
   bool AtEnd() const override;
   void Increment() override;
   void Reset() override;
@@ -22,6 +22,22 @@ Interchange TypedIterator<Container>::Get(
   return convert(*iterator_);
 }
 
+template<typename Container>
+template<typename Interchange>
+int TypedIterator<Container>::Fill(
+    std::function<Interchange(typename Container::value_type const&)> const&
+        convert,
+    Interchange* const buffer,
+    int const capacity) {
+  CHECK_LE(0, capacity);
+  int size = 0;
+  for (; size < capacity && iterator_ != container_.end();
+       ++size, ++iterator_) {
+    buffer[size] = convert(*iterator_);
+  }
+  return size;
+}
+
 template<typename Container>
 bool TypedIterator<Container>::AtEnd() const {
   return iterator_ == container_.end();
@@ -59,6 +75,21 @@ Interchange TypedIterator<DiscreteTrajectory<World>>::Get(
   return convert(iterator_);
 }
 
+template<typename Interchange>
+int TypedIterator<DiscreteTrajectory<World>>::Fill(
+    std::function<Interchange(
+        DiscreteTrajectory<World>::Iterator const&)> const& convert,
+    Interchange* const buffer,
+    int const capacity) {
+  CHECK_LE(0, capacity);
+  int size = 0;
+  for (; size < capacity && iterator_ != trajectory_->end();
+       ++size, ++iterator_) {
+    buffer[size] = convert(iterator_);
+  }
+  return size;
+}
+
 inline bool TypedIterator<DiscreteTrajectory<World>>::AtEnd() const {
   return iterator_ == trajectory_->end();
 }
@@ -0,0 +1,450 @@
+#include "ksp_plugin/message_delta.hpp"
+
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/fingerprint2011.hpp"
+#include "base/macros.hpp"
+#include "glog/logging.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+
+namespace principia {
+namespace ksp_plugin {
+namespace internal_message_delta {
+
+using base::Fingerprint2011;
+using google::protobuf::Reflection;
+using google::protobuf::io::CodedInputStream;
+using google::protobuf::io::CodedOutputStream;
+using google::protobuf::io::StringOutputStream;
+
+namespace {
+
+// Deterministic serialization is needed for maps, otherwise equal messages may
+// have different fingerprints.  The messages may lack required fields.
+std::string SerializeDeterministically(Message const& message) {
+  std::string bytes;
+  {
+    StringOutputStream string_stream(&bytes);
+    CodedOutputStream coded_stream(&string_stream);
+    coded_stream.SetSerializationDeterministic(true);
+    CHECK(message.SerializePartialToCodedStream(&coded_stream));
+  }
+  return bytes;
+}
+
+std::uint64_t Fingerprint(std::string const& bytes) {
+  return Fingerprint2011(bytes.data(), bytes.size());
+}
+
+// Returns a message of the type of |message| where only |field| is set, to the
+// value that it has in |message|.
+std::unique_ptr<Message> CopyField(Message const& message,
+                                   FieldDescriptor const* const field) {
+  std::unique_ptr<Message> copy(message.New());
+  Reflection const* const reflection = message.GetReflection();
+  if (field->is_repeated()) {
+    int const size = reflection->FieldSize(message, field);
+    for (int i = 0; i < size; ++i) {
+      switch (field->cpp_type()) {
+        case FieldDescriptor::CPPTYPE_INT32:
+          reflection->AddInt32(
+              copy.get(), field,
+              reflection->GetRepeatedInt32(message, field, i));
+          break;
+        case FieldDescriptor::CPPTYPE_INT64:
+          reflection->AddInt64(
+              copy.get(), field,
+              reflection->GetRepeatedInt64(message, field, i));
+          break;
+        case FieldDescriptor::CPPTYPE_UINT32:
+          reflection->AddUInt32(
+              copy.get(), field,
+              reflection->GetRepeatedUInt32(message, field, i));
+          break;
+        case FieldDescriptor::CPPTYPE_UINT64:
+          reflection->AddUInt64(
+              copy.get(), field,
+              reflection->GetRepeatedUInt64(message, field, i));
+          break;
+        case FieldDescriptor::CPPTYPE_DOUBLE:
+          reflection->AddDouble(
+              copy.get(), field,
+              reflection->GetRepeatedDouble(message, field, i));
+          break;
+        case FieldDescriptor::CPPTYPE_FLOAT:
+          reflection->AddFloat(
+              copy.get(), field,
+              reflection->GetRepeatedFloat(message, field, i));
+          break;
+        case FieldDescriptor::CPPTYPE_BOOL:
+          reflection->AddBool(
+              copy.get(), field,
+              reflection->GetRepeatedBool(message, field, i));
+          break;
+        case FieldDescriptor::CPPTYPE_ENUM:
+          reflection->AddEnumValue(
+              copy.get(), field,
+              reflection->GetRepeatedEnumValue(message, field, i));
+          break;
+        case FieldDescriptor::CPPTYPE_STRING:
+          reflection->AddString(
+              copy.get(), field,
+              reflection->GetRepeatedString(message, field, i));
+          break;
+        case FieldDescriptor::CPPTYPE_MESSAGE:
+          reflection->AddMessage(copy.get(), field)->CopyFrom(
+              reflection->GetRepeatedMessage(message, field, i));
+          break;
+      }
+    }
+  } else {
+    switch (field->cpp_type()) {
+      case FieldDescriptor::CPPTYPE_INT32:
+        reflection->SetInt32(
+            copy.get(), field, reflection->GetInt32(message, field));
+        break;
+      case FieldDescriptor::CPPTYPE_INT64:
+        reflection->SetInt64(
+            copy.get(), field, reflection->GetInt64(message, field));
+        break;
+      case FieldDescriptor::CPPTYPE_UINT32:
+        reflection->SetUInt32(
+            copy.get(), field, reflection->GetUInt32(message, field));
+        break;
+      case FieldDescriptor::CPPTYPE_UINT64:
+        reflection->SetUInt64(
+            copy.get(), field, reflection->GetUInt64(message, field));
+        break;
+      case FieldDescriptor::CPPTYPE_DOUBLE:
+        reflection->SetDouble(
+            copy.get(), field, reflection->GetDouble(message, field));
+        break;
+      case FieldDescriptor::CPPTYPE_FLOAT:
+        reflection->SetFloat(
+            copy.get(), field, reflection->GetFloat(message, field));
+        break;
+      case FieldDescriptor::CPPTYPE_BOOL:
+        reflection->SetBool(
+            copy.get(), field, reflection->GetBool(message, field));
+        break;
+      case FieldDescriptor::CPPTYPE_ENUM:
+        reflection->SetEnumValue(
+            copy.get(), field, reflection->GetEnumValue(message, field));
+        break;
+      case FieldDescriptor::CPPTYPE_STRING:
+        reflection->SetString(
+            copy.get(), field, reflection->GetString(message, field));
+        break;
+      case FieldDescriptor::CPPTYPE_MESSAGE:
+        reflection->MutableMessage(copy.get(), field)->CopyFrom(
+            reflection->GetMessage(message, field));
+        break;
+    }
+  }
+  return copy;
+}
+
+// True if the changes to |field| are computed recursively, for a singular
+// field, or element by element, for a repeated field.  The other fields are
+// compared as a whole.  Extensions are excluded because their values cannot be
+// modified in place without knowing their type.
+bool IsDecomposable(FieldDescriptor const* const field) {
+  return !field->is_extension() &&
+         field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE &&
+         !field->is_map() &&
+         field->message_type()->extension_range_count() == 0;
+}
+
+void MergeFromBytes(std::string const& bytes,
+                    not_null<Message*> const message) {
+  CodedInputStream input(reinterpret_cast<std::uint8_t const*>(bytes.data()),
+                         bytes.size());
+  CHECK(message->MergePartialFromCodedStream(&input))
+      << message->GetDescriptor()->full_name();
+}
+
+}  // namespace
+
+class DeltaComputer {
+ public:
+  static void Compute(Message const& message,
+                      MatchingKeys const& keys,
+                      MessageSummary& summary,
+                      serialization::MessageDelta* delta);
+
+ private:
+  // Returns true if the field has changed, in which case |field_delta| is
+  // filled if it is not null.
+  static bool ComputeRepeated(Message const& message,
+                              FieldDescriptor const* field,
+                              MatchingKeys const& keys,
+                              MessageSummary::Field* old_field,
+                              MessageSummary::Field& new_field,
+                              serialization::MessageDelta::Field* field_delta);
+
+  static std::uint64_t KeyFingerprint(Message const& element,
+                                      FieldDescriptor const* key);
+};
+
+void DeltaComputer::Compute(Message const& message,
+                            MatchingKeys const& keys,
+                            MessageSummary& summary,
+                            serialization::MessageDelta* const delta) {
+  Reflection const* const reflection = message.GetReflection();
+  std::vector<FieldDescriptor const*> fields;
+  reflection->ListFields(message, &fields);
+
+  std::map<int, MessageSummary::Field> new_fields;
+  for (FieldDescriptor const* const field : fields) {
+    auto const old_it = summary.fields_.find(field->number());
+    MessageSummary::Field* const old_field =
+        old_it == summary.fields_.end() ? nullptr : &old_it->second;
+    MessageSummary::Field& new_field = new_fields[field->number()];
+    serialization::MessageDelta::Field field_delta;
+    field_delta.set_number(field->number());
+    bool changed;
+    if (IsDecomposable(field) && field->is_repeated()) {
+      changed = ComputeRepeated(message,
+                                field,
+                                keys,
+                                old_field,
+                                new_field,
+                                delta == nullptr ? nullptr : &field_delta);
+    } else if (IsDecomposable(field)) {
+      if (old_field == nullptr || old_field->summary == nullptr) {
+        new_field.summary = std::make_unique<MessageSummary>();
+      } else {
+        new_field.summary = std::move(old_field->summary);
+      }
+      Compute(reflection->GetMessage(message, field),
+              keys,
+              *new_field.summary,
+              delta == nullptr ? nullptr : field_delta.mutable_delta());
+      // A field that was not set must be created even if the submessage is
+      // empty.
+      changed = old_field == nullptr || field_delta.delta().field_size() > 0;
+    } else {
+      std::string const bytes =
+          SerializeDeterministically(*CopyField(message, field));
+      new_field.fingerprint = Fingerprint(bytes);
+      changed = old_field == nullptr ||
+                old_field->fingerprint != new_field.fingerprint;
+      if (changed && delta != nullptr) {
+        field_delta.set_value(bytes);
+      }
+    }
+    if (changed && delta != nullptr) {
+      delta->add_field()->Swap(&field_delta);
+    }
+  }
+
+  // The fields that were set in the old version and are not set anymore.
+  if (delta != nullptr) {
+    for (auto const& [number, _] : summary.fields_) {
+      if (new_fields.find(number) == new_fields.end()) {
+        delta->add_field()->set_number(number);
+      }
+    }
+  }
+  summary.fields_ = std::move(new_fields);
+}
+
+bool DeltaComputer::ComputeRepeated(
+    Message const& message,
+    FieldDescriptor const* const field,
+    MatchingKeys const& keys,
+    MessageSummary::Field* const old_field,
+    MessageSummary::Field& new_field,
+    serialization::MessageDelta::Field* const field_delta) {
+  Reflection const* const reflection = message.GetReflection();
+  int const size = reflection->FieldSize(message, field);
+  std::vector<MessageSummary::Element> old_elements;
+  if (old_field != nullptr) {
+    old_elements = std::move(old_field->elements);
+  }
+  new_field.elements.resize(size);
+
+  // The number of leading elements that are unchanged and at the same index.
+  int kept_prefix_size = 0;
+  bool in_prefix = true;
+
+  auto const keys_it = keys.find(field);
+  if (keys_it == keys.end()) {
+    // The elements are compared as a whole.
+    for (int i = 0; i < size; ++i) {
+      std::string const bytes = SerializeDeterministically(
+          reflection->GetRepeatedMessage(message, field, i));
+      auto& new_element = new_field.elements[i];
+      new_element.fingerprint = Fingerprint(bytes);
+      if (in_prefix && i < old_elements.size() &&
+          old_elements[i].fingerprint == new_element.fingerprint) {
+        ++kept_prefix_size;
+      } else {
+        in_prefix = false;
+        if (field_delta != nullptr) {
+          field_delta->add_element()->set_value(bytes);
+        }
+      }
+    }
+  } else {
+    // The elements are matched with those of the old version and their changes
+    // are computed recursively.
+    FieldDescriptor const* const key = keys_it->second;
+    // For each key, the indices of the old elements having that key, in
+    // decreasing order so that the first unmatched one is at the back.
+    std::map<std::uint64_t, std::vector<int>> old_indices;
+    if (key != nullptr) {
+      for (int j = old_elements.size() - 1; j >= 0; --j) {
+        old_indices[old_elements[j].key_fingerprint].push_back(j);
+      }
+    }
+    for (int i = 0; i < size; ++i) {
+      Message const& element =
+          reflection->GetRepeatedMessage(message, field, i);
+      auto& new_element = new_field.elements[i];
+      std::optional<int> old_index;
+      if (key == nullptr) {
+        if (i < old_elements.size()) {
+          old_index = i;
+        }
+      } else {
+        new_element.key_fingerprint = KeyFingerprint(element, key);
+        auto const it = old_indices.find(new_element.key_fingerprint);
+        if (it != old_indices.end() && !it->second.empty()) {
+          old_index = it->second.back();
+          it->second.pop_back();
+        }
+      }
+
+      if (old_index.has_value()) {
+        new_element.summary = std::move(old_elements[*old_index].summary);
+        CHECK(new_element.summary != nullptr);
+        serialization::MessageDelta element_delta;
+        Compute(element,
+                keys,
+                *new_element.summary,
+                field_delta == nullptr ? nullptr : &element_delta);
+        if (in_prefix && *old_index == i && element_delta.field_size() == 0) {
+          ++kept_prefix_size;
+        } else {
+          in_prefix = false;
+          if (field_delta != nullptr) {
+            auto* const delta_element = field_delta->add_element();
+            delta_element->set_previous_index(*old_index);
+            if (element_delta.field_size() > 0) {
+              delta_element->mutable_delta()->Swap(&element_delta);
+            }
+          }
+        }
+      } else {
+        new_element.summary = std::make_unique<MessageSummary>();
+        Compute(element, keys, *new_element.summary, /*delta=*/nullptr);
+        in_prefix = false;
+        if (field_delta != nullptr) {
+          field_delta->add_element()->set_value(
+              SerializeDeterministically(element));
+        }
+      }
+    }
+  }
+
+  bool const changed =
+      kept_prefix_size != size || old_elements.size() != size;
+  if (changed && field_delta != nullptr) {
+    field_delta->set_kept_prefix_size(kept_prefix_size);
+  }
+  return changed;
+}
+
+std::uint64_t DeltaComputer::KeyFingerprint(Message const& element,
+                                            FieldDescriptor const* const key) {
+  CHECK(!key->is_repeated()) << key->full_name();
+  Reflection const* const reflection = element.GetReflection();
+  switch (key->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      return reflection->GetInt32(element, key);
+    case FieldDescriptor::CPPTYPE_INT64:
+      return reflection->GetInt64(element, key);
+    case FieldDescriptor::CPPTYPE_UINT32:
+      return reflection->GetUInt32(element, key);
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return reflection->GetUInt64(element, key);
+    case FieldDescriptor::CPPTYPE_STRING:
+      return Fingerprint(reflection->GetString(element, key));
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      return Fingerprint(
+          SerializeDeterministically(reflection->GetMessage(element, key)));
+    default:
+      LOG(FATAL) << "Unsupported key " << key->full_name();
+      base::noreturn();
+  }
+}
+
+void ComputeMessageDelta(Message const& message,
+                         MatchingKeys const& keys,
+                         MessageSummary& summary,
+                         serialization::MessageDelta* const delta) {
+  DeltaComputer::Compute(message, keys, summary, delta);
+}
+
+void ApplyMessageDelta(serialization::MessageDelta const& delta,
+                       not_null<Message*> const message) {
+  Reflection const* const reflection = message->GetReflection();
+  for (auto const& field_delta : delta.field()) {
+    FieldDescriptor const* field =
+        message->GetDescriptor()->FindFieldByNumber(field_delta.number());
+    if (field == nullptr) {
+      field = reflection->FindKnownExtensionByNumber(field_delta.number());
+    }
+    CHECK_NOTNULL(field);
+
+    if (field_delta.has_value()) {
+      reflection->ClearField(message, field);
+      MergeFromBytes(field_delta.value(), message);
+    } else if (field_delta.has_delta()) {
+      ApplyMessageDelta(field_delta.delta(),
+                        reflection->MutableMessage(message, field));
+    } else if (field_delta.has_kept_prefix_size()) {
+      // Detach the elements that are not in the prefix, and rebuild the field
+      // from them and from the new elements.
+      int const kept_prefix_size = field_delta.kept_prefix_size();
+      int const old_size = reflection->FieldSize(*message, field);
+      CHECK_LE(kept_prefix_size, old_size) << field->full_name();
+      std::vector<std::unique_ptr<Message>> old_elements(old_size -
+                                                         kept_prefix_size);
+      for (int j = old_size - 1; j >= kept_prefix_size; --j) {
+        old_elements[j - kept_prefix_size].reset(
+            reflection->ReleaseLast(message, field));
+      }
+      for (auto const& element : field_delta.element()) {
+        if (element.has_value()) {
+          MergeFromBytes(element.value(),
+                         reflection->AddMessage(message, field));
+        } else {
+          int const j = element.previous_index() - kept_prefix_size;
+          CHECK_LE(0, j) << field->full_name();
+          CHECK_LT(j, old_elements.size()) << field->full_name();
+          CHECK(old_elements[j] != nullptr) << field->full_name();
+          if (element.has_delta()) {
+            ApplyMessageDelta(element.delta(), old_elements[j].get());
+          }
+          reflection->AddAllocatedMessage(message,
+                                          field,
+                                          old_elements[j].release());
+        }
+      }
+    } else {
+      reflection->ClearField(message, field);
+    }
+  }
+}
+
+}  // namespace internal_message_delta
+}  // namespace ksp_plugin
+}  // namespace principia
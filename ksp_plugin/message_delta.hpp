@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "base/not_null.hpp"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+#include "serialization/ksp_plugin.pb.h"
+
+namespace principia {
+namespace ksp_plugin {
+namespace internal_message_delta {
+
+using base::not_null;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::Message;
+
+// For a repeated message field, the field of its elements that identifies them
+// across versions of the enclosing message, or null if the elements are
+// identified by their position.  The elements of the repeated message fields
+// that are not in this map are only compared as a whole: the delta contains
+// all the elements that follow the first changed one.
+using MatchingKeys = std::map<FieldDescriptor const*, FieldDescriptor const*>;
+
+// A compact description of a version of a message, sufficient to compute the
+// changes from that version to another one.  It holds fingerprints of the
+// parts of the message instead of the message itself.  A default-constructed
+// summary describes an empty message.
+class MessageSummary final {
+ public:
+  MessageSummary() = default;
+  MessageSummary(MessageSummary&&) = default;
+  MessageSummary& operator=(MessageSummary&&) = default;
+
+ private:
+  struct Element {
+    std::uint64_t fingerprint = 0;
+    std::uint64_t key_fingerprint = 0;
+    // Only present for the elements of the fields of the |MatchingKeys|.
+    std::unique_ptr<MessageSummary> summary;
+  };
+
+  struct Field {
+    // The fingerprint of the field, for the fields that are compared as a
+    // whole.
+    std::uint64_t fingerprint = 0;
+    // For a singular message field.
+    std::unique_ptr<MessageSummary> summary;
+    // For a repeated message field.
+    std::vector<Element> elements;
+  };
+
+  // Indexed by field number; only has entries for the fields that are set.
+  std::map<int, Field> fields_;
+
+  friend class DeltaComputer;
+};
+
+// Writes to |delta| the changes from the version of the message described by
+// |summary| to |message|, and updates |summary| to describe |message|.  If
+// |delta| is null, only updates |summary|.
+void ComputeMessageDelta(Message const& message,
+                         MatchingKeys const& keys,
+                         MessageSummary& summary,
+                         serialization::MessageDelta* delta);
+
+// Applies |delta| to |message|, which must be the version of the message from
+// which |delta| was computed.
+void ApplyMessageDelta(serialization::MessageDelta const& delta,
+                       not_null<Message*> message);
+
+}  // namespace internal_message_delta
+
+using internal_message_delta::ApplyMessageDelta;
+using internal_message_delta::ComputeMessageDelta;
+using internal_message_delta::MatchingKeys;
+using internal_message_delta::MessageSummary;
+
+}  // namespace ksp_plugin
+}  // namespace principia
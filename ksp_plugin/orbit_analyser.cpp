@@ -15,7 +15,6 @@ namespace ksp_plugin {
 namespace internal_orbit_analyser {
 
 using base::dynamic_cast_not_null;
-using base::MakeStoppableThread;
 using geometry::Frame;
 using geometry::NonRotating;
 using physics::BodyCentredNonRotatingDynamicFrame;
@@ -30,7 +29,9 @@ OrbitAnalyser::OrbitAnalyser(
     Ephemeris<Barycentric>::FixedStepParameters analysed_trajectory_parameters)
     : ephemeris_(ephemeris),
       analysed_trajectory_parameters_(
-          std::move(analysed_trajectory_parameters)) {}
+          std::move(analysed_trajectory_parameters)),
+      analyser_(PredictionService::Default(),
+                [this]() { AnalyseRequestedOrbit(); }) {}
 
 OrbitAnalyser::~OrbitAnalyser() {
   // Ensure that we do not have a thread still running with references to the
@@ -39,9 +40,9 @@ OrbitAnalyser::~OrbitAnalyser() {
 }
 
 void OrbitAnalyser::Interrupt() {
-  analyser_ = jthread();
-  // We are single-threaded here, no need to lock.
-  analyser_idle_ = true;
+  analyser_.Stop();
+  absl::MutexLock l(&lock_);
+  guarded_parameters_.reset();
 }
 
 void OrbitAnalyser::RequestAnalysis(Parameters const& parameters) {
@@ -51,16 +52,15 @@ void OrbitAnalyser::RequestAnalysis(Parameters const& parameters) {
     return;
   }
   last_parameters_ = parameters;
-  absl::MutexLock l(&lock_);
-  // Only process this request if there is no analysis in progress.
-  if (analyser_idle_) {
-    analyser_idle_ = false;
-    analyser_ = MakeStoppableThread(
-        [this](GuardedParameters guarded_parameters) {
-          AnalyseOrbit(std::move(guarded_parameters));
-        },
-        GuardedParameters{std::move(guard), parameters});
+  {
+    absl::MutexLock l(&lock_);
+    guarded_parameters_ = GuardedParameters{std::move(guard), parameters};
   }
+  analyser_.Request();
+}
+
+void OrbitAnalyser::set_priority(PredictionService::Priority const priority) {
+  analyser_.set_priority(priority);
 }
 
 std::optional<OrbitAnalyser::Parameters> const& OrbitAnalyser::last_parameters()
@@ -84,6 +84,18 @@ double OrbitAnalyser::progress_of_next_analysis() const {
   return progress_of_next_analysis_;
 }
 
+Status OrbitAnalyser::AnalyseRequestedOrbit() {
+  std::optional<GuardedParameters> guarded_parameters;
+  {
+    absl::MutexLock l(&lock_);
+    if (!guarded_parameters_.has_value()) {
+      return Status::OK;
+    }
+    std::swap(guarded_parameters, guarded_parameters_);
+  }
+  return AnalyseOrbit(std::move(*guarded_parameters));
+}
+
 Status OrbitAnalyser::AnalyseOrbit(GuardedParameters const guarded_parameters) {
   auto const& parameters = guarded_parameters.parameters;
 
@@ -177,7 +189,6 @@ Status OrbitAnalyser::AnalyseOrbit(GuardedParameters const guarded_parameters) {
 
   absl::MutexLock l(&lock_);
   next_analysis_ = std::move(analysis);
-  analyser_idle_ = true;
   return Status::OK;
 }
 
@@ -8,10 +8,10 @@
 #include "astronomy/orbit_ground_track.hpp"
 #include "astronomy/orbit_recurrence.hpp"
 #include "astronomy/orbital_elements.hpp"
-#include "base/jthread.hpp"
 #include "base/not_null.hpp"
 #include "geometry/named_quantities.hpp"
 #include "ksp_plugin/frames.hpp"
+#include "ksp_plugin/prediction_service.hpp"
 #include "physics/degrees_of_freedom.hpp"
 #include "physics/ephemeris.hpp"
 #include "physics/rotating_body.hpp"
@@ -24,7 +24,6 @@ namespace internal_orbit_analyser {
 using astronomy::OrbitalElements;
 using astronomy::OrbitGroundTrack;
 using astronomy::OrbitRecurrence;
-using base::jthread;
 using base::not_null;
 using base::Status;
 using geometry::Instant;
@@ -105,9 +104,14 @@ class OrbitAnalyser {
   void Interrupt();
 
   // Sets the parameters that will be used for the computation of the next
-  // analysis.
+  // analysis.  If an analysis is in progress, the next one starts when it
+  // completes, with the parameters of the latest request.
   void RequestAnalysis(Parameters const& parameters);
 
+  // Sets the priority of the analysis with respect to the other computations
+  // of the |PredictionService|.
+  void set_priority(PredictionService::Priority priority);
+
   // The last value passed to |RequestAnalysis|.
   std::optional<Parameters> const& last_parameters() const;
 
@@ -128,6 +132,10 @@ class OrbitAnalyser {
     Parameters parameters;
   };
 
+  // Run by the |analyser_| on a thread of the |PredictionService|; analyses
+  // the orbit using the latest |guarded_parameters_|, if any.
+  Status AnalyseRequestedOrbit();
+
   Status AnalyseOrbit(GuardedParameters guarded_parameters);
 
   not_null<Ephemeris<Barycentric>*> const ephemeris_;
@@ -139,20 +147,18 @@ class OrbitAnalyser {
   std::optional<Analysis> analysis_;
 
   mutable absl::Mutex lock_;
-  jthread analyser_;
-  // The |analyser_| is idle:
-  // — if it is not joinable, e.g. because it was stopped by |Interrupt()|, or
-  // — if it is done computing |next_analysis_| and has stopped or is about to
-  //   stop executing.
-  // If it is joined once idle (and joinable), it will not attempt to acquire
-  // |lock_|.
-  bool analyser_idle_ GUARDED_BY(lock_) = true;
+  // Set by |RequestAnalysis| and cleared by the |analyser_| when it starts an
+  // analysis.
+  std::optional<GuardedParameters> guarded_parameters_ GUARDED_BY(lock_);
   // |next_analysis_| is set by the |analyser_| thread; it is read and cleared
   // by the main thread.
   std::optional<Analysis> next_analysis_ GUARDED_BY(lock_);
   // |progress_of_next_analysis_| is set by the |analyser_| thread; it tracks
   // progress in computing |next_analysis_|.
   std::atomic<double> progress_of_next_analysis_ = 0;
+
+  // Declared last so that it is destroyed, and therefore stopped, first.
+  PredictionService::Client analyser_;
 };
 
 }  // namespace internal_orbit_analyser
@@ -6,7 +6,9 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <tuple>
 #include <utility>
+#include <vector>
 
 #include "base/map_util.hpp"
 #include "geometry/identity.hpp"
@@ -19,6 +21,7 @@ namespace ksp_plugin {
 namespace internal_pile_up {
 
 using base::check_not_null;
+using base::Contains;
 using base::FindOrDie;
 using base::make_not_null_unique;
 using geometry::AngularVelocity;
@@ -44,6 +47,7 @@ using geometry::Sign;
 using geometry::Signature;
 using geometry::Velocity;
 using geometry::Wedge;
+using integrators::FixedStepSizeIntegrator;
 using physics::DegreesOfFreedom;
 using physics::RigidMotion;
 using quantities::Abs;
@@ -122,10 +126,12 @@ void PileUp::SetPartApparentRigidMotion(
                   << rigid_motion;
 }
 
+std::atomic<std::int64_t> PileUp::next_serial_number_ = 0;
+
 Status PileUp::DeformAndAdvanceTime(Instant const& t) {
   absl::MutexLock l(lock_.get());
   Status status;
-  if (psychohistory_->back().time < t) {
+  if (fused_history_last_.has_value() || psychohistory_->back().time < t) {
     DeformPileUpIfNeeded(t);
     status = AdvanceTime(t);
     NudgeParts();
@@ -535,18 +541,26 @@ Status PileUp::AdvanceTime(Instant const& t) {
   CHECK_NOTNULL(psychohistory_);
 
   Status status;
-  auto const history_last = --history_->end();
+  auto const history_last = fused_history_last_.has_value()
+                                ? *fused_history_last_
+                                : --history_->end();
   if (intrinsic_force_ == Vector<Force, Barycentric>{}) {
     // Remove the fork.
     history_->DeleteFork(psychohistory_);
-    if (fixed_instance_ == nullptr) {
-      fixed_instance_ = ephemeris_->NewInstance(
-          {history_.get()},
-          Ephemeris<Barycentric>::NoIntrinsicAccelerations,
-          fixed_step_parameters_);
+    if (fused_history_last_.has_value()) {
+      // The |history_| has already been integrated with those of other
+      // pile-ups.
+      fused_history_last_.reset();
+    } else {
+      if (fixed_instance_ == nullptr) {
+        fixed_instance_ = ephemeris_->NewInstance(
+            {history_.get()},
+            Ephemeris<Barycentric>::NoIntrinsicAccelerations,
+            fixed_step_parameters_);
+      }
+      CHECK_LT(history_->back().time, t);
+      status = ephemeris_->FlowWithFixedStep(t, *fixed_instance_);
     }
-    CHECK_LT(history_->back().time, t);
-    status = ephemeris_->FlowWithFixedStep(t, *fixed_instance_);
     psychohistory_ = history_->NewForkAtLast();
     if (history_->back().time < t) {
       // Do not clear the |fixed_instance_| here, we will use it for the next
@@ -560,6 +574,7 @@ Status PileUp::AdvanceTime(Instant const& t) {
               Ephemeris<Barycentric>::unlimited_max_ephemeris_steps));
     }
   } else {
+    CHECK(!fused_history_last_.has_value());
     // Destroy the fixed instance, it wouldn't be correct to use it the next
     // time we go through this function.  It will be re-created as needed.
     fixed_instance_ = nullptr;
@@ -648,6 +663,136 @@ void PileUp::AppendToPart(DiscreteTrajectory<Barycentric>::Iterator it) const {
   }
 }
 
+void FusedPileUps::AdvanceHistories(std::vector<PileUp*> const& pile_ups,
+                                    Instant const& t,
+                                    ThreadPool<Status>& thread_pool) {
+  using Key = std::tuple<
+      FixedStepSizeIntegrator<
+          Ephemeris<Barycentric>::NewtonianMotionEquation> const*,
+      Time,
+      Instant>;
+
+  // The pile-ups whose histories may be integrated together, i.e., those for
+  // which |AdvanceTime| would use a fixed-step instance, and whose
+  // |DeformPileUpIfNeeded| doesn't depend on the psychohistory.
+  std::map<Key, std::vector<not_null<PileUp*>>> candidates;
+  for (PileUp* const pile_up : pile_ups) {
+    if (pile_up->intrinsic_force_ == Vector<Force, Barycentric>{} &&
+        pile_up->apparent_part_rigid_motion_.empty() &&
+        pile_up->psychohistory_->back().time < t) {
+      auto const& parameters = pile_up->fixed_step_parameters_;
+      candidates[{&parameters.integrator(),
+                  parameters.step(),
+                  pile_up->history_->back().time}].push_back(pile_up);
+    }
+  }
+
+  // A fused integration of the histories of |members| by |group.instance|,
+  // which, if null, is created from the histories.
+  struct Integration {
+    std::vector<not_null<PileUp*>> members;
+    Instant history_last_time;
+    Group group;
+    Status status;
+  };
+  std::vector<Integration> integrations;
+  for (auto const& [key, members] : candidates) {
+    Instant const& history_last_time = std::get<Instant>(key);
+    std::map<std::int64_t, not_null<PileUp*>> unassigned_members;
+    for (not_null<PileUp*> const pile_up : members) {
+      unassigned_members.emplace(pile_up->serial_number_, pile_up);
+    }
+
+    // Reuse the instance of a group of the previous call if all its members
+    // are still here, to preserve the state of the compensated summations.
+    // The pile-ups that joined the grid since then don't affect that group,
+    // they are integrated by a group of their own.
+    for (auto& previous_group : groups_) {
+      if (previous_group.instance == nullptr ||
+          previous_group.instance->time().value != history_last_time ||
+          !std::all_of(previous_group.serial_numbers.begin(),
+                       previous_group.serial_numbers.end(),
+                       [&unassigned_members](std::int64_t const serial_number) {
+                         return Contains(unassigned_members, serial_number);
+                       })) {
+        continue;
+      }
+      auto& integration = integrations.emplace_back();
+      integration.history_last_time = history_last_time;
+      for (std::int64_t const serial_number : previous_group.serial_numbers) {
+        integration.members.push_back(
+            FindOrDie(unassigned_members, serial_number));
+        unassigned_members.erase(serial_number);
+      }
+      integration.group = std::move(previous_group);
+    }
+
+    // A lone pile-up is integrated by its own instance in |AdvanceTime|, which
+    // is therefore preserved.
+    if (unassigned_members.size() < 2) {
+      continue;
+    }
+    auto& integration = integrations.emplace_back();
+    integration.history_last_time = history_last_time;
+    for (auto const& [serial_number, pile_up] : unassigned_members) {
+      integration.members.push_back(pile_up);
+      integration.group.serial_numbers.push_back(serial_number);
+    }
+  }
+
+  // The groups don't share any pile-up, so they are integrated in parallel.
+  {
+    auto batch = thread_pool.NewBatch();
+    batch.Reserve(integrations.size());
+    for (auto& integration : integrations) {
+      batch.Add([&integration, &t]() {
+        auto& [members, history_last_time, group, status] = integration;
+        Ephemeris<Barycentric>& ephemeris = *members.front()->ephemeris_;
+        std::vector<not_null<DiscreteTrajectory<Barycentric>*>> histories;
+        for (not_null<PileUp*> const pile_up : members) {
+          CHECK_EQ(pile_up->ephemeris_, &ephemeris);
+          pile_up->history_->DeleteFork(pile_up->psychohistory_);
+          histories.push_back(pile_up->history_.get());
+        }
+        if (group.instance == nullptr) {
+          group.instance = ephemeris.NewInstance(
+              histories,
+              Ephemeris<Barycentric>::NoIntrinsicAccelerations,
+              members.front()->fixed_step_parameters_);
+        }
+        status = ephemeris.FlowWithFixedStep(t, *group.instance);
+
+        for (not_null<PileUp*> const pile_up : members) {
+          if (status.ok()) {
+            pile_up->fused_history_last_ =
+                pile_up->history_->Find(history_last_time);
+            // The instance of the pile-up, if any, is now behind its history.
+            pile_up->fixed_instance_ = nullptr;
+          } else {
+            // We cannot tell which pile-ups caused the failure, so let them be
+            // integrated separately.
+            pile_up->history_->ForgetAfter(history_last_time);
+          }
+          pile_up->psychohistory_ = pile_up->history_->NewForkAtLast();
+        }
+      });
+    }
+    batch.SubmitAndJoin();
+  }
+
+  std::vector<Group> groups;
+  for (auto& integration : integrations) {
+    if (integration.status.ok()) {
+      groups.push_back(std::move(integration.group));
+    } else {
+      LOG(WARNING) << "Fused integration of " << integration.members.size()
+                   << " pile-ups failed, integrating them separately: "
+                   << integration.status;
+    }
+  }
+  groups_ = std::move(groups);
+}
+
 PileUpFuture::PileUpFuture(not_null<PileUp const*> const pile_up,
                            std::future<Status> future)
     : pile_up(pile_up),
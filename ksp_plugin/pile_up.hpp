@@ -1,6 +1,8 @@
 ﻿
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <future>
 #include <list>
@@ -8,10 +10,12 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 #include "absl/synchronization/mutex.h"
 #include "base/not_null.hpp"
 #include "base/status.hpp"
+#include "base/thread_pool.hpp"
 #include "geometry/frame.hpp"
 #include "geometry/grassmann.hpp"
 #include "geometry/named_quantities.hpp"
@@ -36,6 +40,7 @@ namespace internal_pile_up {
 
 using base::not_null;
 using base::Status;
+using base::ThreadPool;
 using geometry::Arbitrary;
 using geometry::Bivector;
 using geometry::Frame;
@@ -115,9 +120,10 @@ class PileUp {
       RigidMotion<RigidPart, Apparent> const& rigid_motion);
 
   // Deforms the pile-up, advances the time, and nudges the parts, in sequence.
-  // Does nothing if the psychohistory is already advanced beyond |t|.  Several
-  // executions of this method may happen concurrently on multiple threads, but
-  // not concurrently with any other method of this class.
+  // Does nothing if the psychohistory is already advanced beyond |t|, unless
+  // the history was just integrated by |FusedPileUps|.  Several executions of
+  // this method may happen concurrently on multiple threads, but not
+  // concurrently with any other method of this class.
   Status DeformAndAdvanceTime(Instant const& t);
 
   // Recomputes the state of motion of the pile-up based on that of its parts.
@@ -228,6 +234,16 @@ class PileUp {
       Ephemeris<Barycentric>::NewtonianMotionEquation>::Instance>
       fixed_instance_;
 
+  // Set when |FusedPileUps| has integrated the |history_| up to the time
+  // passed to the next call to |AdvanceTime|, in which case it designates the
+  // last point of the |history_| before that integration.
+  std::optional<DiscreteTrajectory<Barycentric>::Iterator> fused_history_last_;
+
+  // Identifies this pile-up in |FusedPileUps|.  Unlike its address, it is never
+  // reused for another pile-up.  Not serialized.
+  std::int64_t serial_number_ = next_serial_number_++;
+  static std::atomic<std::int64_t> next_serial_number_;
+
   PartTo<RigidMotion<RigidPart, NonRotatingPileUp>> actual_part_rigid_motion_;
   PartTo<RigidMotion<RigidPart, Apparent>> apparent_part_rigid_motion_;
 
@@ -238,9 +254,47 @@ class PileUp {
   // Called in the destructor.
   std::function<void()> deletion_callback_;
 
+  friend class FusedPileUps;
   friend class TestablePileUp;
 };
 
+// Integrates together the histories of the pile-ups that are not in the
+// bubble and have no intrinsic force, so that the celestials are evaluated once
+// per stage of the fixed-step integrator for all of them, instead of once per
+// pile-up.  The histories of a group must be integrated on the same grid, so
+// the pile-ups are grouped by fixed-step parameters and by the time of the last
+// point of their histories.  The instance that integrates a group is kept as
+// long as all its members remain eligible, like the |fixed_instance_| of a
+// pile-up; the pile-ups that join its grid form another group.  Since the
+// massless bodies don't interact, the results are the same as if the pile-ups
+// were integrated separately.  This class is not thread-safe.
+class FusedPileUps final {
+ public:
+  // Integrates the histories of the eligible |pile_ups| up to |t|, with one
+  // task per group on |thread_pool|.  The next call to
+  // |DeformAndAdvanceTime(t)| on each of them only integrates its
+  // psychohistory.  If the integration of a group fails, e.g., because of a
+  // collision, the histories of its pile-ups are restored so that
+  // |DeformAndAdvanceTime| integrates them separately and returns their
+  // individual statuses.  Must not be called concurrently with any method of
+  // the |pile_ups|.
+  void AdvanceHistories(std::vector<PileUp*> const& pile_ups,
+                        Instant const& t,
+                        ThreadPool<Status>& thread_pool);
+
+ private:
+  struct Group {
+    // The serial numbers of the pile-ups, in the order of the trajectories of
+    // the |instance|.
+    std::vector<std::int64_t> serial_numbers;
+    std::unique_ptr<typename Integrator<
+        Ephemeris<Barycentric>::NewtonianMotionEquation>::Instance>
+        instance;
+  };
+
+  std::vector<Group> groups_;
+};
+
 // A convenient data object to track a pile-up and the result of integrating it.
 struct PileUpFuture {
   PileUpFuture(not_null<PileUp const*> pile_up, std::future<Status> future);
@@ -250,6 +304,7 @@ struct PileUpFuture {
 
 }  // namespace internal_pile_up
 
+using internal_pile_up::FusedPileUps;
 using internal_pile_up::PileUp;
 using internal_pile_up::PileUpFuture;
 
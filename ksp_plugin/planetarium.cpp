@@ -23,12 +23,38 @@ using quantities::Pow;
 using quantities::Sin;
 using quantities::Sqrt;
 using quantities::Tan;
-using quantities::Time;
 
 namespace {
 constexpr int max_plot_method_2_steps = 10'000;
 }  // namespace
 
+void PlottingCache::NewFrame() {
+  absl::MutexLock l(&lock_);
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    Entry& entry = *it->second;
+    bool used;
+    {
+      absl::MutexLock l(&entry.lock);
+      used = entry.used;
+      entry.used = false;
+    }
+    if (used) {
+      ++it;
+    } else {
+      it = entries_.erase(it);
+    }
+  }
+}
+
+not_null<PlottingCache::Entry*> PlottingCache::GetOrCreate(Key const& key) {
+  absl::MutexLock l(&lock_);
+  auto& entry = entries_[key];
+  if (entry == nullptr) {
+    entry = std::make_unique<Entry>();
+  }
+  return entry.get();
+}
+
 Planetarium::Parameters::Parameters(double const sphere_radius_multiplier,
                                     Angle const& angular_resolution,
                                     Angle const& field_of_view)
@@ -41,11 +67,15 @@ Planetarium::Planetarium(
     Parameters const& parameters,
     Perspective<Navigation, Camera> perspective,
     not_null<Ephemeris<Barycentric> const*> const ephemeris,
-    not_null<NavigationFrame const*> const plotting_frame)
+    not_null<NavigationFrame const*> const plotting_frame,
+    PlottingCache* const plotting_cache,
+    ThreadPool<Status>* const thread_pool)
     : parameters_(parameters),
       perspective_(std::move(perspective)),
       ephemeris_(ephemeris),
-      plotting_frame_(plotting_frame) {}
+      plotting_frame_(plotting_frame),
+      plotting_cache_(plotting_cache),
+      thread_pool_(thread_pool) {}
 
 RP2Lines<Length, Camera> Planetarium::PlotMethod0(
     DiscreteTrajectory<Barycentric>::Iterator const& begin,
@@ -156,41 +186,140 @@ RP2Lines<Length, Camera> Planetarium::PlotMethod2(
     Instant const& last_time,
     Instant const& now,
     bool const reverse) const {
-  RP2Lines<Length, Camera> lines;
+  if (last_time <= first_time) {
+    return {};
+  }
+  return PlotMethod2(trajectory,
+                     first_time,
+                     last_time,
+                     reverse,
+                     ComputePlottableSpheres(now));
+}
+
+std::vector<RP2Lines<Length, Camera>> Planetarium::PlotMethod2(
+    std::vector<PlottedTrajectory> const& trajectories,
+    Instant const& now) const {
+  std::vector<RP2Lines<Length, Camera>> lines(trajectories.size());
   auto const plottable_spheres = ComputePlottableSpheres(now);
+  auto const plot = [this, &lines, &plottable_spheres, &trajectories](
+                        int const i) {
+    PlottedTrajectory const& plotted = trajectories[i];
+    lines[i] = PlotMethod2(*plotted.trajectory,
+                           plotted.first_time,
+                           plotted.last_time,
+                           plotted.reverse,
+                           plottable_spheres);
+  };
+  if (thread_pool_ == nullptr) {
+    for (int i = 0; i < trajectories.size(); ++i) {
+      plot(i);
+    }
+  } else {
+    auto batch = thread_pool_->NewBatch();
+    batch.Reserve(trajectories.size());
+    for (int i = 0; i < trajectories.size(); ++i) {
+      batch.Add([&plot, i]() { plot(i); });
+    }
+    batch.SubmitAndJoin();
+  }
+  return lines;
+}
+
+RP2Lines<Length, Camera> Planetarium::PlotMethod2(
+    Trajectory<Barycentric> const& trajectory,
+    Instant const& first_time,
+    Instant const& last_time,
+    bool const reverse,
+    SphereSet<Navigation> const& plottable_spheres) const {
+  RP2Lines<Length, Camera> lines;
+  if (last_time <= first_time) {
+    return lines;
+  }
+
+  std::vector<Sample> samples;
+  if (plotting_cache_ == nullptr) {
+    auto const final_time = reverse ? first_time : last_time;
+    auto const initial_time = reverse ? last_time : first_time;
+    samples.push_back(ComputeSample(trajectory, initial_time));
+    AppendSamples(trajectory,
+                  final_time,
+                  /*Δt=*/final_time - initial_time,
+                  max_plot_method_2_steps,
+                  samples);
+  } else {
+    samples = CachedSamples(trajectory, first_time, last_time, reverse);
+    if (reverse) {
+      std::reverse(samples.begin(), samples.end());
+    }
+  }
+
+  std::optional<Position<Navigation>> last_endpoint;
+  for (int i = 1; i < samples.size(); ++i) {
+    Position<Navigation> const previous_position =
+        samples[i - 1].degrees_of_freedom.position();
+    Position<Navigation> const position =
+        samples[i].degrees_of_freedom.position();
+
+    // TODO(egg): also limit to field of view.
+    auto const segment_behind_focal_plane =
+        perspective_.SegmentBehindFocalPlane(
+            Segment<Navigation>(previous_position, position));
+    if (!segment_behind_focal_plane) {
+      continue;
+    }
+
+    auto const visible_segments = perspective_.VisibleSegments(
+                                      *segment_behind_focal_plane,
+                                      plottable_spheres);
+    for (auto const& segment : visible_segments) {
+      if (last_endpoint != segment.first) {
+        lines.emplace_back();
+        lines.back().push_back(perspective_(segment.first));
+      }
+      lines.back().push_back(perspective_(segment.second));
+      last_endpoint = segment.second;
+    }
+  }
+  return lines;
+}
+
+Planetarium::Sample Planetarium::ComputeSample(
+    Trajectory<Barycentric> const& trajectory,
+    Instant const& t) const {
+  return {t,
+          plotting_frame_->ToThisFrameAtTime(t)(
+              trajectory.EvaluateDegreesOfFreedom(t))};
+}
+
+void Planetarium::AppendSamples(Trajectory<Barycentric> const& trajectory,
+                                Instant const& final_time,
+                                Time Δt,
+                                int const max_steps,
+                                std::vector<Sample>& samples) const {
   double const tan²_angular_resolution =
       Pow<2>(parameters_.tan_angular_resolution_);
-  auto const final_time = reverse ? first_time : last_time;
-  auto previous_time = reverse ? last_time : first_time;
-
-  Sign const direction = reverse ? Sign::Negative() : Sign::Positive();
+  Instant previous_time = samples.back().time;
+  Sign const direction(final_time - previous_time);
   if (direction * (final_time - previous_time) <= Time{}) {
-    return lines;
+    return;
   }
-  RigidMotion<Barycentric, Navigation> to_plotting_frame_at_t =
-      plotting_frame_->ToThisFrameAtTime(previous_time);
-  DegreesOfFreedom<Navigation> const initial_degrees_of_freedom =
-      to_plotting_frame_at_t(
-          trajectory.EvaluateDegreesOfFreedom(previous_time));
   Position<Navigation> previous_position =
-      initial_degrees_of_freedom.position();
+      samples.back().degrees_of_freedom.position();
   Velocity<Navigation> previous_velocity =
-      initial_degrees_of_freedom.velocity();
-  Time Δt = final_time - previous_time;
+      samples.back().degrees_of_freedom.velocity();
 
   Instant t;
   double estimated_tan²_error;
   std::optional<DegreesOfFreedom<Barycentric>>
       degrees_of_freedom_in_barycentric;
+  std::optional<RigidMotion<Barycentric, Navigation>> to_plotting_frame_at_t;
   Position<Navigation> position;
 
-  std::optional<Position<Navigation>> last_endpoint;
-
   int steps_accepted = 0;
 
   goto estimate_tan²_error;
 
-  while (steps_accepted < max_plot_method_2_steps &&
+  while (steps_accepted < max_steps &&
          direction * (previous_time - final_time) < Time{}) {
     do {
       // One square root because we have squared errors, another one because the
@@ -209,7 +338,7 @@ RP2Lines<Length, Camera> Planetarium::PlotMethod2(
       to_plotting_frame_at_t = plotting_frame_->ToThisFrameAtTime(t);
       degrees_of_freedom_in_barycentric =
           trajectory.EvaluateDegreesOfFreedom(t);
-      position = to_plotting_frame_at_t.rigid_transformation()(
+      position = to_plotting_frame_at_t->rigid_transformation()(
                      degrees_of_freedom_in_barycentric->position());
 
       // The quadratic term of the error between the linear interpolation and
@@ -222,36 +351,141 @@ RP2Lines<Length, Camera> Planetarium::PlotMethod2(
     } while (estimated_tan²_error > tan²_angular_resolution);
     ++steps_accepted;
 
-    // TODO(egg): also limit to field of view.
-    auto const segment_behind_focal_plane =
-        perspective_.SegmentBehindFocalPlane(
-            Segment<Navigation>(previous_position, position));
-
     previous_time = t;
     previous_position = position;
     previous_velocity =
-        to_plotting_frame_at_t(*degrees_of_freedom_in_barycentric).velocity();
+        (*to_plotting_frame_at_t)(*degrees_of_freedom_in_barycentric)
+            .velocity();
+    samples.push_back(
+        {t, DegreesOfFreedom<Navigation>(previous_position,
+                                         previous_velocity)});
+  }
+}
 
-    if (!segment_behind_focal_plane) {
-      continue;
-    }
+bool Planetarium::IsWithinAngularResolution(Sample const& previous,
+                                            Sample const& current) const {
+  double const tan²_angular_resolution =
+      Pow<2>(parameters_.tan_angular_resolution_);
+  Position<Navigation> const extrapolated_position =
+      previous.degrees_of_freedom.position() +
+      previous.degrees_of_freedom.velocity() * (current.time - previous.time);
+  // See |AppendSamples| for the factor 16.
+  double const estimated_tan²_error =
+      perspective_.Tan²AngularDistance(
+          extrapolated_position, current.degrees_of_freedom.position()) /
+      16;
+  return estimated_tan²_error <= tan²_angular_resolution;
+}
 
-    auto const visible_segments = perspective_.VisibleSegments(
-                                      *segment_behind_focal_plane,
-                                      plottable_spheres);
-    for (auto const& segment : visible_segments) {
-      if (last_endpoint != segment.first) {
-        lines.emplace_back();
-        lines.back().push_back(perspective_(segment.first));
+std::vector<Planetarium::Sample> Planetarium::CachedSamples(
+    Trajectory<Barycentric> const& trajectory,
+    Instant const& first_time,
+    Instant const& last_time,
+    bool const reverse) const {
+  not_null<PlottingCache::Entry*> const entry =
+      plotting_cache_->GetOrCreate({&trajectory, reverse});
+  absl::MutexLock l(&entry->lock);
+  entry->used = true;
+  std::vector<Sample>& cached = entry->samples;
+
+  // Drop the points outside of the interval to plot.
+  cached.erase(std::upper_bound(cached.begin(),
+                                cached.end(),
+                                last_time,
+                                [](Instant const& t, Sample const& sample) {
+                                  return t < sample.time;
+                                }),
+               cached.end());
+  cached.erase(cached.begin(),
+               std::lower_bound(cached.begin(),
+                                cached.end(),
+                                first_time,
+                                [](Sample const& sample, Instant const& t) {
+                                  return sample.time < t;
+                                }));
+
+  // Drop the points that don't match the trajectory in the plotting frame.  We
+  // assume that trajectories only change after some time (e.g., a prediction
+  // that is recomputed) so the valid points form a prefix, which we find by
+  // bisection.  Usually the last point is valid and this costs a single
+  // evaluation.
+  auto const is_valid = [this, &trajectory](Sample const& sample) {
+    return ComputeSample(trajectory, sample.time).degrees_of_freedom ==
+           sample.degrees_of_freedom;
+  };
+  if (!cached.empty() && !is_valid(cached.back())) {
+    // Invariant: the points before |low| are valid, those at or after |high|
+    // are not.
+    int low = 0;
+    int high = cached.size() - 1;
+    while (low < high) {
+      int const middle = low + (high - low) / 2;
+      if (is_valid(cached[middle])) {
+        low = middle + 1;
+      } else {
+        high = middle;
       }
-      lines.back().push_back(perspective_(segment.second));
-      last_endpoint = segment.second;
     }
+    cached.erase(cached.begin() + high, cached.end());
   }
-  return lines;
+
+  // The perspective may have changed since the points were cached.  Drop the
+  // points after the first segment that is not within the angular resolution
+  // (e.g., because the camera zoomed in), and the points that are not needed
+  // to stay within the angular resolution (e.g., because the camera zoomed
+  // out).
+  std::vector<Sample> resolved;
+  resolved.reserve(cached.size());
+  for (auto const& sample : cached) {
+    if (!resolved.empty() &&
+        !IsWithinAngularResolution(resolved.back(), sample)) {
+      break;
+    }
+    if (resolved.size() >= 2 &&
+        IsWithinAngularResolution(resolved[resolved.size() - 2], sample)) {
+      resolved.back() = sample;
+    } else {
+      resolved.push_back(sample);
+    }
+  }
+  cached = std::move(resolved);
+
+  // Compute the points from |first_time| to the first cached point, if any.
+  if (cached.empty() || first_time < cached.front().time) {
+    std::vector<Sample> head = {ComputeSample(trajectory, first_time)};
+    Instant const head_final_time =
+        cached.empty() ? last_time : cached.front().time;
+    AppendSamples(trajectory,
+                  head_final_time,
+                  /*Δt=*/head_final_time - first_time,
+                  max_plot_method_2_steps,
+                  head);
+    if (!cached.empty() && head.back().time == cached.front().time) {
+      // The cached point is identical to the one that was just computed.
+      head.pop_back();
+    }
+    cached.insert(cached.begin(), head.begin(), head.end());
+  }
+
+  // Compute the points from the last cached point to |last_time|.  The last
+  // segment was shortened to end at the previous |last_time|, so we recompute
+  // it.
+  if (cached.back().time < last_time) {
+    Time Δt = last_time - cached.back().time;
+    if (cached.size() >= 2) {
+      Δt = cached.back().time - cached[cached.size() - 2].time;
+      cached.pop_back();
+    }
+    AppendSamples(trajectory,
+                  last_time,
+                  Δt,
+                  max_plot_method_2_steps + 1 - cached.size(),
+                  cached);
+  }
+  return cached;
 }
 
-std::vector<Sphere<Navigation>> Planetarium::ComputePlottableSpheres(
+SphereSet<Navigation> Planetarium::ComputePlottableSpheres(
     Instant const& now) const {
   RigidMotion<Barycentric, Navigation> const rigid_motion_at_now =
       plotting_frame_->ToThisFrameAtTime(now);
@@ -273,11 +507,11 @@ std::vector<Sphere<Navigation>> Planetarium::ComputePlottableSpheres(
       plottable_spheres.emplace_back(std::move(plottable_sphere));
     }
   }
-  return plottable_spheres;
+  return SphereSet<Navigation>(std::move(plottable_spheres));
 }
 
 Segments<Navigation> Planetarium::ComputePlottableSegments(
-    const std::vector<Sphere<Navigation>>& plottable_spheres,
+    SphereSet<Navigation> const& plottable_spheres,
     DiscreteTrajectory<Barycentric>::Iterator const& begin,
     DiscreteTrajectory<Barycentric>::Iterator const& end) const {
   Segments<Navigation> all_segments;
@@ -1,14 +1,22 @@
 ﻿
 #pragma once
 
+#include <map>
+#include <memory>
+#include <utility>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
 #include "base/not_null.hpp"
+#include "base/status.hpp"
+#include "base/thread_pool.hpp"
 #include "geometry/named_quantities.hpp"
 #include "geometry/orthogonal_map.hpp"
 #include "geometry/perspective.hpp"
 #include "geometry/rp2_point.hpp"
 #include "geometry/sphere.hpp"
+#include "geometry/sphere_set.hpp"
 #include "ksp_plugin/frames.hpp"
 #include "physics/degrees_of_freedom.hpp"
 #include "physics/discrete_trajectory.hpp"
@@ -21,6 +29,8 @@ namespace ksp_plugin {
 namespace internal_planetarium {
 
 using base::not_null;
+using base::Status;
+using base::ThreadPool;
 using geometry::Displacement;
 using geometry::Instant;
 using geometry::OrthogonalMap;
@@ -30,6 +40,7 @@ using geometry::RP2Point;
 using geometry::Segment;
 using geometry::Segments;
 using geometry::Sphere;
+using geometry::SphereSet;
 using physics::DegreesOfFreedom;
 using physics::DiscreteTrajectory;
 using physics::Ephemeris;
@@ -37,6 +48,43 @@ using physics::RigidMotion;
 using physics::Trajectory;
 using quantities::Angle;
 using quantities::Length;
+using quantities::Time;
+
+// The points of trajectories computed by |Planetarium::PlotMethod2|, kept from
+// one frame to the next so that only the parts of the trajectories that have
+// changed need to be recomputed.  A cache outlives the planetaria that use it.
+// This class is thread-safe, but |NewFrame| must not be called while plotting.
+class PlottingCache final {
+ public:
+  // Evicts the trajectories that were not plotted since the previous call.
+  void NewFrame() EXCLUDES(lock_);
+
+ private:
+  // A point of a trajectory, in the plotting frame.
+  struct Sample final {
+    Instant time;
+    DegreesOfFreedom<Navigation> degrees_of_freedom;
+  };
+
+  struct Entry final {
+    absl::Mutex lock;
+    bool used GUARDED_BY(lock) = true;
+    // In increasing order of time.
+    std::vector<Sample> samples GUARDED_BY(lock);
+  };
+
+  // The trajectories plotted forward and backward are cached separately since
+  // they typically cover different intervals, e.g., for a celestial.
+  using Key = std::pair<Trajectory<Barycentric> const*, /*reverse=*/bool>;
+
+  // Returns the entry for the given key, creating it if needed.
+  not_null<Entry*> GetOrCreate(Key const& key) EXCLUDES(lock_);
+
+  absl::Mutex lock_;
+  std::map<Key, std::unique_ptr<Entry>> entries_ GUARDED_BY(lock_);
+
+  friend class Planetarium;
+};
 
 // A planetarium is an ephemeris together with a perspective.  In this setting
 // it is possible to draw trajectories in the projective plane.
@@ -62,10 +110,24 @@ class Planetarium {
 
   // TODO(phl): All this Navigation is weird.  Should it be named Plotting?
   // In particular Navigation vs. NavigationFrame is a mess.
+  // A trajectory and the interval over which to plot it.
+  struct PlottedTrajectory final {
+    not_null<Trajectory<Barycentric> const*> trajectory;
+    Instant first_time;
+    Instant last_time;
+    bool reverse;
+  };
+
+  // If |plotting_cache| is not null, |PlotMethod2| reuses the points that it
+  // computed for earlier planetaria, as long as the trajectory and the plotting
+  // frame haven't changed.  If |thread_pool| is not null, the batched
+  // |PlotMethod2| uses it to plot the trajectories concurrently.
   Planetarium(Parameters const& parameters,
               Perspective<Navigation, Camera> perspective,
               not_null<Ephemeris<Barycentric> const*> ephemeris,
-              not_null<NavigationFrame const*> plotting_frame);
+              not_null<NavigationFrame const*> plotting_frame,
+              PlottingCache* plotting_cache = nullptr,
+              ThreadPool<Status>* thread_pool = nullptr);
 
   // A no-op method that just returns all the points in the trajectory defined
   // by |begin| and |end|.
@@ -100,28 +162,77 @@ class Planetarium {
       Instant const& now,
       bool reverse) const;
 
+  // The same method, for a batch of trajectories, which are plotted
+  // concurrently if this object has a thread pool.  The plottable spheres are
+  // only computed once.  The result has one element per element of
+  // |trajectories|.
+  std::vector<RP2Lines<Length, Camera>> PlotMethod2(
+      std::vector<PlottedTrajectory> const& trajectories,
+      Instant const& now) const;
+
  private:
   // Computes the coordinates of the spheres that represent the |ephemeris_|
   // bodies.  These coordinates are in the |plotting_frame_| at time |now|.
-  std::vector<Sphere<Navigation>> ComputePlottableSpheres(
+  SphereSet<Navigation> ComputePlottableSpheres(
       Instant const& now) const;
 
   // Computes the segments of the trajectory defined by |begin| and |end| that
   // are not hidden by the |plottable_spheres|.
   Segments<Navigation> ComputePlottableSegments(
-      const std::vector<Sphere<Navigation>>& plottable_spheres,
+      SphereSet<Navigation> const& plottable_spheres,
       DiscreteTrajectory<Barycentric>::Iterator const& begin,
       DiscreteTrajectory<Barycentric>::Iterator const& end) const;
 
+  using Sample = PlottingCache::Sample;
+
+  // Same as the public |PlotMethod2|, but with the spheres that hide the
+  // trajectory already computed.
+  RP2Lines<Length, Camera> PlotMethod2(
+      Trajectory<Barycentric> const& trajectory,
+      Instant const& first_time,
+      Instant const& last_time,
+      bool reverse,
+      SphereSet<Navigation> const& plottable_spheres) const;
+
+  // Returns the point of |trajectory| at time |t|, in the plotting frame.
+  Sample ComputeSample(Trajectory<Barycentric> const& trajectory,
+                       Instant const& t) const;
+
+  // Appends to |samples| the points of |trajectory| after |samples.back()| up
+  // to |final_time| (which may be before |samples.back()|), chosen so that the
+  // segments between them are within the angular resolution.  The first step
+  // tried is |Δt|.  At most |max_steps| points are appended.
+  void AppendSamples(Trajectory<Barycentric> const& trajectory,
+                     Instant const& final_time,
+                     Time Δt,
+                     int max_steps,
+                     std::vector<Sample>& samples) const;
+
+  // Returns true if the segment between |previous| and |current| is within the
+  // angular resolution.
+  bool IsWithinAngularResolution(Sample const& previous,
+                                 Sample const& current) const;
+
+  // Returns the points of |trajectory| between |first_time| and |last_time|, in
+  // increasing order of time, reusing those of the |plotting_cache_|, and
+  // updates the cache.
+  std::vector<Sample> CachedSamples(Trajectory<Barycentric> const& trajectory,
+                                    Instant const& first_time,
+                                    Instant const& last_time,
+                                    bool reverse) const;
+
   Parameters const parameters_;
   Perspective<Navigation, Camera> const perspective_;
   not_null<Ephemeris<Barycentric> const*> const ephemeris_;
   not_null<NavigationFrame const*> const plotting_frame_;
+  PlottingCache* const plotting_cache_;
+  ThreadPool<Status>* const thread_pool_;
 };
 
 }  // namespace internal_planetarium
 
 using internal_planetarium::Planetarium;
+using internal_planetarium::PlottingCache;
 
 }  // namespace ksp_plugin
 }  // namespace principia
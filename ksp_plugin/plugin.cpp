@@ -2,25 +2,38 @@
 #include "ksp_plugin/plugin.hpp"
 
 #include <algorithm>
+#include <charconv>
 #include <cmath>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <iomanip>
 #include <ios>
 #include <limits>
 #include <list>
 #include <map>
 #include <optional>
 #include <set>
+#include <sstream>
 #include <string>
+#include <system_error>
 #include <thread>
+#include <tuple>
 #include <utility>
 #include <vector>
+#if OS_WIN
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
 
 #include "astronomy/epoch.hpp"
 #include "astronomy/solar_system_fingerprints.hpp"
 #include "astronomy/stabilize_ksp.hpp"
 #include "astronomy/time_scales.hpp"
 #include "base/file.hpp"
+#include "base/fingerprint2011.hpp"
+#include "base/flags.hpp"
 #include "base/hexadecimal.hpp"
 #include "base/map_util.hpp"
 #include "base/not_null.hpp"
@@ -28,6 +41,7 @@
 #include "base/serialization.hpp"
 #include "base/status.hpp"
 #include "base/unique_ptr_logging.hpp"
+#include "base/version.hpp"
 #include "geometry/affine_map.hpp"
 #include "geometry/barycentre_calculator.hpp"
 #include "geometry/frame.hpp"
@@ -41,6 +55,7 @@
 #include "ksp_plugin/integrators.hpp"
 #include "ksp_plugin/part.hpp"
 #include "ksp_plugin/part_subsets.hpp"
+#include "ksp_plugin/prediction_service.hpp"
 #include "physics/apsides.hpp"
 #include "physics/barycentric_rotating_dynamic_frame_body.hpp"
 #include "physics/body_centred_body_direction_dynamic_frame.hpp"
@@ -58,6 +73,7 @@ namespace principia {
 namespace ksp_plugin {
 namespace internal_plugin {
 
+using astronomy::InfinitePast;
 using astronomy::KSP122;
 using astronomy::KSP191;
 using astronomy::KSPStabilizedSystemFingerprints;
@@ -69,8 +85,11 @@ using base::dynamic_cast_not_null;
 using base::Error;
 using base::FindOrDie;
 using base::Fingerprint2011;
+using base::FingerprintCat2011;
+using base::Flags;
 using base::HexadecimalEncoder;
 using base::make_not_null_unique;
+using base::MakeStoppableThread;
 using base::not_null;
 using base::OFStream;
 using base::SerializeAsBytes;
@@ -94,7 +113,7 @@ using physics::BodyCentredBodyDirectionDynamicFrame;
 using physics::BodyCentredNonRotatingDynamicFrame;
 using physics::BodySurfaceDynamicFrame;
 using physics::BodySurfaceFrameField;
-using physics::ComputeApsides;
+using physics::ComputeClosestApproaches;
 using physics::ComputeNodes;
 using physics::CoordinateFrameField;
 using physics::DynamicFrame;
@@ -107,6 +126,7 @@ using quantities::Force;
 using quantities::Infinity;
 using quantities::Length;
 using quantities::MomentOfInertia;
+using quantities::si::Day;
 using quantities::si::Milli;
 using quantities::si::Minute;
 using quantities::si::Radian;
@@ -115,10 +135,10 @@ using ::operator<<;
 Plugin::Plugin(std::string const& game_epoch,
                std::string const& solar_system_epoch,
                Angle const& planetarium_rotation)
-    : history_parameters_(DefaultHistoryParameters()),
-      psychohistory_parameters_(DefaultPsychohistoryParameters()),
-      vessel_thread_pool_(
+    : vessel_thread_pool_(
           /*pool_size=*/2 * std::thread::hardware_concurrency()),
+      history_parameters_(DefaultHistoryParameters()),
+      psychohistory_parameters_(DefaultPsychohistoryParameters()),
       planetarium_rotation_(planetarium_rotation),
       game_epoch_(ParseTT(game_epoch)),
       current_time_(ParseTT(solar_system_epoch)) {
@@ -128,6 +148,9 @@ Plugin::Plugin(std::string const& game_epoch,
 }
 
 Plugin::~Plugin() {
+  // The writer of the ephemeris cache uses the ephemeris, so it must be stopped
+  // first.
+  ephemeris_cache_writer_ = base::jthread();
   // We must manually destroy the vessels, triggering the destruction of the
   // parts, which have callbacks to remove themselves from |part_id_to_vessel_|,
   // which must therefore still exist.  This also causes the parts to be
@@ -232,6 +255,8 @@ void Plugin::EndInitialization() {
                                      DefaultEphemerisAccuracyParameters()),
                                  ephemeris_fixed_step_parameters_.value_or(
                                      DefaultEphemerisFixedStepParameters()));
+  ephemeris_cache_t_max_ = current_time_;
+  ReadEphemerisCache();
 
   // Construct the celestials using the bodies from the ephemeris.
   for (std::string const& name : solar_system.names()) {
@@ -400,6 +425,7 @@ void Plugin::InsertOrKeepVessel(GUID const& vessel_guid,
   }
   if (loaded) {
     loaded_vessels_.insert(vessel);
+    vessel->RequestHistory();
   }
   LOG_IF(INFO, inserted) << "Inserted " << (loaded ? "loaded" : "unloaded")
                          << " vessel " << vessel->ShortDebugString();
@@ -757,34 +783,56 @@ void Plugin::AdvanceTime(Instant const& t, Angle const& planetarium_rotation) {
   current_time_ = t;
   planetarium_rotation_ = planetarium_rotation;
   ephemeris_->Prolong(current_time_);
+  WriteEphemerisCacheIfNeeded();
   UpdatePlanetariumRotation();
   loaded_vessels_.clear();
+
+  // Drop the apsis detectors of the trajectories that are no longer rendered,
+  // e.g., because they were destroyed.
+  for (auto it = apsis_detectors_.begin(); it != apsis_detectors_.end();) {
+    if (it->second.used) {
+      it->second.used = false;
+      ++it;
+    } else {
+      it = apsis_detectors_.erase(it);
+    }
+  }
 }
 
 void Plugin::CatchUpLaggingVessels(VesselSet& collided_vessels) {
   CHECK(!initializing_);
 
-  // Start all the integrations in parallel.
-  std::vector<PileUpFuture> pile_up_futures;
-  for (auto* const pile_up : pile_ups_) {
-    pile_up_futures.emplace_back(
-        pile_up,
-        vessel_thread_pool_.Add([this, pile_up]() {
-          // Note that there cannot be contention in the following method as
-          // no two pile-ups are advanced at the same time.
-          return pile_up->DeformAndAdvanceTime(current_time_);
-        }));
+  std::vector<PileUp*> const pile_ups(pile_ups_.begin(), pile_ups_.end());
+
+  // Integrate the histories of the unloaded pile-ups together, so that the
+  // celestials are evaluated once for all of them.
+  fused_pile_ups_.AdvanceHistories(
+      pile_ups, current_time_, vessel_thread_pool_);
+
+  // Start all the remaining integrations in parallel.  A batch is cheaper than
+  // one future per pile-up.
+  std::vector<Status> statuses(pile_ups.size());
+  {
+    auto batch = vessel_thread_pool_.NewBatch();
+    batch.Reserve(pile_ups.size());
+    for (std::int64_t i = 0; i < pile_ups.size(); ++i) {
+      batch.Add([this, pile_up = pile_ups[i], &status = statuses[i]]() {
+        // Note that there cannot be contention in the following method as
+        // no two pile-ups are advanced at the same time.
+        status = pile_up->DeformAndAdvanceTime(current_time_);
+      });
+    }
+    batch.SubmitAndJoin();
   }
 
-  // Wait for the integrations to finish and figure out which vessels collided
-  // with a celestial.
-  for (auto& pile_up_future : pile_up_futures) {
-    WaitForVesselToCatchUp(pile_up_future, collided_vessels);
+  // Figure out which vessels collided with a celestial.
+  for (std::int64_t i = 0; i < pile_ups.size(); ++i) {
+    RecordCollisions(*pile_ups[i], statuses[i], collided_vessels);
   }
 
   // Update the vessels.
   for (auto const& [_, vessel] : vessels_) {
-    if (vessel->psychohistory().back().time < current_time_) {
+    if (vessel->psychohistory_back().time < current_time_) {
       if (Contains(collided_vessels, vessel.get())) {
         vessel->DisableDownsampling();
       }
@@ -824,18 +872,7 @@ void Plugin::WaitForVesselToCatchUp(PileUpFuture& pile_up_future,
   PileUp const* const pile_up = pile_up_future.pile_up;
   auto& future = pile_up_future.future;
   future.wait();
-  Status const status = future.get();
-  if (!status.ok()) {
-    for (not_null<Part*> const part : pile_up->parts()) {
-      not_null<Vessel*> const vessel =
-          FindOrDie(part_id_to_vessel_, part->part_id());
-      if (bool const inserted = collided_vessels.insert(vessel).second;
-          inserted) {
-        LOG(WARNING) << "Vessel " << vessel->ShortDebugString()
-                     << " collided with a celestial: " << status.ToString();
-      }
-    }
-  }
+  RecordCollisions(*pile_up, future.get(), collided_vessels);
 }
 
 RelativeDegreesOfFreedom<AliceSun> Plugin::VesselFromParent(
@@ -850,7 +887,7 @@ RelativeDegreesOfFreedom<AliceSun> Plugin::VesselFromParent(
     vessel->set_parent(parent);
   }
   RelativeDegreesOfFreedom<Barycentric> const barycentric_result =
-      vessel->psychohistory().back().degrees_of_freedom -
+      vessel->psychohistory_back().degrees_of_freedom -
       vessel->parent()->current_degrees_of_freedom(current_time_);
   RelativeDegreesOfFreedom<AliceSun> const result =
       PlanetariumRotation()(barycentric_result);
@@ -901,21 +938,39 @@ void Plugin::UpdatePrediction(std::vector<GUID> const& vessel_guids) const {
   // targeting frame.
   if (renderer_->HasTargetVessel()) {
     target_vessel = &renderer_->GetTargetVessel();
+  }
+
+  // The prognosticators of all the vessels share the threads of the
+  // |PredictionService|, so make sure that the ones that the user is looking
+  // at come first.
+  for (auto const& [guid, vessel] : vessels_) {
+    if (Contains(predicted_vessels, vessel.get())) {
+      vessel->set_prediction_priority(
+          PredictionService::Priority::ActiveVessel);
+    } else if (vessel.get() == target_vessel) {
+      vessel->set_prediction_priority(
+          PredictionService::Priority::TargetVessel);
+    } else {
+      vessel->set_prediction_priority(PredictionService::Priority::Other);
+      vessel->StopPrognosticator();
+    }
+  }
+
+  if (target_vessel != nullptr) {
     target_vessel->RefreshPrediction();
+    Instant const& prediction_last_time =
+        target_vessel->prediction().back().time;
     for (auto const vessel : predicted_vessels) {
-      vessel->RefreshPrediction(target_vessel->prediction().back().time);
+      vessel->RefreshPrediction(prediction_last_time);
+      ForgetApsidesAfter(vessel->guid(),
+                         VesselTrajectory::Prediction,
+                         prediction_last_time);
     }
   } else {
     for (auto const vessel : predicted_vessels) {
       vessel->RefreshPrediction();
     }
   }
-  for (auto const& [guid, vessel] : vessels_) {
-    if (!Contains(predicted_vessels, vessel.get()) &&
-        vessel.get() != target_vessel) {
-      vessel->StopPrognosticator();
-    }
-  }
 }
 
 void Plugin::CreateFlightPlan(GUID const& vessel_guid,
@@ -933,30 +988,44 @@ void Plugin::CreateFlightPlan(GUID const& vessel_guid,
 
 void Plugin::ComputeAndRenderApsides(
     Index const celestial_index,
+    GUID const& vessel_guid,
+    VesselTrajectory const trajectory,
     DiscreteTrajectory<Barycentric>::Iterator const& begin,
     DiscreteTrajectory<Barycentric>::Iterator const& end,
     Position<World> const& sun_world_position,
     int const max_points,
     std::unique_ptr<DiscreteTrajectory<World>>& apoapsides,
     std::unique_ptr<DiscreteTrajectory<World>>& periapsides) const {
-  DiscreteTrajectory<Barycentric> apoapsides_trajectory;
-  DiscreteTrajectory<Barycentric> periapsides_trajectory;
-  ComputeApsides(FindOrDie(celestials_, celestial_index)->trajectory(),
-                 begin,
-                 end,
-                 max_points,
-                 apoapsides_trajectory,
-                 periapsides_trajectory);
+  auto const [it, inserted] = apsis_detectors_.emplace(
+      std::piecewise_construct,
+      std::forward_as_tuple(vessel_guid, trajectory, celestial_index),
+      std::forward_as_tuple(
+          &FindOrDie(celestials_, celestial_index)->trajectory()));
+  CachedApsisDetector& cached = it->second;
+  cached.used = true;
+  cached.detector.Update(begin, end);
+
+  // Only the first |max_points| apsides of each kind are rendered.
+  auto const first_points =
+      [max_points](DiscreteTrajectory<Barycentric> const& apsides) {
+        auto last = apsides.begin();
+        for (int i = 0; i < max_points && last != apsides.end(); ++i) {
+          ++last;
+        }
+        return last;
+      };
+  auto const& apoapsides_trajectory = cached.detector.apoapsides();
+  auto const& periapsides_trajectory = cached.detector.periapsides();
   apoapsides = renderer_->RenderBarycentricTrajectoryInWorld(
                    current_time_,
                    apoapsides_trajectory.begin(),
-                   apoapsides_trajectory.end(),
+                   first_points(apoapsides_trajectory),
                    sun_world_position,
                    PlanetariumRotation());
   periapsides = renderer_->RenderBarycentricTrajectoryInWorld(
                     current_time_,
                     periapsides_trajectory.begin(),
-                    periapsides_trajectory.end(),
+                    first_points(periapsides_trajectory),
                     sun_world_position,
                     PlanetariumRotation());
 }
@@ -969,19 +1038,19 @@ void Plugin::ComputeAndRenderClosestApproaches(
     std::unique_ptr<DiscreteTrajectory<World>>& closest_approaches) const {
   CHECK(renderer_->HasTargetVessel());
 
-  DiscreteTrajectory<Barycentric> apoapsides_trajectory;
-  DiscreteTrajectory<Barycentric> periapsides_trajectory;
-  ComputeApsides(renderer_->GetTargetVessel().prediction(),
-                 begin,
-                 end,
-                 max_points,
-                 apoapsides_trajectory,
-                 periapsides_trajectory);
+  DiscreteTrajectory<Barycentric> closest_approaches_trajectory;
+  ComputeClosestApproaches<Barycentric>(
+      {&renderer_->GetTargetVessel().prediction()},
+      begin,
+      end,
+      /*max_distance=*/Infinity<Length>,
+      max_points,
+      {&closest_approaches_trajectory});
   closest_approaches =
       renderer_->RenderBarycentricTrajectoryInWorld(
           current_time_,
-          periapsides_trajectory.begin(),
-          periapsides_trajectory.end(),
+          closest_approaches_trajectory.begin(),
+          closest_approaches_trajectory.end(),
           sun_world_position,
           PlanetariumRotation());
 }
@@ -1067,10 +1136,14 @@ not_null<std::unique_ptr<Planetarium>> Plugin::NewPlanetarium(
     Planetarium::Parameters const& parameters,
     Perspective<Navigation, Camera> const& perspective)
     const {
+  // A planetarium is created for each frame.
+  plotting_cache_->NewFrame();
   return make_not_null_unique<Planetarium>(parameters,
                                            perspective,
                                            ephemeris_.get(),
-                                           renderer_->GetPlottingFrame());
+                                           renderer_->GetPlottingFrame(),
+                                           plotting_cache_.get(),
+                                           &vessel_thread_pool_);
 }
 
 not_null<std::unique_ptr<NavigationFrame>>
@@ -1263,7 +1336,7 @@ Velocity<World> Plugin::UnmanageableVesselVelocity(
 
 Velocity<World> Plugin::VesselVelocity(GUID const& vessel_guid) const {
   Vessel const& vessel = *FindOrDie(vessels_, vessel_guid);
-  auto const back = vessel.psychohistory().back();
+  auto const back = vessel.psychohistory_back();
   return VesselVelocity(back.time, back.degrees_of_freedom);
 }
 
@@ -1289,6 +1362,14 @@ Renderer const& Plugin::renderer() const {
 
 void Plugin::WriteToMessage(
     not_null<serialization::Plugin*> const message) const {
+  WriteToMessage(message, /*history_tails=*/nullptr);
+}
+
+void Plugin::WriteToMessage(
+    not_null<serialization::Plugin*> const message,
+    google::protobuf::RepeatedPtrField<
+        serialization::IncrementalSave::HistoryTail>* const history_tails)
+    const {
   LOG(INFO) << __FUNCTION__;
   CHECK(!initializing_);
   if (system_fingerprint_ != 0) {
@@ -1322,13 +1403,36 @@ void Plugin::WriteToMessage(
         return serialization_index_to_pile_up.at(pile_up);
       };
 
+  // Most of the time is spent compressing the histories and the trajectories,
+  // so the vessels, the pile-ups and the ephemeris are serialized in parallel.
+  // Their messages are created here, in order, and filled by the tasks of
+  // |batch|, which are independent.
+  auto batch = vessel_thread_pool_.NewBatch();
+  batch.Reserve(vessels_.size() + pile_ups_.size() + 1);
   std::map<not_null<Vessel const*>, GUID const> vessel_to_guid;
   for (auto const& [guid, vessel] : vessels_) {
     vessel_to_guid.emplace(vessel.get(), guid);
     auto* const vessel_message = message->add_vessel();
     vessel_message->set_guid(guid);
-    vessel->WriteToMessage(vessel_message->mutable_vessel(),
-                           serialization_index_for_pile_up);
+    if (history_tails == nullptr) {
+      batch.Add([vessel = vessel.get(),
+                 vessel_message,
+                 &serialization_index_for_pile_up]() {
+        vessel->WriteToMessage(vessel_message->mutable_vessel(),
+                               serialization_index_for_pile_up);
+      });
+    } else {
+      batch.Add([vessel = vessel.get(),
+                 vessel_message,
+                 &serialization_index_for_pile_up,
+                 history_tail_start = save_chain_->history_tail_start(guid),
+                 history_tail = history_tails->Add()]() {
+        vessel->WriteToMessage(vessel_message->mutable_vessel(),
+                               serialization_index_for_pile_up,
+                               history_tail_start,
+                               history_tail);
+      });
+    }
     Index const parent_index = FindOrDie(celestial_to_index, vessel->parent());
     vessel_message->set_parent_index(parent_index);
     vessel_message->set_loaded(Contains(loaded_vessels_, vessel.get()));
@@ -1343,8 +1447,17 @@ void Plugin::WriteToMessage(
     zombie_message->set_guid(guid);
     parameters.WriteToMessage(zombie_message->mutable_prediction_parameters());
   }
-
-  ephemeris_->WriteToMessage(message->mutable_ephemeris());
+  for (auto* const pile_up : pile_ups_) {
+    batch.Add([pile_up, pile_up_message = message->add_pile_up()]() {
+      pile_up->WriteToMessage(pile_up_message);
+    });
+  }
+  // The ephemeris serializes its trajectories in a nested batch, which may be
+  // joined from a task.
+  batch.Add([this, ephemeris_message = message->mutable_ephemeris()]() {
+    ephemeris_->WriteToMessage(ephemeris_message, vessel_thread_pool_);
+  });
+  batch.SubmitAndJoin();
 
   history_parameters_.WriteToMessage(message->mutable_history_parameters());
   psychohistory_parameters_.WriteToMessage(
@@ -1356,10 +1469,6 @@ void Plugin::WriteToMessage(
   Index const sun_index = FindOrDie(celestial_to_index, sun_);
   message->set_sun_index(sun_index);
   renderer_->WriteToMessage(message->mutable_renderer());
-
-  for (auto* const pile_up : pile_ups_) {
-    pile_up->WriteToMessage(message->add_pile_up());
-  }
 }
 
 not_null<std::unique_ptr<Plugin>> Plugin::ReadFromMessage(
@@ -1401,10 +1510,16 @@ not_null<std::unique_ptr<Plugin>> Plugin::ReadFromMessage(
 
   // The ephemeris constructed here is *not* prolonged and needs to be
   // explicitly prolonged to cover all the instants that we care about.
-  plugin->ephemeris_ =
-      Ephemeris<Barycentric>::ReadFromMessage(message.ephemeris());
+  plugin->ephemeris_ = Ephemeris<Barycentric>::ReadFromMessage(
+      message.ephemeris(), &plugin->vessel_thread_pool_);
+  // Unless the cache is usable, the past of the ephemeris is reintegrated in
+  // parallel from its checkpoints, and the result is worth caching right away.
+  plugin->ephemeris_cache_t_max_ = InfinitePast;
+  plugin->ReadEphemerisCache();
   plugin->ephemeris_->Prolong(plugin->game_epoch_);
   plugin->ephemeris_->Prolong(plugin->current_time_);
+  // The histories of the vessels may go back to the game epoch.
+  plugin->ephemeris_->AwaitReanimation(plugin->game_epoch_);
 
   ReadCelestialsFromMessages(*plugin->ephemeris_,
                              message.celestial(),
@@ -1425,6 +1540,7 @@ not_null<std::unique_ptr<Plugin>> Plugin::ReadFromMessage(
 
     if (vessel_message.loaded()) {
       plugin->loaded_vessels_.insert(vessel.get());
+      vessel->RequestHistory();
     }
     if (vessel_message.kept()) {
       plugin->kept_vessels_.insert(vessel.get());
@@ -1505,14 +1621,46 @@ not_null<std::unique_ptr<Plugin>> Plugin::ReadFromMessage(
   return plugin;
 }
 
+bool Plugin::WriteToIncrementalSave(
+    bool const force_new_base,
+    not_null<serialization::IncrementalSave*> const save,
+    not_null<serialization::Plugin*> const base) const {
+  if (!force_new_base && !save_chain_->must_start_new_base()) {
+    serialization::IncrementalSave::Increment increment;
+    WriteToMessage(base, increment.mutable_history_tail());
+    if (save_chain_->SaveIncrement(*base, &increment, save)) {
+      return false;
+    }
+    base->Clear();
+  }
+  WriteToMessage(base);
+  save_chain_->SaveBase(base, save);
+  return true;
+}
+
+std::optional<std::uint64_t> Plugin::IncrementalSaveBaseId() const {
+  return save_chain_->base_id();
+}
+
+not_null<std::unique_ptr<Plugin>> Plugin::ReadFromIncrementalSave(
+    serialization::IncrementalSave const& save,
+    not_null<serialization::Plugin*> const base) {
+  LOG(INFO) << __FUNCTION__;
+  auto save_chain = std::make_unique<SaveChain>();
+  save_chain->Load(save, base);
+  not_null<std::unique_ptr<Plugin>> plugin = ReadFromMessage(*base);
+  plugin->save_chain_ = std::move(save_chain);
+  return plugin;
+}
+
 Plugin::Plugin(
     Ephemeris<Barycentric>::FixedStepParameters history_parameters,
     Ephemeris<Barycentric>::AdaptiveStepParameters
         psychohistory_parameters)
-    : history_parameters_(std::move(history_parameters)),
-      psychohistory_parameters_(std::move(psychohistory_parameters)),
-      vessel_thread_pool_(
-          /*pool_size=*/2 * std::thread::hardware_concurrency()) {}
+    : vessel_thread_pool_(
+          /*pool_size=*/2 * std::thread::hardware_concurrency()),
+      history_parameters_(std::move(history_parameters)),
+      psychohistory_parameters_(std::move(psychohistory_parameters)) {}
 
 void Plugin::InitializeIndices(std::string const& name,
                                Index const celestial_index,
@@ -1611,10 +1759,174 @@ void Plugin::AddPart(not_null<Vessel*> const vessel,
   vessel->AddPart(std::move(part));
 }
 
+std::filesystem::path Plugin::InstallationDirectory() {
+#if OS_WIN
+  HMODULE module;
+  CHECK(GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
+                               GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                           reinterpret_cast<LPCWSTR>(&InstallationDirectory),
+                           &module));
+  std::wstring module_path(MAX_PATH, L'\0');
+  DWORD size;
+  while ((size = GetModuleFileNameW(module,
+                                    module_path.data(),
+                                    module_path.size())) ==
+         module_path.size()) {
+    module_path.resize(2 * module_path.size());
+  }
+  CHECK_NE(size, 0);
+  module_path.resize(size);
+  std::filesystem::path const path(module_path);
+#else
+  Dl_info info;
+  CHECK_NE(dladdr(reinterpret_cast<void const*>(&InstallationDirectory),
+                  &info),
+           0);
+  std::filesystem::path const path(info.dli_fname);
+#endif
+  // The DLL is in a subdirectory of the installation directory which depends
+  // on the platform, e.g., GameData/Principia/x64.
+  return std::filesystem::absolute(path).parent_path().parent_path();
+}
+
+std::optional<std::filesystem::path> Plugin::EphemerisCacheDirectory() {
+  if (Flags::IsPresent("ephemeris_cache", "off")) {
+    return std::nullopt;
+  }
+  for (std::string const& value : Flags::Values("ephemeris_cache")) {
+    if (!value.empty()) {
+      // A relative directory is relative to the installation directory, not
+      // to the working directory of the game.
+      return InstallationDirectory() / value;
+    }
+  }
+  return InstallationDirectory() / "ephemeris_cache";
+}
+
+std::uint64_t Plugin::EphemerisCacheFingerprint() const {
+  // The cache depends on the code that produced it.
+  return FingerprintCat2011(
+      system_fingerprint_,
+      Fingerprint2011(base::Version, std::strlen(base::Version)));
+}
+
+std::filesystem::path Plugin::EphemerisCachePath(
+    std::int64_t const generation) const {
+  std::ostringstream name;
+  name << std::hex << std::uppercase << std::setw(16) << std::setfill('0')
+       << EphemerisCacheFingerprint() << "." << std::dec << generation;
+  return *EphemerisCacheDirectory() / name.str();
+}
+
+void Plugin::ReadEphemerisCache() {
+  auto const directory = EphemerisCacheDirectory();
+  if (!directory.has_value()) {
+    return;
+  }
+
+  // Find the generations of the cache for this fingerprint, and the temporary
+  // files left behind by writers that did not complete, e.g., because the game
+  // exited.
+  std::string const prefix =
+      EphemerisCachePath(/*generation=*/0).stem().string() + ".";
+  std::vector<std::int64_t> generations;
+  std::vector<std::filesystem::path> temporary_paths;
+  std::error_code error;
+  for (std::filesystem::directory_iterator it(*directory, error), end;
+       !error && it != end;
+       it.increment(error)) {
+    std::string const name = it->path().filename().string();
+    if (it->path().extension() == ".tmp") {
+      temporary_paths.push_back(it->path());
+      continue;
+    }
+    if (name.compare(0, prefix.size(), prefix) != 0) {
+      continue;
+    }
+    char const* const name_end = name.data() + name.size();
+    std::int64_t generation;
+    auto const [ptr, ec] = std::from_chars(name.data() + prefix.size(),
+                                           name_end,
+                                           generation);
+    if (ec == std::errc() && ptr == name_end) {
+      generations.push_back(generation);
+    }
+  }
+  for (auto const& temporary_path : temporary_paths) {
+    std::filesystem::remove(temporary_path, error);
+  }
+  if (generations.empty()) {
+    return;
+  }
+  std::sort(generations.begin(), generations.end());
+  ephemeris_cache_generation_ = generations.back();
+  for (int i = 0; i < generations.size() - 1; ++i) {
+    std::filesystem::remove(EphemerisCachePath(generations[i]), error);
+  }
+
+  auto const path = EphemerisCachePath(ephemeris_cache_generation_);
+  if (ephemeris_->ReadFromCache(path, EphemerisCacheFingerprint())) {
+    ephemeris_cache_t_max_ = ephemeris_->t_max();
+  }
+}
+
+void Plugin::WriteEphemerisCacheIfNeeded() {
+  if (ephemeris_->t_max() < ephemeris_cache_t_max_ + 365 * Day ||
+      !EphemerisCacheDirectory().has_value()) {
+    return;
+  }
+  ephemeris_cache_t_max_ = ephemeris_->t_max();
+  auto const previous_path = EphemerisCachePath(ephemeris_cache_generation_);
+  auto const path = EphemerisCachePath(++ephemeris_cache_generation_);
+  // Assigning the thread joins the previous writer, which is normally long
+  // done.
+  ephemeris_cache_writer_ = MakeStoppableThread(
+      [this, path, previous_path, fingerprint = EphemerisCacheFingerprint()]() {
+        Status const status = ephemeris_->WriteToCache(path, fingerprint);
+        if (status.ok()) {
+          LOG(INFO) << "Wrote ephemeris cache " << path;
+          // This fails if the previous file is mapped, in which case it will
+          // be removed the next time the cache is read.
+          std::error_code error;
+          std::filesystem::remove(previous_path, error);
+        } else {
+          LOG(WARNING) << "Cannot write ephemeris cache " << path << ": "
+                       << status;
+        }
+      });
+}
+
+void Plugin::ForgetApsidesAfter(GUID const& vessel_guid,
+                                VesselTrajectory const trajectory,
+                                Instant const& time) const {
+  for (auto& [key, cached] : apsis_detectors_) {
+    auto const& [guid, vessel_trajectory, _] = key;
+    if (guid == vessel_guid && vessel_trajectory == trajectory) {
+      cached.detector.ForgetAfter(time);
+    }
+  }
+}
+
 bool Plugin::is_loaded(not_null<Vessel*> vessel) const {
   return Contains(loaded_vessels_, vessel);
 }
 
+void Plugin::RecordCollisions(PileUp const& pile_up,
+                              Status const& status,
+                              VesselSet& collided_vessels) const {
+  if (!status.ok()) {
+    for (not_null<Part*> const part : pile_up.parts()) {
+      not_null<Vessel*> const vessel =
+          FindOrDie(part_id_to_vessel_, part->part_id());
+      if (bool const inserted = collided_vessels.insert(vessel).second;
+          inserted) {
+        LOG(WARNING) << "Vessel " << vessel->ShortDebugString()
+                     << " collided with a celestial: " << status.ToString();
+      }
+    }
+  }
+}
+
 }  // namespace internal_plugin
 }  // namespace ksp_plugin
 }  // namespace principia
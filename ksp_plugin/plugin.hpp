@@ -1,6 +1,9 @@
 ﻿
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
 #include <future>
 #include <limits>
 #include <list>
@@ -9,9 +12,12 @@
 #include <optional>
 #include <set>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <utility>
 #include <vector>
 
+#include "base/jthread.hpp"
 #include "base/monostable.hpp"
 #include "base/status.hpp"
 #include "base/thread_pool.hpp"
@@ -25,8 +31,10 @@
 #include "ksp_plugin/manœuvre.hpp"
 #include "ksp_plugin/planetarium.hpp"
 #include "ksp_plugin/renderer.hpp"
+#include "ksp_plugin/save_chain.hpp"
 #include "ksp_plugin/vessel.hpp"
 #include "integrators/ordinary_differential_equations.hpp"
+#include "physics/apsides.hpp"
 #include "physics/body.hpp"
 #include "physics/degrees_of_freedom.hpp"
 #include "physics/discrete_trajectory.hpp"
@@ -66,6 +74,7 @@ using geometry::Vector;
 using geometry::Velocity;
 using integrators::FixedStepSizeIntegrator;
 using integrators::AdaptiveStepSizeIntegrator;
+using physics::ApsisDetector;
 using physics::Body;
 using physics::DegreesOfFreedom;
 using physics::DiscreteTrajectory;
@@ -78,6 +87,7 @@ using physics::MassiveBody;
 using physics::RelativeDegreesOfFreedom;
 using physics::RigidMotion;
 using physics::RotatingBody;
+using physics::Trajectory;
 using quantities::Angle;
 using quantities::Force;
 using quantities::Length;
@@ -339,10 +349,22 @@ class Plugin {
                                 Instant const& final_time,
                                 Mass const& initial_mass) const;
 
-  // Computes the apsides of the trajectory defined by |begin| and |end| with
-  // respect to the celestial with index |celestial_index|.
+  // The trajectories of a vessel whose apsides may be computed by
+  // |ComputeAndRenderApsides|.
+  enum class VesselTrajectory {
+    Prediction,
+    FlightPlan,
+  };
+
+  // Computes the apsides of the trajectory defined by |begin| and |end|, which
+  // must be the given |trajectory| of the vessel with GUID |vessel_guid|, with
+  // respect to the celestial with index |celestial_index|.  The apsides are
+  // maintained incrementally across calls for the same vessel, trajectory and
+  // celestial.
   virtual void ComputeAndRenderApsides(
       Index celestial_index,
+      GUID const& vessel_guid,
+      VesselTrajectory trajectory,
       DiscreteTrajectory<Barycentric>::Iterator const& begin,
       DiscreteTrajectory<Barycentric>::Iterator const& end,
       Position<World> const& sun_world_position,
@@ -439,6 +461,24 @@ class Plugin {
   static not_null<std::unique_ptr<Plugin>> ReadFromMessage(
       serialization::Plugin const& message);
 
+  // Writes to |save| the increments from the current base of the incremental
+  // saves.  Returns true if a new base was started, which is always the case
+  // if |force_new_base| is true, in which case the plugin is written to |base|
+  // and the caller must store it under |save->base_id()|; otherwise |base| is
+  // used as scratch space.  Must be called after initialization.
+  virtual bool WriteToIncrementalSave(
+      bool force_new_base,
+      not_null<serialization::IncrementalSave*> save,
+      not_null<serialization::Plugin*> base) const;
+  // The id of the current base of the incremental saves, if any.
+  virtual std::optional<std::uint64_t> IncrementalSaveBaseId() const;
+  // |base| must be the base identified by |save.base_id()|.  The deltas of
+  // |save| are applied to it.  The incremental saves of the resulting plugin
+  // extend |save|.
+  static not_null<std::unique_ptr<Plugin>> ReadFromIncrementalSave(
+      serialization::IncrementalSave const& save,
+      not_null<serialization::Plugin*> base);
+
  private:
   using GUIDToOwnedVessel = std::map<GUID, not_null<std::unique_ptr<Vessel>>>;
   using IndexToOwnedCelestial =
@@ -484,6 +524,46 @@ class Plugin {
   // Whether |loaded_vessels_| contains |vessel|.
   bool is_loaded(not_null<Vessel*> vessel) const;
 
+  // Same as |WriteToMessage|, except that, if |history_tails| is not null, the
+  // histories of the vessels are left empty and their tails from the
+  // |SaveChain::history_tail_start| of the |save_chain_| are appended to
+  // |history_tails| instead.
+  void WriteToMessage(
+      not_null<serialization::Plugin*> message,
+      google::protobuf::RepeatedPtrField<
+          serialization::IncrementalSave::HistoryTail>* history_tails) const;
+
+  // If |status| is not OK, inserts the vessels of |pile_up| into
+  // |collided_vessels|.
+  void RecordCollisions(PileUp const& pile_up,
+                        Status const& status,
+                        VesselSet& collided_vessels) const;
+
+  // The directory where the plugin is installed, i.e., GameData/Principia,
+  // found from the location of the DLL.
+  static std::filesystem::path InstallationDirectory();
+  // The directory of the ephemeris cache, or nothing if the cache is disabled
+  // by the flag |ephemeris_cache=off|.  The directory may be changed by the
+  // flag |ephemeris_cache=<directory>|, relative to the installation directory.
+  static std::optional<std::filesystem::path> EphemerisCacheDirectory();
+  // Identifies the files of the cache for this system and this version of the
+  // plugin.
+  std::uint64_t EphemerisCacheFingerprint() const;
+  std::filesystem::path EphemerisCachePath(std::int64_t generation) const;
+  // Initializes the ephemeris from the most recent file of the cache, if it is
+  // usable, and deletes the older files.  Must be called before the ephemeris
+  // is prolonged.
+  void ReadEphemerisCache();
+  // Starts writing a new file of the cache in the background if the ephemeris
+  // was prolonged significantly since the last one.
+  void WriteEphemerisCacheIfNeeded();
+
+  // Must be called when the given |trajectory| of the vessel with GUID
+  // |vessel_guid| forgets its points after |time|.
+  void ForgetApsidesAfter(GUID const& vessel_guid,
+                          VesselTrajectory trajectory,
+                          Instant const& time) const;
+
   // Initialization objects.
   base::Monostable initializing_;
   serialization::GravityModel gravity_model_;
@@ -507,16 +587,24 @@ class Plugin {
   std::map<PartId, not_null<Vessel*>> part_id_to_vessel_;
   IndexToOwnedCelestial celestials_;
 
+  // The thread pool for advancing vessels, also used for reanimating the
+  // ephemeris, which it must therefore outlive, and for the batches of
+  // independent tasks: plotting the trajectories, serializing the vessels, etc.
+  mutable ThreadPool<Status> vessel_thread_pool_;
+
   // Not null after initialization.
   std::unique_ptr<Ephemeris<Barycentric>> ephemeris_;
+  // The cache files are numbered so that a new file may be written while the
+  // previous one is mapped.  The |ephemeris_cache_t_max_| is the time up to
+  // which the ephemeris was last cached.
+  std::int64_t ephemeris_cache_generation_ = 0;
+  Instant ephemeris_cache_t_max_;
+  base::jthread ephemeris_cache_writer_;
 
   // The parameters for computing the various trajectories.
   Ephemeris<Barycentric>::FixedStepParameters history_parameters_;
   Ephemeris<Barycentric>::AdaptiveStepParameters psychohistory_parameters_;
 
-  // The thread pool for advancing vessels.
-  ThreadPool<Status> vessel_thread_pool_;
-
   Angle planetarium_rotation_;
   std::optional<Rotation<Barycentric, AliceSun>> cached_planetarium_rotation_;
   // The game epoch in real time.
@@ -528,6 +616,28 @@ class Plugin {
 
   // Not null after initialization.
   std::unique_ptr<Renderer> renderer_;
+  // The apsides of the trajectories rendered by |ComputeAndRenderApsides|,
+  // keyed by vessel, trajectory of that vessel, and celestial, which are
+  // maintained incrementally as these trajectories grow.  A detector is kept
+  // when its trajectory is replaced, e.g., by a new prediction: it resumes
+  // from the last point that it processed if the new trajectory still has
+  // it, and recomputes the apsides otherwise.  The detectors that were not
+  // used between two calls to |AdvanceTime| are dropped.
+  struct CachedApsisDetector {
+    explicit CachedApsisDetector(
+        not_null<Trajectory<Barycentric> const*> const reference)
+        : detector(reference) {}
+
+    ApsisDetector<Barycentric> detector;
+    bool used = true;
+  };
+  mutable std::map<std::tuple<GUID, VesselTrajectory, Index>,
+                   CachedApsisDetector> apsis_detectors_;
+  // The points plotted by the successive planetaria.
+  std::unique_ptr<PlottingCache> const plotting_cache_ =
+      std::make_unique<PlottingCache>();
+  // The increments written by the successive incremental saves.
+  std::unique_ptr<SaveChain> save_chain_ = std::make_unique<SaveChain>();
 
   RotatingBody<Barycentric> const* main_body_ = nullptr;
   AngularVelocity<Barycentric> angular_velocity_of_world_;
@@ -536,6 +646,8 @@ class Plugin {
   // and the pile-up will remove itself once no part owns it.  The elements are
   // not |not_null<>| because we temporarily need to insert null pointers.
   std::list<PileUp*> pile_ups_;
+  // Integrates together the histories of the unloaded |pile_ups_|.
+  FusedPileUps fused_pile_ups_;
 
   // The vessels that are currently loaded, i.e. in the physics bubble.
   VesselSet loaded_vessels_;
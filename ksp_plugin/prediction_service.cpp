@@ -0,0 +1,161 @@
+#include "ksp_plugin/prediction_service.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include "glog/logging.h"
+
+namespace principia {
+namespace ksp_plugin {
+namespace internal_prediction_service {
+
+using base::CallWithStopToken;
+using base::stop_token;
+
+PredictionService::Client::Client(PredictionService& service,
+                                  std::function<void()> computation)
+    : service_(service),
+      computation_(std::move(computation)) {
+  absl::MutexLock l(&service_.lock_);
+  ++service_.number_of_clients_;
+}
+
+PredictionService::Client::~Client() {
+  Stop();
+  absl::MutexLock l(&service_.lock_);
+  --service_.number_of_clients_;
+}
+
+void PredictionService::Client::set_priority(Priority const priority) {
+  absl::MutexLock l(&service_.lock_);
+  if (priority_ != priority) {
+    bool const queued = position_.has_value();
+    if (queued) {
+      service_.Dequeue(*this);
+    }
+    priority_ = priority;
+    if (queued) {
+      service_.Enqueue(*this);
+    }
+  }
+}
+
+void PredictionService::Client::Request() {
+  absl::MutexLock l(&service_.lock_);
+  if (running_) {
+    requested_while_running_ = true;
+  } else if (!position_.has_value()) {
+    service_.Enqueue(*this);
+  }
+}
+
+void PredictionService::Client::Stop() {
+  absl::MutexLock l(&service_.lock_);
+  if (position_.has_value()) {
+    service_.Dequeue(*this);
+  }
+  requested_while_running_ = false;
+  if (running_) {
+    stop_source_.request_stop();
+    auto const not_running = [this]() { return !running_; };
+    service_.lock_.Await(absl::Condition(&not_running));
+  }
+}
+
+void PredictionService::Client::RequestStop() {
+  absl::MutexLock l(&service_.lock_);
+  if (position_.has_value()) {
+    service_.Dequeue(*this);
+  }
+  requested_while_running_ = false;
+  if (running_) {
+    stop_source_.request_stop();
+  }
+}
+
+PredictionService::PredictionService(std::int64_t const number_of_workers) {
+  CHECK_LT(0, number_of_workers);
+  for (std::int64_t i = 0; i < number_of_workers; ++i) {
+    workers_.emplace_back(&PredictionService::Toil, this);
+  }
+}
+
+PredictionService::~PredictionService() {
+  {
+    absl::MutexLock l(&lock_);
+    CHECK_EQ(0, number_of_clients_);
+    shutdown_ = true;
+  }
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+PredictionService& PredictionService::Default() {
+  // Leave a core for the main thread of the game.
+  static PredictionService* const service = new PredictionService(
+      std::max<std::int64_t>(
+          1,
+          static_cast<std::int64_t>(std::thread::hardware_concurrency()) - 1));
+  return *service;
+}
+
+void PredictionService::Enqueue(Client& client) {
+  auto& queue = queues_[static_cast<int>(client.priority_)];
+  client.position_ = queue.insert(queue.end(), &client);
+}
+
+void PredictionService::Dequeue(Client& client) {
+  queues_[static_cast<int>(client.priority_)].erase(*client.position_);
+  client.position_.reset();
+}
+
+void PredictionService::Toil() {
+  for (;;) {
+    Client* client = nullptr;
+    stop_token token;
+
+    // Wait until either a client is queued or this service is shutting down,
+    // and pick the most urgent client.
+    {
+      absl::MutexLock l(&lock_);
+      auto const has_clients_or_shutdown = [this]() {
+        return shutdown_ ||
+               std::any_of(queues_.begin(),
+                           queues_.end(),
+                           [](auto const& queue) { return !queue.empty(); });
+      };
+      lock_.Await(absl::Condition(&has_clients_or_shutdown));
+      if (shutdown_) {
+        break;
+      }
+      for (auto& queue : queues_) {
+        if (!queue.empty()) {
+          client = queue.front();
+          break;
+        }
+      }
+      Dequeue(*client);
+      client->running_ = true;
+      client->stop_source_ = stop_source();
+      token = client->stop_source_.get_token();
+    }
+
+    // Execute the computation without holding the |lock_| as it might take
+    // some time.  The client cannot be destroyed while it is running.
+    CallWithStopToken(token, client->computation_);
+
+    {
+      absl::MutexLock l(&lock_);
+      client->running_ = false;
+      if (client->requested_while_running_) {
+        client->requested_while_running_ = false;
+        Enqueue(*client);
+      }
+    }
+  }
+}
+
+}  // namespace internal_prediction_service
+}  // namespace ksp_plugin
+}  // namespace principia
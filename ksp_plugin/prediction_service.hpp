@@ -0,0 +1,120 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "base/jthread.hpp"
+
+namespace principia {
+namespace ksp_plugin {
+namespace internal_prediction_service {
+
+using base::stop_source;
+
+// A service that runs the asynchronous computations of the plugin (the
+// prognostications of the vessels and the orbit analyses) on a bounded number
+// of threads, instead of dedicating a thread to each vessel.  The computations
+// are started in order of priority.  This class is thread-safe.
+class PredictionService final {
+ public:
+  // Lower values are more urgent.
+  enum class Priority {
+    ActiveVessel = 0,
+    TargetVessel = 1,
+    Other = 2,
+  };
+
+  // An object that has a computation to perform on the threads of the service,
+  // e.g., a vessel.  Only one instance of the computation of a client runs at
+  // any time.  The requests made while the computation is queued are
+  // coalesced; a request made while the computation is running causes it to be
+  // run again once it completes.  The computation must fetch its parameters
+  // when it starts, so that it uses those of the latest request.
+  class Client final {
+   public:
+    // The |computation| is executed on a thread of the |service|, where
+    // |RETURN_IF_STOPPED| may be used to detect a call to |Stop|.
+    Client(PredictionService& service, std::function<void()> computation);
+
+    Client(Client const&) = delete;
+    Client(Client&&) = delete;
+    Client& operator=(Client const&) = delete;
+    Client& operator=(Client&&) = delete;
+
+    // Stops the client.
+    ~Client();
+
+    // Changes the priority of the computation, including if it is queued.
+    void set_priority(Priority priority);
+
+    // Queues the computation unless it is already queued.
+    void Request();
+
+    // Removes the computation from the queue, requests the running
+    // computation, if any, to stop, and waits for it to complete.  Subsequent
+    // calls to |Request| are honoured.  Must not be called by the computation.
+    void Stop();
+
+    // Same as |Stop|, but does not wait for the running computation to
+    // complete.  A subsequent call to |Request| causes the computation to be
+    // run again once it completes.
+    void RequestStop();
+
+   private:
+    PredictionService& service_;
+    std::function<void()> const computation_;
+
+    // The following members are guarded by the lock of the |service_|.
+    Priority priority_ = Priority::Other;
+    // The position of this client in the queue of its priority, if it is
+    // queued.
+    std::optional<std::list<Client*>::iterator> position_;
+    bool running_ = false;
+    // True if |Request| was called while the computation was running.
+    bool requested_while_running_ = false;
+    // A new stop-state is created for each run of the computation.
+    stop_source stop_source_;
+
+    friend class PredictionService;
+  };
+
+  // Starts the given number of worker threads.
+  explicit PredictionService(std::int64_t number_of_workers);
+
+  // All the clients must have been destroyed.
+  ~PredictionService();
+
+  // The service shared by the entire plugin.  It is never destroyed.
+  static PredictionService& Default();
+
+ private:
+  // Appends |client| to the queue of its priority.
+  void Enqueue(Client& client) REQUIRES(lock_);
+  // Removes |client| from the queue where it is.
+  void Dequeue(Client& client) REQUIRES(lock_);
+
+  // The loop executed by each worker thread.
+  void Toil() EXCLUDES(lock_);
+
+  absl::Mutex lock_;
+  bool shutdown_ GUARDED_BY(lock_) = false;
+  // One queue per priority, indexed by the value of the |Priority|.
+  std::array<std::list<Client*>, 3> queues_ GUARDED_BY(lock_);
+  std::int64_t number_of_clients_ GUARDED_BY(lock_) = 0;
+
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace internal_prediction_service
+
+using internal_prediction_service::PredictionService;
+
+}  // namespace ksp_plugin
+}  // namespace principia
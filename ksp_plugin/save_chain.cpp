@@ -0,0 +1,283 @@
+#include "ksp_plugin/save_chain.hpp"
+
+#include <vector>
+
+#include "astronomy/epoch.hpp"
+#include "base/map_util.hpp"
+#include "glog/logging.h"
+#include "google/protobuf/descriptor.h"
+#include "ksp_plugin/frames.hpp"
+#include "physics/degrees_of_freedom.hpp"
+#include "physics/discrete_trajectory.hpp"
+#include "physics/timeline_codec.hpp"
+#include "serialization/physics.pb.h"
+
+namespace principia {
+namespace ksp_plugin {
+namespace internal_save_chain {
+
+using astronomy::InfinitePast;
+using base::FindOrDie;
+using base::make_not_null_unique;
+using google::protobuf::Descriptor;
+using google::protobuf::FieldDescriptor;
+using physics::DegreesOfFreedom;
+using physics::DiscreteTrajectory;
+using physics::TimelineCodec;
+
+// A new base is started when the size of the increments exceeds this fraction
+// of the size of the base.  This bounds the cost of a save to a fraction of
+// that of a complete save, amortized.
+constexpr double max_increments_to_base_size_ratio = 0.5;
+// A new base is started after this many increments, so that a save that embeds
+// its base, and may thus be loaded on its own, is written periodically.
+constexpr int max_increments_per_base = 10;
+
+// Detaches the histories of the vessels of |message|, leaving them empty, and
+// returns them by vessel GUID.  They are not copied: they belong to the arena
+// of |message| if it has one, and to the caller otherwise.
+std::map<std::string, serialization::DiscreteTrajectory*> ReleaseHistories(
+    not_null<serialization::Plugin*> const message) {
+  std::map<std::string, serialization::DiscreteTrajectory*> histories;
+  for (auto& vessel : *message->mutable_vessel()) {
+    auto* const vessel_message = vessel.mutable_vessel();
+    histories.emplace(vessel.guid(),
+                      vessel_message->unsafe_arena_release_history());
+    vessel_message->mutable_history();
+  }
+  return histories;
+}
+
+// Frees a history returned by |ReleaseHistories| for |message|.
+void DeleteHistory(serialization::Plugin const& message,
+                   serialization::DiscreteTrajectory* const history) {
+  if (message.GetArena() == nullptr) {
+    delete history;
+  }
+}
+
+// Calls |append(time, degrees_of_freedom)| for each point of |message|, which
+// need not be a valid trajectory by itself.
+template<typename Append>
+void ForEachPoint(serialization::DiscreteTrajectory const& message,
+                  Append const& append) {
+  if (message.has_columns()) {
+    TimelineCodec<Barycentric>::ReadFromMessage(message.columns(), append);
+  } else {
+    for (auto const& point : message.timeline()) {
+      append(Instant::ReadFromMessage(point.instant()),
+             DegreesOfFreedom<Barycentric>::ReadFromMessage(
+                 point.degrees_of_freedom()));
+    }
+  }
+}
+
+// Writes to |message| the |history| of a vessel, which may be null, followed
+// by the points of its |history_tails|, with the psychohistory and the
+// prediction of the last tail.
+void AppendHistoryTails(
+    serialization::DiscreteTrajectory const* const history,
+    std::vector<serialization::IncrementalSave::HistoryTail const*> const&
+        history_tails,
+    not_null<serialization::DiscreteTrajectory*> const message) {
+  auto appended_history =
+      make_not_null_unique<DiscreteTrajectory<Barycentric>>();
+  if (history != nullptr) {
+    DiscreteTrajectory<Barycentric>* psychohistory = nullptr;
+    DiscreteTrajectory<Barycentric>* prediction = nullptr;
+    appended_history = DiscreteTrajectory<Barycentric>::ReadFromMessage(
+        *history, /*forks=*/{&psychohistory, &prediction});
+    appended_history->DeleteFork(psychohistory);
+    // The points appended here have already been downsampled, or not, when
+    // they were saved.
+    appended_history->ClearDownsampling();
+  }
+  for (auto const* const history_tail : history_tails) {
+    Instant const start = Instant::ReadFromMessage(history_tail->start());
+    if (start == InfinitePast) {
+      appended_history =
+          make_not_null_unique<DiscreteTrajectory<Barycentric>>();
+    } else {
+      CHECK(!appended_history->Empty()) << history_tail->vessel_guid();
+      CHECK_EQ(start, appended_history->back().time)
+          << history_tail->vessel_guid();
+    }
+    ForEachPoint(history_tail->history(),
+                 [&appended_history](
+                     Instant const& time,
+                     DegreesOfFreedom<Barycentric> const& degrees_of_freedom) {
+                   if (appended_history->Empty() ||
+                       time > appended_history->back().time) {
+                     appended_history->Append(time, degrees_of_freedom);
+                   }
+                 });
+  }
+  message->Clear();
+  appended_history->WriteToMessage(message, /*forks=*/{});
+  auto const& last_history = history_tails.back()->history();
+  *message->mutable_children() = last_history.children();
+  *message->mutable_fork_position() = last_history.fork_position();
+  if (last_history.has_downsampling()) {
+    *message->mutable_downsampling() = last_history.downsampling();
+  }
+}
+
+SaveChain::SaveChain() : random_(std::random_device()()) {}
+
+bool SaveChain::must_start_new_base() const {
+  return !increments_.has_base_id() ||
+         increments_.increment_size() >= max_increments_per_base;
+}
+
+Instant SaveChain::history_tail_start(std::string const& vessel_guid) const {
+  auto const it = history_tail_starts_.find(vessel_guid);
+  return it == history_tail_starts_.end() ? InfinitePast : it->second;
+}
+
+void SaveChain::SaveBase(
+    not_null<serialization::Plugin*> const message,
+    not_null<serialization::IncrementalSave*> const save) {
+  increments_.Clear();
+  increments_.set_base_id(random_());
+  base_size_ = message->ByteSizeLong();
+  increments_size_ = 0;
+  // The increments are computed without the histories, so the summary must
+  // not describe them.
+  auto const histories = ReleaseHistories(message);
+  summary_ = MessageSummary();
+  ComputeMessageDelta(*message, PluginMatchingKeys(), summary_,
+                      /*delta=*/nullptr);
+  for (auto& vessel : *message->mutable_vessel()) {
+    vessel.mutable_vessel()->unsafe_arena_set_allocated_history(
+        FindOrDie(histories, vessel.guid()));
+  }
+  UpdateHistoryTailStarts(*message);
+  save->CopyFrom(increments_);
+}
+
+bool SaveChain::SaveIncrement(
+    serialization::Plugin const& message,
+    not_null<serialization::IncrementalSave::Increment*> const increment,
+    not_null<serialization::IncrementalSave*> const save) {
+  CHECK(!must_start_new_base());
+  ComputeMessageDelta(message, PluginMatchingKeys(), summary_,
+                      increment->mutable_delta());
+  std::int64_t const increment_size = increment->ByteSizeLong();
+  if (increments_size_ + increment_size >
+      max_increments_to_base_size_ratio * base_size_) {
+    return false;
+  }
+  increments_size_ += increment_size;
+  increments_.add_increment()->Swap(increment);
+  UpdateHistoryTailStarts(message);
+  save->CopyFrom(increments_);
+  return true;
+}
+
+void SaveChain::Load(serialization::IncrementalSave const& save,
+                     not_null<serialization::Plugin*> const message) {
+  base_size_ = message->ByteSizeLong();
+  increments_size_ = 0;
+  // The deltas apply to the plugin without the histories, the tails of which
+  // are appended to those of the base at the end.
+  auto histories = ReleaseHistories(message);
+  std::map<std::string,
+           std::vector<serialization::IncrementalSave::HistoryTail const*>>
+      history_tails;
+  for (auto const& increment : save.increment()) {
+    ApplyMessageDelta(increment.delta(), message);
+    for (auto const& history_tail : increment.history_tail()) {
+      history_tails[history_tail.vessel_guid()].push_back(&history_tail);
+    }
+    increments_size_ += increment.ByteSizeLong();
+  }
+  // The base, if it was embedded in |save|, is not part of the increments.
+  increments_.Clear();
+  increments_.set_base_id(save.base_id());
+  *increments_.mutable_increment() = save.increment();
+  summary_ = MessageSummary();
+  ComputeMessageDelta(*message, PluginMatchingKeys(), summary_,
+                      /*delta=*/nullptr);
+  UpdateHistoryTailStarts(*message);
+
+  for (auto& vessel : *message->mutable_vessel()) {
+    serialization::DiscreteTrajectory* history = nullptr;
+    if (auto const it = histories.find(vessel.guid()); it != histories.end()) {
+      history = it->second;
+      histories.erase(it);
+    }
+    auto const it = history_tails.find(vessel.guid());
+    if (it == history_tails.end()) {
+      // The history is that of the base.
+      CHECK_NOTNULL(history);
+      vessel.mutable_vessel()->unsafe_arena_set_allocated_history(history);
+    } else {
+      AppendHistoryTails(history,
+                         it->second,
+                         vessel.mutable_vessel()->mutable_history());
+      DeleteHistory(*message, history);
+    }
+  }
+  // The histories of the vessels that were removed after the base.
+  for (auto const& [_, history] : histories) {
+    DeleteHistory(*message, history);
+  }
+  CHECK(message->IsInitialized()) << message->InitializationErrorString();
+}
+
+std::optional<std::uint64_t> SaveChain::base_id() const {
+  if (increments_.has_base_id()) {
+    return increments_.base_id();
+  } else {
+    return std::nullopt;
+  }
+}
+
+MatchingKeys const& SaveChain::PluginMatchingKeys() {
+  static MatchingKeys const* const keys = [] {
+    auto* const keys = new MatchingKeys;
+    auto const key = [keys](Descriptor const* const descriptor,
+                            char const* const field,
+                            char const* const key) {
+      FieldDescriptor const* const repeated_field =
+          CHECK_NOTNULL(descriptor->FindFieldByName(field));
+      CHECK(repeated_field->is_repeated()) << repeated_field->full_name();
+      (*keys)[repeated_field] =
+          key == nullptr
+              ? nullptr
+              : CHECK_NOTNULL(
+                    repeated_field->message_type()->FindFieldByName(key));
+    };
+    key(serialization::Plugin::descriptor(), "vessel", "guid");
+    key(serialization::Plugin::descriptor(), "zombie", "guid");
+    key(serialization::Plugin::descriptor(), "pile_up", /*key=*/nullptr);
+    key(serialization::Vessel::descriptor(), "parts", "part_id");
+    key(serialization::Ephemeris::descriptor(), "trajectory", /*key=*/nullptr);
+    key(serialization::Ephemeris::descriptor(), "checkpoint", "time");
+    key(serialization::ContinuousTrajectory::descriptor(),
+        "checkpoint",
+        "time");
+    key(serialization::DiscreteTrajectory::descriptor(),
+        "children",
+        /*key=*/nullptr);
+    key(serialization::DiscreteTrajectory::Litter::descriptor(),
+        "trajectories",
+        /*key=*/nullptr);
+    return keys;
+  }();
+  return *keys;
+}
+
+void SaveChain::UpdateHistoryTailStarts(serialization::Plugin const& message) {
+  history_tail_starts_.clear();
+  for (auto const& vessel : message.vessel()) {
+    history_tail_starts_.emplace(
+        vessel.guid(),
+        Instant::ReadFromMessage(
+            vessel.vessel().history_last_point().instant()));
+  }
+}
+
+}  // namespace internal_save_chain
+}  // namespace ksp_plugin
+}  // namespace principia
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <random>
+#include <string>
+
+#include "base/not_null.hpp"
+#include "geometry/named_quantities.hpp"
+#include "ksp_plugin/message_delta.hpp"
+#include "serialization/ksp_plugin.pb.h"
+
+namespace principia {
+namespace ksp_plugin {
+namespace internal_save_chain {
+
+using base::not_null;
+using geometry::Instant;
+
+// The successive saves of a plugin, expressed as increments against a base,
+// i.e., a complete |serialization::Plugin| which is stored separately by the
+// caller.  A save contains all the increments since the base, so that it may be
+// loaded without the saves that precede it.  An increment consists of the delta
+// of the plugin without the histories of its vessels, and of the points
+// appended to these histories, so that the histories, which make up most of a
+// save, are neither written again nor fingerprinted.  A new base is started
+// when the increments become large compared to the base, and after a fixed
+// number of increments, so that a save that embeds its base is written
+// periodically.
+class SaveChain final {
+ public:
+  SaveChain();
+
+  // True if the next save must start a new base, either because there is none
+  // or to make the saves self-contained periodically.
+  bool must_start_new_base() const;
+
+  // The time from which the history of the vessel with the given |vessel_guid|
+  // must be written in the next increment, i.e., the time of its last point in
+  // the previous save, or -∞ if the vessel was not part of that save.
+  Instant history_tail_start(std::string const& vessel_guid) const;
+
+  // Starts a new base with |message|, which must be complete, and fills |save|
+  // accordingly.  The caller must store |message| as the base identified by
+  // |save->base_id()|.  |message| is left unchanged.
+  void SaveBase(not_null<serialization::Plugin*> message,
+                not_null<serialization::IncrementalSave*> save);
+
+  // |message| must be the plugin with empty vessel histories, and
+  // |increment->history_tail()| the tails of these histories, from their
+  // |history_tail_start|.  Completes |increment| and fills |save| with the
+  // increments since the base.  Returns false, leaving |save| unchanged, if the
+  // increments have become too large compared to the base, in which case the
+  // caller must start a new base.
+  bool SaveIncrement(serialization::Plugin const& message,
+                     not_null<serialization::IncrementalSave::Increment*>
+                         increment,
+                     not_null<serialization::IncrementalSave*> save);
+
+  // |message| must be the base identified by |save.base_id()|.  Applies the
+  // increments of |save| to it, and makes this chain extend |save|.
+  void Load(serialization::IncrementalSave const& save,
+            not_null<serialization::Plugin*> message);
+
+  // The id of the current base, if any.
+  std::optional<std::uint64_t> base_id() const;
+
+ private:
+  // The keys used to match the vessels, parts, trajectories, etc. across
+  // versions of a |serialization::Plugin|.
+  static MatchingKeys const& PluginMatchingKeys();
+
+  // Records the last points of the histories of the vessels of |message|.
+  void UpdateHistoryTailStarts(serialization::Plugin const& message);
+
+  // The increments since the base, with the id of the base.  The id is absent
+  // if there is no base.
+  serialization::IncrementalSave increments_;
+  std::int64_t base_size_ = 0;
+  std::int64_t increments_size_ = 0;
+  // Describes the last version saved or loaded, without the histories.
+  MessageSummary summary_;
+  // The time of the last point of the history of each vessel in the last
+  // version saved or loaded.
+  std::map<std::string, Instant> history_tail_starts_;
+  std::mt19937_64 random_;
+};
+
+}  // namespace internal_save_chain
+
+using internal_save_chain::SaveChain;
+
+}  // namespace ksp_plugin
+}  // namespace principia
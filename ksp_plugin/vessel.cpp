@@ -8,6 +8,7 @@
 #include <vector>
 
 #include "astronomy/epoch.hpp"
+#include "base/flags.hpp"
 #include "base/map_util.hpp"
 #include "ksp_plugin/integrators.hpp"
 #include "ksp_plugin/pile_up.hpp"
@@ -19,12 +20,13 @@ namespace ksp_plugin {
 namespace internal_vessel {
 
 using astronomy::InfiniteFuture;
+using astronomy::InfinitePast;
 using base::Contains;
+using base::check_not_null;
 using base::Error;
 using base::FindOrDie;
-using base::jthread;
+using base::Flags;
 using base::make_not_null_unique;
-using base::MakeStoppableThread;
 using geometry::BarycentreCalculator;
 using geometry::Position;
 using quantities::IsFinite;
@@ -59,7 +61,11 @@ Vessel::Vessel(GUID guid,
           std::move(prediction_adaptive_step_parameters)),
       parent_(parent),
       ephemeris_(ephemeris),
-      history_(make_not_null_unique<DiscreteTrajectory<Barycentric>>()) {
+      prognosticator_(PredictionService::Default(),
+                      [this]() { FlowRequestedPrognostication(); }),
+      history_(make_not_null_unique<DiscreteTrajectory<Barycentric>>()),
+      history_reader_(PredictionService::Default(),
+                      [this]() { ReadSerializedHistory(); }) {
   // Can't create the |psychohistory_| and |prediction_| here because |history_|
   // is empty;
 }
@@ -169,6 +175,9 @@ void Vessel::PrepareHistory(Instant const& t) {
 
 void Vessel::DisableDownsampling() {
   history_->ClearDownsampling();
+  if (serialized_history_ != nullptr) {
+    history_downsampling_disabled_ = true;
+  }
 }
 
 not_null<Part*> Vessel::part(PartId const id) const {
@@ -194,6 +203,11 @@ DiscreteTrajectory<Barycentric> const& Vessel::prediction() const {
   return *prediction_;
 }
 
+DiscreteTrajectory<Barycentric>::Iterator::reference
+Vessel::psychohistory_back() const {
+  return psychohistory_->back();
+}
+
 void Vessel::set_prediction_adaptive_step_parameters(
     Ephemeris<Barycentric>::AdaptiveStepParameters const&
         prediction_adaptive_step_parameters) {
@@ -220,6 +234,8 @@ bool Vessel::has_flight_plan() const {
 }
 
 void Vessel::AdvanceTime() {
+  AttachReadHistory();
+
   // Squirrel away the prediction so that we can reattach it if we don't have a
   // prognostication.
   auto prediction = prediction_->DetachFork();
@@ -267,6 +283,8 @@ void Vessel::CreateFlightPlan(
         flight_plan_adaptive_step_parameters,
     Ephemeris<Barycentric>::GeneralizedAdaptiveStepParameters const&
         flight_plan_generalized_adaptive_step_parameters) {
+  // The flight plan is plotted together with the history.
+  RequestHistory();
   auto const history_back = history_->back();
   flight_plan_ = std::make_unique<FlightPlan>(
       initial_mass,
@@ -276,6 +294,7 @@ void Vessel::CreateFlightPlan(
       ephemeris_,
       flight_plan_adaptive_step_parameters,
       flight_plan_generalized_adaptive_step_parameters);
+  flight_plan_->set_priority(prediction_priority_);
 }
 
 void Vessel::DeleteFlightPlan() {
@@ -343,11 +362,15 @@ void Vessel::RefreshPrediction() {
                             prognostication);
     SwapPrognostication(prognostication, status);
   } else {
-    StartPrognosticatorIfNeeded();
+    // Coalesced with the pending request, if any.
+    prognosticator_.Request();
   }
   if (prognostication_ != nullptr) {
     AttachPrediction(std::move(prognostication_));
   }
+  if (flight_plan_ != nullptr) {
+    flight_plan_->RefreshSegments();
+  }
 }
 
 void Vessel::RefreshPrediction(Instant const& time) {
@@ -356,7 +379,30 @@ void Vessel::RefreshPrediction(Instant const& time) {
 }
 
 void Vessel::StopPrognosticator() {
-  prognosticator_ = jthread();
+  prognosticator_.Stop();
+}
+
+void Vessel::set_prediction_priority(
+    PredictionService::Priority const priority) {
+  prediction_priority_ = priority;
+  prognosticator_.set_priority(priority);
+  if (orbit_analyser_.has_value()) {
+    orbit_analyser_->set_priority(priority);
+  }
+  if (flight_plan_ != nullptr) {
+    flight_plan_->set_priority(priority);
+  }
+  history_reader_.set_priority(priority);
+}
+
+void Vessel::RequestHistory() {
+  if (serialized_history_ == nullptr || history_requested_) {
+    return;
+  }
+  history_requested_ = true;
+  if (!synchronous_) {
+    history_reader_.Request();
+  }
 }
 
 std::string Vessel::ShortDebugString() const {
@@ -366,29 +412,25 @@ std::string Vessel::ShortDebugString() const {
 void Vessel::WriteToMessage(not_null<serialization::Vessel*> const message,
                             PileUp::SerializationIndexForPileUp const&
                                 serialization_index_for_pile_up) const {
-  message->set_guid(guid_);
-  message->set_name(name_);
-  body_.WriteToMessage(message->mutable_body());
-  prediction_adaptive_step_parameters_.WriteToMessage(
-      message->mutable_prediction_adaptive_step_parameters());
-  for (auto const& [_, part] : parts_) {
-    part->WriteToMessage(message->add_parts(), serialization_index_for_pile_up);
-  }
-  for (auto const& part_id : kept_parts_) {
-    CHECK(Contains(parts_, part_id));
-    message->add_kept_parts(part_id);
-  }
-  // Starting with Gateaux we don't save the prediction, see #2685.  Instead we
-  // save an empty prediction that we re-read as a prediction.  This is a bit
-  // hacky, but hopefully we can remove this hack once #2400 is solved.
-  DiscreteTrajectory<Barycentric>* empty_prediction =
-      psychohistory_->NewForkAtLast();
-  history_->WriteToMessage(message->mutable_history(),
-                           /*forks=*/{psychohistory_, empty_prediction});
-  psychohistory_->DeleteFork(empty_prediction);
-  if (flight_plan_ != nullptr) {
-    flight_plan_->WriteToMessage(message->mutable_flight_plan());
-  }
+  WriteAllButHistoryToMessage(message, serialization_index_for_pile_up);
+  WriteHistoryToMessage(InfinitePast, message->mutable_history());
+}
+
+void Vessel::WriteToMessage(
+    not_null<serialization::Vessel*> const message,
+    PileUp::SerializationIndexForPileUp const& serialization_index_for_pile_up,
+    Instant const& history_tail_start,
+    not_null<serialization::IncrementalSave::HistoryTail*> const history_tail)
+    const {
+  WriteAllButHistoryToMessage(message, serialization_index_for_pile_up);
+  // The history is a required field.
+  message->mutable_history();
+  // The psychohistory is forked off the last point, which must therefore be
+  // part of the tail.
+  Instant const start = std::min(history_tail_start, history_->back().time);
+  history_tail->set_vessel_guid(guid_);
+  history_tail_start.WriteToMessage(history_tail->mutable_start());
+  WriteHistoryToMessage(start, history_tail->mutable_history());
 }
 
 not_null<std::unique_ptr<Vessel>> Vessel::ReadFromMessage(
@@ -399,6 +441,7 @@ not_null<std::unique_ptr<Vessel>> Vessel::ReadFromMessage(
   bool const is_pre_cesàro = message.has_psychohistory_is_authoritative();
   bool const is_pre_chasles = message.has_prediction();
   bool const is_pre_陈景润 = !message.history().has_downsampling();
+  bool const is_pre_green = !message.has_history_last_point();
 
   // NOTE(egg): for now we do not read the |MasslessBody| as it can contain no
   // information.
@@ -451,9 +494,47 @@ not_null<std::unique_ptr<Vessel>> Vessel::ReadFromMessage(
         /*forks=*/{&vessel->psychohistory_});
     vessel->prediction_ = vessel->psychohistory_->NewForkAtLast();
   } else {
-    vessel->history_ = DiscreteTrajectory<Barycentric>::ReadFromMessage(
-        message.history(),
-        /*forks=*/{&vessel->psychohistory_, &vessel->prediction_});
+    if (is_pre_green || Flags::IsPresent("lazy_history", "off")) {
+      vessel->history_ = DiscreteTrajectory<Barycentric>::ReadFromMessage(
+          message.history(),
+          /*forks=*/{&vessel->psychohistory_, &vessel->prediction_});
+    } else {
+      // Only read the last point of the history, to which the psychohistory
+      // is attached.  Decompressing the entire history is expensive and often
+      // not needed as many vessels are never looked at.
+      auto const& serialized_history = message.history();
+      serialization::DiscreteTrajectory history_end;
+      *history_end.add_timeline() = message.history_last_point();
+      *history_end.mutable_children() = serialized_history.children();
+      *history_end.mutable_fork_position() =
+          serialized_history.fork_position();
+      vessel->history_ = DiscreteTrajectory<Barycentric>::ReadFromMessage(
+          history_end,
+          /*forks=*/{&vessel->psychohistory_, &vessel->prediction_});
+
+      auto unread_history =
+          std::make_unique<serialization::DiscreteTrajectory>();
+      *unread_history->mutable_timeline() = serialized_history.timeline();
+      if (serialized_history.has_downsampling()) {
+        *unread_history->mutable_downsampling() =
+            serialized_history.downsampling();
+      }
+      if (serialized_history.has_zfp()) {
+        *unread_history->mutable_zfp() = serialized_history.zfp();
+      }
+      if (serialized_history.has_columns()) {
+        *unread_history->mutable_columns() = serialized_history.columns();
+      }
+      // Downsample the points appended until the history is attached like
+      // the history itself would.
+      if (serialized_history.has_downsampling()) {
+        auto const& downsampling = serialized_history.downsampling();
+        vessel->history_->SetDownsampling(
+            downsampling.max_dense_intervals(),
+            Length::ReadFromMessage(downsampling.tolerance()));
+      }
+      vessel->serialized_history_ = std::move(unread_history);
+    }
     // Necessary after Εὔδοξος because the ephemeris has not been prolonged
     // during deserialization.  Doesn't hurt prior to Εὔδοξος.
     ephemeris->Prolong(vessel->prediction_->back().time);
@@ -467,6 +548,8 @@ not_null<std::unique_ptr<Vessel>> Vessel::ReadFromMessage(
   if (message.has_flight_plan()) {
     vessel->flight_plan_ = FlightPlan::ReadFromMessage(message.flight_plan(),
                                                        ephemeris);
+    // The flight plan is plotted together with the history.
+    vessel->RequestHistory();
   }
   return vessel;
 }
@@ -490,6 +573,7 @@ void Vessel::RequestOrbitAnalysis(Time const& mission_duration) {
     // perhaps we should pick something appropriate automatically instead.  The
     // default will do in the meantime.
     orbit_analyser_.emplace(ephemeris_, DefaultHistoryParameters());
+    orbit_analyser_->set_priority(prediction_priority_);
   }
   if (orbit_analyser_->last_parameters().has_value() &&
       orbit_analyser_->last_parameters()->mission_duration !=
@@ -536,44 +620,32 @@ Vessel::Vessel()
       prediction_adaptive_step_parameters_(DefaultPredictionParameters()),
       parent_(testing_utilities::make_not_null<Celestial const*>()),
       ephemeris_(testing_utilities::make_not_null<Ephemeris<Barycentric>*>()),
-      history_(make_not_null_unique<DiscreteTrajectory<Barycentric>>()) {}
-
-void Vessel::StartPrognosticatorIfNeeded() {
-  prognosticator_lock_.AssertHeld();
-  if (!prognosticator_.joinable()) {
-    prognosticator_ = MakeStoppableThread(
-        std::bind(&Vessel::RepeatedlyFlowPrognostication, this));
-  }
-}
-
-Status Vessel::RepeatedlyFlowPrognostication() {
-  for (std::chrono::steady_clock::time_point wakeup_time;;
-       std::this_thread::sleep_until(wakeup_time)) {
-    // No point in going faster than 50 Hz.
-    wakeup_time =
-        std::chrono::steady_clock::now() + std::chrono::milliseconds(20);
-    RETURN_IF_STOPPED;
-
-    std::optional<PrognosticatorParameters> prognosticator_parameters;
-    {
-      absl::MutexLock l(&prognosticator_lock_);
-      if (!prognosticator_parameters_) {
-        // No parameters, let's wait for them to appear.
-        continue;
-      }
-      std::swap(prognosticator_parameters, prognosticator_parameters_);
+      prognosticator_(PredictionService::Default(),
+                      [this]() { FlowRequestedPrognostication(); }),
+      history_(make_not_null_unique<DiscreteTrajectory<Barycentric>>()),
+      history_reader_(PredictionService::Default(),
+                      [this]() { ReadSerializedHistory(); }) {}
+
+Status Vessel::FlowRequestedPrognostication() {
+  std::optional<PrognosticatorParameters> prognosticator_parameters;
+  {
+    absl::MutexLock l(&prognosticator_lock_);
+    if (!prognosticator_parameters_) {
+      // The parameters were consumed by a previous run.
+      return Status::OK;
     }
-    RETURN_IF_STOPPED;
+    std::swap(prognosticator_parameters, prognosticator_parameters_);
+  }
+  RETURN_IF_STOPPED;
 
-    std::unique_ptr<DiscreteTrajectory<Barycentric>> prognostication;
-    Status const status =
-        FlowPrognostication(std::move(*prognosticator_parameters),
-                            prognostication);
-    RETURN_IF_STOPPED;
-    {
-      absl::MutexLock l(&prognosticator_lock_);
-      SwapPrognostication(prognostication, status);
-    }
+  std::unique_ptr<DiscreteTrajectory<Barycentric>> prognostication;
+  Status const status =
+      FlowPrognostication(std::move(*prognosticator_parameters),
+                          prognostication);
+  RETURN_IF_STOPPED;
+  {
+    absl::MutexLock l(&prognosticator_lock_);
+    SwapPrognostication(prognostication, status);
   }
   return Status::OK;
 }
@@ -676,6 +748,123 @@ void Vessel::AppendToVesselTrajectory(
   }
 }
 
+void Vessel::ReadSerializedHistory() {
+  // The |serialized_history_| is not reset before the |read_history_| has been
+  // taken, so it is safe to read it here.
+  std::unique_ptr<DiscreteTrajectory<Barycentric>> history =
+      DiscreteTrajectory<Barycentric>::ReadFromMessage(*serialized_history_,
+                                                       /*forks=*/{});
+  absl::MutexLock l(&history_reader_lock_);
+  read_history_ = std::move(history);
+}
+
+void Vessel::AttachReadHistory() {
+  if (serialized_history_ == nullptr || !history_requested_) {
+    return;
+  }
+  if (synchronous_) {
+    ReadSerializedHistory();
+  }
+  std::unique_ptr<DiscreteTrajectory<Barycentric>> history;
+  {
+    absl::MutexLock l(&history_reader_lock_);
+    std::swap(history, read_history_);
+  }
+  if (history == nullptr) {
+    // Still being read.
+    return;
+  }
+  serialized_history_.reset();
+
+  CompleteReadHistory(*history);
+
+  // Move the psychohistory, and the prediction that is forked off of it, to the
+  // complete history.  The pointers remain valid.
+  history->AttachFork(psychohistory_->DetachFork());
+  history_ = check_not_null(std::move(history));
+}
+
+void Vessel::WriteAllButHistoryToMessage(
+    not_null<serialization::Vessel*> const message,
+    PileUp::SerializationIndexForPileUp const& serialization_index_for_pile_up)
+    const {
+  message->set_guid(guid_);
+  message->set_name(name_);
+  body_.WriteToMessage(message->mutable_body());
+  prediction_adaptive_step_parameters_.WriteToMessage(
+      message->mutable_prediction_adaptive_step_parameters());
+  for (auto const& [_, part] : parts_) {
+    part->WriteToMessage(message->add_parts(), serialization_index_for_pile_up);
+  }
+  for (auto const& part_id : kept_parts_) {
+    CHECK(Contains(parts_, part_id));
+    message->add_kept_parts(part_id);
+  }
+  auto const history_back = history_->back();
+  auto* const history_last_point = message->mutable_history_last_point();
+  history_back.time.WriteToMessage(history_last_point->mutable_instant());
+  history_back.degrees_of_freedom.WriteToMessage(
+      history_last_point->mutable_degrees_of_freedom());
+  if (flight_plan_ != nullptr) {
+    flight_plan_->WriteToMessage(message->mutable_flight_plan());
+  }
+}
+
+void Vessel::WriteHistoryToMessage(
+    Instant const& start,
+    not_null<serialization::DiscreteTrajectory*> const message) const {
+  // Starting with Gateaux we don't save the prediction, see #2685.  Instead we
+  // save an empty prediction that we re-read as a prediction.  This is a bit
+  // hacky, but hopefully we can remove this hack once #2400 is solved.
+  DiscreteTrajectory<Barycentric>* empty_prediction =
+      psychohistory_->NewForkAtLast();
+  history_->WriteTailToMessage(start,
+                               message,
+                               /*forks=*/{psychohistory_, empty_prediction});
+  psychohistory_->DeleteFork(empty_prediction);
+  if (serialized_history_ != nullptr && start < history_->front().time) {
+    // The history has not been attached, so the points written above are only
+    // those appended since deserialization.  Replace them with the complete
+    // history, keeping the children.
+    message->clear_timeline();
+    message->clear_downsampling();
+    message->clear_zfp();
+    message->clear_columns();
+    if (start == InfinitePast &&
+        history_->Size() == 1 &&
+        !history_downsampling_disabled_) {
+      // Nothing has changed, the serialized history is written back as is.
+      message->MergeFrom(*serialized_history_);
+    } else {
+      // Don't wait for the |history_reader_|, which would require attaching
+      // the history here.
+      auto const complete_history =
+          DiscreteTrajectory<Barycentric>::ReadFromMessage(*serialized_history_,
+                                                           /*forks=*/{});
+      CompleteReadHistory(*complete_history);
+      serialization::DiscreteTrajectory complete_history_message;
+      complete_history->WriteTailToMessage(start,
+                                           &complete_history_message,
+                                           /*forks=*/{});
+      message->MergeFrom(complete_history_message);
+    }
+  }
+}
+
+void Vessel::CompleteReadHistory(
+    DiscreteTrajectory<Barycentric>& history) const {
+  if (history_downsampling_disabled_) {
+    history.ClearDownsampling();
+  }
+  // The serialized history ends at the first point of |history_|.
+  CHECK_EQ(history.back().time, history_->front().time);
+  for (auto it = history_->begin(); it != history_->end(); ++it) {
+    if (it->time > history.back().time) {
+      history.Append(it->time, it->degrees_of_freedom);
+    }
+  }
+}
+
 void Vessel::AttachPrediction(
     not_null<std::unique_ptr<DiscreteTrajectory<Barycentric>>> trajectory) {
   trajectory->ForgetBefore(psychohistory_->back().time);
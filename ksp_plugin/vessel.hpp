@@ -9,13 +9,13 @@
 #include <vector>
 
 #include "absl/synchronization/mutex.h"
-#include "base/jthread.hpp"
 #include "base/status.hpp"
 #include "ksp_plugin/celestial.hpp"
 #include "ksp_plugin/flight_plan.hpp"
 #include "ksp_plugin/orbit_analyser.hpp"
 #include "ksp_plugin/part.hpp"
 #include "ksp_plugin/pile_up.hpp"
+#include "ksp_plugin/prediction_service.hpp"
 #include "physics/discrete_trajectory.hpp"
 #include "physics/ephemeris.hpp"
 #include "physics/massless_body.hpp"
@@ -105,7 +105,8 @@ class Vessel {
 
   // Disables downsampling for the history of this vessel.  This is useful when
   // the vessel collided with a celestial, as downsampling might run into
-  // trouble.
+  // trouble.  If the history has not been read yet, the downsampling is
+  // disabled for the partial history and, once read, for the complete one.
   virtual void DisableDownsampling();
 
   // Returns the part with the given ID.  Such a part must have been added using
@@ -117,9 +118,17 @@ class Vessel {
   // Calls |action| on all parts.
   virtual void ForAllParts(std::function<void(Part&)> action) const;
 
+  // If the history was not read by |ReadFromMessage|, the psychohistory only
+  // starts at the last point of the serialized history until the complete
+  // history has been attached by |AdvanceTime|.
   virtual DiscreteTrajectory<Barycentric> const& psychohistory() const;
   virtual DiscreteTrajectory<Barycentric> const& prediction() const;
 
+  // Returns the last point of the psychohistory.  Unlike |psychohistory()|,
+  // this never requires the history to be read.
+  virtual DiscreteTrajectory<Barycentric>::Iterator::reference
+  psychohistory_back() const;
+
   virtual void set_prediction_adaptive_step_parameters(
       Ephemeris<Barycentric>::AdaptiveStepParameters const&
           prediction_adaptive_step_parameters);
@@ -132,7 +141,9 @@ class Vessel {
 
   // Extends the history and psychohistory of this vessel by computing the
   // centre of mass of its parts at every point in their history and
-  // psychohistory.  Clears the parts' history and psychohistory.
+  // psychohistory.  Clears the parts' history and psychohistory.  If the
+  // history that was not read by |ReadFromMessage| is now available, makes it
+  // the |history_|.
   virtual void AdvanceTime();
 
   // Creates a |flight_plan_| at the end of history using the given parameters.
@@ -170,13 +181,42 @@ class Vessel {
   // Stop the asynchronous prognosticator as soon as convenient.
   void StopPrognosticator();
 
+  // Sets the priority of the asynchronous computations of this vessel (the
+  // prognostication, the orbit analysis, and those of the flight plan) with
+  // respect to those of the other vessels.
+  void set_prediction_priority(PredictionService::Priority priority);
+
+  // If the history was not read by |ReadFromMessage|, requests that it be read
+  // in the background by the |history_reader_|, to be attached by
+  // |AdvanceTime|.  Must be called when the complete history is needed, i.e.,
+  // when it is plotted, when the vessel has a flight plan, or when it is
+  // loaded.
+  void RequestHistory();
+
   // Returns "vessel_name (GUID)".
   std::string ShortDebugString() const;
 
-  // The vessel must satisfy |is_initialized()|.
+  // The vessel must satisfy |is_initialized()|.  If the history was not read by
+  // |ReadFromMessage| and has changed since then, it is read again here to be
+  // written; this doesn't affect the vessel.
   virtual void WriteToMessage(not_null<serialization::Vessel*> message,
                               PileUp::SerializationIndexForPileUp const&
                                   serialization_index_for_pile_up) const;
+  // Same as above, except that the history is left empty in |message|.
+  // Instead, the points of the history at or after |history_tail_start| are
+  // written to |history_tail|, with the psychohistory and the prediction.  If
+  // |history_tail_start| is the time of the last point of the history written
+  // previously, this is what has been appended to the history since then.
+  virtual void WriteToMessage(
+      not_null<serialization::Vessel*> message,
+      PileUp::SerializationIndexForPileUp const&
+          serialization_index_for_pile_up,
+      Instant const& history_tail_start,
+      not_null<serialization::IncrementalSave::HistoryTail*> history_tail)
+      const;
+  // Unless the flag "lazy_history" is "off", only the last point of the
+  // history is read from |message|, together with the psychohistory.  The rest
+  // of the history is only read once |RequestHistory| has been called.
   static not_null<std::unique_ptr<Vessel>> ReadFromMessage(
       serialization::Vessel const& message,
       not_null<Celestial const*> parent,
@@ -214,13 +254,9 @@ class Vessel {
   using TrajectoryIterator =
       DiscreteTrajectory<Barycentric>::Iterator (Part::*)();
 
-  // Starts the |prognosticator_| if it is not started already.  The
-  // |prognosticator_parameters_| must have been set.
-  void StartPrognosticatorIfNeeded() REQUIRES(prognosticator_lock_);
-
-  // Run by the |prognosticator_| thread to periodically recompute the
-  // prognostication.
-  Status RepeatedlyFlowPrognostication();
+  // Run by the |prognosticator_| on a thread of the |PredictionService| to
+  // recompute the prognostication if |RefreshPrediction| has been called.
+  Status FlowRequestedPrognostication();
 
   // Runs the integrator to compute the |prognostication_| based on the given
   // parameters.
@@ -245,6 +281,36 @@ class Vessel {
   void AttachPrediction(
       not_null<std::unique_ptr<DiscreteTrajectory<Barycentric>>> trajectory);
 
+  // Run by the |history_reader_| on a thread of the |PredictionService| to
+  // read the |serialized_history_| into |read_history_|.
+  void ReadSerializedHistory();
+
+  // If the history was not read by |ReadFromMessage|, was requested, and the
+  // |history_reader_| is done, makes the |read_history_| the |history_|.  The
+  // points appended since deserialization are retained, and the
+  // |psychohistory_| and |prediction_| are moved to the complete history.
+  void AttachReadHistory();
+
+  // Writes everything but the history to |message|.
+  void WriteAllButHistoryToMessage(
+      not_null<serialization::Vessel*> message,
+      PileUp::SerializationIndexForPileUp const&
+          serialization_index_for_pile_up) const;
+
+  // Writes to |message| the points of the history at or after |start|, with
+  // the psychohistory and an empty prediction as forks.  If the history was
+  // not read by |ReadFromMessage| and has changed since then, it is read again
+  // here to be written, unless |start| is not before the first point of
+  // |history_|.
+  void WriteHistoryToMessage(
+      Instant const& start,
+      not_null<serialization::DiscreteTrajectory*> message) const;
+
+  // Completes |history|, which must end at the first point of |history_|, with
+  // the points that were added to |history_| since deserialization.  Disables
+  // its downsampling if |DisableDownsampling| was called in the meantime.
+  void CompleteReadHistory(DiscreteTrajectory<Barycentric>& history) const;
+
   GUID const guid_;
   std::string name_;
 
@@ -265,9 +331,13 @@ class Vessel {
   // that reading it clears it.
   std::optional<PrognosticatorParameters> prognosticator_parameters_
       GUARDED_BY(prognosticator_lock_);
-  base::jthread prognosticator_;
+  PredictionService::Client prognosticator_;
+  PredictionService::Priority prediction_priority_ =
+      PredictionService::Priority::Other;
 
   // See the comments in pile_up.hpp for an explanation of the terminology.
+  // Until the history has been read, |history_| only contains the points
+  // starting at the last point of the serialized history.
   not_null<std::unique_ptr<DiscreteTrajectory<Barycentric>>> history_;
   DiscreteTrajectory<Barycentric>* psychohistory_ = nullptr;
 
@@ -283,6 +353,20 @@ class Vessel {
 
   std::optional<OrbitAnalyser> orbit_analyser_;
 
+  // The serialized history, without its children, if it has not been attached
+  // yet.  Only modified on the main thread.
+  std::unique_ptr<serialization::DiscreteTrajectory const> serialized_history_;
+  // True if |DisableDownsampling| was called before the history was attached.
+  bool history_downsampling_disabled_ = false;
+  // True if |RequestHistory| was called before the history was attached.
+  bool history_requested_ = false;
+
+  absl::Mutex history_reader_lock_;
+  // The history read from |serialized_history_|, until it is attached.
+  std::unique_ptr<DiscreteTrajectory<Barycentric>> read_history_
+      GUARDED_BY(history_reader_lock_);
+  PredictionService::Client history_reader_;
+
   static std::atomic_bool synchronous_;
 };
 
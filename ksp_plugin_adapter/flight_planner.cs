@@ -140,6 +140,16 @@ class FlightPlanner : VesselSupervisedWindowRenderer {
       // differential sliders.
       number_of_anomalous_manœuvres_ =
           plugin.FlightPlanNumberOfAnomalousManoeuvres(vessel_guid);
+      // When the flight plan is recomputed asynchronously, the edits return OK
+      // and the integration status is only known once the recomputation is
+      // complete.
+      if (plugin.FlightPlanGetRecomputationProgress(vessel_guid) < 1) {
+        recomputing_ = true;
+      } else if (recomputing_) {
+        recomputing_ = false;
+        UpdateStatus(plugin.FlightPlanGetRecomputationStatus(vessel_guid),
+                     null);
+      }
     }
   }
 
@@ -654,6 +664,7 @@ class FlightPlanner : VesselSupervisedWindowRenderer {
   private readonly DifferentialSlider final_time_;
   private int? first_future_manœuvre_;
   private int number_of_anomalous_manœuvres_ = 0;
+  private bool recomputing_ = false;
 
   private bool show_guidance_ = false;
   private float warning_height_ = 1;
@@ -100,30 +100,32 @@ public enum Style {
       using (DisposableIterator rp2_line_iterator =
           rp2_lines_iterator.IteratorGetRP2LinesIterator()) {
         XY? previous_rp2_point = null;
-        for (;
-            !rp2_line_iterator.IteratorAtEnd();
-            rp2_line_iterator.IteratorIncrement()) {
-          XY current_rp2_point = ToScreen(
-              rp2_line_iterator.IteratorGetRP2LineXY());
-          if (previous_rp2_point.HasValue) {
-            if (style == Style.Faded) {
-              var faded_colour = colour;
-              // Fade from the opacity of |colour| (when index = 0) down to 1/4
-              // of that opacity.
-              faded_colour.a *= 1 - (float)(4 * index) / (float)(5 * size);
-              UnityEngine.GL.Color(faded_colour);
-            }
-            if (style != Style.Dashed || index % 2 == 1) {
-              UnityEngine.GL.Vertex3((float)previous_rp2_point.Value.x,
-                                     (float)previous_rp2_point.Value.y,
-                                     0);
-              UnityEngine.GL.Vertex3((float)current_rp2_point.x,
-                                     (float)current_rp2_point.y,
-                                     0);
+        // Fetch the points in chunks to limit the number of interop calls.
+        for (int count;
+             (count = rp2_line_iterator.IteratorGetRP2LineXYs(
+                  rp2_points_, rp2_points_.Length)) > 0;) {
+          for (int i = 0; i < count; ++i) {
+            XY current_rp2_point = ToScreen(rp2_points_[i]);
+            if (previous_rp2_point.HasValue) {
+              if (style == Style.Faded) {
+                var faded_colour = colour;
+                // Fade from the opacity of |colour| (when index = 0) down to
+                // 1/4 of that opacity.
+                faded_colour.a *= 1 - (float)(4 * index) / (float)(5 * size);
+                UnityEngine.GL.Color(faded_colour);
+              }
+              if (style != Style.Dashed || index % 2 == 1) {
+                UnityEngine.GL.Vertex3((float)previous_rp2_point.Value.x,
+                                       (float)previous_rp2_point.Value.y,
+                                       0);
+                UnityEngine.GL.Vertex3((float)current_rp2_point.x,
+                                       (float)current_rp2_point.y,
+                                       0);
+              }
             }
+            previous_rp2_point = current_rp2_point;
+            ++index;
           }
-          previous_rp2_point = current_rp2_point;
-          ++index;
         }
       }
     }
@@ -146,6 +148,9 @@ public enum Style {
     };
   }
 
+  // The buffer in which the points of the lines are fetched from the C++.
+  private static readonly XY[] rp2_points_ = new XY[1024];
+
   private static UnityEngine.Material line_material_;
 
   private static UnityEngine.Material line_material {
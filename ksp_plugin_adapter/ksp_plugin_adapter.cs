@@ -50,6 +50,8 @@ private enum UnityLayers {
   };
 
   private const string principia_serialized_plugin = "serialized_plugin";
+  private const string principia_incrementally_serialized_plugin =
+      "incrementally_serialized_plugin";
   private const string principia_initial_state_config_name =
       "principia_initial_state";
   private const string principia_gravity_model_config_name =
@@ -143,6 +145,7 @@ private enum UnityLayers {
   private int? last_guidance_manœuvre_ = null;
 
   private static Dictionary<CelestialBody, Orbit> unmodified_orbits_;
+  private static Dictionary<int, CelestialBody> index_to_celestial_;
 
   private Krakensbane krakensbane_;
 
@@ -708,6 +711,10 @@ class PartCentredForceHolder {
                       body  : celestial.orbit.referenceBody));
       }
     }
+    if (index_to_celestial_ == null) {
+      index_to_celestial_ = FlightGlobals.Bodies.ToDictionary(
+          celestial => celestial.flightGlobalsIndex);
+    }
 
     GameEvents.onShowUI.Add(() => { hide_all_gui_ = false; });
     GameEvents.onHideUI.Add(() => { hide_all_gui_ = true; });
@@ -762,19 +769,31 @@ class PartCentredForceHolder {
                                 BetterLateThanNeverLateUpdate);
   }
 
+  // The directory where the bases of the incremental saves of the current game
+  // are stored.
+  private static string IncrementalSaveBaseDirectory() {
+    return KSPUtil.ApplicationRootPath + Path.DirectorySeparatorChar +
+           "saves" + Path.DirectorySeparatorChar +
+           HighLogic.SaveFolder + Path.DirectorySeparatorChar +
+           "Principia";
+  }
+
   public override void OnSave(ConfigNode node) {
     base.OnSave(node);
     if (PluginRunning()) {
       IntPtr serializer = IntPtr.Zero;
+      string base_directory = IncrementalSaveBaseDirectory();
       for (;;) {
-        string serialization = plugin_.SerializePlugin(
+        string serialization = plugin_.SerializePluginIncrementally(
             ref serializer,
             serialization_compression_,
-            serialization_encoding_);
+            serialization_encoding_,
+            base_directory);
         if (serialization == null) {
           break;
         }
-        node.AddValue(principia_serialized_plugin, serialization);
+        node.AddValue(principia_incrementally_serialized_plugin,
+                      serialization);
       }
     }
   }
@@ -784,7 +803,42 @@ class PartCentredForceHolder {
     if (is_bad_installation_ || in_main_menu_) {
       return;
     }
-    if (node.HasValue(principia_serialized_plugin)) {
+    if (node.HasValue(principia_incrementally_serialized_plugin)) {
+      Cleanup();
+      RemoveBuggyTidalLocking();
+
+      IntPtr deserializer = IntPtr.Zero;
+      string base_directory = IncrementalSaveBaseDirectory();
+      string[] serializations =
+          node.GetValues(principia_incrementally_serialized_plugin);
+      Log.Info("Incremental serialization has " + serializations.Length +
+               " chunks");
+      foreach (string serialization in serializations) {
+        Interface.DeserializePluginIncrementally(serialization,
+                                                 ref deserializer,
+                                                 ref plugin_,
+                                                 serialization_compression_,
+                                                 serialization_encoding_,
+                                                 base_directory);
+      }
+      Interface.DeserializePluginIncrementally("",
+                                               ref deserializer,
+                                               ref plugin_,
+                                               serialization_compression_,
+                                               serialization_encoding_,
+                                               base_directory);
+
+      // The deserialization leaves |plugin_| null if the base of the save was
+      // lost.  Resetting the plugin would silently lose the histories of all
+      // the vessels, and saving would then overwrite the game, so we stop.
+      if (!PluginRunning()) {
+        Log.Fatal("Could not load the incremental save: its base is missing " +
+                  "from " + base_directory + ".  Restore the base, or load " +
+                  "an earlier save that contains it.");
+      }
+      previous_display_mode_ = null;
+      must_set_plotting_frame_ = true;
+    } else if (node.HasValue(principia_serialized_plugin)) {
       Cleanup();
       RemoveBuggyTidalLocking();
 
@@ -2231,10 +2285,13 @@ select PartCentredForceHolder.
 
   private void PlotCelestialTrajectories(DisposablePlanetarium planetarium,
                                          string main_vessel_guid) {
-    foreach (CelestialBody celestial in FlightGlobals.Bodies) {
-      if (plotting_frame_selector_.FixedBodies().Contains(celestial)) {
-        continue;
-      }
+    // The celestials that are fixed in the plotting frame, or whose colour is
+    // transparent, are not plotted, so we don't ask the plugin to compute
+    // their trajectories.
+    var fixed_bodies = plotting_frame_selector_.FixedBodies();
+    var colours = new Dictionary<int, UnityEngine.Color>();
+    var hidden_celestial_indices = new List<int>();
+    foreach (CelestialBody celestial in index_to_celestial_.Values) {
       var colour = celestial.MapObject?.uiNode?.VisualIconData.color ??
                    XKCDColors.SunshineYellow;
       if (colour.a != 1) {
@@ -2250,25 +2307,44 @@ select PartCentredForceHolder.
               colour.a);
         }
       }
-      if (colour.a == 0) {
-        continue;
-      }
-      using (DisposableIterator rp2_lines_iterator =
-          planetarium.PlanetariumPlotCelestialTrajectoryForPsychohistory(
-              plugin_,
-              celestial.flightGlobalsIndex,
-              main_vessel_guid,
-              main_window_.history_length)) {
-        GLLines.PlotRP2Lines(rp2_lines_iterator, colour, GLLines.Style.Faded);
+      if (fixed_bodies.Contains(celestial) || colour.a == 0) {
+        hidden_celestial_indices.Add(celestial.flightGlobalsIndex);
+      } else {
+        colours.Add(celestial.flightGlobalsIndex, colour);
       }
-      if (main_vessel_guid != null) {
-        using (DisposableIterator rp2_lines_iterator =
-            planetarium.
-                PlanetariumPlotCelestialTrajectoryForPredictionOrFlightPlan(
-                    plugin_,
-                    celestial.flightGlobalsIndex,
-                    main_vessel_guid)) {
-          GLLines.PlotRP2Lines(rp2_lines_iterator, colour, GLLines.Style.Solid);
+    }
+
+    // The trajectories of the other celestials are plotted concurrently; the
+    // iterator has a past and a future trajectory for each celestial, in the
+    // order of |flightGlobalsIndex|.
+    using (DisposableIterator celestial_trajectories_iterator =
+        planetarium.PlanetariumPlotCelestialTrajectories(
+            plugin_,
+            main_vessel_guid,
+            main_window_.history_length,
+            hidden_celestial_indices.ToArray(),
+            hidden_celestial_indices.Count)) {
+      for (int index = 0;
+           !celestial_trajectories_iterator.IteratorAtEnd();
+           ++index) {
+        using (DisposableIterator past_rp2_lines_iterator =
+                   celestial_trajectories_iterator.
+                       IteratorGetRP2LinesIterator()) {
+          celestial_trajectories_iterator.IteratorIncrement();
+          using (DisposableIterator future_rp2_lines_iterator =
+                     celestial_trajectories_iterator.
+                         IteratorGetRP2LinesIterator()) {
+            celestial_trajectories_iterator.IteratorIncrement();
+            if (!colours.TryGetValue(index, out UnityEngine.Color colour)) {
+              continue;
+            }
+            GLLines.PlotRP2Lines(past_rp2_lines_iterator,
+                                 colour,
+                                 GLLines.Style.Faded);
+            GLLines.PlotRP2Lines(future_rp2_lines_iterator,
+                                 colour,
+                                 GLLines.Style.Solid);
+          }
         }
       }
     }
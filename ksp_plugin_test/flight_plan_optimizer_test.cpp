@@ -0,0 +1,235 @@
+#include "ksp_plugin/flight_plan_optimizer.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "astronomy/epoch.hpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "integrators/embedded_explicit_generalized_runge_kutta_nyström_integrator.hpp"
+#include "integrators/embedded_explicit_runge_kutta_nyström_integrator.hpp"
+#include "integrators/methods.hpp"
+#include "integrators/symmetric_linear_multistep_integrator.hpp"
+#include "ksp_plugin/celestial.hpp"
+#include "ksp_plugin/flight_plan.hpp"
+#include "physics/body_centred_non_rotating_dynamic_frame.hpp"
+#include "physics/degrees_of_freedom.hpp"
+#include "physics/discrete_trajectory.hpp"
+#include "physics/massive_body.hpp"
+#include "physics/rotating_body.hpp"
+#include "quantities/si.hpp"
+#include "testing_utilities/approximate_quantity.hpp"
+#include "testing_utilities/is_near.hpp"
+#include "testing_utilities/matchers.hpp"
+
+namespace principia {
+namespace ksp_plugin {
+namespace internal_flight_plan_optimizer {
+
+using astronomy::J2000;
+using base::dynamic_cast_not_null;
+using base::Error;
+using base::make_not_null_unique;
+using geometry::Displacement;
+using geometry::Instant;
+using geometry::Position;
+using geometry::Velocity;
+using integrators::EmbeddedExplicitGeneralizedRungeKuttaNyströmIntegrator;
+using integrators::EmbeddedExplicitRungeKuttaNyströmIntegrator;
+using integrators::SymmetricLinearMultistepIntegrator;
+using integrators::methods::DormandالمكاوىPrince1986RKN434FM;
+using integrators::methods::Fine1987RKNG34;
+using integrators::methods::QuinlanTremaine1990Order12;
+using physics::BodyCentredNonRotatingDynamicFrame;
+using physics::DegreesOfFreedom;
+using physics::Ephemeris;
+using physics::Frenet;
+using physics::MassiveBody;
+using physics::RotatingBody;
+using quantities::Pow;
+using quantities::si::Degree;
+using quantities::si::Kilogram;
+using quantities::si::Metre;
+using quantities::si::Micro;
+using quantities::si::Milli;
+using quantities::si::Minute;
+using quantities::si::Newton;
+using quantities::si::Radian;
+using quantities::si::Second;
+using testing_utilities::IsNear;
+using testing_utilities::StatusIs;
+using testing_utilities::operator""_⑴;
+using testing_utilities::operator""_⑵;
+
+// A test mass in a circular orbit of radius 1 m and period 2π s around a body
+// with gravitational parameter μ = 1 m³/s² and radius 0.1 m.
+class FlightPlanOptimizerTest : public testing::Test {
+ protected:
+  using TestNavigationFrame =
+      BodyCentredNonRotatingDynamicFrame<Barycentric, Navigation>;
+
+  FlightPlanOptimizerTest() {
+    FlightPlan::MakeSynchronous();
+    std::vector<not_null<std::unique_ptr<MassiveBody const>>> bodies;
+    bodies.emplace_back(make_not_null_unique<RotatingBody<Barycentric>>(
+        1 * Pow<3>(Metre) / Pow<2>(Second),
+        RotatingBody<Barycentric>::Parameters(
+            /*mean_radius=*/0.1 * Metre,
+            /*reference_angle=*/0 * Radian,
+            /*reference_instant=*/J2000,
+            /*angular_frequency=*/1 * Radian / Second,
+            /*right_ascension_of_pole=*/0 * Radian,
+            /*declination_of_pole=*/90 * Degree)));
+    std::vector<DegreesOfFreedom<Barycentric>> initial_state{
+        {Barycentric::origin, Barycentric::unmoving}};
+    ephemeris_ = std::make_unique<Ephemeris<Barycentric>>(
+        std::move(bodies),
+        initial_state,
+        /*initial_time=*/t0_,
+        Ephemeris<Barycentric>::AccuracyParameters(
+            /*fitting_tolerance=*/1 * Milli(Metre),
+            /*geopotential_tolerance=*/0x1p-24),
+        Ephemeris<Barycentric>::FixedStepParameters(
+            SymmetricLinearMultistepIntegrator<QuinlanTremaine1990Order12,
+                                               Position<Barycentric>>(),
+            /*step=*/10 * Minute));
+    auto const body = dynamic_cast_not_null<RotatingBody<Barycentric> const*>(
+        ephemeris_->bodies().back());
+    celestial_ = std::make_unique<Celestial>(body);
+    celestial_->set_trajectory(ephemeris_->trajectory(body));
+    navigation_frame_ = std::make_unique<TestNavigationFrame>(
+        ephemeris_.get(),
+        ephemeris_->bodies().back());
+    flight_plan_ = std::make_unique<FlightPlan>(
+        /*initial_mass=*/1 * Kilogram,
+        /*initial_time=*/t0_,
+        /*initial_degrees_of_freedom=*/DegreesOfFreedom<Barycentric>(
+            Barycentric::origin + Displacement<Barycentric>(
+                                      {1 * Metre, 0 * Metre, 0 * Metre}),
+            Velocity<Barycentric>({0 * Metre / Second,
+                                   1 * Metre / Second,
+                                   0 * Metre / Second})),
+        /*desired_final_time=*/t0_ + 10 * Second,
+        ephemeris_.get(),
+        Ephemeris<Barycentric>::AdaptiveStepParameters(
+            EmbeddedExplicitRungeKuttaNyströmIntegrator<
+                DormandالمكاوىPrince1986RKN434FM,
+                Position<Barycentric>>(),
+            /*max_steps=*/10'000,
+            /*length_integration_tolerance=*/1 * Micro(Metre),
+            /*speed_integration_tolerance=*/1 * Micro(Metre) / Second),
+        Ephemeris<Barycentric>::GeneralizedAdaptiveStepParameters(
+            EmbeddedExplicitGeneralizedRungeKuttaNyströmIntegrator<
+                Fine1987RKNG34,
+                Position<Barycentric>>(),
+            /*max_steps=*/10'000,
+            /*length_integration_tolerance=*/1 * Micro(Metre),
+            /*speed_integration_tolerance=*/1 * Micro(Metre) / Second));
+    optimizer_ = &flight_plan_->optimizer();
+  }
+
+  NavigationManœuvre::Burn MakeBurn(Speed const& retrograde_Δv,
+                                    Speed const& binormal_Δv) {
+    NavigationManœuvre::Intensity intensity;
+    intensity.Δv = Velocity<Frenet<Navigation>>({-retrograde_Δv,
+                                                 0 * Metre / Second,
+                                                 binormal_Δv});
+    NavigationManœuvre::Timing timing;
+    timing.initial_time = t0_ + 1 * Second;
+    return {intensity,
+            timing,
+            /*thrust=*/1 * Newton,
+            /*specific_impulse=*/1 * Newton * Second / Kilogram,
+            make_not_null_unique<TestNavigationFrame>(*navigation_frame_),
+            /*is_inertially_fixed=*/true};
+  }
+
+  Length PeriapsisDistance() {
+    DiscreteTrajectory<Barycentric>::Iterator begin;
+    DiscreteTrajectory<Barycentric>::Iterator end;
+    flight_plan_->GetSegment(2, begin, end);
+    Length periapsis_distance = std::numeric_limits<double>::infinity() * Metre;
+    for (auto it = begin; it != end; ++it) {
+      periapsis_distance =
+          std::min(periapsis_distance,
+                   (it->degrees_of_freedom.position() - Barycentric::origin)
+                       .Norm());
+    }
+    return periapsis_distance;
+  }
+
+  Instant const t0_ = J2000;
+  std::unique_ptr<Ephemeris<Barycentric>> ephemeris_;
+  std::unique_ptr<Celestial> celestial_;
+  std::unique_ptr<TestNavigationFrame> navigation_frame_;
+  std::unique_ptr<FlightPlan> flight_plan_;
+  FlightPlanOptimizer* optimizer_;
+};
+
+TEST_F(FlightPlanOptimizerTest, Periapsis) {
+  EXPECT_OK(flight_plan_->Insert(MakeBurn(50 * Milli(Metre) / Second,
+                                          0 * Metre / Second),
+                                 /*index=*/0));
+  // By the vis-viva equation, a periapsis at 0.7 m, i.e., at an altitude of
+  // 0.6 m, requires a retrograde Δv of 1 - √(2 - 20/17) m/s ≈ 92.5 mm/s.
+  EXPECT_OK(optimizer_->RequestOptimization(
+      {.index = 0,
+       .metric = FlightPlanOptimizer::ForCelestialAltitude(
+           celestial_.get(),
+           /*target_altitude=*/0.6 * Metre),
+       .Δv_tolerance = 1 * Milli(Metre) / Second,
+       .time_tolerance = std::nullopt}));
+  auto const& Δv = flight_plan_->GetManœuvre(0).Δv().coordinates();
+  EXPECT_THAT(-Δv.x, IsNear(93_⑴ * Milli(Metre) / Second));
+  EXPECT_THAT(PeriapsisDistance(), IsNear(0.70_⑴ * Metre));
+}
+
+TEST_F(FlightPlanOptimizerTest, Inclination) {
+  // The inclination is not differentiable for an equatorial orbit, so we start
+  // from a slightly inclined one.  A change of inclination of 5° requires a
+  // binormal Δv of about tan 5° × 0.9 m/s ≈ 79 mm/s.
+  EXPECT_OK(flight_plan_->Insert(MakeBurn(50 * Milli(Metre) / Second,
+                                          10 * Milli(Metre) / Second),
+                                 /*index=*/0));
+  EXPECT_OK(optimizer_->RequestOptimization(
+      {.index = 0,
+       .metric = FlightPlanOptimizer::Sum(
+           {FlightPlanOptimizer::ForCelestialAltitude(
+                celestial_.get(),
+                /*target_altitude=*/0.6 * Metre),
+            FlightPlanOptimizer::ForInclination(
+                celestial_.get(),
+                /*target_inclination=*/5 * Degree)}),
+       .Δv_tolerance = 1 * Milli(Metre) / Second,
+       .time_tolerance = 1 * Milli(Second)}));
+  auto const& Δv = flight_plan_->GetManœuvre(0).Δv().coordinates();
+  EXPECT_THAT(Δv.z, IsNear(79_⑵ * Milli(Metre) / Second));
+  EXPECT_THAT(PeriapsisDistance(), IsNear(0.70_⑴ * Metre));
+}
+
+TEST_F(FlightPlanOptimizerTest, UnreachablePeriapsis) {
+  EXPECT_OK(flight_plan_->Insert(MakeBurn(50 * Milli(Metre) / Second,
+                                          0 * Metre / Second),
+                                 /*index=*/0));
+  auto const Δv = flight_plan_->GetManœuvre(0).Δv();
+  // The periapsis cannot be above the point where the burn takes place, which
+  // is at an altitude of 0.9 m, so an altitude of 1.5 m is out of reach.
+  EXPECT_THAT(optimizer_->RequestOptimization(
+                  {.index = 0,
+                   .metric = FlightPlanOptimizer::ForCelestialAltitude(
+                       celestial_.get(),
+                       /*target_altitude=*/1.5 * Metre),
+                   .Δv_tolerance = 1 * Milli(Metre) / Second,
+                   .time_tolerance = std::nullopt}),
+              StatusIs(Error::OUT_OF_RANGE));
+  EXPECT_THAT(optimizer_->optimization_status(),
+              StatusIs(Error::OUT_OF_RANGE));
+  EXPECT_EQ(1, optimizer_->progress_of_optimization());
+  EXPECT_EQ(Δv, flight_plan_->GetManœuvre(0).Δv());
+}
+
+}  // namespace internal_flight_plan_optimizer
+}  // namespace ksp_plugin
+}  // namespace principia
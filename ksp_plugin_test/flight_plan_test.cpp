@@ -1,7 +1,9 @@
 ﻿
 #include "ksp_plugin/flight_plan.hpp"
 
+#include <chrono>
 #include <limits>
+#include <thread>
 #include <vector>
 
 #include "astronomy/epoch.hpp"
@@ -76,6 +78,7 @@ class FlightPlanTest : public testing::Test {
       BodyCentredNonRotatingDynamicFrame<Barycentric, Navigation>;
 
   FlightPlanTest() {
+    FlightPlan::MakeSynchronous();
     std::vector<not_null<std::unique_ptr<MassiveBody const>>> bodies;
     bodies.emplace_back(make_not_null_unique<RotatingBody<Barycentric>>(
         1 * Pow<3>(Metre) / Pow<2>(Second),
@@ -600,6 +603,135 @@ TEST_F(FlightPlanTest, Insertion) {
   EXPECT_THAT(inserted_out_of_order, EqualsProto(inserted_in_order));
 }
 
+TEST_F(FlightPlanTest, SegmentReuse) {
+  flight_plan_->SetDesiredFinalTime(t0_ + 42 * Second);
+  EXPECT_OK(flight_plan_->Insert(MakeFirstBurn(), 0));
+  EXPECT_OK(flight_plan_->Insert(MakeSecondBurn(), 1));
+  DiscreteTrajectory<Barycentric>::Iterator begin;
+  DiscreteTrajectory<Barycentric>::Iterator end;
+
+  // Extending the flight plan reuses the last coast, so its former final point
+  // is still there.
+  EXPECT_OK(flight_plan_->SetDesiredFinalTime(t0_ + 50 * Second));
+  flight_plan_->GetSegment(4, begin, end);
+  bool found_former_final_point = false;
+  for (auto it = begin; it != end; ++it) {
+    found_former_final_point |= it->time == t0_ + 42 * Second;
+  }
+  EXPECT_TRUE(found_former_final_point);
+  --end;
+  EXPECT_EQ(t0_ + 50 * Second, end->time);
+
+  flight_plan_->GetAllSegments(begin, end);
+  --end;
+  DegreesOfFreedom<Barycentric> const final_degrees_of_freedom =
+      end->degrees_of_freedom;
+
+  // Replacing a burn with an identical one reuses all the segments.
+  EXPECT_OK(flight_plan_->Replace(MakeSecondBurn(), 1));
+  EXPECT_EQ(5, flight_plan_->number_of_segments());
+  flight_plan_->GetAllSegments(begin, end);
+  --end;
+  EXPECT_EQ(t0_ + 50 * Second, end->time);
+  EXPECT_EQ(final_degrees_of_freedom, end->degrees_of_freedom);
+
+  // Nudging the burn changes the segments that follow it.
+  auto nudged_burn = MakeSecondBurn();
+  *nudged_burn.intensity.Δv *= 1.01;
+  EXPECT_OK(flight_plan_->Replace(nudged_burn, 1));
+  flight_plan_->GetAllSegments(begin, end);
+  --end;
+  EXPECT_EQ(t0_ + 50 * Second, end->time);
+  EXPECT_NE(final_degrees_of_freedom, end->degrees_of_freedom);
+}
+
+TEST_F(FlightPlanTest, AsynchronousRecomputation) {
+  flight_plan_->SetDesiredFinalTime(t0_ + 42 * Second);
+  EXPECT_OK(flight_plan_->Insert(MakeFirstBurn(), 0));
+  EXPECT_OK(flight_plan_->Insert(MakeSecondBurn(), 1));
+  DiscreteTrajectory<Barycentric>::Iterator begin;
+  DiscreteTrajectory<Barycentric>::Iterator end;
+  flight_plan_->GetAllSegments(begin, end);
+  --end;
+  Instant const expected_final_time = end->time;
+  DegreesOfFreedom<Barycentric> const expected_final_degrees_of_freedom =
+      end->degrees_of_freedom;
+
+  FlightPlan::MakeAsynchronous();
+  EXPECT_OK(flight_plan_->Remove(0));
+  EXPECT_OK(flight_plan_->Remove(0));
+  EXPECT_OK(flight_plan_->Insert(MakeSecondBurn(), 0));
+  EXPECT_OK(flight_plan_->Insert(MakeFirstBurn(), 0));
+
+  // Nothing is visible until the segments are refreshed.
+  EXPECT_EQ(2, flight_plan_->number_of_manœuvres());
+  EXPECT_EQ(5, flight_plan_->number_of_segments());
+  EXPECT_EQ(2, flight_plan_->number_of_anomalous_manœuvres());
+  EXPECT_OK(flight_plan_->recomputation_status());
+
+  while (flight_plan_->progress_of_recomputation() < 1) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  flight_plan_->RefreshSegments();
+  EXPECT_EQ(5, flight_plan_->number_of_segments());
+  EXPECT_EQ(0, flight_plan_->number_of_anomalous_manœuvres());
+  EXPECT_OK(flight_plan_->recomputation_status());
+  flight_plan_->GetAllSegments(begin, end);
+  --end;
+  EXPECT_EQ(expected_final_time, end->time);
+  EXPECT_EQ(expected_final_degrees_of_freedom, end->degrees_of_freedom);
+
+  // A change made while the recomputation is in progress cancels it.
+  EXPECT_OK(flight_plan_->SetDesiredFinalTime(t0_ + 41 * Second));
+  EXPECT_OK(flight_plan_->Replace(MakeFirstBurn(), 0));
+  EXPECT_OK(flight_plan_->SetDesiredFinalTime(t0_ + 42 * Second));
+  while (flight_plan_->progress_of_recomputation() < 1) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  flight_plan_->RefreshSegments();
+  EXPECT_EQ(0, flight_plan_->number_of_anomalous_manœuvres());
+  flight_plan_->GetAllSegments(begin, end);
+  --end;
+  EXPECT_EQ(expected_final_time, end->time);
+  EXPECT_EQ(expected_final_degrees_of_freedom, end->degrees_of_freedom);
+
+  FlightPlan::MakeSynchronous();
+}
+
+// Checks that edits made while a recomputation is in flight, which stop the
+// worker, don't lose the latest request.
+TEST_F(FlightPlanTest, EditsDuringRecomputation) {
+  flight_plan_->SetDesiredFinalTime(t0_ + 42 * Second);
+  EXPECT_OK(flight_plan_->Insert(MakeFirstBurn(), 0));
+  EXPECT_OK(flight_plan_->Insert(MakeSecondBurn(), 1));
+  DiscreteTrajectory<Barycentric>::Iterator begin;
+  DiscreteTrajectory<Barycentric>::Iterator end;
+  flight_plan_->GetAllSegments(begin, end);
+  --end;
+  Instant const expected_final_time = end->time;
+  DegreesOfFreedom<Barycentric> const expected_final_degrees_of_freedom =
+      end->degrees_of_freedom;
+
+  FlightPlan::MakeAsynchronous();
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_OK(flight_plan_->Replace(MakeFirstBurn(), 0));
+    std::this_thread::sleep_for(std::chrono::microseconds(10 * (i % 10)));
+  }
+  while (flight_plan_->progress_of_recomputation() < 1) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  flight_plan_->RefreshSegments();
+  EXPECT_EQ(5, flight_plan_->number_of_segments());
+  EXPECT_EQ(0, flight_plan_->number_of_anomalous_manœuvres());
+  EXPECT_OK(flight_plan_->recomputation_status());
+  flight_plan_->GetAllSegments(begin, end);
+  --end;
+  EXPECT_EQ(expected_final_time, end->time);
+  EXPECT_EQ(expected_final_degrees_of_freedom, end->degrees_of_freedom);
+
+  FlightPlan::MakeSynchronous();
+}
+
 }  // namespace internal_flight_plan
 }  // namespace ksp_plugin
 }  // namespace principia
@@ -5,6 +5,7 @@
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "ksp_plugin/flight_plan.hpp"
 #include "ksp_plugin_test/fake_plugin.hpp"
 #include "testing_utilities/approximate_quantity.hpp"
 #include "testing_utilities/componentwise.hpp"
@@ -19,6 +20,7 @@ using ksp_plugin::GUID;
 using ksp_plugin::Navigation;
 using ksp_plugin::PartId;
 using ksp_plugin::FakePlugin;
+using ksp_plugin::FlightPlan;
 using ksp_plugin::NavigationManœuvre;
 using ksp_plugin::Vessel;
 using physics::SolarSystem;
@@ -63,6 +65,8 @@ class InterfaceExternalTest : public ::testing::Test {
             SOLUTION_DIR / "astronomy" / "sol_gravity_model.proto.txt",
             SOLUTION_DIR / "astronomy" /
                 "sol_initial_state_jd_2451545_000000000.proto.txt")) {
+    // The test below needs the segments of the flight plan.
+    FlightPlan::MakeSynchronous();
     physics::KeplerianElements<Barycentric> low_earth_orbit;
     low_earth_orbit.eccentricity = 0;
     low_earth_orbit.semimajor_axis = 6783 * Kilo(Metre);
@@ -390,6 +390,20 @@ TEST_F(InterfaceFlightPlanTest, FlightPlan) {
   EXPECT_EQ(XYZ({0, 2, 4}),
             principia__IteratorGetDiscreteTrajectoryXYZ(iterator));
 
+  // Same thing, in chunks.
+  principia__IteratorReset(iterator);
+  XYZ xyzs[2];
+  EXPECT_EQ(2,
+            principia__IteratorGetDiscreteTrajectoryXYZs(iterator, xyzs, 2));
+  EXPECT_EQ(XYZ({0, 0, 0}), xyzs[0]);
+  EXPECT_EQ(XYZ({0, 1, 2}), xyzs[1]);
+  EXPECT_EQ(1,
+            principia__IteratorGetDiscreteTrajectoryXYZs(iterator, xyzs, 2));
+  EXPECT_EQ(XYZ({0, 2, 4}), xyzs[0]);
+  EXPECT_TRUE(principia__IteratorAtEnd(iterator));
+  EXPECT_EQ(0,
+            principia__IteratorGetDiscreteTrajectoryXYZs(iterator, xyzs, 2));
+
   interface_burn.thrust_in_kilonewtons = 10;
   EXPECT_CALL(*plugin_,
               FillBodyCentredNonRotatingNavigationFrame(celestial_index, _))
@@ -0,0 +1,203 @@
+#include "ksp_plugin/message_delta.hpp"
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "google/protobuf/text_format.h"
+#include "gtest/gtest.h"
+#include "serialization/ksp_plugin.pb.h"
+#include "serialization/physics.pb.h"
+#include "testing_utilities/matchers.hpp"
+
+namespace principia {
+namespace ksp_plugin {
+
+using testing_utilities::EqualsProto;
+using ::testing::IsEmpty;
+using ::testing::SizeIs;
+
+class MessageDeltaTest : public ::testing::Test {
+ protected:
+  MessageDeltaTest() {
+    auto const* const plugin = serialization::Plugin::descriptor();
+    auto const* const vessel_and_properties =
+        serialization::Plugin::VesselAndProperties::descriptor();
+    auto const* const vessel = serialization::Vessel::descriptor();
+    keys_[plugin->FindFieldByName("vessel")] =
+        vessel_and_properties->FindFieldByName("guid");
+    keys_[vessel->FindFieldByName("parts")] =
+        serialization::Part::descriptor()->FindFieldByName("part_id");
+    keys_[plugin->FindFieldByName("pile_up")] = nullptr;
+  }
+
+  template<typename Message>
+  static Message Parse(std::string const& text) {
+    google::protobuf::TextFormat::Parser parser;
+    parser.AllowPartialMessage(true);
+    Message message;
+    CHECK(parser.ParseFromString(text, &message)) << text;
+    return message;
+  }
+
+  // Computes the delta from |previous| to |next|, checks that applying it to
+  // |previous| yields |next|, and returns it.
+  template<typename Message>
+  serialization::MessageDelta ComputeAndApply(Message const& previous,
+                                              Message const& next) {
+    MessageSummary summary;
+    ComputeMessageDelta(previous, keys_, summary, /*delta=*/nullptr);
+    serialization::MessageDelta delta;
+    ComputeMessageDelta(next, keys_, summary, &delta);
+    Message applied = previous;
+    ApplyMessageDelta(delta, &applied);
+    EXPECT_THAT(applied, EqualsProto(next));
+    return delta;
+  }
+
+  MatchingKeys keys_;
+};
+
+TEST_F(MessageDeltaTest, Unchanged) {
+  auto const plugin = Parse<serialization::Plugin>(R"(
+      vessel { guid: "a" vessel { name: "A" } }
+      vessel { guid: "b" vessel { name: "B" } }
+      part_id_to_vessel { key: 1 value: "a" }
+      part_id_to_vessel { key: 2 value: "b" }
+      sun_index: 3)");
+  EXPECT_THAT(ComputeAndApply(plugin, plugin).field(), IsEmpty());
+}
+
+TEST_F(MessageDeltaTest, Scalars) {
+  auto const previous = Parse<serialization::Plugin>(R"(
+      sun_index: 3
+      system_fingerprint: 42
+      current_time { scalar { magnitude: 1 } })");
+  auto const next = Parse<serialization::Plugin>(R"(
+      sun_index: 4
+      current_time { scalar { magnitude: 2 } })");
+  auto const delta = ComputeAndApply(previous, next);
+  // The changed scalar, the submessage, and the cleared fingerprint.
+  EXPECT_THAT(delta.field(), SizeIs(3));
+  EXPECT_FALSE(delta.field(2).has_value());
+  EXPECT_FALSE(delta.field(2).has_delta());
+  EXPECT_FALSE(delta.field(2).has_kept_prefix_size());
+}
+
+TEST_F(MessageDeltaTest, Map) {
+  auto const previous = Parse<serialization::Plugin>(R"(
+      part_id_to_vessel { key: 1 value: "a" }
+      part_id_to_vessel { key: 2 value: "b" })");
+  auto const next = Parse<serialization::Plugin>(R"(
+      part_id_to_vessel { key: 2 value: "b" }
+      part_id_to_vessel { key: 3 value: "a" })");
+  auto const delta = ComputeAndApply(previous, next);
+  EXPECT_THAT(delta.field(), SizeIs(1));
+  EXPECT_TRUE(delta.field(0).has_value());
+}
+
+TEST_F(MessageDeltaTest, KeyedElements) {
+  auto const previous = Parse<serialization::Plugin>(R"(
+      vessel { guid: "a" vessel { name: "A" } }
+      vessel { guid: "b" vessel { name: "B" } }
+      vessel {
+        guid: "c"
+        vessel {
+          name: "C"
+          parts { part_id: 1 name: "P1" }
+          parts { part_id: 2 name: "P2" }
+        }
+      })");
+  auto const next = Parse<serialization::Plugin>(R"(
+      vessel { guid: "a" vessel { name: "A" } }
+      vessel {
+        guid: "c"
+        vessel {
+          name: "C"
+          parts { part_id: 2 name: "P2" }
+          parts { part_id: 1 name: "P1" }
+          parts { part_id: 3 name: "P3" }
+        }
+      }
+      vessel { guid: "d" vessel { name: "D" } })");
+  auto const delta = ComputeAndApply(previous, next);
+  ASSERT_THAT(delta.field(), SizeIs(1));
+  auto const& vessels = delta.field(0);
+  EXPECT_EQ(1, vessels.kept_prefix_size());
+  ASSERT_THAT(vessels.element(), SizeIs(2));
+  // Vessel "c" is matched with the one at index 2 and only its parts changed.
+  EXPECT_EQ(2, vessels.element(0).previous_index());
+  EXPECT_THAT(vessels.element(0).delta().field(), SizeIs(1));
+  auto const& parts = vessels.element(0).delta().field(0).delta().field(0);
+  EXPECT_EQ(0, parts.kept_prefix_size());
+  ASSERT_THAT(parts.element(), SizeIs(3));
+  EXPECT_EQ(1, parts.element(0).previous_index());
+  EXPECT_FALSE(parts.element(0).has_delta());
+  EXPECT_EQ(0, parts.element(1).previous_index());
+  EXPECT_TRUE(parts.element(2).has_value());
+  // Vessel "d" is new.
+  EXPECT_TRUE(vessels.element(1).has_value());
+}
+
+TEST_F(MessageDeltaTest, AppendedElements) {
+  auto const previous = Parse<serialization::ContinuousTrajectory>(R"(
+      instant_polynomial_pair { t_max { scalar { magnitude: 1 } } }
+      instant_polynomial_pair { t_max { scalar { magnitude: 2 } } })");
+  auto const next = Parse<serialization::ContinuousTrajectory>(R"(
+      instant_polynomial_pair { t_max { scalar { magnitude: 1 } } }
+      instant_polynomial_pair { t_max { scalar { magnitude: 2 } } }
+      instant_polynomial_pair { t_max { scalar { magnitude: 3 } } })");
+  auto const delta = ComputeAndApply(previous, next);
+  ASSERT_THAT(delta.field(), SizeIs(1));
+  EXPECT_EQ(2, delta.field(0).kept_prefix_size());
+  ASSERT_THAT(delta.field(0).element(), SizeIs(1));
+  EXPECT_TRUE(delta.field(0).element(0).has_value());
+
+  // Removing the last elements and changing the next-to-last one.
+  auto const truncated = Parse<serialization::ContinuousTrajectory>(R"(
+      instant_polynomial_pair { t_max { scalar { magnitude: 4 } } })");
+  auto const truncation_delta = ComputeAndApply(next, truncated);
+  ASSERT_THAT(truncation_delta.field(), SizeIs(1));
+  EXPECT_EQ(0, truncation_delta.field(0).kept_prefix_size());
+  EXPECT_THAT(truncation_delta.field(0).element(), SizeIs(1));
+}
+
+TEST_F(MessageDeltaTest, PositionalElements) {
+  auto const previous = Parse<serialization::Plugin>(R"(
+      pile_up { part_id: 1 }
+      pile_up { part_id: 2 })");
+  auto const next = Parse<serialization::Plugin>(R"(
+      pile_up { part_id: 1 }
+      pile_up { part_id: 2 part_id: 3 })");
+  auto const delta = ComputeAndApply(previous, next);
+  ASSERT_THAT(delta.field(), SizeIs(1));
+  EXPECT_EQ(1, delta.field(0).kept_prefix_size());
+  ASSERT_THAT(delta.field(0).element(), SizeIs(1));
+  EXPECT_EQ(1, delta.field(0).element(0).previous_index());
+  EXPECT_THAT(delta.field(0).element(0).delta().field(), SizeIs(1));
+}
+
+TEST_F(MessageDeltaTest, SuccessiveDeltas) {
+  auto const v0 = Parse<serialization::Plugin>(R"(
+      vessel { guid: "a" vessel { name: "A" } })");
+  auto const v1 = Parse<serialization::Plugin>(R"(
+      vessel { guid: "a" vessel { name: "A1" } }
+      vessel { guid: "b" vessel { name: "B" } })");
+  auto const v2 = Parse<serialization::Plugin>(R"(
+      vessel { guid: "b" vessel { name: "B2" } })");
+
+  MessageSummary summary;
+  ComputeMessageDelta(v0, keys_, summary, /*delta=*/nullptr);
+  serialization::MessageDelta delta1;
+  ComputeMessageDelta(v1, keys_, summary, &delta1);
+  serialization::MessageDelta delta2;
+  ComputeMessageDelta(v2, keys_, summary, &delta2);
+
+  serialization::Plugin applied = v0;
+  ApplyMessageDelta(delta1, &applied);
+  EXPECT_THAT(applied, EqualsProto(v1));
+  ApplyMessageDelta(delta2, &applied);
+  EXPECT_THAT(applied, EqualsProto(v2));
+}
+
+}  // namespace ksp_plugin
+}  // namespace principia
@@ -41,6 +41,16 @@ class MockFlightPlan : public FlightPlan {
                      void(int index,
                           DiscreteTrajectory<Barycentric>::Iterator& begin,
                           DiscreteTrajectory<Barycentric>::Iterator& end));
+
+  MOCK_METHOD0(RefreshSegments, void());
+  MOCK_CONST_METHOD0(progress_of_recomputation, double());
+  MOCK_CONST_METHOD0(recomputation_status, Status());
+
+  MOCK_CONST_METHOD3(
+      ComputeTrajectoryWithBurn,
+      Status(ManœuvreContext const& context,
+             NavigationManœuvre::Burn const& burn,
+             DiscreteTrajectory<Barycentric>& trajectory));
 };
 
 }  // namespace internal_flight_plan
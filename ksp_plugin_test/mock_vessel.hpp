@@ -40,6 +40,14 @@ class MockVessel : public Vessel {
                      void(not_null<serialization::Vessel*> message,
                           PileUp::SerializationIndexForPileUp const&
                               serialization_index_for_pile_up));
+  MOCK_CONST_METHOD4(
+      WriteToMessage,
+      void(not_null<serialization::Vessel*> message,
+           PileUp::SerializationIndexForPileUp const&
+               serialization_index_for_pile_up,
+           Instant const& history_tail_start,
+           not_null<serialization::IncrementalSave::HistoryTail*>
+               history_tail));
 };
 
 }  // namespace internal_vessel
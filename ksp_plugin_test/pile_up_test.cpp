@@ -36,6 +36,7 @@ namespace internal_pile_up {
 using base::check_not_null;
 using base::make_not_null_unique;
 using base::Status;
+using base::ThreadPool;
 using geometry::AngularVelocity;
 using geometry::Displacement;
 using geometry::NonRotating;
@@ -646,6 +647,104 @@ TEST_F(PileUpTest, MidStepIntrinsicForce) {
       AlmostEquals(old_velocity + 0.5 * fixed_step * a, 1));
 }
 
+// Checks that the histories integrated together by |FusedPileUps| are the same
+// as those integrated separately.
+TEST_F(PileUpTest, FusedHistories) {
+  std::vector<not_null<std::unique_ptr<MassiveBody const>>> bodies;
+  bodies.emplace_back(make_not_null_unique<MassiveBody>(1e20 * Kilogram));
+  std::vector<DegreesOfFreedom<Barycentric>> initial_state{
+      DegreesOfFreedom<Barycentric>{
+          Barycentric::origin +
+              Displacement<Barycentric>({1e6 * Metre, 0 * Metre, 0 * Metre}),
+          Barycentric::unmoving}};
+  Ephemeris<Barycentric> ephemeris{
+      std::move(bodies),
+      initial_state,
+      /*initial_time=*/astronomy::J2000,
+      /*accuracy_parameters=*/{/*fitting_tolerance=*/1 * Metre,
+                               /*geopotential_tolerance=*/0x1p-24},
+      Ephemeris<Barycentric>::FixedStepParameters{
+          SymplecticRungeKuttaNyströmIntegrator<BlanesMoan2002SRKN6B,
+                                                Position<Barycentric>>(),
+          1 * Second}};
+
+  // Copies of |p1_| and |p2_| for the separate integrations.
+  Part q1(333,
+          "q1",
+          mass1_,
+          EccentricPart::origin,
+          inertia_tensor1_,
+          RigidMotion<EccentricPart, Barycentric>::MakeNonRotatingMotion(
+              p1_dof_),
+          /*deletion_callback=*/nullptr);
+  Part q2(444,
+          "q2",
+          mass2_,
+          EccentricPart::origin,
+          inertia_tensor2_,
+          RigidMotion<EccentricPart, Barycentric>::MakeNonRotatingMotion(
+              p2_dof_),
+          /*deletion_callback=*/nullptr);
+
+  TestablePileUp fused_pile_up1({&p1_},
+                                astronomy::J2000,
+                                DefaultPsychohistoryParameters(),
+                                DefaultHistoryParameters(),
+                                &ephemeris,
+                                /*deletion_callback=*/nullptr);
+  TestablePileUp fused_pile_up2({&p2_},
+                                astronomy::J2000,
+                                DefaultPsychohistoryParameters(),
+                                DefaultHistoryParameters(),
+                                &ephemeris,
+                                /*deletion_callback=*/nullptr);
+  TestablePileUp pile_up1({&q1},
+                          astronomy::J2000,
+                          DefaultPsychohistoryParameters(),
+                          DefaultHistoryParameters(),
+                          &ephemeris,
+                          /*deletion_callback=*/nullptr);
+  TestablePileUp pile_up2({&q2},
+                          astronomy::J2000,
+                          DefaultPsychohistoryParameters(),
+                          DefaultHistoryParameters(),
+                          &ephemeris,
+                          /*deletion_callback=*/nullptr);
+
+  // Several calls, so that the fused instance gets reused.
+  FusedPileUps fused_pile_ups;
+  ThreadPool<Status> thread_pool(/*pool_size=*/2);
+  for (Instant t = astronomy::J2000 + 25 * Second;
+       t < astronomy::J2000 + 200 * Second;
+       t += 25 * Second) {
+    fused_pile_ups.AdvanceHistories(
+        {&fused_pile_up1, &fused_pile_up2}, t, thread_pool);
+    for (PileUp* const pile_up :
+         {&fused_pile_up1, &fused_pile_up2, &pile_up1, &pile_up2}) {
+      EXPECT_OK(pile_up->DeformAndAdvanceTime(t));
+    }
+  }
+
+  auto const expect_same_trajectories = [](Part& fused, Part& separate) {
+    int size = 0;
+    auto it1 = fused.history_begin();
+    auto it2 = separate.history_begin();
+    for (; it1 != fused.history_end() && it2 != separate.history_end();
+         ++it1, ++it2, ++size) {
+      EXPECT_EQ(it1->time, it2->time);
+      EXPECT_EQ(it1->degrees_of_freedom, it2->degrees_of_freedom);
+    }
+    EXPECT_TRUE(it1 == fused.history_end());
+    EXPECT_TRUE(it2 == separate.history_end());
+    EXPECT_LT(1, size);
+    EXPECT_EQ(
+        fused.rigid_motion()({RigidPart::origin, RigidPart::unmoving}),
+        separate.rigid_motion()({RigidPart::origin, RigidPart::unmoving}));
+  };
+  expect_same_trajectories(p1_, q1);
+  expect_same_trajectories(p2_, q2);
+}
+
 TEST_F(PileUpTest, Serialization) {
   MockEphemeris<Barycentric> ephemeris;
   p1_.apply_intrinsic_force(
@@ -666,7 +765,7 @@ TEST_F(PileUpTest, Serialization) {
   EXPECT_EQ(2, message.part_id_size());
   EXPECT_EQ(part_id1_, message.part_id(0));
   EXPECT_EQ(part_id2_, message.part_id(1));
-  EXPECT_EQ(1, message.history().zfp().timeline_size());
+  EXPECT_EQ(1, message.history().columns().timeline_size());
   EXPECT_EQ(2, message.actual_part_rigid_motion().size());
   EXPECT_TRUE(message.apparent_part_rigid_motion().empty());
 
@@ -709,7 +808,7 @@ TEST_F(PileUpTest, SerializationCompatibility) {
 
   // Clear the children to simulate pre-Cesàro serialization.
   message.mutable_history()->clear_children();
-  EXPECT_EQ(1, message.history().zfp().timeline_size());
+  EXPECT_EQ(1, message.history().columns().timeline_size());
 
   auto const part_id_to_part = [this](PartId const part_id) {
     if (part_id == part_id1_) {
@@ -6,6 +6,7 @@
 
 #include "base/not_null.hpp"
 #include "base/serialization.hpp"
+#include "base/thread_pool.hpp"
 #include "geometry/affine_map.hpp"
 #include "geometry/grassmann.hpp"
 #include "geometry/linear_map.hpp"
@@ -34,6 +35,7 @@ using astronomy::InfinitePast;
 using astronomy::InfiniteFuture;
 using base::make_not_null_unique;
 using base::ParseFromBytes;
+using base::ThreadPool;
 using geometry::AngularVelocity;
 using geometry::Arbitrary;
 using geometry::Bivector;
@@ -251,6 +253,121 @@ TEST_F(PlanetariumTest, PlotMethod2) {
   }
 }
 
+TEST_F(PlanetariumTest, PlotMethod2Cached) {
+  auto const discrete_trajectory =
+      NewCircularTrajectory(/*period=*/100'000 * Second,
+                            /*step=*/1 * Second,
+                            /*last=*/30'000 * Second);
+  auto const end = discrete_trajectory->LowerBound(t0_ + 25'000 * Second);
+
+  Planetarium::Parameters parameters(
+      /*sphere_radius_multiplier=*/1,
+      /*angular_resolution=*/0.4 * ArcMinute,
+      /*field_of_view=*/90 * Degree);
+  PlottingCache plotting_cache;
+  Planetarium const uncached_planetarium(
+      parameters, perspective_, &ephemeris_, &plotting_frame_);
+  Planetarium const planetarium(
+      parameters, perspective_, &ephemeris_, &plotting_frame_, &plotting_cache);
+
+  // When nothing is cached, the points are those computed without a cache.
+  auto const uncached_rp2_lines =
+      uncached_planetarium.PlotMethod2(discrete_trajectory->begin(),
+                                       end,
+                                       t0_ + 10 * Second,
+                                       /*reverse=*/false);
+  auto const rp2_lines1 = planetarium.PlotMethod2(discrete_trajectory->begin(),
+                                                  end,
+                                                  t0_ + 10 * Second,
+                                                  /*reverse=*/false);
+  EXPECT_EQ(uncached_rp2_lines, rp2_lines1);
+  EXPECT_THAT(rp2_lines1, SizeIs(1));
+
+  // The cached points are reused.  Some of them may be dropped if they are not
+  // needed to stay within the angular resolution.
+  plotting_cache.NewFrame();
+  auto const rp2_lines2 = planetarium.PlotMethod2(discrete_trajectory->begin(),
+                                                  end,
+                                                  t0_ + 10 * Second,
+                                                  /*reverse=*/false);
+  EXPECT_THAT(rp2_lines2, SizeIs(1));
+  EXPECT_GE(rp2_lines1[0].size(), rp2_lines2[0].size());
+  EXPECT_EQ(rp2_lines1[0].front(), rp2_lines2[0].front());
+  EXPECT_EQ(rp2_lines1[0].back(), rp2_lines2[0].back());
+
+  // When the trajectory gets longer, the new points are appended.
+  plotting_cache.NewFrame();
+  auto const rp2_lines3 = planetarium.PlotMethod2(discrete_trajectory->begin(),
+                                                  discrete_trajectory->end(),
+                                                  t0_ + 10 * Second,
+                                                  /*reverse=*/false);
+  EXPECT_THAT(rp2_lines3, SizeIs(1));
+  EXPECT_LT(rp2_lines2[0].size(), rp2_lines3[0].size());
+  EXPECT_EQ(rp2_lines1[0].front(), rp2_lines3[0].front());
+  for (auto const& rp2_point : rp2_lines3[0]) {
+    EXPECT_THAT(rp2_point.y(), VanishesBefore(1 * Metre, 0, 14));
+  }
+
+  // Plotting backward uses separate cached points.
+  auto const reverse_rp2_lines =
+      planetarium.PlotMethod2(discrete_trajectory->begin(),
+                              end,
+                              t0_ + 10 * Second,
+                              /*reverse=*/true);
+  EXPECT_THAT(reverse_rp2_lines, SizeIs(1));
+  EXPECT_EQ(rp2_lines1[0].front(), reverse_rp2_lines[0].back());
+  EXPECT_EQ(rp2_lines1[0].back(), reverse_rp2_lines[0].front());
+}
+
+TEST_F(PlanetariumTest, PlotMethod2Batch) {
+  auto const discrete_trajectory =
+      NewCircularTrajectory(/*period=*/100'000 * Second,
+                            /*step=*/1 * Second,
+                            /*last=*/50'000 * Second);
+
+  Planetarium::Parameters parameters(
+      /*sphere_radius_multiplier=*/1,
+      /*angular_resolution=*/0.4 * ArcMinute,
+      /*field_of_view=*/90 * Degree);
+  ThreadPool<Status> thread_pool(/*pool_size=*/4);
+  Planetarium const planetarium(parameters,
+                                perspective_,
+                                &ephemeris_,
+                                &plotting_frame_,
+                                /*plotting_cache=*/nullptr,
+                                &thread_pool);
+
+  std::vector<Planetarium::PlottedTrajectory> plotted_trajectories;
+  for (int i = 0; i < 20; ++i) {
+    plotted_trajectories.push_back(
+        {discrete_trajectory.get(),
+         /*first_time=*/t0_ + i * 1000 * Second,
+         /*last_time=*/t0_ + (i + 25) * 1000 * Second,
+         /*reverse=*/i % 2 == 1});
+  }
+  // An empty interval yields no lines.
+  plotted_trajectories.push_back({discrete_trajectory.get(),
+                                  /*first_time=*/t0_ + 10 * Second,
+                                  /*last_time=*/t0_ + 10 * Second,
+                                  /*reverse=*/false});
+
+  // The lines plotted concurrently are those plotted one at a time.
+  auto const batch_rp2_lines =
+      planetarium.PlotMethod2(plotted_trajectories, t0_ + 10 * Second);
+  ASSERT_THAT(batch_rp2_lines, SizeIs(plotted_trajectories.size()));
+  for (int i = 0; i < plotted_trajectories.size(); ++i) {
+    auto const& plotted = plotted_trajectories[i];
+    EXPECT_EQ(planetarium.PlotMethod2(*plotted.trajectory,
+                                      plotted.first_time,
+                                      plotted.last_time,
+                                      t0_ + 10 * Second,
+                                      plotted.reverse),
+              batch_rp2_lines[i]) << i;
+  }
+  EXPECT_THAT(batch_rp2_lines.front(), SizeIs(1));
+  EXPECT_THAT(batch_rp2_lines.back(), SizeIs(0));
+}
+
 #if !defined(_DEBUG)
 TEST_F(PlanetariumTest, RealSolarSystem) {
   auto discrete_trajectory = DiscreteTrajectory<Barycentric>::ReadFromMessage(
@@ -263,6 +380,7 @@ TEST_F(PlanetariumTest, RealSolarSystem) {
       ParseFromBytes<serialization::Ephemeris>(
           ReadFromBinaryFile(SOLUTION_DIR / "ksp_plugin_test" /
                              "planetarium_ephemeris.proto.bin")));
+  ephemeris->AwaitReanimation(InfinitePast);
 
   auto plotting_frame = NavigationFrame::ReadFromMessage(
       ParseFromBytes<serialization::DynamicFrame>(
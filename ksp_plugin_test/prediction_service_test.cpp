@@ -0,0 +1,195 @@
+
+#include "ksp_plugin/prediction_service.hpp"
+
+#include <atomic>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "base/jthread.hpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace principia {
+namespace ksp_plugin {
+
+using base::this_stoppable_thread;
+using ::testing::ElementsAre;
+
+class PredictionServiceTest : public ::testing::Test {
+ protected:
+  using Priority = PredictionService::Priority;
+
+  // Returns a computation that blocks until |release| is notified.
+  static std::function<void()> Blocker(absl::Notification& started,
+                                       absl::Notification& release) {
+    return [&started, &release]() {
+      started.Notify();
+      release.WaitForNotification();
+    };
+  }
+};
+
+TEST_F(PredictionServiceTest, Coalescing) {
+  PredictionService service(/*number_of_workers=*/1);
+  absl::Notification started;
+  absl::Notification release;
+  PredictionService::Client blocker(service, Blocker(started, release));
+  std::atomic<int> runs = 0;
+  PredictionService::Client client(service, [&runs]() { ++runs; });
+
+  // While the only worker is busy, the requests are coalesced.
+  blocker.Request();
+  started.WaitForNotification();
+  client.Request();
+  client.Request();
+  client.Request();
+  release.Notify();
+  while (runs == 0) {
+    absl::SleepFor(absl::Milliseconds(1));
+  }
+  absl::SleepFor(absl::Milliseconds(50));
+  EXPECT_EQ(1, runs);
+}
+
+TEST_F(PredictionServiceTest, RequestWhileRunning) {
+  PredictionService service(/*number_of_workers=*/2);
+  absl::Notification started;
+  absl::Notification release;
+  std::atomic<int> runs = 0;
+  PredictionService::Client client(service, [&]() {
+    if (++runs == 1) {
+      started.Notify();
+      release.WaitForNotification();
+    }
+  });
+
+  // A request made while the computation runs causes it to run again, but not
+  // concurrently.
+  client.Request();
+  started.WaitForNotification();
+  client.Request();
+  absl::SleepFor(absl::Milliseconds(50));
+  EXPECT_EQ(1, runs);
+  release.Notify();
+  while (runs < 2) {
+    absl::SleepFor(absl::Milliseconds(1));
+  }
+  absl::SleepFor(absl::Milliseconds(50));
+  EXPECT_EQ(2, runs);
+}
+
+TEST_F(PredictionServiceTest, Priorities) {
+  PredictionService service(/*number_of_workers=*/1);
+  absl::Notification started;
+  absl::Notification release;
+  PredictionService::Client blocker(service, Blocker(started, release));
+
+  absl::Mutex lock;
+  std::vector<int> order;
+  auto const record = [&lock, &order](int const i) {
+    return [i, &lock, &order]() {
+      absl::MutexLock l(&lock);
+      order.push_back(i);
+    };
+  };
+  PredictionService::Client other(service, record(2));
+  PredictionService::Client target(service, record(1));
+  PredictionService::Client active(service, record(0));
+  target.set_priority(Priority::TargetVessel);
+
+  blocker.Request();
+  started.WaitForNotification();
+  other.Request();
+  target.Request();
+  active.Request();
+  // Changing the priority of a queued client moves it.
+  active.set_priority(Priority::ActiveVessel);
+  release.Notify();
+
+  for (;;) {
+    absl::SleepFor(absl::Milliseconds(1));
+    absl::MutexLock l(&lock);
+    if (order.size() == 3) {
+      break;
+    }
+  }
+  EXPECT_THAT(order, ElementsAre(0, 1, 2));
+}
+
+TEST_F(PredictionServiceTest, Stop) {
+  PredictionService service(/*number_of_workers=*/1);
+  absl::Notification started;
+  std::atomic<bool> observed_stop = false;
+  std::atomic<int> runs = 0;
+  PredictionService::Client client(service, [&]() {
+    if (++runs == 1) {
+      started.Notify();
+    }
+    while (!this_stoppable_thread::get_stop_token().stop_requested()) {
+      absl::SleepFor(absl::Milliseconds(1));
+    }
+    observed_stop = true;
+  });
+
+  client.Request();
+  started.WaitForNotification();
+  client.Request();
+  // Stopping cancels the running computation and drops the pending request.
+  client.Stop();
+  EXPECT_TRUE(observed_stop);
+  absl::SleepFor(absl::Milliseconds(50));
+  EXPECT_EQ(1, runs);
+
+  // The client may be restarted.
+  observed_stop = false;
+  client.Request();
+  while (runs < 2) {
+    absl::SleepFor(absl::Milliseconds(1));
+  }
+  client.Stop();
+  EXPECT_TRUE(observed_stop);
+}
+
+TEST_F(PredictionServiceTest, RequestStop) {
+  PredictionService service(/*number_of_workers=*/1);
+  absl::Notification started;
+  absl::Notification release;
+  std::atomic<bool> observed_stop = false;
+  std::atomic<int> runs = 0;
+  PredictionService::Client client(service, [&]() {
+    if (++runs == 1) {
+      started.Notify();
+      while (!this_stoppable_thread::get_stop_token().stop_requested()) {
+        absl::SleepFor(absl::Milliseconds(1));
+      }
+      observed_stop = true;
+      release.WaitForNotification();
+    }
+  });
+
+  client.Request();
+  started.WaitForNotification();
+  // Requesting a stop doesn't wait for the computation to complete.
+  client.RequestStop();
+  while (!observed_stop) {
+    absl::SleepFor(absl::Milliseconds(1));
+  }
+
+  // A request made after the stop is honoured once the stopped computation
+  // completes.
+  client.Request();
+  absl::SleepFor(absl::Milliseconds(50));
+  EXPECT_EQ(1, runs);
+  release.Notify();
+  while (runs < 2) {
+    absl::SleepFor(absl::Milliseconds(1));
+  }
+  absl::SleepFor(absl::Milliseconds(50));
+  EXPECT_EQ(2, runs);
+}
+
+}  // namespace ksp_plugin
+}  // namespace principia
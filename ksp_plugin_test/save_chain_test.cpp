@@ -0,0 +1,272 @@
+#include "ksp_plugin/save_chain.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "astronomy/epoch.hpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "ksp_plugin/frames.hpp"
+#include "physics/discrete_trajectory.hpp"
+#include "quantities/si.hpp"
+#include "serialization/ksp_plugin.pb.h"
+#include "testing_utilities/matchers.hpp"
+#include "testing_utilities/serialization.hpp"
+
+namespace principia {
+namespace ksp_plugin {
+
+using astronomy::InfinitePast;
+using geometry::Instant;
+using physics::DiscreteTrajectory;
+using quantities::Length;
+using quantities::si::Second;
+using testing_utilities::EqualsProto;
+using testing_utilities::ReadFromBinaryFile;
+using ::testing::Eq;
+using ::testing::IsEmpty;
+using ::testing::Le;
+using ::testing::SizeIs;
+
+class SaveChainTest : public ::testing::Test {
+ protected:
+  SaveChainTest() {
+    std::vector<std::uint8_t> const serialized_simple_plugin =
+        ReadFromBinaryFile(SOLUTION_DIR / "ksp_plugin_test" /
+                           "simple_plugin.proto.bin");
+    CHECK(simple_plugin_.ParseFromArray(serialized_simple_plugin.data(),
+                                        serialized_simple_plugin.size()));
+    // The plugin predates the last point of the history, which identifies the
+    // tails of the histories.
+    auto* const vessel = simple_plugin_.mutable_vessel(0)->mutable_vessel();
+    *vessel->mutable_history_last_point() = vessel->history().timeline(
+        vessel->history().timeline_size() - 1);
+  }
+
+  // |plugin| without the histories of its vessels.
+  static serialization::Plugin WithoutHistories(
+      serialization::Plugin const& plugin) {
+    serialization::Plugin result = plugin;
+    for (auto& vessel : *result.mutable_vessel()) {
+      vessel.mutable_vessel()->mutable_history()->Clear();
+    }
+    return result;
+  }
+
+  // Appends |count| points to the history of the first vessel of |plugin| as
+  // |Vessel| would, and writes to |increment| the tail of that history since
+  // |history_tail_start|.
+  static void AppendToHistory(
+      int const count,
+      Instant const& history_tail_start,
+      serialization::Plugin& plugin,
+      serialization::IncrementalSave::Increment& increment) {
+    auto* const vessel = plugin.mutable_vessel(0)->mutable_vessel();
+    DiscreteTrajectory<Barycentric>* psychohistory = nullptr;
+    DiscreteTrajectory<Barycentric>* prediction = nullptr;
+    auto const history = DiscreteTrajectory<Barycentric>::ReadFromMessage(
+        vessel->history(), /*forks=*/{&psychohistory, &prediction});
+    history->DeleteFork(psychohistory);
+    auto const last = history->back();
+    for (int i = 1; i <= count; ++i) {
+      history->Append(last.time + i * Second, last.degrees_of_freedom);
+    }
+    psychohistory = history->NewForkAtLast();
+    psychohistory->Append(history->back().time + 0.5 * Second,
+                          last.degrees_of_freedom);
+    prediction = psychohistory->NewForkAtLast();
+
+    auto* const history_tail = increment.add_history_tail();
+    history_tail->set_vessel_guid(plugin.vessel(0).guid());
+    history_tail_start.WriteToMessage(history_tail->mutable_start());
+    history->WriteTailToMessage(history_tail_start,
+                                history_tail->mutable_history(),
+                                /*forks=*/{psychohistory, prediction});
+
+    vessel->mutable_history()->Clear();
+    history->WriteToMessage(vessel->mutable_history(),
+                            /*forks=*/{psychohistory, prediction});
+    auto* const history_last_point = vessel->mutable_history_last_point();
+    history->back().time.WriteToMessage(history_last_point->mutable_instant());
+    history->back().degrees_of_freedom.WriteToMessage(
+        history_last_point->mutable_degrees_of_freedom());
+  }
+
+  // Checks that |actual| and |expected| are equal, except that their histories
+  // may be encoded differently.
+  static void ExpectSamePlugin(serialization::Plugin const& actual,
+                               serialization::Plugin const& expected) {
+    EXPECT_THAT(WithoutHistories(actual),
+                EqualsProto(WithoutHistories(expected)));
+    ASSERT_THAT(actual.vessel(), SizeIs(expected.vessel_size()));
+    for (int i = 0; i < expected.vessel_size(); ++i) {
+      auto const& actual_history = actual.vessel(i).vessel().history();
+      auto const& expected_history = expected.vessel(i).vessel().history();
+      EXPECT_THAT(actual_history.children(),
+                  EqualsProto(expected_history.children()));
+      EXPECT_THAT(actual_history.downsampling(),
+                  EqualsProto(expected_history.downsampling()));
+      DiscreteTrajectory<Barycentric>* psychohistory = nullptr;
+      DiscreteTrajectory<Barycentric>* prediction = nullptr;
+      auto const actual_trajectory =
+          DiscreteTrajectory<Barycentric>::ReadFromMessage(
+              actual_history, /*forks=*/{&psychohistory, &prediction});
+      psychohistory = nullptr;
+      prediction = nullptr;
+      auto const expected_trajectory =
+          DiscreteTrajectory<Barycentric>::ReadFromMessage(
+              expected_history, /*forks=*/{&psychohistory, &prediction});
+      // The histories are only as accurate as the downsampling tolerance.
+      Length const tolerance = Length::ReadFromMessage(
+          expected_history.downsampling().tolerance());
+      ASSERT_THAT(actual_trajectory->Size(), Eq(expected_trajectory->Size()));
+      for (auto actual_it = actual_trajectory->begin(),
+                expected_it = expected_trajectory->begin();
+           expected_it != expected_trajectory->end();
+           ++actual_it, ++expected_it) {
+        EXPECT_THAT(actual_it->time, Eq(expected_it->time));
+        EXPECT_THAT((actual_it->degrees_of_freedom.position() -
+                     expected_it->degrees_of_freedom.position()).Norm(),
+                    Le(2 * tolerance));
+      }
+    }
+  }
+
+  serialization::Plugin simple_plugin_;
+};
+
+TEST_F(SaveChainTest, SaveAndLoad) {
+  SaveChain save_chain;
+  EXPECT_TRUE(save_chain.must_start_new_base());
+
+  // The first save starts a base.
+  serialization::Plugin base = simple_plugin_;
+  serialization::IncrementalSave save0;
+  save_chain.SaveBase(&base, &save0);
+  EXPECT_THAT(base, EqualsProto(simple_plugin_));
+  EXPECT_THAT(save0.increment(), IsEmpty());
+  EXPECT_FALSE(save_chain.must_start_new_base());
+  std::string const& guid = simple_plugin_.vessel(0).guid();
+  Instant const t0 = Instant::ReadFromMessage(
+      simple_plugin_.vessel(0).vessel().history_last_point().instant());
+  EXPECT_EQ(t0, save_chain.history_tail_start(guid));
+  EXPECT_EQ(InfinitePast, save_chain.history_tail_start("unknown"));
+
+  // Small changes are saved as increments against that base.  The histories
+  // are not written again.
+  serialization::Plugin plugin1 = simple_plugin_;
+  plugin1.mutable_current_time()->mutable_scalar()->set_magnitude(
+      simple_plugin_.current_time().scalar().magnitude() + 10);
+  serialization::IncrementalSave::Increment increment1;
+  AppendToHistory(/*count=*/3, t0, plugin1, increment1);
+  serialization::IncrementalSave save1;
+  EXPECT_TRUE(save_chain.SaveIncrement(
+      WithoutHistories(plugin1), &increment1, &save1));
+  EXPECT_EQ(save0.base_id(), save1.base_id());
+  EXPECT_THAT(save1.increment(), SizeIs(1));
+  EXPECT_LT(save1.ByteSizeLong(), base.ByteSizeLong() / 4);
+  Instant const t1 = save_chain.history_tail_start(guid);
+  EXPECT_EQ(t0 + 3 * Second, t1);
+
+  serialization::Plugin plugin2 = plugin1;
+  plugin2.mutable_vessel(0)->mutable_vessel()->set_name("renamed");
+  serialization::IncrementalSave::Increment increment2;
+  AppendToHistory(/*count=*/2, t1, plugin2, increment2);
+  serialization::IncrementalSave save2;
+  EXPECT_TRUE(save_chain.SaveIncrement(
+      WithoutHistories(plugin2), &increment2, &save2));
+  EXPECT_EQ(save0.base_id(), save2.base_id());
+  EXPECT_THAT(save2.increment(), SizeIs(2));
+
+  // Each save may be loaded from the base.
+  serialization::Plugin loaded1 = base;
+  SaveChain loaded_save_chain1;
+  loaded_save_chain1.Load(save1, &loaded1);
+  ExpectSamePlugin(loaded1, plugin1);
+  EXPECT_EQ(t1, loaded_save_chain1.history_tail_start(guid));
+
+  serialization::Plugin loaded2 = base;
+  SaveChain loaded_save_chain2;
+  loaded_save_chain2.Load(save2, &loaded2);
+  ExpectSamePlugin(loaded2, plugin2);
+
+  // A chain that was loaded extends the save it was loaded from.
+  serialization::IncrementalSave::Increment increment3;
+  serialization::Plugin plugin3 = plugin1;
+  AppendToHistory(/*count=*/2, t1, plugin3, increment3);
+  serialization::IncrementalSave save3;
+  EXPECT_TRUE(loaded_save_chain1.SaveIncrement(
+      WithoutHistories(plugin3), &increment3, &save3));
+  EXPECT_EQ(save0.base_id(), save3.base_id());
+  EXPECT_THAT(save3.increment(), SizeIs(2));
+  serialization::Plugin loaded3 = base;
+  SaveChain().Load(save3, &loaded3);
+  ExpectSamePlugin(loaded3, plugin3);
+}
+
+TEST_F(SaveChainTest, NewVessel) {
+  SaveChain save_chain;
+  serialization::Plugin base = simple_plugin_;
+  serialization::IncrementalSave save0;
+  save_chain.SaveBase(&base, &save0);
+
+  // The history of a vessel that is not in the base is written entirely.
+  serialization::Plugin plugin1 = simple_plugin_;
+  auto* const vessel = plugin1.add_vessel();
+  *vessel = simple_plugin_.vessel(0);
+  vessel->set_guid("copy");
+  EXPECT_EQ(InfinitePast, save_chain.history_tail_start("copy"));
+  serialization::IncrementalSave::Increment increment1;
+  auto* const history_tail = increment1.add_history_tail();
+  history_tail->set_vessel_guid("copy");
+  InfinitePast.WriteToMessage(history_tail->mutable_start());
+  *history_tail->mutable_history() = vessel->vessel().history();
+  serialization::IncrementalSave save1;
+  EXPECT_TRUE(save_chain.SaveIncrement(
+      WithoutHistories(plugin1), &increment1, &save1));
+
+  serialization::Plugin loaded1 = base;
+  SaveChain().Load(save1, &loaded1);
+  ExpectSamePlugin(loaded1, plugin1);
+}
+
+TEST_F(SaveChainTest, NewBase) {
+  SaveChain save_chain;
+  serialization::Plugin base = simple_plugin_;
+  serialization::IncrementalSave save0;
+  save_chain.SaveBase(&base, &save0);
+
+  // A new base is started periodically.
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_FALSE(save_chain.must_start_new_base());
+    serialization::IncrementalSave::Increment increment;
+    serialization::IncrementalSave save;
+    EXPECT_TRUE(save_chain.SaveIncrement(
+        WithoutHistories(simple_plugin_), &increment, &save));
+  }
+  EXPECT_TRUE(save_chain.must_start_new_base());
+  serialization::IncrementalSave save1;
+  save_chain.SaveBase(&base, &save1);
+  EXPECT_NE(save0.base_id(), save1.base_id());
+  EXPECT_THAT(save1.increment(), IsEmpty());
+  EXPECT_EQ(save1.base_id(), save_chain.base_id());
+
+  // Adding many vessels makes the increment large compared to the base, in
+  // which case a new base must be started.
+  serialization::Plugin plugin2 = WithoutHistories(simple_plugin_);
+  for (int i = 0; plugin2.ByteSizeLong() < 2 * simple_plugin_.ByteSizeLong();
+       ++i) {
+    auto* const vessel = plugin2.add_vessel();
+    *vessel = simple_plugin_.vessel(0);
+    vessel->set_guid("copy " + std::to_string(i));
+  }
+  serialization::IncrementalSave::Increment increment2;
+  serialization::IncrementalSave save2;
+  EXPECT_FALSE(save_chain.SaveIncrement(plugin2, &increment2, &save2));
+  EXPECT_FALSE(save2.has_base_id());
+}
+
+}  // namespace ksp_plugin
+}  // namespace principia
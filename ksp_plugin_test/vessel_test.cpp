@@ -44,6 +44,7 @@ using quantities::MomentOfInertia;
 using quantities::si::Degree;
 using quantities::si::Kilogram;
 using quantities::si::Metre;
+using quantities::si::Milli;
 using quantities::si::Radian;
 using quantities::si::Second;
 using testing_utilities::AlmostEquals;
@@ -469,6 +470,103 @@ TEST_F(VesselTest, SerializationSuccess) {
   EXPECT_THAT(message, EqualsProto(second_message));
 }
 
+TEST_F(VesselTest, LazyHistory) {
+  MockFunction<int(not_null<PileUp const*>)>
+      serialization_index_for_pile_up;
+  EXPECT_CALL(serialization_index_for_pile_up, Call(_)).Times(0);
+
+  EXPECT_CALL(ephemeris_, t_max())
+      .WillRepeatedly(Return(astronomy::J2000 + 2 * Second));
+  EXPECT_CALL(ephemeris_, FlowWithAdaptiveStep(_, _, _, _, _))
+      .Times(AnyNumber());
+  EXPECT_CALL(ephemeris_, Prolong(_)).Times(AnyNumber());
+  vessel_.PrepareHistory(astronomy::J2000);
+
+  auto const append_to_part_histories = [this](Vessel& vessel,
+                                                Instant const& time) {
+    Displacement<Barycentric> const displacement(
+        {(time - astronomy::J2000) * Metre / Second, 0 * Metre, 0 * Metre});
+    vessel.part(part_id1_)->AppendToHistory(
+        time,
+        DegreesOfFreedom<Barycentric>(p1_dof_.position() + displacement,
+                                      p1_dof_.velocity()));
+    vessel.part(part_id2_)->AppendToHistory(
+        time,
+        DegreesOfFreedom<Barycentric>(p2_dof_.position() + displacement,
+                                      p2_dof_.velocity()));
+  };
+  append_to_part_histories(vessel_, astronomy::J2000 + 0.5 * Second);
+  append_to_part_histories(vessel_, astronomy::J2000 + 1.0 * Second);
+  vessel_.AdvanceTime();
+
+  serialization::Vessel message;
+  vessel_.WriteToMessage(&message,
+                         serialization_index_for_pile_up.AsStdFunction());
+  EXPECT_TRUE(message.has_history_last_point());
+
+  auto const v = Vessel::ReadFromMessage(
+      message, &celestial_, &ephemeris_, /*deletion_callback=*/nullptr);
+  EXPECT_EQ(astronomy::J2000 + 1.0 * Second, v->psychohistory_back().time);
+
+  // The history is written back without being read if it has not changed.
+  serialization::Vessel second_message;
+  v->WriteToMessage(&second_message,
+                    serialization_index_for_pile_up.AsStdFunction());
+  EXPECT_THAT(second_message, EqualsProto(message));
+
+  // If the history has changed, it is read again to be written.
+  vessel_.DisableDownsampling();
+  v->DisableDownsampling();
+  serialization::Vessel third_message;
+  vessel_.WriteToMessage(&third_message,
+                         serialization_index_for_pile_up.AsStdFunction());
+  serialization::Vessel fourth_message;
+  v->WriteToMessage(&fourth_message,
+                    serialization_index_for_pile_up.AsStdFunction());
+  EXPECT_THAT(fourth_message, EqualsProto(third_message));
+
+  // The history is not read until it is requested.
+  Instant time = astronomy::J2000 + 1.0 * Second;
+  for (int i = 0; i < 3; ++i) {
+    time += 10 * Milli(Second);
+    append_to_part_histories(vessel_, time);
+    vessel_.AdvanceTime();
+    append_to_part_histories(*v, time);
+    v->AdvanceTime();
+    EXPECT_EQ(astronomy::J2000 + 1.0 * Second,
+              v->psychohistory().front().time);
+  }
+
+  // Points appended before the history is attached are retained.  The history
+  // is read asynchronously in release builds, so it may take a few steps.
+  v->RequestHistory();
+  do {
+    using namespace std::chrono_literals;
+    time += 10 * Milli(Second);
+    append_to_part_histories(vessel_, time);
+    vessel_.AdvanceTime();
+    append_to_part_histories(*v, time);
+    v->AdvanceTime();
+    std::this_thread::sleep_for(100ms);
+  } while (v->psychohistory().front().time != astronomy::J2000);
+  EXPECT_EQ(vessel_.psychohistory().Size(), v->psychohistory().Size());
+  for (auto it1 = vessel_.psychohistory().begin(),
+            it2 = v->psychohistory().begin();
+       it1 != vessel_.psychohistory().end();
+       ++it1, ++it2) {
+    EXPECT_EQ(it1->time, it2->time);
+    EXPECT_EQ(it1->degrees_of_freedom, it2->degrees_of_freedom);
+  }
+
+  serialization::Vessel fifth_message;
+  vessel_.WriteToMessage(&fifth_message,
+                         serialization_index_for_pile_up.AsStdFunction());
+  serialization::Vessel sixth_message;
+  v->WriteToMessage(&sixth_message,
+                    serialization_index_for_pile_up.AsStdFunction());
+  EXPECT_THAT(sixth_message, EqualsProto(fifth_message));
+}
+
 }  // namespace internal_vessel
 }  // namespace ksp_plugin
 }  // namespace principia
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include "base/array.hpp"
+#include "base/not_constructible.hpp"
+#include "base/traits.hpp"
+#include "geometry/grassmann.hpp"
+#include "geometry/point.hpp"
+#include "numerics/polynomial.hpp"
+#include "quantities/quantities.hpp"
+
+namespace principia {
+namespace numerics {
+namespace internal_mapped_polynomial_sequence {
+
+using base::Array;
+using base::not_constructible;
+using geometry::Multivector;
+using geometry::Point;
+using quantities::Quantity;
+
+// The representation of values and arguments as doubles in SI units.
+template<typename T>
+struct FlatRepresentation;
+
+template<>
+struct FlatRepresentation<double> : not_constructible {
+  static constexpr int dimension = 1;
+  static double FromDoubles(double const* coordinates);
+  static double ToDouble(double x);
+};
+
+template<typename Dimensions>
+struct FlatRepresentation<Quantity<Dimensions>> : not_constructible {
+  static constexpr int dimension = 1;
+  static Quantity<Dimensions> FromDoubles(double const* coordinates);
+  static double ToDouble(Quantity<Dimensions> const& quantity);
+};
+
+template<typename Scalar, typename Frame>
+struct FlatRepresentation<Multivector<Scalar, Frame, 1>> : not_constructible {
+  static constexpr int dimension = 3;
+  static Multivector<Scalar, Frame, 1> FromDoubles(double const* coordinates);
+};
+
+template<typename Vector>
+struct FlatRepresentation<Point<Vector>> : not_constructible {
+  static constexpr int dimension = 1;
+  static Point<Vector> FromDoubles(double const* coordinates);
+  static double ToDouble(Point<Vector> const& point);
+};
+
+// A sequence of polynomials in the monomial basis stored in a flat array of
+// doubles that is not owned by this object, e.g., a memory-mapped file.  The
+// polynomials are evaluated in place: they are materialized on the stack when
+// they are visited, which costs a copy of their coefficients but no allocation.
+// Each polynomial is valid over an interval whose upper bound is its |t_max|;
+// the lower bound of the interval is the |t_max| of the previous polynomial, or
+// |t_min| for the first one.  The layout, which is produced by the |Writer|, is
+// as follows, with all fields being 8 bytes long:
+//   number of polynomials n, as an int64;
+//   t_min;
+//   the n t_maxes;
+//   n + 1 offsets into the coefficients, as int64s, in units of doubles;
+//   the coefficients: for each polynomial, the origin (for affine arguments)
+//   followed by the coordinates of the coefficients in increasing degree.
+// All the arguments and coordinates are expressed in SI units.  This class is
+// thread-safe.
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+class MappedPolynomialSequence final {
+  static_assert(0 <= min_degree && min_degree <= max_degree);
+
+ public:
+  template<int degree>
+  using PolynomialOfDegree =
+      PolynomialInMonomialBasis<Value, Argument, degree, Evaluator>;
+
+  // |bytes| must be aligned on 8 bytes and have the layout described above.
+  // They must remain valid as long as |owner| is alive.
+  MappedPolynomialSequence(std::shared_ptr<void const> owner,
+                           Array<std::uint8_t const> bytes);
+
+  bool empty() const;
+  std::int64_t size() const;
+
+  Argument t_min() const;
+  // The |t_max| of the last polynomial, or |t_min()| if this object is empty.
+  Argument t_max() const;
+  Argument t_max(std::int64_t index) const;
+
+  int degree(std::int64_t index) const;
+
+  // Returns the index of the first polynomial whose |t_max| is at or after
+  // |argument|, or |size()| if there is none.  Time complexity is O(log N).
+  std::int64_t LowerBound(Argument const& argument) const;
+
+  // Calls |function| with a const reference to the polynomial at |index|, which
+  // is statically typed, so that |function| should be a generic lambda.
+  // Returns the result of |function|, which must be the same for all the
+  // degrees.
+  template<typename Function>
+  decltype(auto) Visit(std::int64_t index, Function&& function) const;
+
+  // Produces the layout described above.
+  class Writer final {
+   public:
+    explicit Writer(Argument const& t_min);
+
+    // |polynomial| must be in the monomial basis, with a degree in
+    // [min_degree, max_degree].  |t_max| must be after the |t_max| of the
+    // polynomial previously appended.
+    void Append(Argument const& t_max,
+                Polynomial<Value, Argument> const& polynomial);
+
+    std::int64_t size_in_bytes() const;
+    void WriteTo(std::ostream& stream) const;
+
+   private:
+    double const t_min_;
+    std::vector<double> t_maxes_;
+    std::vector<std::int64_t> offsets_;
+    std::vector<double> coefficients_;
+  };
+
+ private:
+  static constexpr bool is_affine = base::is_instance_of_v<Point, Argument>;
+  static constexpr int value_dimension = FlatRepresentation<Value>::dimension;
+
+  // The coefficients of the polynomial at |index|, starting with its origin if
+  // the argument is affine.
+  double const* coefficients(std::int64_t index) const;
+
+  template<int degree_>
+  static PolynomialOfDegree<degree_> MakePolynomial(
+      double const* coefficients);
+
+  template<typename Coefficients, std::size_t... k>
+  static Coefficients MakeCoefficients(double const* coefficients,
+                                       std::index_sequence<k...>);
+
+  // Calls |function| with the polynomial of |actual_degree|, which must be in
+  // [degree_, max_degree], whose coefficients are given.
+  template<int degree_ = min_degree, typename Function>
+  static decltype(auto) VisitDegree(int actual_degree,
+                                    double const* coefficients,
+                                    Function&& function);
+
+  std::shared_ptr<void const> owner_;
+  std::int64_t size_;
+  double t_min_;
+  double const* t_maxes_;
+  std::int64_t const* offsets_;
+  double const* coefficients_;
+};
+
+}  // namespace internal_mapped_polynomial_sequence
+
+using internal_mapped_polynomial_sequence::MappedPolynomialSequence;
+
+}  // namespace numerics
+}  // namespace principia
+
+#include "numerics/mapped_polynomial_sequence_body.hpp"
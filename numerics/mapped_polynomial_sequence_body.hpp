@@ -0,0 +1,360 @@
+#pragma once
+
+#include "numerics/mapped_polynomial_sequence.hpp"
+
+#include <algorithm>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "base/macros.hpp"
+#include "geometry/r3_element.hpp"
+#include "glog/logging.h"
+#include "quantities/si.hpp"
+#include "serialization/geometry.pb.h"
+#include "serialization/numerics.pb.h"
+
+namespace principia {
+namespace numerics {
+namespace internal_mapped_polynomial_sequence {
+
+using geometry::R3Element;
+namespace si = quantities::si;
+
+inline double FlatRepresentation<double>::FromDoubles(
+    double const* const coordinates) {
+  return coordinates[0];
+}
+
+inline double FlatRepresentation<double>::ToDouble(double const x) {
+  return x;
+}
+
+template<typename Dimensions>
+Quantity<Dimensions> FlatRepresentation<Quantity<Dimensions>>::FromDoubles(
+    double const* const coordinates) {
+  return coordinates[0] * si::Unit<Quantity<Dimensions>>;
+}
+
+template<typename Dimensions>
+double FlatRepresentation<Quantity<Dimensions>>::ToDouble(
+    Quantity<Dimensions> const& quantity) {
+  return quantity / si::Unit<Quantity<Dimensions>>;
+}
+
+template<typename Scalar, typename Frame>
+Multivector<Scalar, Frame, 1>
+FlatRepresentation<Multivector<Scalar, Frame, 1>>::FromDoubles(
+    double const* const coordinates) {
+  using Coordinate = FlatRepresentation<Scalar>;
+  return Multivector<Scalar, Frame, 1>(
+      R3Element<Scalar>(Coordinate::FromDoubles(coordinates),
+                        Coordinate::FromDoubles(coordinates + 1),
+                        Coordinate::FromDoubles(coordinates + 2)));
+}
+
+template<typename Vector>
+Point<Vector> FlatRepresentation<Point<Vector>>::FromDoubles(
+    double const* const coordinates) {
+  return Point<Vector>() + FlatRepresentation<Vector>::FromDoubles(coordinates);
+}
+
+template<typename Vector>
+double FlatRepresentation<Point<Vector>>::ToDouble(Point<Vector> const& point) {
+  return FlatRepresentation<Vector>::ToDouble(point - Point<Vector>());
+}
+
+// Appends to |coordinates| the magnitude of the given serialized |coordinate|.
+inline void AppendCoordinate(
+    serialization::R3Element::Coordinate const& coordinate,
+    std::vector<double>& coordinates) {
+  coordinates.push_back(coordinate.has_quantity()
+                            ? coordinate.quantity().magnitude()
+                            : coordinate.double_());
+}
+
+// Appends to |coordinates| the magnitudes of the coordinates of the given
+// serialized |coefficient|.  Returns the number of coordinates appended.
+inline int AppendCoordinates(
+    serialization::PolynomialInMonomialBasis::Coefficient const& coefficient,
+    std::vector<double>& coordinates) {
+  switch (coefficient.message_case()) {
+    case serialization::PolynomialInMonomialBasis::Coefficient::kDouble:
+      coordinates.push_back(coefficient.double_());
+      return 1;
+    case serialization::PolynomialInMonomialBasis::Coefficient::kQuantity:
+      coordinates.push_back(coefficient.quantity().magnitude());
+      return 1;
+    case serialization::PolynomialInMonomialBasis::Coefficient::kMultivector: {
+      auto const& vector = coefficient.multivector().vector();
+      AppendCoordinate(vector.x(), coordinates);
+      AppendCoordinate(vector.y(), coordinates);
+      AppendCoordinate(vector.z(), coordinates);
+      return 3;
+    }
+    default:
+      LOG(FATAL) << "Unexpected coefficient " << coefficient.DebugString();
+      base::noreturn();
+  }
+}
+
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+MappedPolynomialSequence<Value, Argument,
+                         min_degree, max_degree,
+                         Evaluator>::MappedPolynomialSequence(
+    std::shared_ptr<void const> owner,
+    Array<std::uint8_t const> const bytes)
+    : owner_(std::move(owner)) {
+  CHECK_EQ(0, reinterpret_cast<std::uintptr_t>(bytes.data) % sizeof(double));
+  CHECK_LE(2 * sizeof(double), bytes.size);
+  auto const* const fields = reinterpret_cast<double const*>(bytes.data);
+  size_ = *reinterpret_cast<std::int64_t const*>(&fields[0]);
+  t_min_ = fields[1];
+  t_maxes_ = &fields[2];
+  offsets_ = reinterpret_cast<std::int64_t const*>(t_maxes_ + size_);
+  coefficients_ = reinterpret_cast<double const*>(offsets_ + size_ + 1);
+  CHECK_LE(0, size_);
+  CHECK_LE(reinterpret_cast<std::uint8_t const*>(coefficients_),
+           bytes.data + bytes.size);
+  CHECK_EQ(bytes.data + bytes.size,
+           reinterpret_cast<std::uint8_t const*>(coefficients_ +
+                                                 offsets_[size_]));
+}
+
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+bool MappedPolynomialSequence<Value, Argument,
+                              min_degree, max_degree,
+                              Evaluator>::empty() const {
+  return size_ == 0;
+}
+
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+std::int64_t MappedPolynomialSequence<Value, Argument,
+                                      min_degree, max_degree,
+                                      Evaluator>::size() const {
+  return size_;
+}
+
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+Argument MappedPolynomialSequence<Value, Argument,
+                                  min_degree, max_degree,
+                                  Evaluator>::t_min() const {
+  return FlatRepresentation<Argument>::FromDoubles(&t_min_);
+}
+
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+Argument MappedPolynomialSequence<Value, Argument,
+                                  min_degree, max_degree,
+                                  Evaluator>::t_max() const {
+  return empty() ? t_min() : t_max(size_ - 1);
+}
+
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+Argument MappedPolynomialSequence<Value, Argument,
+                                  min_degree, max_degree,
+                                  Evaluator>::t_max(
+    std::int64_t const index) const {
+  DCHECK_LE(0, index);
+  DCHECK_LT(index, size_);
+  return FlatRepresentation<Argument>::FromDoubles(&t_maxes_[index]);
+}
+
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+int MappedPolynomialSequence<Value, Argument,
+                             min_degree, max_degree,
+                             Evaluator>::degree(
+    std::int64_t const index) const {
+  DCHECK_LE(0, index);
+  DCHECK_LT(index, size_);
+  std::int64_t const number_of_coordinates =
+      offsets_[index + 1] - offsets_[index] - (is_affine ? 1 : 0);
+  return number_of_coordinates / value_dimension - 1;
+}
+
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+std::int64_t MappedPolynomialSequence<Value, Argument,
+                                      min_degree, max_degree,
+                                      Evaluator>::LowerBound(
+    Argument const& argument) const {
+  return std::lower_bound(t_maxes_,
+                          t_maxes_ + size_,
+                          FlatRepresentation<Argument>::ToDouble(argument)) -
+         t_maxes_;
+}
+
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+template<typename Function>
+decltype(auto) MappedPolynomialSequence<Value, Argument,
+                                        min_degree, max_degree,
+                                        Evaluator>::Visit(
+    std::int64_t const index,
+    Function&& function) const {
+  return VisitDegree(degree(index),
+                     coefficients(index),
+                     std::forward<Function>(function));
+}
+
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+MappedPolynomialSequence<Value, Argument,
+                         min_degree, max_degree,
+                         Evaluator>::Writer::Writer(Argument const& t_min)
+    : t_min_(FlatRepresentation<Argument>::ToDouble(t_min)),
+      offsets_({0}) {}
+
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+void MappedPolynomialSequence<Value, Argument,
+                              min_degree, max_degree,
+                              Evaluator>::Writer::Append(
+    Argument const& t_max,
+    Polynomial<Value, Argument> const& polynomial) {
+  double const flat_t_max = FlatRepresentation<Argument>::ToDouble(t_max);
+  CHECK_LT(t_maxes_.empty() ? t_min_ : t_maxes_.back(), flat_t_max);
+  int const degree = polynomial.degree();
+  CHECK_LE(min_degree, degree);
+  CHECK_LE(degree, max_degree);
+
+  serialization::Polynomial message;
+  polynomial.WriteToMessage(&message);
+  CHECK(message.HasExtension(
+      serialization::PolynomialInMonomialBasis::extension))
+      << message.DebugString();
+  auto const& extension =
+      message.GetExtension(serialization::PolynomialInMonomialBasis::extension);
+  CHECK_EQ(degree + 1, extension.coefficient_size());
+  CHECK_EQ(is_affine, extension.has_origin());
+  if constexpr (is_affine) {
+    coefficients_.push_back(
+        FlatRepresentation<Argument>::ToDouble(
+            Argument::ReadFromMessage(extension.origin())));
+  }
+  for (auto const& coefficient : extension.coefficient()) {
+    CHECK_EQ(value_dimension, AppendCoordinates(coefficient, coefficients_));
+  }
+  t_maxes_.push_back(flat_t_max);
+  offsets_.push_back(coefficients_.size());
+}
+
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+std::int64_t MappedPolynomialSequence<Value, Argument,
+                                      min_degree, max_degree,
+                                      Evaluator>::Writer::size_in_bytes()
+    const {
+  return sizeof(std::int64_t) + sizeof(double) +
+         t_maxes_.size() * sizeof(double) +
+         offsets_.size() * sizeof(std::int64_t) +
+         coefficients_.size() * sizeof(double);
+}
+
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+void MappedPolynomialSequence<Value, Argument,
+                              min_degree, max_degree,
+                              Evaluator>::Writer::WriteTo(
+    std::ostream& stream) const {
+  std::int64_t const size = t_maxes_.size();
+  stream.write(reinterpret_cast<char const*>(&size), sizeof(size));
+  stream.write(reinterpret_cast<char const*>(&t_min_), sizeof(t_min_));
+  stream.write(reinterpret_cast<char const*>(t_maxes_.data()),
+               t_maxes_.size() * sizeof(double));
+  stream.write(reinterpret_cast<char const*>(offsets_.data()),
+               offsets_.size() * sizeof(std::int64_t));
+  stream.write(reinterpret_cast<char const*>(coefficients_.data()),
+               coefficients_.size() * sizeof(double));
+}
+
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+double const* MappedPolynomialSequence<Value, Argument,
+                                       min_degree, max_degree,
+                                       Evaluator>::coefficients(
+    std::int64_t const index) const {
+  return coefficients_ + offsets_[index];
+}
+
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+template<int degree_>
+auto MappedPolynomialSequence<Value, Argument,
+                              min_degree, max_degree,
+                              Evaluator>::MakePolynomial(
+    double const* const coefficients) -> PolynomialOfDegree<degree_> {
+  using Coefficients = typename PolynomialOfDegree<degree_>::Coefficients;
+  if constexpr (is_affine) {
+    return PolynomialOfDegree<degree_>(
+        MakeCoefficients<Coefficients>(
+            coefficients + 1, std::make_index_sequence<degree_ + 1>()),
+        FlatRepresentation<Argument>::FromDoubles(coefficients));
+  } else {
+    return PolynomialOfDegree<degree_>(MakeCoefficients<Coefficients>(
+        coefficients, std::make_index_sequence<degree_ + 1>()));
+  }
+}
+
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+template<typename Coefficients, std::size_t... k>
+Coefficients MappedPolynomialSequence<Value, Argument,
+                                      min_degree, max_degree,
+                                      Evaluator>::MakeCoefficients(
+    double const* const coefficients,
+    std::index_sequence<k...>) {
+  return Coefficients(
+      FlatRepresentation<std::tuple_element_t<k, Coefficients>>::FromDoubles(
+          coefficients + k * value_dimension)...);
+}
+
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+template<int degree_, typename Function>
+decltype(auto) MappedPolynomialSequence<Value, Argument,
+                                        min_degree, max_degree,
+                                        Evaluator>::VisitDegree(
+    int const actual_degree,
+    double const* const coefficients,
+    Function&& function) {
+  // The compilers turn this chain of comparisons into a jump table.
+  if constexpr (degree_ == max_degree) {
+    DCHECK_EQ(degree_, actual_degree);
+    return function(MakePolynomial<degree_>(coefficients));
+  } else {
+    if (actual_degree == degree_) {
+      return function(MakePolynomial<degree_>(coefficients));
+    }
+    return VisitDegree<degree_ + 1>(actual_degree,
+                                    coefficients,
+                                    std::forward<Function>(function));
+  }
+}
+
+}  // namespace internal_mapped_polynomial_sequence
+}  // namespace numerics
+}  // namespace principia
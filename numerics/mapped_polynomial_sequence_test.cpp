@@ -0,0 +1,163 @@
+#include "numerics/mapped_polynomial_sequence.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "geometry/frame.hpp"
+#include "geometry/grassmann.hpp"
+#include "geometry/named_quantities.hpp"
+#include "gtest/gtest.h"
+#include "numerics/polynomial.hpp"
+#include "numerics/polynomial_evaluators.hpp"
+#include "quantities/elementary_functions.hpp"
+#include "quantities/named_quantities.hpp"
+#include "quantities/quantities.hpp"
+#include "quantities/si.hpp"
+#include "serialization/geometry.pb.h"
+
+namespace principia {
+
+using base::Array;
+using geometry::Displacement;
+using geometry::Frame;
+using geometry::Handedness;
+using geometry::Inertial;
+using geometry::Instant;
+using quantities::Length;
+using quantities::Pow;
+using quantities::Time;
+using quantities::si::Metre;
+using quantities::si::Second;
+
+namespace numerics {
+
+class MappedPolynomialSequenceTest : public ::testing::Test {
+ protected:
+  using World = Frame<serialization::Frame::TestTag,
+                      Inertial,
+                      Handedness::Right,
+                      serialization::Frame::TEST>;
+  using Sequence =
+      MappedPolynomialSequence<Length, Time, 3, 5, EstrinEvaluator>;
+  using AffineSequence = MappedPolynomialSequence<Displacement<World>,
+                                                  Instant,
+                                                  3, 5,
+                                                  EstrinEvaluator>;
+
+  // Returns the polynomial |value + value / s * t + t^degree m / s^degree|.
+  template<int degree>
+  static PolynomialInMonomialBasis<Length, Time, degree, EstrinEvaluator>
+  MakePolynomial(double const value) {
+    using P = PolynomialInMonomialBasis<Length, Time, degree, EstrinEvaluator>;
+    typename P::Coefficients coefficients;
+    std::get<0>(coefficients) = value * Metre;
+    std::get<1>(coefficients) = value * Metre / Second;
+    std::get<degree>(coefficients) += Metre / Pow<degree>(Second);
+    return P(coefficients);
+  }
+
+  // Writes the contents of |writer| to 8-byte aligned storage which is owned
+  // by the resulting sequence.
+  template<typename MappedSequence>
+  static MappedSequence Map(typename MappedSequence::Writer const& writer) {
+    std::ostringstream stream;
+    writer.WriteTo(stream);
+    std::string const bytes = stream.str();
+    EXPECT_EQ(writer.size_in_bytes(), bytes.size());
+    auto const storage = std::make_shared<std::vector<double>>(
+        bytes.size() / sizeof(double));
+    std::memcpy(storage->data(), bytes.data(), bytes.size());
+    return MappedSequence(
+        storage,
+        Array<std::uint8_t const>(
+            reinterpret_cast<std::uint8_t const*>(storage->data()),
+            bytes.size()));
+  }
+
+  static Length Evaluate(Sequence const& sequence,
+                         std::int64_t const index,
+                         Time const& t) {
+    return sequence.Visit(
+        index, [&t](auto const& polynomial) { return polynomial(t); });
+  }
+};
+
+TEST_F(MappedPolynomialSequenceTest, Empty) {
+  Sequence::Writer const writer(3 * Second);
+  Sequence const sequence = Map<Sequence>(writer);
+  EXPECT_TRUE(sequence.empty());
+  EXPECT_EQ(0, sequence.size());
+  EXPECT_EQ(3 * Second, sequence.t_min());
+  EXPECT_EQ(3 * Second, sequence.t_max());
+  EXPECT_EQ(0, sequence.LowerBound(4 * Second));
+}
+
+TEST_F(MappedPolynomialSequenceTest, Scalar) {
+  Sequence::Writer writer(0 * Second);
+  writer.Append(1 * Second, MakePolynomial<4>(1));
+  writer.Append(2 * Second, MakePolynomial<3>(2));
+  writer.Append(4 * Second, MakePolynomial<5>(3));
+  Sequence const sequence = Map<Sequence>(writer);
+
+  EXPECT_FALSE(sequence.empty());
+  EXPECT_EQ(3, sequence.size());
+  EXPECT_EQ(0 * Second, sequence.t_min());
+  EXPECT_EQ(4 * Second, sequence.t_max());
+  EXPECT_EQ(2 * Second, sequence.t_max(1));
+  EXPECT_EQ(4, sequence.degree(0));
+  EXPECT_EQ(3, sequence.degree(1));
+  EXPECT_EQ(5, sequence.degree(2));
+
+  EXPECT_EQ(0, sequence.LowerBound(0.5 * Second));
+  EXPECT_EQ(0, sequence.LowerBound(1 * Second));
+  EXPECT_EQ(1, sequence.LowerBound(1.5 * Second));
+  EXPECT_EQ(2, sequence.LowerBound(4 * Second));
+  EXPECT_EQ(3, sequence.LowerBound(5 * Second));
+
+  Time const t = 2 * Second;
+  EXPECT_EQ(MakePolynomial<4>(1)(t), Evaluate(sequence, 0, t));
+  EXPECT_EQ(MakePolynomial<3>(2)(t), Evaluate(sequence, 1, t));
+  EXPECT_EQ(MakePolynomial<5>(3)(t), Evaluate(sequence, 2, t));
+  EXPECT_EQ(MakePolynomial<5>(3).EvaluateDerivative(t),
+            sequence.Visit(2, [&t](auto const& polynomial) {
+              return polynomial.EvaluateDerivative(t);
+            }));
+}
+
+TEST_F(MappedPolynomialSequenceTest, Affine) {
+  using P = PolynomialInMonomialBasis<Displacement<World>,
+                                      Instant,
+                                      3,
+                                      EstrinEvaluator>;
+  Instant const t0 = Instant() + 1e9 * Second;
+  P const polynomial(
+      {Displacement<World>({1 * Metre, 2 * Metre, 3 * Metre}),
+       Displacement<World>({4 * Metre, 5 * Metre, 6 * Metre}) / Second,
+       Displacement<World>({7 * Metre, 8 * Metre, 9 * Metre}) / Pow<2>(Second),
+       Displacement<World>({1 * Metre, 1 * Metre, 1 * Metre}) /
+           Pow<3>(Second)},
+      t0 + 5 * Second);
+
+  AffineSequence::Writer writer(t0);
+  writer.Append(t0 + 10 * Second, polynomial);
+  AffineSequence const sequence = Map<AffineSequence>(writer);
+
+  EXPECT_EQ(1, sequence.size());
+  EXPECT_EQ(t0, sequence.t_min());
+  EXPECT_EQ(t0 + 10 * Second, sequence.t_max());
+  EXPECT_EQ(3, sequence.degree(0));
+  for (Instant t = t0; t <= t0 + 10 * Second; t += 1 * Second) {
+    EXPECT_EQ(polynomial(t),
+              sequence.Visit(0, [&t](auto const& polynomial) {
+                return polynomial(t);
+              }));
+  }
+}
+
+}  // namespace numerics
+}  // namespace principia
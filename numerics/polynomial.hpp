@@ -94,7 +94,7 @@ class Polynomial {
 
 template<typename Value_, typename Argument_, int degree_,
          template<typename, typename, int> typename Evaluator>
-class PolynomialInMonomialBasis : public Polynomial<Value_, Argument_> {
+class PolynomialInMonomialBasis final : public Polynomial<Value_, Argument_> {
  public:
   using Argument = Argument_;
   using Value = Value_;
@@ -220,7 +220,7 @@ class PolynomialInMonomialBasis : public Polynomial<Value_, Argument_> {
 template<typename Value_, typename Argument_, int degree_,
          template<typename, typename, int> typename Evaluator>
 class PolynomialInMonomialBasis<Value_, Point<Argument_>, degree_, Evaluator>
-    : public Polynomial<Value_, Point<Argument_>> {
+    final : public Polynomial<Value_, Point<Argument_>> {
  public:
   using Argument = Argument_;
   using Value = Value_;
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "base/not_null.hpp"
+#include "numerics/polynomial.hpp"
+
+namespace principia {
+namespace numerics {
+namespace internal_polynomial_sequence {
+
+using base::not_null;
+
+// A sequence of polynomials, stored so as to avoid one heap allocation and one
+// virtual call per polynomial.  The polynomials in the monomial basis that use
+// |Evaluator| and have a degree in [min_degree, max_degree] are stored by value
+// in contiguous per-degree vectors, and evaluation dispatches on the degree to
+// statically-typed code.  Other polynomials are owned through pointers to
+// their base class and evaluated by virtual calls; this is mostly useful for
+// testing.
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+class PolynomialSequence final {
+  static_assert(0 <= min_degree && min_degree <= max_degree);
+
+ public:
+  using AnyPolynomial = Polynomial<Value, Argument>;
+  template<int degree>
+  using PolynomialOfDegree =
+      PolynomialInMonomialBasis<Value, Argument, degree, Evaluator>;
+
+  PolynomialSequence() = default;
+  PolynomialSequence(PolynomialSequence&&) = default;
+  PolynomialSequence& operator=(PolynomialSequence&&) = default;
+
+  bool empty() const;
+  std::int64_t size() const;
+
+  // Appends the given |polynomial| at the end of this sequence.  If it is
+  // stored by value, it is copied and the pointer is freed.
+  void Append(not_null<std::unique_ptr<AnyPolynomial>> polynomial);
+
+  // Appends at the end of this sequence the polynomial returned by
+  // |factory(std::integral_constant<int, degree>())|, which must be a
+  // |PolynomialOfDegree<degree>|.  |degree| must be in [min_degree,
+  // max_degree].  The polynomial is stored by value without going through the
+  // heap.
+  template<typename Factory>
+  void Append(int degree, Factory&& factory);
+
+  // Removes the last polynomial of this sequence, which must not be empty.
+  void RemoveLast();
+
+  // Appends all the polynomials of |suffix| at the end of this sequence.
+  // |suffix| is left empty.  This operation is in O(suffix.size()).
+  void Concatenate(PolynomialSequence&& suffix);
+
+  // Calls |function| with a const reference to the polynomial at |index|.  The
+  // argument is statically typed if the polynomial is stored by value, so that
+  // |function| should be a generic lambda.  Returns the result of |function|,
+  // which must be the same for all the types of polynomials.
+  template<typename Function>
+  decltype(auto) Visit(std::int64_t index, Function&& function) const;
+
+ private:
+  // The location of a polynomial in this object.
+  struct Location {
+    // If |degree| is in [min_degree, max_degree], the polynomial is at
+    // |index| in the vector of |monomial_polynomials_| for that degree.
+    // Otherwise |degree| is -1 and the polynomial is at |index| in
+    // |other_polynomials_|.
+    std::int32_t degree;
+    std::int32_t index;
+  };
+
+  template<typename Degrees>
+  struct MonomialPolynomialsGenerator;
+  template<int... degrees>
+  struct MonomialPolynomialsGenerator<std::integer_sequence<int, degrees...>> {
+    using Type =
+        std::tuple<std::vector<PolynomialOfDegree<min_degree + degrees>>...>;
+  };
+  using MonomialPolynomials = typename MonomialPolynomialsGenerator<
+      std::make_integer_sequence<int, max_degree - min_degree + 1>>::Type;
+
+  // Calls |function| with a reference to the vector of |monomial_polynomials|
+  // for |actual_degree|, which must be in [min_degree, max_degree].
+  // |MonomialPolynomialsType| is deduced to be either |MonomialPolynomials| or
+  // |MonomialPolynomials const|.
+  template<int degree = min_degree,
+           typename MonomialPolynomialsType,
+           typename Function>
+  static decltype(auto) VisitVector(
+      MonomialPolynomialsType& monomial_polynomials,
+      int actual_degree,
+      Function&& function);
+
+  // Appends |factory(std::integral_constant<int, actual_degree>())| to the
+  // vector of |monomial_polynomials_| for |actual_degree|, which must be in
+  // [min_degree, max_degree].
+  template<int degree = min_degree, typename Factory>
+  void AppendMonomialPolynomial(int actual_degree, Factory&& factory);
+
+  // Appends the vectors at |indices| in the |monomial_polynomials_| of
+  // |suffix| to the corresponding vectors of this object.  Returns the sizes
+  // that the vectors of this object had before the operation.
+  template<int... indices>
+  std::array<std::int32_t, max_degree - min_degree + 1> ConcatenateVectors(
+      std::integer_sequence<int, indices...>,
+      PolynomialSequence& suffix);
+
+  // Same as above for a single vector.
+  template<int index>
+  std::int32_t ConcatenateVector(PolynomialSequence& suffix);
+
+  MonomialPolynomials monomial_polynomials_;
+  std::vector<not_null<std::unique_ptr<AnyPolynomial>>> other_polynomials_;
+  std::vector<Location> locations_;
+};
+
+}  // namespace internal_polynomial_sequence
+
+using internal_polynomial_sequence::PolynomialSequence;
+
+}  // namespace numerics
+}  // namespace principia
+
+#include "numerics/polynomial_sequence_body.hpp"
@@ -0,0 +1,239 @@
+#pragma once
+
+#include "numerics/polynomial_sequence.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include "glog/logging.h"
+
+namespace principia {
+namespace numerics {
+namespace internal_polynomial_sequence {
+
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+bool PolynomialSequence<Value, Argument,
+                        min_degree, max_degree,
+                        Evaluator>::empty() const {
+  return locations_.empty();
+}
+
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+std::int64_t PolynomialSequence<Value, Argument,
+                                min_degree, max_degree,
+                                Evaluator>::size() const {
+  return locations_.size();
+}
+
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+void PolynomialSequence<Value, Argument,
+                        min_degree, max_degree,
+                        Evaluator>::Append(
+    not_null<std::unique_ptr<AnyPolynomial>> polynomial) {
+  int const degree = polynomial->degree();
+  if (min_degree <= degree && degree <= max_degree) {
+    bool const appended = VisitVector(
+        monomial_polynomials_,
+        degree,
+        [this, degree, &polynomial](auto& polynomials) {
+          using MonomialPolynomial =
+              typename std::remove_reference_t<decltype(polynomials)>::
+                  value_type;
+          auto const* const monomial_polynomial =
+              dynamic_cast<MonomialPolynomial const*>(&*polynomial);
+          if (monomial_polynomial == nullptr) {
+            return false;
+          }
+          locations_.push_back(
+              {degree, static_cast<std::int32_t>(polynomials.size())});
+          polynomials.push_back(*monomial_polynomial);
+          return true;
+        });
+    if (appended) {
+      return;
+    }
+  }
+  locations_.push_back(
+      {-1, static_cast<std::int32_t>(other_polynomials_.size())});
+  other_polynomials_.push_back(std::move(polynomial));
+}
+
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+template<typename Factory>
+void PolynomialSequence<Value, Argument,
+                        min_degree, max_degree,
+                        Evaluator>::Append(int const degree,
+                                           Factory&& factory) {
+  CHECK_LE(min_degree, degree);
+  CHECK_LE(degree, max_degree);
+  AppendMonomialPolynomial(degree, std::forward<Factory>(factory));
+}
+
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+void PolynomialSequence<Value, Argument,
+                        min_degree, max_degree,
+                        Evaluator>::RemoveLast() {
+  CHECK(!locations_.empty());
+  Location const& last = locations_.back();
+  // The last polynomial of the sequence is necessarily the last one of the
+  // vector where it is stored.
+  if (last.degree == -1) {
+    DCHECK_EQ(last.index + 1,
+              static_cast<std::int32_t>(other_polynomials_.size()));
+    other_polynomials_.pop_back();
+  } else {
+    VisitVector(monomial_polynomials_,
+                last.degree,
+                [&last](auto& polynomials) {
+                  DCHECK_EQ(last.index + 1,
+                            static_cast<std::int32_t>(polynomials.size()));
+                  polynomials.pop_back();
+                });
+  }
+  locations_.pop_back();
+}
+
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+void PolynomialSequence<Value, Argument,
+                        min_degree, max_degree,
+                        Evaluator>::Concatenate(PolynomialSequence&& suffix) {
+  auto const offsets = ConcatenateVectors(
+      std::make_integer_sequence<int, max_degree - min_degree + 1>(), suffix);
+  auto const other_offset =
+      static_cast<std::int32_t>(other_polynomials_.size());
+  std::move(suffix.other_polynomials_.begin(),
+            suffix.other_polynomials_.end(),
+            std::back_inserter(other_polynomials_));
+
+  locations_.reserve(locations_.size() + suffix.locations_.size());
+  for (auto const& location : suffix.locations_) {
+    if (location.degree == -1) {
+      locations_.push_back({-1, location.index + other_offset});
+    } else {
+      locations_.push_back(
+          {location.degree,
+           location.index + offsets[location.degree - min_degree]});
+    }
+  }
+  suffix = PolynomialSequence();
+}
+
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+template<typename Function>
+decltype(auto) PolynomialSequence<Value, Argument,
+                                  min_degree, max_degree,
+                                  Evaluator>::Visit(
+    std::int64_t const index,
+    Function&& function) const {
+  Location const& location = locations_[index];
+  if (location.degree == -1) {
+    return function(
+        static_cast<AnyPolynomial const&>(*other_polynomials_[location.index]));
+  }
+  return VisitVector(
+      monomial_polynomials_,
+      location.degree,
+      [&function, &location](auto const& polynomials) -> decltype(auto) {
+        return function(polynomials[location.index]);
+      });
+}
+
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+template<int degree, typename MonomialPolynomialsType, typename Function>
+decltype(auto) PolynomialSequence<Value, Argument,
+                                  min_degree, max_degree,
+                                  Evaluator>::VisitVector(
+    MonomialPolynomialsType& monomial_polynomials,
+    int const actual_degree,
+    Function&& function) {
+  // The compilers turn this chain of comparisons into a jump table.
+  if constexpr (degree == max_degree) {
+    DCHECK_EQ(degree, actual_degree);
+    return function(std::get<degree - min_degree>(monomial_polynomials));
+  } else {
+    if (actual_degree == degree) {
+      return function(std::get<degree - min_degree>(monomial_polynomials));
+    }
+    return VisitVector<degree + 1>(monomial_polynomials,
+                                   actual_degree,
+                                   std::forward<Function>(function));
+  }
+}
+
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+template<int degree, typename Factory>
+void PolynomialSequence<Value, Argument,
+                        min_degree, max_degree,
+                        Evaluator>::AppendMonomialPolynomial(
+    int const actual_degree,
+    Factory&& factory) {
+  // Same structure as |VisitVector|, but the degree must be a constant
+  // expression to be passed to |factory|.
+  if constexpr (degree < max_degree) {
+    if (actual_degree != degree) {
+      AppendMonomialPolynomial<degree + 1>(actual_degree,
+                                           std::forward<Factory>(factory));
+      return;
+    }
+  }
+  DCHECK_EQ(degree, actual_degree);
+  auto& polynomials = std::get<degree - min_degree>(monomial_polynomials_);
+  locations_.push_back(
+      {degree, static_cast<std::int32_t>(polynomials.size())});
+  polynomials.push_back(factory(std::integral_constant<int, degree>()));
+}
+
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+template<int... indices>
+std::array<std::int32_t, max_degree - min_degree + 1>
+PolynomialSequence<Value, Argument,
+                   min_degree, max_degree,
+                   Evaluator>::ConcatenateVectors(
+    std::integer_sequence<int, indices...>,
+    PolynomialSequence& suffix) {
+  // The elements of a braced-init-list are evaluated in order.
+  return {ConcatenateVector<indices>(suffix)...};
+}
+
+template<typename Value, typename Argument,
+         int min_degree, int max_degree,
+         template<typename, typename, int> typename Evaluator>
+template<int index>
+std::int32_t PolynomialSequence<Value, Argument,
+                                min_degree, max_degree,
+                                Evaluator>::ConcatenateVector(
+    PolynomialSequence& suffix) {
+  auto& polynomials = std::get<index>(monomial_polynomials_);
+  auto& suffix_polynomials = std::get<index>(suffix.monomial_polynomials_);
+  auto const offset = static_cast<std::int32_t>(polynomials.size());
+  polynomials.insert(polynomials.end(),
+                     std::make_move_iterator(suffix_polynomials.begin()),
+                     std::make_move_iterator(suffix_polynomials.end()));
+  return offset;
+}
+
+}  // namespace internal_polynomial_sequence
+}  // namespace numerics
+}  // namespace principia
@@ -0,0 +1,150 @@
+#include "numerics/polynomial_sequence.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <utility>
+
+#include "base/not_null.hpp"
+#include "gtest/gtest.h"
+#include "numerics/polynomial.hpp"
+#include "numerics/polynomial_evaluators.hpp"
+#include "quantities/named_quantities.hpp"
+#include "quantities/quantities.hpp"
+#include "quantities/si.hpp"
+
+namespace principia {
+
+using base::not_null;
+using quantities::Length;
+using quantities::Speed;
+using quantities::Time;
+using quantities::si::Metre;
+using quantities::si::Second;
+
+namespace numerics {
+
+class PolynomialSequenceTest : public ::testing::Test {
+ protected:
+  using Sequence =
+      PolynomialSequence<Length, Time, 3, 5, EstrinEvaluator>;
+
+  // Returns the polynomial |value + value / s * t| of the given degree, with
+  // the given evaluator.
+  template<int degree, template<typename, typename, int> typename Evaluator>
+  static not_null<std::unique_ptr<Polynomial<Length, Time>>> MakePolynomial(
+      double const value) {
+    using P = PolynomialInMonomialBasis<Length, Time, degree, Evaluator>;
+    typename P::Coefficients coefficients;
+    std::get<0>(coefficients) = value * Metre;
+    std::get<1>(coefficients) = value * Metre / Second;
+    return std::make_unique<P>(coefficients);
+  }
+
+  static Length Evaluate(Sequence const& sequence,
+                         std::int64_t const index,
+                         Time const& t) {
+    return sequence.Visit(
+        index, [&t](auto const& polynomial) { return polynomial(t); });
+  }
+
+  static int Degree(Sequence const& sequence, std::int64_t const index) {
+    return sequence.Visit(
+        index, [](auto const& polynomial) { return polynomial.degree(); });
+  }
+
+  // Appends polynomials of all the degrees, some of which are not stored by
+  // value, with values |first|, |first + 1|, etc.
+  static void AppendPolynomials(double const first, Sequence& sequence) {
+    sequence.Append(MakePolynomial<4, EstrinEvaluator>(first));
+    sequence.Append(MakePolynomial<2, EstrinEvaluator>(first + 1));
+    sequence.Append(MakePolynomial<3, EstrinEvaluator>(first + 2));
+    sequence.Append(MakePolynomial<4, HornerEvaluator>(first + 3));
+    sequence.Append(MakePolynomial<5, EstrinEvaluator>(first + 4));
+    sequence.Append(MakePolynomial<4, EstrinEvaluator>(first + 5));
+  }
+};
+
+TEST_F(PolynomialSequenceTest, Append) {
+  Sequence sequence;
+  EXPECT_TRUE(sequence.empty());
+  AppendPolynomials(/*first=*/1, sequence);
+  EXPECT_FALSE(sequence.empty());
+  EXPECT_EQ(6, sequence.size());
+
+  Time const t = 2 * Second;
+  for (int i = 0; i < sequence.size(); ++i) {
+    EXPECT_EQ(3 * (i + 1) * Metre, Evaluate(sequence, i, t)) << i;
+  }
+  EXPECT_EQ(4, Degree(sequence, 0));
+  EXPECT_EQ(2, Degree(sequence, 1));
+  EXPECT_EQ(3, Degree(sequence, 2));
+  EXPECT_EQ(4, Degree(sequence, 3));
+  EXPECT_EQ(5, Degree(sequence, 4));
+  EXPECT_EQ(4, Degree(sequence, 5));
+  EXPECT_EQ(
+      5 * Metre / Second,
+      sequence.Visit(4, [&t](auto const& polynomial) {
+        return polynomial.EvaluateDerivative(t);
+      }));
+}
+
+TEST_F(PolynomialSequenceTest, AppendOfDegree) {
+  Sequence sequence;
+  AppendPolynomials(/*first=*/1, sequence);
+  for (int degree = 3; degree <= 5; ++degree) {
+    sequence.Append(degree, [degree](auto const static_degree) {
+      EXPECT_EQ(degree, static_degree());
+      using P = Sequence::PolynomialOfDegree<static_degree()>;
+      typename P::Coefficients coefficients;
+      std::get<0>(coefficients) = degree * Metre;
+      std::get<1>(coefficients) = degree * Metre / Second;
+      return P(coefficients);
+    });
+  }
+  EXPECT_EQ(9, sequence.size());
+  for (int i = 6; i < 9; ++i) {
+    EXPECT_EQ(i - 3, Degree(sequence, i));
+    EXPECT_EQ(3 * (i - 3) * Metre, Evaluate(sequence, i, 2 * Second)) << i;
+  }
+  sequence.RemoveLast();
+  EXPECT_EQ(4, Degree(sequence, 7));
+  EXPECT_EQ(6 * Metre, Evaluate(sequence, 5, 2 * Second));
+}
+
+TEST_F(PolynomialSequenceTest, RemoveLast) {
+  Sequence sequence;
+  AppendPolynomials(/*first=*/1, sequence);
+  sequence.RemoveLast();
+  sequence.RemoveLast();
+  EXPECT_EQ(4, sequence.size());
+  sequence.Append(MakePolynomial<3, EstrinEvaluator>(10));
+  EXPECT_EQ(5, sequence.size());
+  EXPECT_EQ(3, Degree(sequence, 4));
+  EXPECT_EQ(30 * Metre, Evaluate(sequence, 4, 2 * Second));
+  EXPECT_EQ(12 * Metre, Evaluate(sequence, 3, 2 * Second));
+  for (int i = 0; i < 5; ++i) {
+    sequence.RemoveLast();
+  }
+  EXPECT_TRUE(sequence.empty());
+}
+
+TEST_F(PolynomialSequenceTest, Concatenate) {
+  Sequence prefix;
+  Sequence suffix;
+  AppendPolynomials(/*first=*/1, prefix);
+  AppendPolynomials(/*first=*/7, suffix);
+  prefix.Concatenate(std::move(suffix));
+  EXPECT_TRUE(suffix.empty());
+  EXPECT_EQ(12, prefix.size());
+
+  Time const t = 2 * Second;
+  for (int i = 0; i < prefix.size(); ++i) {
+    EXPECT_EQ(3 * (i + 1) * Metre, Evaluate(prefix, i, t)) << i;
+  }
+  EXPECT_EQ(4, Degree(prefix, 9));
+  EXPECT_EQ(5, Degree(prefix, 10));
+}
+
+}  // namespace numerics
+}  // namespace principia
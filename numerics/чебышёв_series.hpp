@@ -65,6 +65,10 @@ class ЧебышёвSeries final {
   // code.
   int degree() const;
 
+  // Returns the coefficient of Tᵢ, for 0 ≤ i ≤ degree.  Since |Tᵢ| ≤ 1 on
+  // [t_min, t_max], the norms of the coefficients bound the series there.
+  Vector coefficient(int i) const;
+
   // Uses the Clenshaw algorithm.  |t| must be in the range [t_min, t_max].
   Vector Evaluate(Instant const& t) const;
   Variation<Vector> EvaluateDerivative(Instant const& t) const;
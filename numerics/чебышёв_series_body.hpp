@@ -206,6 +206,13 @@ int ЧебышёвSeries<Vector>::degree() const {
   return helper_.degree();
 }
 
+template<typename Vector>
+Vector ЧебышёвSeries<Vector>::coefficient(int const i) const {
+  CHECK_LE(0, i);
+  CHECK_LE(i, helper_.degree());
+  return helper_.coefficients(i);
+}
+
 template<typename Vector>
 Vector ЧебышёвSeries<Vector>::Evaluate(Instant const& t) const {
   // This formula ensures continuity at the edges by producing -1 or +1 within
@@ -1,11 +1,18 @@
 #pragma once
 
 #include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
 
 #include "base/constant_function.hpp"
+#include "base/not_null.hpp"
 #include "base/status.hpp"
+#include "geometry/named_quantities.hpp"
+#include "physics/degrees_of_freedom.hpp"
 #include "physics/discrete_trajectory.hpp"
 #include "physics/trajectory.hpp"
+#include "quantities/quantities.hpp"
 
 namespace principia {
 namespace physics {
@@ -13,8 +20,11 @@ namespace internal_apsides {
 
 using base::ConstantFunction;
 using base::Identically;
+using base::not_null;
 using base::Status;
+using geometry::Instant;
 using geometry::Vector;
+using quantities::Length;
 
 // Computes the apsides with respect to |reference| for the discrete trajectory
 // segment given by |begin| and |end|.  Appends to the given trajectories one
@@ -27,6 +37,41 @@ void ComputeApsides(Trajectory<Frame> const& reference,
                     DiscreteTrajectory<Frame>& apoapsides,
                     DiscreteTrajectory<Frame>& periapsides);
 
+// Maintains the apsides with respect to |reference| of a discrete trajectory
+// that grows over time.  Each call to |Update| only processes the points that
+// were appended since the previous call, and yields the same apsides as
+// |ComputeApsides| on the entire segment.
+template<typename Frame>
+class ApsisDetector {
+ public:
+  explicit ApsisDetector(not_null<Trajectory<Frame> const*> reference);
+
+  // Brings the apsides up to date with the discrete trajectory segment given
+  // by |begin| and |end|, which must be the end of the trajectory.  The
+  // apsides before |begin| are forgotten.  If the last point processed by the
+  // previous call is not in the segment, with the same degrees of freedom,
+  // and was not forgotten by |ForgetAfter|, the apsides are recomputed from
+  // scratch.
+  void Update(typename DiscreteTrajectory<Frame>::Iterator begin,
+              typename DiscreteTrajectory<Frame>::Iterator end);
+
+  // Must be called when the trajectory forgets its points after |time|.
+  void ForgetAfter(Instant const& time);
+
+  DiscreteTrajectory<Frame> const& apoapsides() const;
+  DiscreteTrajectory<Frame> const& periapsides() const;
+
+ private:
+  not_null<Trajectory<Frame> const*> const reference_;
+  // The time of the last point processed by |Update|, and its degrees of
+  // freedom.  After a call to |ForgetAfter| this may be an earlier time, in
+  // which case |last_degrees_of_freedom_| is not set.
+  std::optional<Instant> last_time_;
+  std::optional<DegreesOfFreedom<Frame>> last_degrees_of_freedom_;
+  not_null<std::unique_ptr<DiscreteTrajectory<Frame>>> apoapsides_;
+  not_null<std::unique_ptr<DiscreteTrajectory<Frame>>> periapsides_;
+};
+
 // Computes the crossings of the discrete trajectory segment given by |begin|
 // and |end| with the xy plane.  Appends the crossings that go towards the
 // |north| side of the xy plane to |ascending|, and those that go away from the
@@ -41,6 +86,24 @@ Status ComputeNodes(typename DiscreteTrajectory<Frame>::Iterator begin,
                     DiscreteTrajectory<Frame>& descending,
                     Predicate predicate = Identically(true));
 
+// Computes the closest approaches of the discrete trajectory segment given by
+// |begin| and |end| to each of the |targets|, i.e., the local minima of the
+// distance to the target.  Appends to |closest_approaches[i]| the closest
+// approaches to |targets[i]| at a distance of at most |max_distance|, until it
+// has |max_points| points.  The relative positions are approximated by
+// piecewise Чебышёв series; the segment is evaluated once per piece for all
+// the targets, and a piece is skipped without root finding if its series show
+// that it stays farther than |max_distance| from the target.
+template<typename Frame>
+void ComputeClosestApproaches(
+    std::vector<not_null<Trajectory<Frame> const*>> const& targets,
+    typename DiscreteTrajectory<Frame>::Iterator begin,
+    typename DiscreteTrajectory<Frame>::Iterator end,
+    Length const& max_distance,
+    int max_points,
+    std::vector<not_null<DiscreteTrajectory<Frame>*>> const&
+        closest_approaches);
+
 // TODO(egg): when we can usefully iterate over an arbitrary |Trajectory|, move
 // the following from |Ephemeris|.
 #if 0
@@ -55,7 +118,9 @@ void ComputeApsides(Trajectory<Frame> const& trajectory1,
 
 }  // namespace internal_apsides
 
+using internal_apsides::ApsisDetector;
 using internal_apsides::ComputeApsides;
+using internal_apsides::ComputeClosestApproaches;
 using internal_apsides::ComputeNodes;
 
 }  // namespace physics
@@ -3,30 +3,114 @@
 
 #include "physics/apsides.hpp"
 
+#include <algorithm>
 #include <optional>
+#include <utility>
 #include <vector>
 
 #include "base/array.hpp"
 #include "base/jthread.hpp"
+#include "numerics/newhall.hpp"
 #include "numerics/root_finders.hpp"
+#include "numerics/чебышёв_series.hpp"
 
 namespace principia {
 namespace physics {
 namespace internal_apsides {
 
 using base::BoundedArray;
+using base::make_not_null_unique;
 using geometry::Barycentre;
+using geometry::Displacement;
 using geometry::Instant;
 using geometry::Position;
 using geometry::Sign;
+using geometry::Velocity;
 using numerics::Bisect;
+using numerics::Brent;
 using numerics::Hermite3;
+using numerics::NewhallApproximationInЧебышёвBasis;
+using numerics::ЧебышёвSeries;
+using quantities::Infinity;
 using quantities::IsFinite;
 using quantities::Length;
 using quantities::Speed;
 using quantities::Square;
+using quantities::Time;
 using quantities::Variation;
 
+// The number of steps of the discrete trajectory covered by a piece of
+// |ComputeClosestApproaches|, and the degree of the Чебышёв series fitted on
+// each piece.  The Newhall approximation requires 9 equally-spaced samples.
+constexpr int closest_approach_piece_steps = 8;
+constexpr int closest_approach_degree = 10;
+constexpr int closest_approach_samples = 9;
+// A piece that contains a closest approach is split if the error estimate of
+// its series exceeds this fraction of the distance at the closest sample.
+constexpr double closest_approach_relative_tolerance = 1e-6;
+
+// The squared distance between a point of a trajectory and a reference
+// trajectory, and its time derivative.
+struct SquaredDistance {
+  Square<Length> value;
+  Variation<Square<Length>> derivative;
+};
+
+template<typename Frame>
+SquaredDistance SquaredDistanceTo(
+    Trajectory<Frame> const& reference,
+    Instant const& time,
+    DegreesOfFreedom<Frame> const& degrees_of_freedom) {
+  DegreesOfFreedom<Frame> const body_degrees_of_freedom =
+      reference.EvaluateDegreesOfFreedom(time);
+  RelativeDegreesOfFreedom<Frame> const relative =
+      degrees_of_freedom - body_degrees_of_freedom;
+  return {relative.displacement().Norm²(),
+          2.0 * InnerProduct(relative.displacement(), relative.velocity())};
+}
+
+// Returns the time of the apsis between two consecutive points of a trajectory
+// at |time1| and |time2| where the derivatives of the squared distance have
+// opposite signs, or nothing if that time cannot be determined.
+inline std::optional<Instant> ApsisTime(Instant const& time1,
+                                        SquaredDistance const& distance1,
+                                        Instant const& time2,
+                                        SquaredDistance const& distance2) {
+  // Construct a Hermite approximation of the squared distance and find its
+  // extrema.
+  Hermite3<Instant, Square<Length>> const squared_distance_approximation(
+      {time1, time2},
+      {distance1.value, distance2.value},
+      {distance1.derivative, distance2.derivative});
+  BoundedArray<Instant, 2> const extrema =
+      squared_distance_approximation.FindExtrema();
+
+  // Now look at the extrema and check that exactly one is in the required time
+  // interval.  This is normally the case, but it can fail due to
+  // ill-conditioning.
+  Instant apsis_time;
+  int valid_extrema = 0;
+  for (auto const& extremum : extrema) {
+    if (extremum >= time1 && extremum <= time2) {
+      apsis_time = extremum;
+      ++valid_extrema;
+    }
+  }
+  if (valid_extrema != 1) {
+    // Something went wrong when finding the extrema of
+    // |squared_distance_approximation|. Use a linear interpolation of the
+    // derivative instead.
+    apsis_time = Barycentre<Instant, Variation<Square<Length>>>(
+        {time2, time1}, {distance1.derivative, -distance2.derivative});
+  }
+
+  // This can happen for instance if the square distance is stationary.
+  if (!IsFinite(apsis_time - Instant{})) {
+    return std::nullopt;
+  }
+  return apsis_time;
+}
+
 template<typename Frame>
 void ComputeApsides(Trajectory<Frame> const& reference,
                     typename DiscreteTrajectory<Frame>::Iterator const begin,
@@ -35,10 +119,7 @@ void ComputeApsides(Trajectory<Frame> const& reference,
                     DiscreteTrajectory<Frame>& apoapsides,
                     DiscreteTrajectory<Frame>& periapsides) {
   std::optional<Instant> previous_time;
-  std::optional<DegreesOfFreedom<Frame>> previous_degrees_of_freedom;
-  std::optional<Square<Length>> previous_squared_distance;
-  std::optional<Variation<Square<Length>>>
-      previous_squared_distance_derivative;
+  std::optional<SquaredDistance> previous_squared_distance;
 
   Instant const t_min = reference.t_min();
   Instant const t_max = reference.t_max();
@@ -50,57 +131,17 @@ void ComputeApsides(Trajectory<Frame> const& reference,
     if (time > t_max) {
       break;
     }
-    DegreesOfFreedom<Frame> const body_degrees_of_freedom =
-        reference.EvaluateDegreesOfFreedom(time);
-    RelativeDegreesOfFreedom<Frame> const relative =
-        degrees_of_freedom - body_degrees_of_freedom;
-    Square<Length> const squared_distance = relative.displacement().Norm²();
-    // This is the derivative of |squared_distance|.
-    Variation<Square<Length>> const squared_distance_derivative =
-        2.0 * InnerProduct(relative.displacement(), relative.velocity());
-
-    if (previous_squared_distance_derivative &&
-        Sign(squared_distance_derivative) !=
-            Sign(*previous_squared_distance_derivative)) {
-      CHECK(previous_time &&
-            previous_degrees_of_freedom &&
-            previous_squared_distance);
-
-      // The derivative of |squared_distance| changed sign.  Construct a Hermite
-      // approximation of |squared_distance| and find its extrema.
-      Hermite3<Instant, Square<Length>> const
-          squared_distance_approximation(
-              {*previous_time, time},
-              {*previous_squared_distance, squared_distance},
-              {*previous_squared_distance_derivative,
-               squared_distance_derivative});
-      BoundedArray<Instant, 2> const extrema =
-          squared_distance_approximation.FindExtrema();
-
-      // Now look at the extrema and check that exactly one is in the required
-      // time interval.  This is normally the case, but it can fail due to
-      // ill-conditioning.
-      Instant apsis_time;
-      int valid_extrema = 0;
-      for (auto const& extremum : extrema) {
-        if (extremum >= *previous_time && extremum <= time) {
-          apsis_time = extremum;
-          ++valid_extrema;
-        }
-      }
-      if (valid_extrema != 1) {
-        // Something went wrong when finding the extrema of
-        // |squared_distance_approximation|. Use a linear interpolation of
-        // |squared_distance_derivative| instead.
-        apsis_time = Barycentre<Instant, Variation<Square<Length>>>(
-            {time, *previous_time},
-            {*previous_squared_distance_derivative,
-             -squared_distance_derivative});
-      }
+    SquaredDistance const squared_distance =
+        SquaredDistanceTo(reference, time, degrees_of_freedom);
 
-      // This can happen for instance if the square distance is stationary.
-      // Safer to give up.
-      if (!IsFinite(apsis_time - Instant{})) {
+    if (previous_squared_distance &&
+        Sign(squared_distance.derivative) !=
+            Sign(previous_squared_distance->derivative)) {
+      CHECK(previous_time);
+      std::optional<Instant> const apsis_time = ApsisTime(
+          *previous_time, *previous_squared_distance, time, squared_distance);
+      // Safer to give up if the time of the apsis cannot be determined.
+      if (!apsis_time.has_value()) {
         break;
       }
 
@@ -112,11 +153,11 @@ void ComputeApsides(Trajectory<Frame> const& reference,
       // 3rd-degree polynomial would yield |squared_distance_approximation|, so
       // we shouldn't be far from the truth.
       DegreesOfFreedom<Frame> const apsis_degrees_of_freedom =
-          begin.trajectory()->EvaluateDegreesOfFreedom(apsis_time);
-      if (Sign(squared_distance_derivative).is_negative()) {
-        apoapsides.Append(apsis_time, apsis_degrees_of_freedom);
+          begin.trajectory()->EvaluateDegreesOfFreedom(*apsis_time);
+      if (Sign(squared_distance.derivative).is_negative()) {
+        apoapsides.Append(*apsis_time, apsis_degrees_of_freedom);
       } else {
-        periapsides.Append(apsis_time, apsis_degrees_of_freedom);
+        periapsides.Append(*apsis_time, apsis_degrees_of_freedom);
       }
       if (apoapsides.Size() >= max_points && periapsides.Size() >= max_points) {
         break;
@@ -124,12 +165,122 @@ void ComputeApsides(Trajectory<Frame> const& reference,
     }
 
     previous_time = time;
-    previous_degrees_of_freedom = degrees_of_freedom;
     previous_squared_distance = squared_distance;
-    previous_squared_distance_derivative = squared_distance_derivative;
   }
 }
 
+template<typename Frame>
+ApsisDetector<Frame>::ApsisDetector(
+    not_null<Trajectory<Frame> const*> const reference)
+    : reference_(reference),
+      apoapsides_(make_not_null_unique<DiscreteTrajectory<Frame>>()),
+      periapsides_(make_not_null_unique<DiscreteTrajectory<Frame>>()) {}
+
+template<typename Frame>
+void ApsisDetector<Frame>::Update(
+    typename DiscreteTrajectory<Frame>::Iterator const begin,
+    typename DiscreteTrajectory<Frame>::Iterator const end) {
+  // Find the point after which the processing resumes, if any.
+  std::optional<typename DiscreteTrajectory<Frame>::Iterator> resume;
+  if (begin != end && last_time_.has_value() && *last_time_ >= begin->time) {
+    auto it = begin.trajectory()->LowerBound(*last_time_);
+    if (last_degrees_of_freedom_.has_value()) {
+      if (it != end && it->time == *last_time_ &&
+          it->degrees_of_freedom == *last_degrees_of_freedom_) {
+        resume = it;
+      }
+    } else if (it != end && it->time == *last_time_) {
+      resume = it;
+    } else if (it != begin) {
+      // The points after |*last_time_| were forgotten, resume from the last
+      // one before.
+      resume = --it;
+    }
+  }
+
+  Instant const t_min = reference_->t_min();
+  Instant const t_max = reference_->t_max();
+  std::optional<Instant> previous_time;
+  std::optional<SquaredDistance> previous_squared_distance;
+  auto it = begin;
+  if (resume.has_value()) {
+    // The apsides after the resumption point depend on points that were
+    // forgotten.
+    it = *resume;
+    auto const& [time, degrees_of_freedom] = *it;
+    apoapsides_->ForgetAfter(time);
+    periapsides_->ForgetAfter(time);
+    apoapsides_->ForgetBefore(begin->time);
+    periapsides_->ForgetBefore(begin->time);
+    if (time >= t_min && time <= t_max) {
+      previous_time = time;
+      previous_squared_distance =
+          SquaredDistanceTo(*reference_, time, degrees_of_freedom);
+    }
+    last_time_ = time;
+    last_degrees_of_freedom_ = degrees_of_freedom;
+    ++it;
+  } else {
+    apoapsides_ = make_not_null_unique<DiscreteTrajectory<Frame>>();
+    periapsides_ = make_not_null_unique<DiscreteTrajectory<Frame>>();
+    last_time_.reset();
+    last_degrees_of_freedom_.reset();
+  }
+
+  // Same as |ComputeApsides|, but remembers the last point processed.
+  for (; it != end; ++it) {
+    auto const& [time, degrees_of_freedom] = *it;
+    if (time < t_min) {
+      continue;
+    }
+    if (time > t_max) {
+      break;
+    }
+    SquaredDistance const squared_distance =
+        SquaredDistanceTo(*reference_, time, degrees_of_freedom);
+
+    if (previous_squared_distance &&
+        Sign(squared_distance.derivative) !=
+            Sign(previous_squared_distance->derivative)) {
+      std::optional<Instant> const apsis_time = ApsisTime(
+          *previous_time, *previous_squared_distance, time, squared_distance);
+      if (!apsis_time.has_value()) {
+        break;
+      }
+      DegreesOfFreedom<Frame> const apsis_degrees_of_freedom =
+          begin.trajectory()->EvaluateDegreesOfFreedom(*apsis_time);
+      if (Sign(squared_distance.derivative).is_negative()) {
+        apoapsides_->Append(*apsis_time, apsis_degrees_of_freedom);
+      } else {
+        periapsides_->Append(*apsis_time, apsis_degrees_of_freedom);
+      }
+    }
+
+    previous_time = time;
+    previous_squared_distance = squared_distance;
+    last_time_ = time;
+    last_degrees_of_freedom_ = degrees_of_freedom;
+  }
+}
+
+template<typename Frame>
+void ApsisDetector<Frame>::ForgetAfter(Instant const& time) {
+  if (last_time_.has_value() && *last_time_ > time) {
+    last_time_ = time;
+    last_degrees_of_freedom_.reset();
+  }
+}
+
+template<typename Frame>
+DiscreteTrajectory<Frame> const& ApsisDetector<Frame>::apoapsides() const {
+  return *apoapsides_;
+}
+
+template<typename Frame>
+DiscreteTrajectory<Frame> const& ApsisDetector<Frame>::periapsides() const {
+  return *periapsides_;
+}
+
 template<typename Frame, typename Predicate>
 Status ComputeNodes(typename DiscreteTrajectory<Frame>::Iterator begin,
                   typename DiscreteTrajectory<Frame>::Iterator end,
@@ -208,6 +359,255 @@ Status ComputeNodes(typename DiscreteTrajectory<Frame>::Iterator begin,
   return Status::OK;
 }
 
+// Returns the times of the samples used to fit a Чебышёв series on
+// [t_min, t_max].
+inline std::vector<Instant> ClosestApproachSampleTimes(Instant const& t_min,
+                                                       Instant const& t_max) {
+  std::vector<Instant> times;
+  times.reserve(closest_approach_samples);
+  Time const step = (t_max - t_min) / (closest_approach_samples - 1);
+  for (int i = 0; i < closest_approach_samples - 1; ++i) {
+    times.push_back(t_min + i * step);
+  }
+  // Make sure that consecutive pieces join exactly.
+  times.push_back(t_max);
+  return times;
+}
+
+template<typename Frame>
+std::vector<DegreesOfFreedom<Frame>> ClosestApproachSamples(
+    DiscreteTrajectory<Frame> const& trajectory,
+    Instant const& t_min,
+    Instant const& t_max) {
+  std::vector<DegreesOfFreedom<Frame>> samples;
+  samples.reserve(closest_approach_samples);
+  for (Instant const& t : ClosestApproachSampleTimes(t_min, t_max)) {
+    samples.push_back(trajectory.EvaluateDegreesOfFreedom(t));
+  }
+  return samples;
+}
+
+// Appends to |closest_approaches| the closest approaches of |trajectory| to
+// |target| between |t_min| and |t_max|, given the |samples| of |trajectory|
+// on that interval.  |previous_derivative| is the derivative of the squared
+// distance at |t_min| computed on the preceding piece, if any; on return, it
+// is the derivative at |t_max|, if it was computed.
+template<typename Frame>
+void ComputeClosestApproachesInPiece(
+    DiscreteTrajectory<Frame> const& trajectory,
+    Trajectory<Frame> const& target,
+    Instant const& t_min,
+    Instant const& t_max,
+    std::vector<DegreesOfFreedom<Frame>> const& samples,
+    Length const& max_distance,
+    int const max_points,
+    std::optional<Variation<Square<Length>>>& previous_derivative,
+    DiscreteTrajectory<Frame>& closest_approaches) {
+  std::vector<Displacement<Frame>> q;
+  std::vector<Velocity<Frame>> v;
+  q.reserve(closest_approach_samples);
+  v.reserve(closest_approach_samples);
+  Length closest_sample_distance = Infinity<Length>;
+  std::vector<Instant> const times = ClosestApproachSampleTimes(t_min, t_max);
+  for (int i = 0; i < closest_approach_samples; ++i) {
+    RelativeDegreesOfFreedom<Frame> const relative =
+        samples[i] - target.EvaluateDegreesOfFreedom(times[i]);
+    q.push_back(relative.displacement());
+    v.push_back(relative.velocity());
+    closest_sample_distance =
+        std::min(closest_sample_distance, relative.displacement().Norm());
+  }
+  Displacement<Frame> error_estimate;
+  ЧебышёвSeries<Displacement<Frame>> const relative_position =
+      NewhallApproximationInЧебышёвBasis(
+          closest_approach_degree, q, v, t_min, t_max, error_estimate);
+  Length const error = error_estimate.Norm();
+
+  // Since |Tᵢ| ≤ 1 on the piece, the distance is at least |c₀| - Σ|cᵢ| there,
+  // up to the error of the approximation.
+  Length distance_lower_bound =
+      relative_position.coefficient(0).Norm() - error;
+  for (int i = 1; i <= closest_approach_degree; ++i) {
+    distance_lower_bound -= relative_position.coefficient(i).Norm();
+  }
+  if (distance_lower_bound > max_distance) {
+    // Neither this piece nor its junction with the next one can contain a
+    // closest approach of interest.
+    previous_derivative.reset();
+    return;
+  }
+
+  auto const squared_distance_derivative =
+      [&relative_position](Instant const& t) -> Variation<Square<Length>> {
+    return 2.0 * InnerProduct(relative_position.Evaluate(t),
+                              relative_position.EvaluateDerivative(t));
+  };
+
+  // The derivative is a polynomial of degree 2 * closest_approach_degree - 1,
+  // so we look for changes of sign on a grid that fine, which separates its
+  // roots in all but pathological cases.  The minima are where it goes from
+  // negative to nonnegative.
+  int const subdivisions = 2 * closest_approach_degree;
+  Time const subdivision = (t_max - t_min) / subdivisions;
+  std::vector<Instant> grid_times;
+  std::vector<Variation<Square<Length>>> grid_derivatives;
+  for (int i = 0; i <= subdivisions; ++i) {
+    Instant const t = i == subdivisions ? t_max : t_min + i * subdivision;
+    grid_times.push_back(t);
+    grid_derivatives.push_back(squared_distance_derivative(t));
+  }
+  Variation<Square<Length>> const zero{};
+  bool const minimum_at_t_min = previous_derivative.has_value() &&
+                                *previous_derivative < zero &&
+                                grid_derivatives.front() >= zero;
+  bool has_minimum = minimum_at_t_min;
+  for (int i = 0; i < subdivisions; ++i) {
+    has_minimum |= grid_derivatives[i] < zero &&
+                   grid_derivatives[i + 1] >= zero;
+  }
+
+  // If the approximation is not accurate enough for locating the closest
+  // approaches, split the piece unless it lies within a single step of
+  // |trajectory|, in which case there is nothing more to gain.
+  if (has_minimum &&
+      error > closest_approach_relative_tolerance * closest_sample_distance) {
+    auto it = trajectory.LowerBound(t_min);
+    if (it != trajectory.end() && it->time == t_min) {
+      ++it;
+    }
+    if (it != trajectory.end() && it->time < t_max) {
+      Instant const t_mid = Barycentre<Instant, double>({t_min, t_max},
+                                                        {1, 1});
+      for (auto const& [t1, t2] : {std::pair{t_min, t_mid},
+                                   std::pair{t_mid, t_max}}) {
+        ComputeClosestApproachesInPiece(
+            trajectory,
+            target,
+            t1,
+            t2,
+            ClosestApproachSamples(trajectory, t1, t2),
+            max_distance,
+            max_points,
+            previous_derivative,
+            closest_approaches);
+      }
+      return;
+    }
+  }
+
+  auto const append = [&closest_approaches,
+                       max_distance,
+                       max_points,
+                       &relative_position,
+                       &trajectory](Instant const& time) {
+    if (closest_approaches.Size() < max_points &&
+        relative_position.Evaluate(time).Norm() <= max_distance &&
+        (closest_approaches.Empty() ||
+         time > closest_approaches.back().time)) {
+      closest_approaches.Append(time,
+                                trajectory.EvaluateDegreesOfFreedom(time));
+    }
+  };
+  if (minimum_at_t_min) {
+    append(t_min);
+  }
+  for (int i = 0; i < subdivisions; ++i) {
+    if (grid_derivatives[i] < zero && grid_derivatives[i + 1] >= zero) {
+      append(Brent(squared_distance_derivative,
+                   grid_times[i],
+                   grid_times[i + 1]));
+    }
+  }
+  previous_derivative = grid_derivatives.back();
+}
+
+template<typename Frame>
+void ComputeClosestApproaches(
+    std::vector<not_null<Trajectory<Frame> const*>> const& targets,
+    typename DiscreteTrajectory<Frame>::Iterator const begin,
+    typename DiscreteTrajectory<Frame>::Iterator const end,
+    Length const& max_distance,
+    int const max_points,
+    std::vector<not_null<DiscreteTrajectory<Frame>*>> const&
+        closest_approaches) {
+  CHECK_EQ(targets.size(), closest_approaches.size());
+  if (begin == end) {
+    return;
+  }
+  DiscreteTrajectory<Frame> const& trajectory = *begin.trajectory();
+  auto last = end;
+  --last;
+
+  // For each target, the derivative of the squared distance at the end of the
+  // previous piece, used to detect closest approaches at the junctions.
+  std::vector<std::optional<Variation<Square<Length>>>> previous_derivatives(
+      targets.size());
+  for (auto piece_begin = begin; piece_begin != last;) {
+    auto piece_end = piece_begin;
+    for (int i = 0; i < closest_approach_piece_steps && piece_end != last;
+         ++i) {
+      ++piece_end;
+    }
+    Instant const t_min = piece_begin->time;
+    Instant const t_max = piece_end->time;
+
+    // The samples of |trajectory| over the piece are shared by all the
+    // targets whose trajectories cover it.
+    std::optional<std::vector<DegreesOfFreedom<Frame>>> samples;
+    bool done = true;
+    for (int i = 0; i < targets.size(); ++i) {
+      Trajectory<Frame> const& target = *targets[i];
+      DiscreteTrajectory<Frame>& target_closest_approaches =
+          *closest_approaches[i];
+      std::optional<Variation<Square<Length>>>& previous_derivative =
+          previous_derivatives[i];
+      if (target_closest_approaches.Size() >= max_points) {
+        continue;
+      }
+      done = false;
+
+      // Only consider the part of the piece where |target| is defined.
+      Instant const target_t_min = std::max(t_min, target.t_min());
+      Instant const target_t_max = std::min(t_max, target.t_max());
+      if (target_t_min != t_min) {
+        previous_derivative.reset();
+      }
+      if (target_t_min >= target_t_max) {
+        continue;
+      }
+      if (target_t_min == t_min && target_t_max == t_max) {
+        if (!samples.has_value()) {
+          samples = ClosestApproachSamples(trajectory, t_min, t_max);
+        }
+        ComputeClosestApproachesInPiece(trajectory,
+                                        target,
+                                        t_min,
+                                        t_max,
+                                        *samples,
+                                        max_distance,
+                                        max_points,
+                                        previous_derivative,
+                                        target_closest_approaches);
+      } else {
+        ComputeClosestApproachesInPiece(
+            trajectory,
+            target,
+            target_t_min,
+            target_t_max,
+            ClosestApproachSamples(trajectory, target_t_min, target_t_max),
+            max_distance,
+            max_points,
+            previous_derivative,
+            target_closest_approaches);
+      }
+    }
+    if (done) {
+      break;
+    }
+    piece_begin = piece_end;
+  }
+}
+
 }  // namespace internal_apsides
 }  // namespace physics
 }  // namespace principia
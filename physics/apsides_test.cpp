@@ -4,6 +4,7 @@
 #include <limits>
 #include <map>
 #include <optional>
+#include <utility>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -15,6 +16,7 @@
 #include "physics/kepler_orbit.hpp"
 #include "quantities/astronomy.hpp"
 #include "testing_utilities/almost_equals.hpp"
+#include "testing_utilities/numerics.hpp"
 
 namespace principia {
 namespace physics {
@@ -31,6 +33,7 @@ using integrators::SymmetricLinearMultistepIntegrator;
 using integrators::methods::DormandالمكاوىPrince1986RKN434FM;
 using integrators::methods::QuinlanTremaine1990Order12;
 using quantities::GravitationalParameter;
+using quantities::Infinity;
 using quantities::Pow;
 using quantities::Sin;
 using quantities::Speed;
@@ -46,8 +49,11 @@ using quantities::si::Minute;
 using quantities::si::Metre;
 using quantities::si::Radian;
 using quantities::si::Second;
+using testing_utilities::AbsoluteError;
 using testing_utilities::AlmostEquals;
+using testing_utilities::RelativeError;
 using ::testing::Eq;
+using ::testing::Lt;
 
 class ApsidesTest : public ::testing::Test {
  protected:
@@ -150,6 +156,200 @@ TEST_F(ApsidesTest, ComputeApsidesDiscreteTrajectory) {
   }
 }
 
+TEST_F(ApsidesTest, ApsisDetector) {
+  Instant const t0;
+  GravitationalParameter const μ = SolarGravitationalParameter;
+  auto const b = new MassiveBody(μ);
+
+  std::vector<not_null<std::unique_ptr<MassiveBody const>>> bodies;
+  std::vector<DegreesOfFreedom<World>> initial_state;
+  bodies.emplace_back(std::unique_ptr<MassiveBody const>(b));
+  initial_state.emplace_back(World::origin, World::unmoving);
+
+  Ephemeris<World> ephemeris(
+      std::move(bodies),
+      initial_state,
+      t0,
+      /*accuracy_parameters=*/{/*fitting_tolerance=*/1 * Metre,
+                               /*geopotential_tolerance=*/0x1p-24},
+      Ephemeris<World>::FixedStepParameters(
+          SymmetricLinearMultistepIntegrator<QuinlanTremaine1990Order12,
+                                             Position<World>>(),
+          10 * Minute));
+
+  Displacement<World> r(
+      {1 * AstronomicalUnit, 2 * AstronomicalUnit, 3 * AstronomicalUnit});
+  Velocity<World> v({4 * Kilo(Metre) / Second,
+                     5 * Kilo(Metre) / Second,
+                     6 * Kilo(Metre) / Second});
+
+  DiscreteTrajectory<World> trajectory;
+  trajectory.Append(t0, DegreesOfFreedom<World>(World::origin + r, v));
+  auto const flow = [&ephemeris, &trajectory](Instant const& t) {
+    ephemeris.FlowWithAdaptiveStep(
+        &trajectory,
+        Ephemeris<World>::NoIntrinsicAcceleration,
+        t,
+        Ephemeris<World>::AdaptiveStepParameters(
+            EmbeddedExplicitRungeKuttaNyströmIntegrator<
+                DormandالمكاوىPrince1986RKN434FM,
+                Position<World>>(),
+            std::numeric_limits<std::int64_t>::max(),
+            1e-3 * Metre,
+            1e-3 * Metre / Second),
+        Ephemeris<World>::unlimited_max_ephemeris_steps);
+  };
+
+  // The incremental apsides must be exactly those of the entire trajectory.
+  ApsisDetector<World> detector(ephemeris.trajectory(b));
+  auto const expect_same_apsides = [&b, &detector, &ephemeris, &trajectory]() {
+    DiscreteTrajectory<World> apoapsides;
+    DiscreteTrajectory<World> periapsides;
+    ComputeApsides(*ephemeris.trajectory(b),
+                   trajectory.begin(),
+                   trajectory.end(),
+                   /*max_points=*/std::numeric_limits<int>::max(),
+                   apoapsides,
+                   periapsides);
+    detector.Update(trajectory.begin(), trajectory.end());
+    for (auto const& [expected, actual] :
+         {std::pair{&apoapsides, &detector.apoapsides()},
+          std::pair{&periapsides, &detector.periapsides()}}) {
+      ASSERT_EQ(expected->Size(), actual->Size());
+      for (auto it1 = expected->begin(), it2 = actual->begin();
+           it1 != expected->end();
+           ++it1, ++it2) {
+        EXPECT_THAT(it2->time, Eq(it1->time));
+        EXPECT_THAT(it2->degrees_of_freedom, Eq(it1->degrees_of_freedom));
+      }
+    }
+  };
+
+  for (int year = 1; year <= 10; ++year) {
+    flow(t0 + year * JulianYear);
+    expect_same_apsides();
+  }
+  EXPECT_EQ(6, detector.apoapsides().Size() + detector.periapsides().Size());
+
+  // Forget the second half of the trajectory and integrate it again.  The new
+  // points need not be the same as the forgotten ones.
+  trajectory.ForgetAfter(t0 + 5.5 * JulianYear);
+  detector.ForgetAfter(t0 + 5.5 * JulianYear);
+  expect_same_apsides();
+  flow(t0 + 10 * JulianYear);
+  expect_same_apsides();
+  EXPECT_EQ(6, detector.apoapsides().Size() + detector.periapsides().Size());
+}
+
+TEST_F(ApsidesTest, ComputeClosestApproaches) {
+  Instant const t0;
+  GravitationalParameter const μ = SolarGravitationalParameter;
+  auto const b = new MassiveBody(μ);
+
+  std::vector<not_null<std::unique_ptr<MassiveBody const>>> bodies;
+  std::vector<DegreesOfFreedom<World>> initial_state;
+  bodies.emplace_back(std::unique_ptr<MassiveBody const>(b));
+  initial_state.emplace_back(World::origin, World::unmoving);
+
+  Ephemeris<World> ephemeris(
+      std::move(bodies),
+      initial_state,
+      t0,
+      /*accuracy_parameters=*/{/*fitting_tolerance=*/1 * Metre,
+                               /*geopotential_tolerance=*/0x1p-24},
+      Ephemeris<World>::FixedStepParameters(
+          SymmetricLinearMultistepIntegrator<QuinlanTremaine1990Order12,
+                                             Position<World>>(),
+          10 * Minute));
+
+  Displacement<World> r(
+      {1 * AstronomicalUnit, 2 * AstronomicalUnit, 3 * AstronomicalUnit});
+  Velocity<World> v({4 * Kilo(Metre) / Second,
+                     5 * Kilo(Metre) / Second,
+                     6 * Kilo(Metre) / Second});
+
+  DiscreteTrajectory<World> trajectory;
+  trajectory.Append(t0, DegreesOfFreedom<World>(World::origin + r, v));
+
+  ephemeris.FlowWithAdaptiveStep(
+      &trajectory,
+      Ephemeris<World>::NoIntrinsicAcceleration,
+      t0 + 10 * JulianYear,
+      Ephemeris<World>::AdaptiveStepParameters(
+          EmbeddedExplicitRungeKuttaNyströmIntegrator<
+              DormandالمكاوىPrince1986RKN434FM,
+              Position<World>>(),
+          std::numeric_limits<std::int64_t>::max(),
+          1e-3 * Metre,
+          1e-3 * Metre / Second),
+      Ephemeris<World>::unlimited_max_ephemeris_steps);
+
+  DiscreteTrajectory<World> apoapsides;
+  DiscreteTrajectory<World> periapsides;
+  ComputeApsides(*ephemeris.trajectory(b),
+                 trajectory.begin(),
+                 trajectory.end(),
+                 /*max_points=*/std::numeric_limits<int>::max(),
+                 apoapsides,
+                 periapsides);
+  Length const periapsis_distance =
+      (periapsides.front().degrees_of_freedom.position() - World::origin)
+          .Norm();
+
+  // The closest approaches to the Sun are the periapsides.  Computing them for
+  // two targets at once yields the same points for both.
+  DiscreteTrajectory<World> closest_approaches1;
+  DiscreteTrajectory<World> closest_approaches2;
+  ComputeClosestApproaches<World>(
+      {ephemeris.trajectory(b), ephemeris.trajectory(b)},
+      trajectory.begin(),
+      trajectory.end(),
+      /*max_distance=*/Infinity<Length>,
+      /*max_points=*/std::numeric_limits<int>::max(),
+      {&closest_approaches1, &closest_approaches2});
+  ASSERT_EQ(3, periapsides.Size());
+  ASSERT_EQ(periapsides.Size(), closest_approaches1.Size());
+  ASSERT_EQ(periapsides.Size(), closest_approaches2.Size());
+  for (auto it1 = periapsides.begin(),
+            it2 = closest_approaches1.begin(),
+            it3 = closest_approaches2.begin();
+       it1 != periapsides.end();
+       ++it1, ++it2, ++it3) {
+    EXPECT_THAT(AbsoluteError(it1->time, it2->time), Lt(1 * Minute));
+    EXPECT_THAT(
+        RelativeError(
+            (it1->degrees_of_freedom.position() - World::origin).Norm(),
+            (it2->degrees_of_freedom.position() - World::origin).Norm()),
+        Lt(1e-12));
+    EXPECT_THAT(it3->time, Eq(it2->time));
+    EXPECT_THAT(it3->degrees_of_freedom, Eq(it2->degrees_of_freedom));
+  }
+
+  // Only the closest approaches within |max_distance| are returned, and at
+  // most |max_points| of them.
+  DiscreteTrajectory<World> far_closest_approaches;
+  DiscreteTrajectory<World> limited_closest_approaches;
+  ComputeClosestApproaches<World>(
+      {ephemeris.trajectory(b)},
+      trajectory.begin(),
+      trajectory.end(),
+      /*max_distance=*/0.5 * periapsis_distance,
+      /*max_points=*/std::numeric_limits<int>::max(),
+      {&far_closest_approaches});
+  EXPECT_TRUE(far_closest_approaches.Empty());
+  ComputeClosestApproaches<World>({ephemeris.trajectory(b)},
+                                  trajectory.begin(),
+                                  trajectory.end(),
+                                  /*max_distance=*/2 * periapsis_distance,
+                                  /*max_points=*/2,
+                                  {&limited_closest_approaches});
+  ASSERT_EQ(2, limited_closest_approaches.Size());
+  auto second_closest_approach = closest_approaches1.begin();
+  ++second_closest_approach;
+  EXPECT_THAT(limited_closest_approaches.back().time,
+              Eq(second_closest_approach->time));
+}
+
 TEST_F(ApsidesTest, ComputeNodes) {
   Instant const t0;
   GravitationalParameter const μ = SolarGravitationalParameter;
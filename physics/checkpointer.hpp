@@ -53,6 +53,10 @@ class Checkpointer {
   // ever created.
   Instant oldest_checkpoint() const EXCLUDES(lock_);
 
+  // Returns the newest checkpoint in this object, or -∞ if no checkpoint was
+  // ever created.
+  Instant newest_checkpoint() const EXCLUDES(lock_);
+
   // Creates a checkpoint at time |t|, which will be used to recreate the
   // timeline after |t|.  The checkpoint is constructed by calling the |Writer|
   // passed at construction.
@@ -70,12 +74,27 @@ class Checkpointer {
   // checkpoint or if the |Reader| returns one.
   Status ReadFromOldestCheckpoint() const EXCLUDES(lock_);
 
+  // Same as above, but using the newest checkpoint.
+  Status ReadFromNewestCheckpoint() const EXCLUDES(lock_);
+
+  // Calls |reader| on the checkpoint at time |t|.  Returns an error if this
+  // object contains no checkpoint at |t| or if |reader| returns one.
+  Status ReadFromCheckpointAt(Instant const& t, Reader const& reader) const
+      EXCLUDES(lock_);
+
   // Calls |reader| on each of the checkpoints in this object, going backwards
   // from the most recent to the oldest.  Returns an error if |reader| returns
   // one.
   Status ReadFromAllCheckpointsBackwards(Reader const& reader) const
       EXCLUDES(lock_);
 
+  // Adds the checkpoints of |message| whose times are not already present in
+  // this object.  The client is responsible for ensuring that they describe
+  // the same timeline as the existing checkpoints.
+  void AddCheckpointsFromMessage(
+      google::protobuf::RepeatedPtrField<typename Message::Checkpoint> const&
+          message) EXCLUDES(lock_);
+
   void WriteToMessage(not_null<google::protobuf::RepeatedPtrField<
                           typename Message::Checkpoint>*> message) const
       EXCLUDES(lock_);
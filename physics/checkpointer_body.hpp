@@ -12,6 +12,7 @@ namespace physics {
 namespace internal_checkpointer {
 
 using astronomy::InfiniteFuture;
+using astronomy::InfinitePast;
 using base::Error;
 
 template<typename Message>
@@ -28,6 +29,15 @@ Instant Checkpointer<Message>::oldest_checkpoint() const {
   return checkpoints_.cbegin()->first;
 }
 
+template<typename Message>
+Instant Checkpointer<Message>::newest_checkpoint() const {
+  absl::ReaderMutexLock l(&lock_);
+  if (checkpoints_.empty()) {
+    return InfinitePast;
+  }
+  return checkpoints_.crbegin()->first;
+}
+
 template<typename Message>
 void Checkpointer<Message>::WriteToCheckpoint(Instant const& t) {
   absl::MutexLock l(&lock_);
@@ -60,6 +70,34 @@ Status Checkpointer<Message>::ReadFromOldestCheckpoint() const {
   return reader_(*checkpoint);
 }
 
+template<typename Message>
+Status Checkpointer<Message>::ReadFromNewestCheckpoint() const {
+  typename Message::Checkpoint const* checkpoint = nullptr;
+  {
+    absl::ReaderMutexLock l(&lock_);
+    if (checkpoints_.empty()) {
+      return Status(Error::NOT_FOUND, "No checkpoint");
+    }
+    checkpoint = &checkpoints_.crbegin()->second;
+  }
+  return reader_(*checkpoint);
+}
+
+template<typename Message>
+Status Checkpointer<Message>::ReadFromCheckpointAt(Instant const& t,
+                                                   Reader const& reader) const {
+  typename Message::Checkpoint const* checkpoint = nullptr;
+  {
+    absl::ReaderMutexLock l(&lock_);
+    auto const it = checkpoints_.find(t);
+    if (it == checkpoints_.cend()) {
+      return Status(Error::NOT_FOUND, "No checkpoint at " + DebugString(t));
+    }
+    checkpoint = &it->second;
+  }
+  return reader(*checkpoint);
+}
+
 template<typename Message>
 Status Checkpointer<Message>::ReadFromAllCheckpointsBackwards(
     Reader const& reader) const {
@@ -78,6 +116,17 @@ Status Checkpointer<Message>::ReadFromAllCheckpointsBackwards(
   return Status::OK;
 }
 
+template<typename Message>
+void Checkpointer<Message>::AddCheckpointsFromMessage(
+    google::protobuf::RepeatedPtrField<typename Message::Checkpoint> const&
+        message) {
+  absl::MutexLock l(&lock_);
+  for (auto const& checkpoint : message) {
+    Instant const time = Instant::ReadFromMessage(checkpoint.time());
+    checkpoints_.emplace(time, checkpoint);
+  }
+}
+
 template<typename Message>
 void Checkpointer<Message>::WriteToMessage(
     not_null<google::protobuf::RepeatedPtrField<typename Message::Checkpoint>*>
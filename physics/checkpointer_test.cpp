@@ -1,5 +1,6 @@
 #include "physics/checkpointer.hpp"
 
+#include "astronomy/epoch.hpp"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "testing_utilities/matchers.hpp"
@@ -7,6 +8,7 @@
 namespace principia {
 namespace physics {
 
+using astronomy::InfinitePast;
 using base::Error;
 using base::not_null;
 using base::Status;
@@ -96,6 +98,43 @@ TEST_F(CheckpointerTest, ReadFromOldestCheckpoint) {
   EXPECT_OK(checkpointer_.ReadFromOldestCheckpoint());
 }
 
+TEST_F(CheckpointerTest, ReadFromNewestCheckpoint) {
+  EXPECT_EQ(InfinitePast, checkpointer_.newest_checkpoint());
+  EXPECT_THAT(checkpointer_.ReadFromNewestCheckpoint(),
+              StatusIs(Error::NOT_FOUND));
+
+  Instant const t1 = Instant() + 10 * Second;
+  EXPECT_CALL(writer_, Call(_)).WillOnce(SetPayload(1));
+  checkpointer_.WriteToCheckpoint(t1);
+
+  Instant const t2 = t1 + 11 * Second;
+  EXPECT_CALL(writer_, Call(_)).WillOnce(SetPayload(2));
+  checkpointer_.WriteToCheckpoint(t2);
+  EXPECT_EQ(t2, checkpointer_.newest_checkpoint());
+
+  EXPECT_CALL(reader_, Call(Field(&Message::Checkpoint::payload, 2)));
+  EXPECT_OK(checkpointer_.ReadFromNewestCheckpoint());
+}
+
+TEST_F(CheckpointerTest, ReadFromCheckpointAt) {
+  Instant const t1 = Instant() + 10 * Second;
+  EXPECT_CALL(writer_, Call(_)).WillOnce(SetPayload(1));
+  checkpointer_.WriteToCheckpoint(t1);
+
+  Instant const t2 = t1 + 11 * Second;
+  EXPECT_CALL(writer_, Call(_)).WillOnce(SetPayload(2));
+  checkpointer_.WriteToCheckpoint(t2);
+
+  MockFunction<Status(Message::Checkpoint const&)> reader;
+  EXPECT_CALL(reader, Call(Field(&Message::Checkpoint::payload, 1)));
+  EXPECT_OK(checkpointer_.ReadFromCheckpointAt(t1, reader.AsStdFunction()));
+  EXPECT_CALL(reader, Call(_)).Times(0);
+  EXPECT_THAT(
+      checkpointer_.ReadFromCheckpointAt(t1 + 1 * Second,
+                                         reader.AsStdFunction()),
+      StatusIs(Error::NOT_FOUND));
+}
+
 TEST_F(CheckpointerTest, ReadFromAllCheckpointsBackwards) {
   Instant const t1 = Instant() + 10 * Second;
   EXPECT_CALL(writer_, Call(_)).WillOnce(SetPayload(1));
@@ -149,5 +188,30 @@ TEST_F(CheckpointerTest, Serialization) {
   EXPECT_EQ(Instant() + 10 * Second, checkpointer->oldest_checkpoint());
 }
 
+TEST_F(CheckpointerTest, AddCheckpointsFromMessage) {
+  Instant const t1 = Instant() + 10 * Second;
+  EXPECT_CALL(writer_, Call(_)).WillOnce(SetPayload(1));
+  checkpointer_.WriteToCheckpoint(t1);
+
+  Message m;
+  for (int i = 0; i < 3; ++i) {
+    auto* const checkpoint = m.checkpoint.Add();
+    (t1 + (i - 1) * 10 * Second).WriteToMessage(checkpoint->mutable_time());
+    checkpoint->payload = 10 + i;
+  }
+  checkpointer_.AddCheckpointsFromMessage(m.checkpoint);
+  EXPECT_EQ(Instant(), checkpointer_.oldest_checkpoint());
+
+  // The existing checkpoint is not overwritten.
+  {
+    InSequence s;
+    EXPECT_CALL(reader_, Call(Field(&Message::Checkpoint::payload, 12)));
+    EXPECT_CALL(reader_, Call(Field(&Message::Checkpoint::payload, 1)));
+    EXPECT_CALL(reader_, Call(Field(&Message::Checkpoint::payload, 10)));
+  }
+  EXPECT_OK(
+      checkpointer_.ReadFromAllCheckpointsBackwards(reader_.AsStdFunction()));
+}
+
 }  // namespace physics
 }  // namespace principia
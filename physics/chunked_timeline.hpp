@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "geometry/named_quantities.hpp"
+
+namespace principia {
+namespace physics {
+namespace internal_chunked_timeline {
+
+using geometry::Instant;
+
+// A timeline, i.e., a sequence of |Value|s associated with strictly increasing
+// |Instant|s, which may be used as a replacement for an
+// |std::map<Instant, Value>| when insertions and deletions only happen at the
+// ends.  The elements are stored in contiguous chunks of fixed capacity, which
+// avoids one allocation per element and makes iteration and lookups cache-
+// friendly.
+// Iterators are random-access and remain valid (and keep designating the same
+// element) when elements are inserted or removed at either end of the
+// timeline, except for iterators to the removed elements.  In addition, an
+// |end()| iterator always remains an |end()| iterator.  Removing elements from
+// the middle of the timeline invalidates the iterators to the elements that
+// follow the removed ones.
+template<typename Value>
+class ChunkedTimeline final {
+ public:
+  using value_type = std::pair<Instant, Value>;
+
+  class const_iterator final {
+   public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = typename ChunkedTimeline::value_type;
+    using difference_type = std::int64_t;
+    using pointer = value_type const*;
+    using reference = value_type const&;
+
+    // A singular iterator, only useful as a placeholder.
+    const_iterator() = default;
+
+    reference operator*() const;
+    pointer operator->() const;
+    reference operator[](difference_type n) const;
+
+    const_iterator& operator++();
+    const_iterator& operator--();
+    const_iterator operator++(int);
+    const_iterator operator--(int);
+    const_iterator& operator+=(difference_type n);
+    const_iterator& operator-=(difference_type n);
+    const_iterator operator+(difference_type n) const;
+    const_iterator operator-(difference_type n) const;
+    difference_type operator-(const_iterator const& right) const;
+
+    bool operator==(const_iterator const& right) const;
+    bool operator!=(const_iterator const& right) const;
+    bool operator<(const_iterator const& right) const;
+
+   private:
+    // The sentinel used for |end()| iterators.
+    static constexpr std::int64_t end_index =
+        std::numeric_limits<std::int64_t>::max();
+
+    const_iterator(ChunkedTimeline const* timeline, std::int64_t index);
+
+    // The position of this iterator relative to the beginning of the timeline,
+    // in [0, size()].
+    std::int64_t position() const;
+    static const_iterator FromPosition(ChunkedTimeline const* timeline,
+                                       std::int64_t position);
+
+    ChunkedTimeline const* timeline_ = nullptr;
+    // The index of the element in the timeline, counting from the first
+    // element ever inserted, so that it is not affected by insertions or
+    // deletions at the beginning.  |end_index| for an |end()| iterator.
+    std::int64_t index_ = end_index;
+
+    friend class ChunkedTimeline;
+  };
+
+  ChunkedTimeline() = default;
+  ChunkedTimeline(ChunkedTimeline const&) = delete;
+  ChunkedTimeline(ChunkedTimeline&&) = delete;
+  ChunkedTimeline& operator=(ChunkedTimeline const&) = delete;
+  ChunkedTimeline& operator=(ChunkedTimeline&&) = delete;
+
+  const_iterator begin() const;
+  const_iterator end() const;
+
+  bool empty() const;
+  std::int64_t size() const;
+
+  // Returns the number of elements that may be stored without allocating more
+  // memory.
+  std::int64_t capacity() const;
+
+  const_iterator find(Instant const& time) const;
+  const_iterator lower_bound(Instant const& time) const;
+  const_iterator upper_bound(Instant const& time) const;
+
+  // Inserts an element at |time|, which must be before the first element or
+  // after the last element of the timeline, and returns an iterator to it.  If
+  // an element already exists at |time|, does nothing and returns an iterator
+  // to that element.  The |hint| is ignored; this function exists for
+  // compatibility with |std::map|.
+  const_iterator emplace_hint(const_iterator hint,
+                              Instant const& time,
+                              Value const& value);
+
+  // Appends copies of the elements in [first, last[, which must be in a
+  // different timeline and must be after the last element of this timeline.
+  void insert(const_iterator first, const_iterator last);
+
+  // Removes the elements in [first, last[ and returns an iterator to the
+  // element that followed them.  This is efficient if the range touches either
+  // end of the timeline.
+  const_iterator erase(const_iterator first, const_iterator last);
+  const_iterator erase(const_iterator position);
+
+ private:
+  // The number of elements per chunk, chosen so that a chunk fits in a few
+  // pages.
+  static constexpr std::int64_t chunk_size = 1024;
+
+  using Chunk = std::vector<value_type>;
+
+  value_type& at(std::int64_t position);
+  value_type const& at(std::int64_t position) const;
+
+  // Returns the position of the first element for which |is_after| is true,
+  // or |size()| if there is none.  |is_after| must be monotonic.
+  template<typename Predicate>
+  std::int64_t PartitionPoint(Predicate is_after) const;
+
+  void PushBack(value_type const& element);
+  void PushFront(value_type const& element);
+  void PopBack(std::int64_t count);
+  void PopFront(std::int64_t count);
+
+  // All the chunks except the last have |chunk_size| elements, and the last
+  // one is nonempty.  The first |first_chunk_offset_| elements of the first
+  // chunk are not part of the timeline: they are left over by removals at the
+  // front, or are placeholders for insertions at the front, so that neither
+  // has to shift the elements of the chunk.
+  std::deque<Chunk> chunks_;
+  // The number of elements at the beginning of the first chunk that are not
+  // part of the timeline, in [0, chunk_size[.
+  std::int64_t first_chunk_offset_ = 0;
+  // The number of elements in all the chunks.
+  std::int64_t size_ = 0;
+  // The index of the first element of the timeline, see
+  // |const_iterator::index_|.
+  std::int64_t first_index_ = 0;
+};
+
+}  // namespace internal_chunked_timeline
+
+using internal_chunked_timeline::ChunkedTimeline;
+
+}  // namespace physics
+}  // namespace principia
+
+#include "physics/chunked_timeline_body.hpp"
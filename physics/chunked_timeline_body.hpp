@@ -0,0 +1,381 @@
+#pragma once
+
+#include "physics/chunked_timeline.hpp"
+
+#include <algorithm>
+
+#include "glog/logging.h"
+
+namespace principia {
+namespace physics {
+namespace internal_chunked_timeline {
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator::reference
+ChunkedTimeline<Value>::const_iterator::operator*() const {
+  DCHECK_NE(index_, end_index);
+  return timeline_->at(position());
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator::pointer
+ChunkedTimeline<Value>::const_iterator::operator->() const {
+  return &**this;
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator::reference
+ChunkedTimeline<Value>::const_iterator::operator[](
+    difference_type const n) const {
+  return *(*this + n);
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator&
+ChunkedTimeline<Value>::const_iterator::operator++() {
+  return *this += 1;
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator&
+ChunkedTimeline<Value>::const_iterator::operator--() {
+  return *this -= 1;
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator
+ChunkedTimeline<Value>::const_iterator::operator++(int) {
+  const_iterator const result = *this;
+  ++*this;
+  return result;
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator
+ChunkedTimeline<Value>::const_iterator::operator--(int) {
+  const_iterator const result = *this;
+  --*this;
+  return result;
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator&
+ChunkedTimeline<Value>::const_iterator::operator+=(difference_type const n) {
+  *this = FromPosition(timeline_, position() + n);
+  return *this;
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator&
+ChunkedTimeline<Value>::const_iterator::operator-=(difference_type const n) {
+  return *this += -n;
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator
+ChunkedTimeline<Value>::const_iterator::operator+(
+    difference_type const n) const {
+  const_iterator result = *this;
+  return result += n;
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator
+ChunkedTimeline<Value>::const_iterator::operator-(
+    difference_type const n) const {
+  const_iterator result = *this;
+  return result -= n;
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator::difference_type
+ChunkedTimeline<Value>::const_iterator::operator-(
+    const_iterator const& right) const {
+  DCHECK_EQ(timeline_, right.timeline_);
+  return position() - right.position();
+}
+
+template<typename Value>
+bool ChunkedTimeline<Value>::const_iterator::operator==(
+    const_iterator const& right) const {
+  return timeline_ == right.timeline_ && index_ == right.index_;
+}
+
+template<typename Value>
+bool ChunkedTimeline<Value>::const_iterator::operator!=(
+    const_iterator const& right) const {
+  return !(*this == right);
+}
+
+template<typename Value>
+bool ChunkedTimeline<Value>::const_iterator::operator<(
+    const_iterator const& right) const {
+  DCHECK_EQ(timeline_, right.timeline_);
+  return position() < right.position();
+}
+
+template<typename Value>
+ChunkedTimeline<Value>::const_iterator::const_iterator(
+    ChunkedTimeline const* const timeline,
+    std::int64_t const index)
+    : timeline_(timeline),
+      index_(index) {}
+
+template<typename Value>
+std::int64_t ChunkedTimeline<Value>::const_iterator::position() const {
+  if (index_ == end_index) {
+    return timeline_->size_;
+  } else {
+    std::int64_t const position = index_ - timeline_->first_index_;
+    DCHECK_LE(0, position);
+    DCHECK_LT(position, timeline_->size_);
+    return position;
+  }
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator
+ChunkedTimeline<Value>::const_iterator::FromPosition(
+    ChunkedTimeline const* const timeline,
+    std::int64_t const position) {
+  DCHECK_LE(0, position);
+  DCHECK_LE(position, timeline->size_);
+  if (position == timeline->size_) {
+    return const_iterator(timeline, end_index);
+  } else {
+    return const_iterator(timeline, timeline->first_index_ + position);
+  }
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator
+ChunkedTimeline<Value>::begin() const {
+  return const_iterator::FromPosition(this, 0);
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator
+ChunkedTimeline<Value>::end() const {
+  return const_iterator(this, const_iterator::end_index);
+}
+
+template<typename Value>
+bool ChunkedTimeline<Value>::empty() const {
+  return size_ == 0;
+}
+
+template<typename Value>
+std::int64_t ChunkedTimeline<Value>::size() const {
+  return size_;
+}
+
+template<typename Value>
+std::int64_t ChunkedTimeline<Value>::capacity() const {
+  std::int64_t capacity = 0;
+  for (auto const& chunk : chunks_) {
+    capacity += chunk.capacity();
+  }
+  return capacity;
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator
+ChunkedTimeline<Value>::find(Instant const& time) const {
+  auto const it = lower_bound(time);
+  if (it != end() && it->first == time) {
+    return it;
+  } else {
+    return end();
+  }
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator
+ChunkedTimeline<Value>::lower_bound(Instant const& time) const {
+  return const_iterator::FromPosition(
+      this,
+      PartitionPoint([&time](value_type const& element) {
+        return element.first >= time;
+      }));
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator
+ChunkedTimeline<Value>::upper_bound(Instant const& time) const {
+  return const_iterator::FromPosition(
+      this,
+      PartitionPoint([&time](value_type const& element) {
+        return element.first > time;
+      }));
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator
+ChunkedTimeline<Value>::emplace_hint(const_iterator const hint,
+                                     Instant const& time,
+                                     Value const& value) {
+  if (empty() || at(size_ - 1).first < time) {
+    PushBack({time, value});
+    return const_iterator::FromPosition(this, size_ - 1);
+  } else if (time < at(0).first) {
+    PushFront({time, value});
+    return begin();
+  } else {
+    auto const it = find(time);
+    CHECK(it != end()) << "Insertion at " << time
+                       << " in the middle of the timeline";
+    return it;
+  }
+}
+
+template<typename Value>
+void ChunkedTimeline<Value>::insert(const_iterator const first,
+                                    const_iterator const last) {
+  DCHECK_NE(this, first.timeline_);
+  for (auto it = first; it != last; ++it) {
+    CHECK(empty() || at(size_ - 1).first < it->first)
+        << "Insertion out of order at " << it->first;
+    PushBack(*it);
+  }
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator
+ChunkedTimeline<Value>::erase(const_iterator const first,
+                              const_iterator const last) {
+  std::int64_t const first_position = first.position();
+  std::int64_t const last_position = last.position();
+  CHECK_LE(first_position, last_position);
+  if (first_position == last_position) {
+    return last;
+  } else if (last_position == size_) {
+    PopBack(last_position - first_position);
+    return end();
+  } else if (first_position == 0) {
+    PopFront(last_position);
+    return begin();
+  } else {
+    // Shift the elements that follow the range and remove the space left at
+    // the end.
+    for (std::int64_t i = last_position; i < size_; ++i) {
+      at(first_position + i - last_position) = std::move(at(i));
+    }
+    PopBack(last_position - first_position);
+    return const_iterator::FromPosition(this, first_position);
+  }
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::const_iterator
+ChunkedTimeline<Value>::erase(const_iterator const position) {
+  return erase(position, std::next(position));
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::value_type&
+ChunkedTimeline<Value>::at(std::int64_t position) {
+  position += first_chunk_offset_;
+  return chunks_[position / chunk_size][position % chunk_size];
+}
+
+template<typename Value>
+typename ChunkedTimeline<Value>::value_type const&
+ChunkedTimeline<Value>::at(std::int64_t position) const {
+  position += first_chunk_offset_;
+  return chunks_[position / chunk_size][position % chunk_size];
+}
+
+template<typename Value>
+template<typename Predicate>
+std::int64_t ChunkedTimeline<Value>::PartitionPoint(
+    Predicate is_after) const {
+  // First find the chunk, using only its last element, then the element
+  // within the chunk.
+  auto const chunk = std::partition_point(
+      chunks_.begin(), chunks_.end(), [&is_after](Chunk const& chunk) {
+        return !is_after(chunk.back());
+      });
+  if (chunk == chunks_.end()) {
+    return size_;
+  }
+  auto const chunk_begin = chunk == chunks_.begin()
+                               ? chunk->begin() + first_chunk_offset_
+                               : chunk->begin();
+  auto const element = std::partition_point(
+      chunk_begin, chunk->end(), [&is_after](value_type const& element) {
+        return !is_after(element);
+      });
+  return (chunk - chunks_.begin()) * chunk_size +
+         (element - chunk->begin()) - first_chunk_offset_;
+}
+
+template<typename Value>
+void ChunkedTimeline<Value>::PushBack(value_type const& element) {
+  if (chunks_.empty() || chunks_.back().size() == chunk_size) {
+    chunks_.emplace_back().reserve(chunk_size);
+  }
+  chunks_.back().push_back(element);
+  ++size_;
+}
+
+template<typename Value>
+void ChunkedTimeline<Value>::PushFront(value_type const& element) {
+  if (chunks_.empty() || first_chunk_offset_ == 0) {
+    // The new chunk is filled with placeholders, which are overwritten by this
+    // and the following insertions at the front.
+    chunks_.emplace_front(chunk_size, element);
+    first_chunk_offset_ = chunk_size;
+  }
+  --first_chunk_offset_;
+  chunks_.front()[first_chunk_offset_] = element;
+  ++size_;
+  --first_index_;
+}
+
+template<typename Value>
+void ChunkedTimeline<Value>::PopBack(std::int64_t count) {
+  DCHECK_LE(count, size_);
+  size_ -= count;
+  if (size_ == 0) {
+    chunks_.clear();
+    first_chunk_offset_ = 0;
+    return;
+  }
+  // Since some elements remain, this never removes the first chunk or the
+  // elements that precede |first_chunk_offset_|.
+  while (count > 0) {
+    Chunk& last_chunk = chunks_.back();
+    std::int64_t const last_chunk_size = last_chunk.size();
+    if (count >= last_chunk_size) {
+      chunks_.pop_back();
+      count -= last_chunk_size;
+    } else {
+      last_chunk.erase(last_chunk.end() - count, last_chunk.end());
+      count = 0;
+    }
+  }
+}
+
+template<typename Value>
+void ChunkedTimeline<Value>::PopFront(std::int64_t count) {
+  DCHECK_LE(count, size_);
+  size_ -= count;
+  first_index_ += count;
+  if (size_ == 0) {
+    chunks_.clear();
+    first_chunk_offset_ = 0;
+    return;
+  }
+  // The removed elements are left in the first chunk, which is only destroyed
+  // once none of its elements are part of the timeline.
+  first_chunk_offset_ += count;
+  while (first_chunk_offset_ >= static_cast<std::int64_t>(
+                                    chunks_.front().size())) {
+    first_chunk_offset_ -= chunks_.front().size();
+    chunks_.pop_front();
+  }
+}
+
+}  // namespace internal_chunked_timeline
+}  // namespace physics
+}  // namespace principia
@@ -0,0 +1,191 @@
+#include "physics/chunked_timeline.hpp"
+
+#include <iterator>
+#include <vector>
+
+#include "geometry/named_quantities.hpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "quantities/si.hpp"
+
+namespace principia {
+namespace physics {
+
+using geometry::Instant;
+using quantities::si::Second;
+using ::testing::ElementsAreArray;
+
+class ChunkedTimelineTest : public ::testing::Test {
+ protected:
+  // Enough elements to span several chunks.
+  static constexpr int size = 3000;
+
+  static Instant Time(int const i) {
+    return Instant() + i * Second;
+  }
+
+  // Appends the elements |first| to |last| (inclusive), with value |i| at
+  // |Time(i)|.
+  void Append(int const first, int const last) {
+    for (int i = first; i <= last; ++i) {
+      timeline_.emplace_hint(timeline_.end(), Time(i), i);
+    }
+  }
+
+  std::vector<int> Values() const {
+    std::vector<int> values;
+    for (auto const& [time, value] : timeline_) {
+      EXPECT_EQ(Time(value), time);
+      values.push_back(value);
+    }
+    return values;
+  }
+
+  static std::vector<int> Range(int const first, int const last) {
+    std::vector<int> range;
+    for (int i = first; i <= last; ++i) {
+      range.push_back(i);
+    }
+    return range;
+  }
+
+  ChunkedTimeline<int> timeline_;
+};
+
+TEST_F(ChunkedTimelineTest, Empty) {
+  EXPECT_TRUE(timeline_.empty());
+  EXPECT_EQ(0, timeline_.size());
+  EXPECT_TRUE(timeline_.begin() == timeline_.end());
+  EXPECT_TRUE(timeline_.find(Time(0)) == timeline_.end());
+  EXPECT_TRUE(timeline_.lower_bound(Time(0)) == timeline_.end());
+}
+
+TEST_F(ChunkedTimelineTest, AppendAndIterate) {
+  Append(0, size - 1);
+  EXPECT_FALSE(timeline_.empty());
+  EXPECT_EQ(size, timeline_.size());
+  EXPECT_LE(size, timeline_.capacity());
+  EXPECT_THAT(Values(), ElementsAreArray(Range(0, size - 1)));
+  EXPECT_EQ(size, std::distance(timeline_.begin(), timeline_.end()));
+
+  int expected = size;
+  for (auto it = timeline_.end(); it != timeline_.begin();) {
+    --it;
+    --expected;
+    EXPECT_EQ(expected, it->second);
+  }
+  EXPECT_EQ(0, expected);
+}
+
+TEST_F(ChunkedTimelineTest, Lookups) {
+  Append(0, size - 1);
+  for (int i = 0; i < size; i += 7) {
+    EXPECT_EQ(i, timeline_.find(Time(i))->second);
+    EXPECT_EQ(i, timeline_.lower_bound(Time(i))->second);
+    EXPECT_EQ(i + 1, timeline_.lower_bound(Time(i) + 0.5 * Second)->second);
+    EXPECT_EQ(i + 1, timeline_.upper_bound(Time(i))->second);
+    EXPECT_TRUE(timeline_.find(Time(i) + 0.5 * Second) == timeline_.end());
+  }
+  EXPECT_EQ(0, timeline_.lower_bound(Time(-1))->second);
+  EXPECT_TRUE(timeline_.lower_bound(Time(size)) == timeline_.end());
+  EXPECT_TRUE(timeline_.upper_bound(Time(size - 1)) == timeline_.end());
+}
+
+TEST_F(ChunkedTimelineTest, Prepend) {
+  Append(1500, size - 1);
+  for (int i = 1499; i >= 0; --i) {
+    auto const it = timeline_.emplace_hint(timeline_.begin(), Time(i), i);
+    EXPECT_TRUE(it == timeline_.begin());
+  }
+  EXPECT_THAT(Values(), ElementsAreArray(Range(0, size - 1)));
+  for (int i = 0; i < size; i += 11) {
+    EXPECT_EQ(i, timeline_.find(Time(i))->second);
+  }
+  // Inserting at an existing time does nothing.
+  EXPECT_EQ(17, timeline_.emplace_hint(timeline_.end(), Time(17), 42)->second);
+  EXPECT_EQ(size, timeline_.size());
+}
+
+TEST_F(ChunkedTimelineTest, EraseAndPrepend) {
+  Append(0, size - 1);
+  // Remove elements at the front, leaving some of the first chunk unused, and
+  // reuse that space for insertions at the front.
+  timeline_.erase(timeline_.begin(), timeline_.find(Time(1100)));
+  for (int i = 1099; i >= 500; --i) {
+    timeline_.emplace_hint(timeline_.begin(), Time(i), i);
+  }
+  EXPECT_THAT(Values(), ElementsAreArray(Range(500, size - 1)));
+  for (int i = 500; i < size; i += 13) {
+    EXPECT_EQ(i, timeline_.find(Time(i))->second);
+    EXPECT_EQ(i + 1, timeline_.upper_bound(Time(i))->second);
+  }
+
+  // Remove everything but the first element, then everything.
+  timeline_.erase(std::next(timeline_.begin()), timeline_.end());
+  EXPECT_THAT(Values(), ElementsAreArray(Range(500, 500)));
+  timeline_.erase(timeline_.begin(), timeline_.end());
+  EXPECT_TRUE(timeline_.empty());
+
+  // Prepending to an empty timeline.
+  for (int i = size - 1; i >= 0; --i) {
+    timeline_.emplace_hint(timeline_.begin(), Time(i), i);
+  }
+  Append(size, size + 10);
+  EXPECT_THAT(Values(), ElementsAreArray(Range(0, size + 10)));
+}
+
+TEST_F(ChunkedTimelineTest, IteratorStability) {
+  Append(0, 999);
+  auto const it100 = timeline_.find(Time(100));
+  auto const it999 = timeline_.find(Time(999));
+  auto const end = timeline_.end();
+
+  Append(1000, size - 1);
+  EXPECT_EQ(100, it100->second);
+  EXPECT_EQ(999, it999->second);
+  EXPECT_TRUE(end == timeline_.end());
+
+  timeline_.erase(timeline_.begin(), timeline_.find(Time(50)));
+  EXPECT_EQ(100, it100->second);
+  EXPECT_EQ(50, timeline_.begin()->second);
+  EXPECT_EQ(50, it100 - timeline_.begin());
+
+  timeline_.erase(timeline_.upper_bound(Time(2000)), timeline_.end());
+  EXPECT_EQ(999, it999->second);
+  EXPECT_TRUE(end == timeline_.end());
+
+  timeline_.emplace_hint(timeline_.begin(), Time(10), 10);
+  EXPECT_EQ(100, it100->second);
+  EXPECT_EQ(10, timeline_.begin()->second);
+}
+
+TEST_F(ChunkedTimelineTest, EraseMiddle) {
+  Append(0, size - 1);
+  auto const it = timeline_.erase(timeline_.find(Time(1000)),
+                                  timeline_.find(Time(2500)));
+  EXPECT_EQ(2500, it->second);
+  std::vector<int> expected = Range(0, 999);
+  for (int i = 2500; i < size; ++i) {
+    expected.push_back(i);
+  }
+  EXPECT_THAT(Values(), ElementsAreArray(expected));
+  for (int i : expected) {
+    EXPECT_EQ(i, timeline_.find(Time(i))->second);
+  }
+
+  Append(size, size + 2000);
+  EXPECT_EQ(size + 2000, (--timeline_.end())->second);
+  EXPECT_EQ(1000 + 500 + 2001, timeline_.size());
+}
+
+TEST_F(ChunkedTimelineTest, Insert) {
+  Append(0, size - 1);
+  ChunkedTimeline<int> copy;
+  copy.insert(timeline_.find(Time(10)), timeline_.end());
+  EXPECT_EQ(size - 10, copy.size());
+  EXPECT_EQ(10, copy.begin()->second);
+  EXPECT_EQ(size - 1, (--copy.end())->second);
+}
+
+}  // namespace physics
+}  // namespace principia
@@ -2,6 +2,7 @@
 #pragma once
 
 #include <atomic>
+#include <memory>
 #include <optional>
 #include <utility>
 #include <vector>
@@ -10,9 +11,11 @@
 #include "base/not_null.hpp"
 #include "base/status.hpp"
 #include "geometry/named_quantities.hpp"
+#include "numerics/mapped_polynomial_sequence.hpp"
 #include "numerics/piecewise_poisson_series.hpp"
 #include "numerics/polynomial.hpp"
 #include "numerics/polynomial_evaluators.hpp"
+#include "numerics/polynomial_sequence.hpp"
 #include "physics/checkpointer.hpp"
 #include "physics/degrees_of_freedom.hpp"
 #include "physics/trajectory.hpp"
@@ -32,8 +35,10 @@ using geometry::Velocity;
 using quantities::Length;
 using quantities::Time;
 using numerics::EstrinEvaluator;
+using numerics::MappedPolynomialSequence;
 using numerics::PiecewisePoissonSeries;
 using numerics::Polynomial;
+using numerics::PolynomialSequence;
 
 template<typename Frame>
 class TestableContinuousTrajectory;
@@ -44,6 +49,16 @@ class TestableContinuousTrajectory;
 template<typename Frame>
 class ContinuousTrajectory : public Trajectory<Frame> {
  public:
+  static constexpr int min_degree = 3;
+  static constexpr int max_degree = 17;
+
+  // Polynomials of this trajectory stored outside of it, typically in a
+  // memory-mapped file.
+  using MappedPolynomials = MappedPolynomialSequence<Displacement<Frame>,
+                                                     Instant,
+                                                     min_degree, max_degree,
+                                                     EstrinEvaluator>;
+
   // Constructs a trajectory with the given time |step|.  Because the Чебышёв
   // polynomials have values in the range [-1, 1], the error resulting of
   // truncating the infinite Чебышёв series to a finite degree are a small
@@ -76,8 +91,8 @@ class ContinuousTrajectory : public Trajectory<Frame> {
   // Prepends the given |trajectory| to this one.  Ideally the last point of
   // |trajectory| should match the first point of this object.
   // Note the rvalue reference: |ContinuousTrajectory| is not moveable and not
-  // copyable, but the |InstantPolynomialPairs| are moveable and we really want
-  // to move them.  We could pass by non-const lvalue reference, but we would
+  // copyable, but the polynomials are moveable and we really want to move
+  // them.  We could pass by non-const lvalue reference, but we would
   // rather make it clear at the calling site that the object is consumed, so
   // we require the use of std::move.
   void Prepend(ContinuousTrajectory&& trajectory);
@@ -128,27 +143,42 @@ class ContinuousTrajectory : public Trajectory<Frame> {
   // trajectories.
   Checkpointer<serialization::ContinuousTrajectory>& checkpointer();
 
+  // Restores into |trajectory|, which must not have been appended to, the
+  // state of this trajectory at the time |t| of one of its checkpoints.
+  // Appending to |trajectory| the points after |t| then reconstructs the
+  // polynomials of this trajectory after |t|, and the result may be prepended
+  // to the trajectory restored from the next checkpoint.  Returns an error if
+  // there is no checkpoint at |t|.
+  Status ReadFromCheckpointAt(Instant const& t,
+                              not_null<ContinuousTrajectory*> trajectory)
+      EXCLUDES(lock_);
+
+  // Returns a writer containing the polynomials of this trajectory whose
+  // |t_max| is at or before |t|.  The trajectory must not be empty.
+  typename MappedPolynomials::Writer MakeMappedPolynomialsWriter(
+      Instant const& t) const EXCLUDES(lock_);
+
+  // Replaces the polynomials of this trajectory with the |prefix|, which is
+  // shared, not copied, and restores the rest of the state from |checkpoint|.
+  // The |checkpoint| must have been taken when the last polynomial of |prefix|
+  // was the last polynomial of the trajectory, so that it may be appended to
+  // afterwards.  A trajectory with a mapped prefix cannot be prepended to.
+  void SetMappedPrefix(
+      not_null<std::shared_ptr<MappedPolynomials const>> prefix,
+      serialization::ContinuousTrajectory::Checkpoint const& checkpoint)
+      EXCLUDES(lock_);
+
  protected:
   // For mocking.
   ContinuousTrajectory();
 
  private:
-  // Each polynomial is valid over an interval [t_min, t_max].  Polynomials are
-  // stored in this vector sorted by their |t_max|, as it turns out that we
-  // never need to extract their |t_min|.  Logically, the |t_min| for a
-  // polynomial is the |t_max| of the previous one.  The first polynomial has a
-  // |t_min| which is |*first_time_|.
+  // The polynomials produced by the Newhall approximation are stored by value
+  // in contiguous blocks and evaluated without virtual calls.
   // TODO(phl): These should be polynomials returning Position<Frame>.
-  struct InstantPolynomialPair {
-    InstantPolynomialPair(
-        Instant t_max,
-        not_null<std::unique_ptr<Polynomial<Displacement<Frame>, Instant>>>
-            polynomial);
-    Instant t_max;
-    not_null<std::unique_ptr<Polynomial<Displacement<Frame>, Instant>>>
-        polynomial;
-  };
-  using InstantPolynomialPairs = std::vector<InstantPolynomialPair>;
+  using Polynomials = PolynomialSequence<Displacement<Frame>, Instant,
+                                         min_degree, max_degree,
+                                         EstrinEvaluator>;
 
   // Checkpointing support.
   Checkpointer<serialization::ContinuousTrajectory>::Writer
@@ -156,18 +186,20 @@ class ContinuousTrajectory : public Trajectory<Frame> {
   Checkpointer<serialization::ContinuousTrajectory>::Reader
   MakeCheckpointerReader();
 
+  bool empty_locked() const REQUIRES_SHARED(lock_);
   Instant t_min_locked() const REQUIRES_SHARED(lock_);
   Instant t_max_locked() const REQUIRES_SHARED(lock_);
 
-  // Really a static method, but may be overridden for testing.
-  virtual not_null<std::unique_ptr<Polynomial<Displacement<Frame>, Instant>>>
-  NewhallApproximationInMonomialBasis(
+  // Appends to |polynomials_| the Newhall approximation of the given |degree|.
+  // The polynomial is constructed directly in |polynomials_|.  May be
+  // overridden for testing.
+  virtual void AppendNewhallApproximationInMonomialBasis(
       int degree,
       std::vector<Displacement<Frame>> const& q,
       std::vector<Velocity<Frame>> const& v,
       Instant const& t_min,
       Instant const& t_max,
-      Displacement<Frame>& error_estimate) const;
+      Displacement<Frame>& error_estimate) REQUIRES(lock_);
 
   // Computes the best Newhall approximation based on the desired tolerance.
   // Adjust the |degree_| and other member variables to stay within the
@@ -178,11 +210,19 @@ class ContinuousTrajectory : public Trajectory<Frame> {
       std::vector<Displacement<Frame>> const& q,
       std::vector<Velocity<Frame>> const& v) REQUIRES(lock_);
 
-  // Returns an iterator to the polynomial applicable for the given |time|, or
-  // |begin()| if |time| is before the first polynomial or |end()| if |time| is
-  // after the last polynomial.  Time complexity is O(N Log N).
-  typename InstantPolynomialPairs::const_iterator
-  FindPolynomialForInstant(Instant const& time) const REQUIRES_SHARED(lock_);
+  // Returns the index of the polynomial applicable for the given |time|, or 0
+  // if |time| is before the first polynomial or |polynomials_.size()| if |time|
+  // is after the last polynomial.  Time complexity is O(N Log N).
+  std::int64_t FindPolynomialForInstant(Instant const& time) const
+      REQUIRES_SHARED(lock_);
+
+  // Calls |function| with the polynomial applicable for the given |time|,
+  // which must be in [t_min, t_max], taken either from |mapped_prefix_| or
+  // from |polynomials_|.  Returns the result of |function|.
+  template<typename Function>
+  decltype(auto) VisitPolynomialForInstant(Instant const& time,
+                                           Function&& function) const
+      REQUIRES_SHARED(lock_);
 
   // Construction parameters;
   Time const step_;
@@ -203,10 +243,22 @@ class ContinuousTrajectory : public Trajectory<Frame> {
   int degree_ GUARDED_BY(lock_);
   int degree_age_ GUARDED_BY(lock_);
 
-  // The polynomials are in increasing time order.
-  InstantPolynomialPairs polynomials_ GUARDED_BY(lock_);
+  // Each polynomial is valid over an interval [t_min, t_max].  The |t_max|s are
+  // stored in this vector in increasing order, separately from the polynomials
+  // so that lookups only touch contiguous |Instant|s.  It turns out that we
+  // never need to extract the |t_min|s.  Logically, the |t_min| for a
+  // polynomial is the |t_max| of the previous one.  The first polynomial has a
+  // |t_min| which is |*first_time_|.
+  std::vector<Instant> polynomial_t_maxes_ GUARDED_BY(lock_);
+
+  // The polynomials, at the same indices as |polynomial_t_maxes_|.
+  Polynomials polynomials_ GUARDED_BY(lock_);
+
+  // If not null, the polynomials that precede those of |polynomials_|.  The
+  // first polynomial of |polynomials_| starts at |mapped_prefix_->t_max()|.
+  std::shared_ptr<MappedPolynomials const> mapped_prefix_ GUARDED_BY(lock_);
 
-  // Lookups into |polynomials_| are expensive because they entail a binary
+  // Lookups into |polynomial_t_maxes_| are expensive because they entail a binary
   // search into a vector that grows over time.  In benchmarks, this can be as
   // costly as the polynomial evaluation itself.  The accesses are not random,
   // though, they are clustered in time and (slowly) increasing.  To take
@@ -220,13 +272,17 @@ class ContinuousTrajectory : public Trajectory<Frame> {
   // parallel, and benchmarks show that there is no adverse performance effects.
   // Any value in the range of |polynomials_| or 0 is correct.
   mutable std::int64_t last_accessed_polynomial_ GUARDED_BY(lock_) = 0;
+  // Same as above, for |mapped_prefix_|.
+  mutable std::int64_t last_accessed_mapped_polynomial_ GUARDED_BY(lock_) = 0;
 
-  // The time at which this trajectory starts.  Set for a nonempty trajectory.
+  // The time at which this trajectory starts.  Set for a nonempty trajectory or
+  // one with a mapped prefix.
   std::optional<Instant> first_time_ GUARDED_BY(lock_);
 
   // The points that have not yet been incorporated in a polynomial.  Nonempty
   // for a nonempty trajectory.
-  // |last_points_.begin()->first == polynomials_.back().t_max|
+  // |last_points_.begin()->first == polynomial_t_maxes_.back()|, or
+  // |mapped_prefix_->t_max()| if |polynomials_| is empty.
   std::vector<std::pair<Instant, DegreesOfFreedom<Frame>>> last_points_
       GUARDED_BY(lock_);
 
@@ -4,6 +4,7 @@
 #include "physics/continuous_trajectory.hpp"
 
 #include <algorithm>
+#include <cstdint>
 #include <limits>
 #include <optional>
 #include <sstream>
@@ -23,6 +24,7 @@ namespace physics {
 namespace internal_continuous_trajectory {
 
 using astronomy::InfiniteFuture;
+using base::check_not_null;
 using base::dynamic_cast_not_null;
 using base::Error;
 using base::make_not_null_unique;
@@ -37,8 +39,6 @@ using quantities::si::Metre;
 using quantities::si::Second;
 namespace si = quantities::si;
 
-constexpr int max_degree = 17;
-constexpr int min_degree = 3;
 int const max_degree_age = 100;
 
 // Only supports 8 divisions for now.
@@ -64,20 +64,28 @@ ContinuousTrajectory<Frame>::ContinuousTrajectory(Time const& step,
 template<typename Frame>
 bool ContinuousTrajectory<Frame>::empty() const {
   absl::ReaderMutexLock l(&lock_);
-  return polynomials_.empty();
+  return empty_locked();
 }
 
 template<typename Frame>
 double ContinuousTrajectory<Frame>::average_degree() const {
   absl::ReaderMutexLock l(&lock_);
-  if (polynomials_.empty()) {
+  if (empty_locked()) {
     return 0;
   } else {
     double total = 0;
-    for (auto const& pair : polynomials_) {
-      total += pair.polynomial->degree();
+    std::int64_t size = polynomials_.size();
+    if (mapped_prefix_ != nullptr) {
+      for (std::int64_t i = 0; i < mapped_prefix_->size(); ++i) {
+        total += mapped_prefix_->degree(i);
+      }
+      size += mapped_prefix_->size();
+    }
+    for (std::int64_t i = 0; i < polynomials_.size(); ++i) {
+      total += polynomials_.Visit(
+          i, [](auto const& polynomial) { return polynomial.degree(); });
     }
-    return total / polynomials_.size();
+    return total / size;
   }
 }
 
@@ -138,32 +146,48 @@ void ContinuousTrajectory<Frame>::Prepend(ContinuousTrajectory&& prefix) {
 
   CHECK_EQ(step_, prefix.step_);
   CHECK_EQ(tolerance_, prefix.tolerance_);
+  CHECK(mapped_prefix_ == nullptr);
+  CHECK(prefix.mapped_prefix_ == nullptr);
 
   if (prefix.polynomials_.empty()) {
     // Nothing to do.
-  } else if (polynomials_.empty()) {
+  } else if (polynomials_.empty() && !first_time_) {
     // All the data comes from |prefix|.  This must set all the fields of
     // this object that are not set at construction.
     adjusted_tolerance_ = prefix.adjusted_tolerance_;
     is_unstable_ = prefix.is_unstable_;
     degree_ = prefix.degree_;
     degree_age_ = prefix.degree_age_;
+    polynomial_t_maxes_ = std::move(prefix.polynomial_t_maxes_);
     polynomials_ = std::move(prefix.polynomials_);
     last_accessed_polynomial_ = prefix.last_accessed_polynomial_;
     first_time_ = prefix.first_time_;
     last_points_ = prefix.last_points_;
+  } else if (polynomials_.empty()) {
+    // This object was restored from a checkpoint and may have been appended to
+    // since, but it does not have polynomials yet.  Its state is more recent
+    // than that of |prefix|, so we only take the polynomials.
+    CHECK_EQ(*first_time_, prefix.polynomial_t_maxes_.back());
+    polynomial_t_maxes_ = std::move(prefix.polynomial_t_maxes_);
+    polynomials_ = std::move(prefix.polynomials_);
+    last_accessed_polynomial_ = 0;
+    first_time_ = prefix.first_time_;
   } else {
     // The polynomials must be aligned, because the time computations only use
     // basic arithmetic and are platform-independent.  The space computations,
     // on the other may depend on characteristics of the hardware and/or math
     // library, so we cannot check that the trajectories are "continuous" at the
     // junction.
-    CHECK_EQ(*first_time_, prefix.polynomials_.back().t_max);
-    // This operation is in O(prefix.size()).
-    std::move(polynomials_.begin(),
-              polynomials_.end(),
-              std::back_inserter(prefix.polynomials_));
-    polynomials_.swap(prefix.polynomials_);
+    CHECK_EQ(*first_time_, prefix.polynomial_t_maxes_.back());
+    // These operations are in O(this->size()).
+    prefix.polynomial_t_maxes_.insert(prefix.polynomial_t_maxes_.end(),
+                                      polynomial_t_maxes_.begin(),
+                                      polynomial_t_maxes_.end());
+    polynomial_t_maxes_.swap(prefix.polynomial_t_maxes_);
+    prefix.polynomials_.Concatenate(std::move(polynomials_));
+    polynomials_ = std::move(prefix.polynomials_);
+    // The indices have shifted.
+    last_accessed_polynomial_ = 0;
     first_time_ = prefix.first_time_;
     // Note that any |last_points_| in |prefix| are irrelevant because they
     // correspond to a time interval covered by the first polynomial of this
@@ -189,10 +213,9 @@ Position<Frame> ContinuousTrajectory<Frame>::EvaluatePosition(
   absl::ReaderMutexLock l(&lock_);
   CHECK_LE(t_min_locked(), time);
   CHECK_GE(t_max_locked(), time);
-  auto const it = FindPolynomialForInstant(time);
-  CHECK(it != polynomials_.end());
-  auto const& polynomial = *it->polynomial;
-  return polynomial(time) + Frame::origin;
+  return VisitPolynomialForInstant(time, [&time](auto const& polynomial) {
+    return polynomial(time) + Frame::origin;
+  });
 }
 
 template<typename Frame>
@@ -201,10 +224,9 @@ Velocity<Frame> ContinuousTrajectory<Frame>::EvaluateVelocity(
   absl::ReaderMutexLock l(&lock_);
   CHECK_LE(t_min_locked(), time);
   CHECK_GE(t_max_locked(), time);
-  auto const it = FindPolynomialForInstant(time);
-  CHECK(it != polynomials_.end());
-  auto const& polynomial = *it->polynomial;
-  return polynomial.EvaluateDerivative(time);
+  return VisitPolynomialForInstant(time, [&time](auto const& polynomial) {
+    return polynomial.EvaluateDerivative(time);
+  });
 }
 
 template<typename Frame>
@@ -213,11 +235,10 @@ DegreesOfFreedom<Frame> ContinuousTrajectory<Frame>::EvaluateDegreesOfFreedom(
   absl::ReaderMutexLock l(&lock_);
   CHECK_LE(t_min_locked(), time);
   CHECK_GE(t_max_locked(), time);
-  auto const it = FindPolynomialForInstant(time);
-  CHECK(it != polynomials_.end());
-  auto const& polynomial = *it->polynomial;
-  return DegreesOfFreedom<Frame>(polynomial(time) + Frame::origin,
-                                 polynomial.EvaluateDerivative(time));
+  return VisitPolynomialForInstant(time, [&time](auto const& polynomial) {
+    return DegreesOfFreedom<Frame>(polynomial(time) + Frame::origin,
+                                   polynomial.EvaluateDerivative(time));
+  });
 }
 
 #if PRINCIPIA_CONTINUOUS_TRAJECTORY_SUPPORTS_PIECEWISE_POISSON_SERIES
@@ -227,16 +248,17 @@ int ContinuousTrajectory<Frame>::PiecewisePoissonSeriesDegree(
     Instant const& t_min,
     Instant const& t_max) const {
   absl::ReaderMutexLock l(&lock_);
+  CHECK(mapped_prefix_ == nullptr);
   CHECK_LE(t_min_locked(), t_min);
   CHECK_GE(t_max_locked(), t_max);
-  auto const it_min = FindPolynomialForInstant(t_min);
-  auto const it_max = FindPolynomialForInstant(t_max);
+  auto const index_min = FindPolynomialForInstant(t_min);
+  auto const index_max = FindPolynomialForInstant(t_max);
   int degree = min_degree;
-  for (auto it = it_min;; ++it) {
-    degree = std::max(degree, it->polynomial->degree());
-    if (it == it_max) {
-      break;
-    }
+  for (auto index = index_min; index <= index_max; ++index) {
+    degree = std::max(
+        degree,
+        polynomials_.Visit(
+            index, [](auto const& polynomial) { return polynomial.degree(); }));
   }
   return degree;
 }
@@ -322,15 +344,21 @@ ContinuousTrajectory<Frame>::ToPiecewisePoissonSeries(
   std::unique_ptr<PiecewisePoisson> result;
 
   absl::ReaderMutexLock l(&lock_);
-  auto const it_min = FindPolynomialForInstant(t_min);
-  auto const it_max = FindPolynomialForInstant(t_max);
+  CHECK(mapped_prefix_ == nullptr);
+  auto const index_min = FindPolynomialForInstant(t_min);
+  auto const index_max = FindPolynomialForInstant(t_max);
   Instant current_t_min = t_min;
-  for (auto it = it_min;; ++it) {
-    Instant const current_t_max = std::min(t_max, it->t_max);
+  for (auto index = index_min; index <= index_max; ++index) {
+    Instant const current_t_max = std::min(t_max, polynomial_t_maxes_[index]);
     Interval<Instant> interval;
     interval.Include(current_t_min);
     interval.Include(current_t_max);
-    auto const polynomial_cast_to_degree = cast_to_degree(it->polynomial.get());
+    auto const polynomial_cast_to_degree = polynomials_.Visit(
+        index,
+        [&cast_to_degree](
+            Polynomial<Displacement<Frame>, Instant> const& polynomial) {
+          return cast_to_degree(check_not_null(&polynomial));
+        });
     if (result == nullptr) {
       result = std::make_unique<PiecewisePoisson>(
           interval, Poisson(polynomial_cast_to_degree, {{}}));
@@ -338,9 +366,6 @@ ContinuousTrajectory<Frame>::ToPiecewisePoissonSeries(
       result->Append(interval, Poisson(polynomial_cast_to_degree, {{}}));
     }
     current_t_min = current_t_max;
-    if (it == it_max) {
-      break;
-    }
   }
   return *result;
 }
@@ -356,13 +381,29 @@ void ContinuousTrajectory<Frame>::WriteToMessage(
   checkpointer_->WriteToMessage(message->mutable_checkpoint());
   step_.WriteToMessage(message->mutable_step());
   tolerance_.WriteToMessage(message->mutable_tolerance());
-  for (auto const& pair : polynomials_) {
-    Instant const& t_max = pair.t_max;
-    auto const& polynomial = pair.polynomial;
-    if (t_max <= checkpointer_->oldest_checkpoint()) {
+  Instant const oldest_checkpoint = checkpointer_->oldest_checkpoint();
+  if (mapped_prefix_ != nullptr) {
+    for (std::int64_t i = 0; i < mapped_prefix_->size(); ++i) {
+      Instant const t_max = mapped_prefix_->t_max(i);
+      if (t_max <= oldest_checkpoint) {
+        auto* const pair = message->add_instant_polynomial_pair();
+        t_max.WriteToMessage(pair->mutable_t_max());
+        mapped_prefix_->Visit(i, [pair](auto const& polynomial) {
+          polynomial.WriteToMessage(pair->mutable_polynomial());
+        });
+      } else {
+        break;
+      }
+    }
+  }
+  for (std::int64_t i = 0; i < polynomials_.size(); ++i) {
+    Instant const& t_max = polynomial_t_maxes_[i];
+    if (t_max <= oldest_checkpoint) {
       auto* const pair = message->add_instant_polynomial_pair();
       t_max.WriteToMessage(pair->mutable_t_max());
-      polynomial->WriteToMessage(pair->mutable_polynomial());
+      polynomials_.Visit(i, [pair](auto const& polynomial) {
+        polynomial.WriteToMessage(pair->mutable_polynomial());
+      });
     } else {
       break;
     }
@@ -403,18 +444,18 @@ ContinuousTrajectory<Frame>::ReadFromMessage(
         v.push_back(series.EvaluateDerivative(t));
       }
       Displacement<Frame> error_estimate;  // Should we do something with this?
-      continuous_trajectory->polynomials_.emplace_back(
-          series.t_max(),
-          continuous_trajectory->NewhallApproximationInMonomialBasis(
-              series.degree(),
-              q, v,
-              series.t_min(), series.t_max(),
-              error_estimate));
+      continuous_trajectory->polynomial_t_maxes_.push_back(series.t_max());
+      continuous_trajectory->AppendNewhallApproximationInMonomialBasis(
+          series.degree(),
+          q, v,
+          series.t_min(), series.t_max(),
+          error_estimate);
     }
   } else {
     for (auto const& pair : message.instant_polynomial_pair()) {
-      continuous_trajectory->polynomials_.emplace_back(
-          Instant::ReadFromMessage(pair.t_max()),
+      continuous_trajectory->polynomial_t_maxes_.push_back(
+          Instant::ReadFromMessage(pair.t_max()));
+      continuous_trajectory->polynomials_.Append(
           Polynomial<Displacement<Frame>, Instant>::template ReadFromMessage<
               EstrinEvaluator>(pair.polynomial()));
     }
@@ -463,6 +504,65 @@ ContinuousTrajectory<Frame>::checkpointer() {
   return *checkpointer_;
 }
 
+template<typename Frame>
+Status ContinuousTrajectory<Frame>::ReadFromCheckpointAt(
+    Instant const& t,
+    not_null<ContinuousTrajectory*> const trajectory) {
+  CHECK_EQ(step_, trajectory->step_);
+  CHECK_EQ(tolerance_, trajectory->tolerance_);
+  return checkpointer_->ReadFromCheckpointAt(
+      t, trajectory->MakeCheckpointerReader());
+}
+
+template<typename Frame>
+auto ContinuousTrajectory<Frame>::MakeMappedPolynomialsWriter(
+    Instant const& t) const -> typename MappedPolynomials::Writer {
+  absl::ReaderMutexLock l(&lock_);
+  CHECK(first_time_);
+  typename MappedPolynomials::Writer writer(*first_time_);
+  if (mapped_prefix_ != nullptr) {
+    for (std::int64_t i = 0; i < mapped_prefix_->size(); ++i) {
+      Instant const t_max = mapped_prefix_->t_max(i);
+      if (t_max > t) {
+        return writer;
+      }
+      mapped_prefix_->Visit(i, [&t_max, &writer](auto const& polynomial) {
+        writer.Append(t_max, polynomial);
+      });
+    }
+  }
+  for (std::int64_t i = 0; i < polynomials_.size(); ++i) {
+    Instant const& t_max = polynomial_t_maxes_[i];
+    if (t_max > t) {
+      break;
+    }
+    polynomials_.Visit(i, [&t_max, &writer](auto const& polynomial) {
+      writer.Append(t_max, polynomial);
+    });
+  }
+  return writer;
+}
+
+template<typename Frame>
+void ContinuousTrajectory<Frame>::SetMappedPrefix(
+    not_null<std::shared_ptr<MappedPolynomials const>> prefix,
+    serialization::ContinuousTrajectory::Checkpoint const& checkpoint) {
+  // The reader takes the lock.
+  CHECK_OK(MakeCheckpointerReader()(checkpoint));
+
+  absl::MutexLock l(&lock_);
+  CHECK(!last_points_.empty());
+  if (!prefix->empty()) {
+    CHECK_EQ(prefix->t_max(), last_points_.front().first);
+  }
+  polynomial_t_maxes_.clear();
+  polynomials_ = Polynomials();
+  last_accessed_polynomial_ = 0;
+  last_accessed_mapped_polynomial_ = 0;
+  first_time_ = prefix->t_min();
+  mapped_prefix_ = std::move(prefix);
+}
+
 template<typename Frame>
 ContinuousTrajectory<Frame>::ContinuousTrajectory()
     : checkpointer_(
@@ -471,14 +571,6 @@ ContinuousTrajectory<Frame>::ContinuousTrajectory()
           /*reader=*/nullptr,
           /*writer=*/nullptr)) {}
 
-template<typename Frame>
-ContinuousTrajectory<Frame>::InstantPolynomialPair::InstantPolynomialPair(
-    Instant const t_max,
-    not_null<std::unique_ptr<Polynomial<Displacement<Frame>, Instant>>>
-        polynomial)
-    : t_max(t_max),
-      polynomial(std::move(polynomial)) {}
-
 template<typename Frame>
 Checkpointer<serialization::ContinuousTrajectory>::Writer
 ContinuousTrajectory<Frame>::MakeCheckpointerWriter() {
@@ -524,6 +616,11 @@ ContinuousTrajectory<Frame>::MakeCheckpointerReader() {
             {Instant::ReadFromMessage(l.instant()),
              DegreesOfFreedom<Frame>::ReadFromMessage(l.degrees_of_freedom())});
       }
+      // A trajectory restored from a checkpoint without its polynomials starts
+      // where the next polynomial will start.
+      if (!first_time_ && empty_locked() && !last_points_.empty()) {
+        first_time_ = last_points_.front().first;
+      }
       return Status::OK;
     };
   } else {
@@ -531,12 +628,21 @@ ContinuousTrajectory<Frame>::MakeCheckpointerReader() {
   }
 }
 
+template<typename Frame>
+bool ContinuousTrajectory<Frame>::empty_locked() const {
+#if defined(_DEBUG)
+  lock_.AssertReaderHeld();
+#endif
+  return polynomials_.empty() &&
+         (mapped_prefix_ == nullptr || mapped_prefix_->empty());
+}
+
 template<typename Frame>
 Instant ContinuousTrajectory<Frame>::t_min_locked() const {
 #if defined(_DEBUG)
   lock_.AssertReaderHeld();
 #endif
-  if (polynomials_.empty()) {
+  if (empty_locked()) {
     return astronomy::InfiniteFuture;
   }
   return *first_time_;
@@ -547,26 +653,30 @@ Instant ContinuousTrajectory<Frame>::t_max_locked() const {
 #if defined(_DEBUG)
   lock_.AssertReaderHeld();
 #endif
-  if (polynomials_.empty()) {
+  if (!polynomials_.empty()) {
+    return polynomial_t_maxes_.back();
+  }
+  if (empty_locked()) {
     return astronomy::InfinitePast;
   }
-  return polynomials_.crbegin()->t_max;
+  return mapped_prefix_->t_max();
 }
 
 template<typename Frame>
-not_null<std::unique_ptr<Polynomial<Displacement<Frame>, Instant>>>
-ContinuousTrajectory<Frame>::NewhallApproximationInMonomialBasis(
-    int degree,
+void ContinuousTrajectory<Frame>::AppendNewhallApproximationInMonomialBasis(
+    int const degree,
     std::vector<Displacement<Frame>> const& q,
     std::vector<Velocity<Frame>> const& v,
     Instant const& t_min,
     Instant const& t_max,
-    Displacement<Frame>& error_estimate) const {
-  return numerics::NewhallApproximationInMonomialBasis<
-            Displacement<Frame>, EstrinEvaluator>(degree,
-                                                  q, v,
-                                                  t_min, t_max,
-                                                  error_estimate);
+    Displacement<Frame>& error_estimate) {
+  polynomials_.Append(
+      degree,
+      [&q, &v, &t_min, &t_max, &error_estimate](auto const static_degree) {
+        return numerics::NewhallApproximationInMonomialBasis<
+            Displacement<Frame>, decltype(static_degree)::value,
+            EstrinEvaluator>(q, v, t_min, t_max, error_estimate);
+      });
 }
 
 template<typename Frame>
@@ -590,12 +700,11 @@ Status ContinuousTrajectory<Frame>::ComputeBestNewhallApproximation(
 
   // Compute the approximation with the current degree.
   Displacement<Frame> displacement_error_estimate;
-  polynomials_.emplace_back(time,
-                            NewhallApproximationInMonomialBasis(
-                                degree_,
-                                q, v,
-                                last_points_.cbegin()->first, time,
-                                displacement_error_estimate));
+  polynomial_t_maxes_.push_back(time);
+  AppendNewhallApproximationInMonomialBasis(degree_,
+                                            q, v,
+                                            last_points_.cbegin()->first, time,
+                                            displacement_error_estimate);
 
   // Estimate the error.  For initializing |previous_error_estimate|, any value
   // greater than |error_estimate| will do.
@@ -627,11 +736,12 @@ Status ContinuousTrajectory<Frame>::ComputeBestNewhallApproximation(
     ++degree_;
     VLOG(1) << "Increasing degree for " << this << " to " <<degree_
             << " because error estimate was " << error_estimate;
-    polynomials_.back().polynomial = NewhallApproximationInMonomialBasis(
-                                         degree_,
-                                         q, v,
-                                         last_points_.cbegin()->first, time,
-                                         displacement_error_estimate);
+    polynomials_.RemoveLast();
+    AppendNewhallApproximationInMonomialBasis(degree_,
+                                              q, v,
+                                              last_points_.cbegin()->first,
+                                              time,
+                                              displacement_error_estimate);
     previous_error_estimate = error_estimate;
     error_estimate = displacement_error_estimate.Norm();
   }
@@ -673,33 +783,53 @@ Status ContinuousTrajectory<Frame>::ComputeBestNewhallApproximation(
 }
 
 template<typename Frame>
-typename ContinuousTrajectory<Frame>::InstantPolynomialPairs::const_iterator
-ContinuousTrajectory<Frame>::FindPolynomialForInstant(
+std::int64_t ContinuousTrajectory<Frame>::FindPolynomialForInstant(
     Instant const& time) const {
 #if defined(_DEBUG)
   lock_.AssertReaderHeld();
 #endif
   // This returns the first polynomial |p| such that |time <= p.t_max|.
   {
-    auto const begin = polynomials_.begin();
+    auto const begin = polynomial_t_maxes_.begin();
     auto const it = begin + last_accessed_polynomial_;
-    if (it != polynomials_.end() && time <= it->t_max &&
-        (it == begin || std::prev(it)->t_max < time)) {
-      return it;
+    if (it != polynomial_t_maxes_.end() && time <= *it &&
+        (it == begin || *std::prev(it) < time)) {
+      return last_accessed_polynomial_;
     }
   }
   {
-    auto const it =
-        std::lower_bound(polynomials_.begin(),
-                         polynomials_.end(),
-                         time,
-                         [](InstantPolynomialPair const& left,
-                            Instant const& right) {
-                           return left.t_max < right;
-                         });
-    last_accessed_polynomial_ = it - polynomials_.begin();
-    return it;
+    auto const it = std::lower_bound(polynomial_t_maxes_.begin(),
+                                     polynomial_t_maxes_.end(),
+                                     time);
+    last_accessed_polynomial_ = it - polynomial_t_maxes_.begin();
+    return last_accessed_polynomial_;
+  }
+}
+
+template<typename Frame>
+template<typename Function>
+decltype(auto) ContinuousTrajectory<Frame>::VisitPolynomialForInstant(
+    Instant const& time,
+    Function&& function) const {
+#if defined(_DEBUG)
+  lock_.AssertReaderHeld();
+#endif
+  if (mapped_prefix_ != nullptr && !mapped_prefix_->empty() &&
+      time <= mapped_prefix_->t_max()) {
+    // Same caching strategy as in |FindPolynomialForInstant|.
+    std::int64_t index = last_accessed_mapped_polynomial_;
+    if (!(index < mapped_prefix_->size() &&
+          time <= mapped_prefix_->t_max(index) &&
+          (index == 0 || mapped_prefix_->t_max(index - 1) < time))) {
+      index = mapped_prefix_->LowerBound(time);
+      last_accessed_mapped_polynomial_ = index;
+    }
+    CHECK_LT(index, mapped_prefix_->size());
+    return mapped_prefix_->Visit(index, std::forward<Function>(function));
   }
+  auto const index = FindPolynomialForInstant(time);
+  CHECK_LT(index, polynomials_.size());
+  return polynomials_.Visit(index, std::forward<Function>(function));
 }
 
 }  // namespace internal_continuous_trajectory
@@ -2,11 +2,16 @@
 #include "physics/continuous_trajectory.hpp"
 
 #include <algorithm>
+#include <cstring>
 #include <deque>
 #include <functional>
 #include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
 #include <vector>
 
+#include "base/array.hpp"
 #include "geometry/frame.hpp"
 #include "geometry/named_quantities.hpp"
 #include "gtest/gtest.h"
@@ -30,6 +35,8 @@ namespace principia {
 namespace physics {
 namespace internal_continuous_trajectory {
 
+using base::Array;
+using base::Error;
 using geometry::Displacement;
 using geometry::Frame;
 using geometry::Handedness;
@@ -55,6 +62,7 @@ using testing_utilities::AbsoluteError;
 using testing_utilities::AlmostEquals;
 using testing_utilities::EqualsProto;
 using testing_utilities::IsNear;
+using testing_utilities::StatusIs;
 using testing_utilities::operator""_⑴;
 using ::testing::Sequence;
 using ::testing::SetArgReferee;
@@ -66,14 +74,13 @@ class TestableContinuousTrajectory : public ContinuousTrajectory<Frame> {
   using ContinuousTrajectory<Frame>::ContinuousTrajectory;
 
   // Mock the Newhall factory.
-  not_null<std::unique_ptr<Polynomial<Displacement<Frame>, Instant>>>
-  NewhallApproximationInMonomialBasis(
+  void AppendNewhallApproximationInMonomialBasis(
       int degree,
       std::vector<Displacement<Frame>> const& q,
       std::vector<Velocity<Frame>> const& v,
       Instant const& t_min,
       Instant const& t_max,
-      Displacement<Frame>& error_estimate) const override;
+      Displacement<Frame>& error_estimate) override;
 
   MOCK_CONST_METHOD7_T(
       FillNewhallApproximationInMonomialBasis,
@@ -99,14 +106,14 @@ class TestableContinuousTrajectory : public ContinuousTrajectory<Frame> {
 };
 
 template<typename Frame>
-not_null<std::unique_ptr<Polynomial<Displacement<Frame>, Instant>>>
-TestableContinuousTrajectory<Frame>::NewhallApproximationInMonomialBasis(
+void
+TestableContinuousTrajectory<Frame>::AppendNewhallApproximationInMonomialBasis(
     int degree,
     std::vector<Displacement<Frame>> const& q,
     std::vector<Velocity<Frame>> const& v,
     Instant const& t_min,
     Instant const& t_max,
-    Displacement<Frame>& error_estimate) const {
+    Displacement<Frame>& error_estimate) {
   using P = PolynomialInMonomialBasis<
                 Displacement<Frame>, Instant, /*degree=*/1, HornerEvaluator>;
   typename P::Coefficients const coefficients = {Displacement<Frame>(),
@@ -118,7 +125,7 @@ TestableContinuousTrajectory<Frame>::NewhallApproximationInMonomialBasis(
                                           t_min, t_max,
                                           error_estimate,
                                           polynomial);
-  return polynomial;
+  this->polynomials_.Append(std::move(polynomial));
 }
 
 template<typename Frame>
@@ -957,6 +964,169 @@ TEST_F(ContinuousTrajectoryTest, Checkpoint) {
   }
 }
 
+TEST_F(ContinuousTrajectoryTest, MappedPrefix) {
+  int const number_of_steps1 = 30;
+  int const number_of_steps2 = 20;
+  int const number_of_substeps = 50;
+  Time const step = 0.01 * Second;
+  Length const tolerance = 0.1 * Metre;
+
+  auto position_function =
+      [this](Instant const t) {
+        return World::origin +
+            Displacement<World>({(t - t0_) * 3 * Metre / Second,
+                                 (t - t0_) * 5 * Metre / Second,
+                                 (t - t0_) * (-2) * Metre / Second});
+      };
+  auto velocity_function =
+      [](Instant const t) {
+        return Velocity<World>({3 * Metre / Second,
+                                5 * Metre / Second,
+                                -2 * Metre / Second});
+      };
+
+  auto const trajectory = std::make_unique<ContinuousTrajectory<World>>(
+                              step, tolerance);
+  FillTrajectory(number_of_steps1,
+                 step,
+                 position_function,
+                 velocity_function,
+                 t0_,
+                 *trajectory);
+  Instant const checkpoint_time = trajectory->t_max();
+  trajectory->checkpointer().WriteToCheckpoint(checkpoint_time);
+  serialization::ContinuousTrajectory message;
+  trajectory->WriteToMessage(&message);
+
+  // Store the polynomials up to the checkpoint in 8-byte aligned storage.
+  auto const writer = trajectory->MakeMappedPolynomialsWriter(checkpoint_time);
+  std::ostringstream stream;
+  writer.WriteTo(stream);
+  std::string const bytes = stream.str();
+  auto const storage =
+      std::make_shared<std::vector<double>>(bytes.size() / sizeof(double));
+  std::memcpy(storage->data(), bytes.data(), bytes.size());
+  auto const prefix =
+      std::make_shared<ContinuousTrajectory<World>::MappedPolynomials const>(
+          storage,
+          Array<std::uint8_t const>(
+              reinterpret_cast<std::uint8_t const*>(storage->data()),
+              bytes.size()));
+  EXPECT_EQ(3, prefix->size());
+  EXPECT_EQ(checkpoint_time, prefix->t_max());
+
+  auto const mapped_trajectory =
+      std::make_unique<ContinuousTrajectory<World>>(step, tolerance);
+  mapped_trajectory->SetMappedPrefix(prefix, message.checkpoint(0));
+  mapped_trajectory->checkpointer().AddCheckpointsFromMessage(
+      message.checkpoint());
+  EXPECT_EQ(trajectory->t_min(), mapped_trajectory->t_min());
+  EXPECT_EQ(checkpoint_time, mapped_trajectory->t_max());
+  EXPECT_EQ(trajectory->average_degree(), mapped_trajectory->average_degree());
+
+  // Appending to both trajectories yields identical results.
+  for (auto* const t : {trajectory.get(), mapped_trajectory.get()}) {
+    FillTrajectory(number_of_steps2,
+                   step,
+                   position_function,
+                   velocity_function,
+                   t0_ + number_of_steps1 * step,
+                   *t);
+  }
+  EXPECT_EQ(trajectory->t_max(), mapped_trajectory->t_max());
+  for (Instant time = trajectory->t_min();
+       time <= trajectory->t_max();
+       time += step / number_of_substeps) {
+    EXPECT_EQ(trajectory->EvaluateDegreesOfFreedom(time),
+              mapped_trajectory->EvaluateDegreesOfFreedom(time));
+  }
+
+  serialization::ContinuousTrajectory mapped_message;
+  mapped_trajectory->WriteToMessage(&mapped_message);
+  serialization::ContinuousTrajectory second_message;
+  trajectory->WriteToMessage(&second_message);
+  EXPECT_THAT(mapped_message, EqualsProto(second_message));
+}
+
+TEST_F(ContinuousTrajectoryTest, ReadFromCheckpointAt) {
+  int const number_of_steps1 = 30;
+  int const number_of_steps2 = 20;
+  int const number_of_steps3 = 3;
+  int const number_of_steps4 = 20;
+  int const number_of_substeps = 50;
+  Time const step = 0.01 * Second;
+  Length const tolerance = 0.1 * Metre;
+
+  auto position_function =
+      [this](Instant const t) {
+        return World::origin +
+            Displacement<World>({(t - t0_) * 3 * Metre / Second,
+                                 (t - t0_) * 5 * Metre / Second,
+                                 (t - t0_) * (-2) * Metre / Second});
+      };
+  auto velocity_function =
+      [](Instant const t) {
+        return Velocity<World>({3 * Metre / Second,
+                                5 * Metre / Second,
+                                -2 * Metre / Second});
+      };
+  auto const fill = [&](int const number_of_steps,
+                        int const first_step,
+                        ContinuousTrajectory<World>& trajectory) {
+    FillTrajectory(number_of_steps,
+                   step,
+                   position_function,
+                   velocity_function,
+                   t0_ + first_step * step,
+                   trajectory);
+  };
+
+  auto const trajectory = std::make_unique<ContinuousTrajectory<World>>(
+                              step, tolerance);
+  fill(number_of_steps1, 0, *trajectory);
+  Instant const checkpoint_time1 = t0_ + number_of_steps1 * step;
+  trajectory->checkpointer().WriteToCheckpoint(checkpoint_time1);
+  fill(number_of_steps2, number_of_steps1, *trajectory);
+  Instant const checkpoint_time2 = checkpoint_time1 + number_of_steps2 * step;
+  trajectory->checkpointer().WriteToCheckpoint(checkpoint_time2);
+
+  // Reconstruct the interval between the checkpoints.
+  auto const past = std::make_unique<ContinuousTrajectory<World>>(
+                        step, tolerance);
+  EXPECT_OK(trajectory->ReadFromCheckpointAt(checkpoint_time1, past.get()));
+  fill(number_of_steps2, number_of_steps1, *past);
+  EXPECT_THAT(trajectory->ReadFromCheckpointAt(checkpoint_time1 + step,
+                                               past.get()),
+              StatusIs(Error::NOT_FOUND));
+
+  // Restart from the second checkpoint, but not long enough to produce a
+  // polynomial.
+  auto const present = std::make_unique<ContinuousTrajectory<World>>(
+                           step, tolerance);
+  EXPECT_OK(trajectory->ReadFromCheckpointAt(checkpoint_time2, present.get()));
+  int const first_step3 = number_of_steps1 + number_of_steps2;
+  fill(number_of_steps3, first_step3, *trajectory);
+  fill(number_of_steps3, first_step3, *present);
+  EXPECT_TRUE(present->empty());
+
+  // Prepending the past keeps the state of the present, so that the
+  // trajectories may be extended identically.
+  present->Prepend(std::move(*past));
+  EXPECT_EQ(trajectory->t_max(), present->t_max());
+  int const first_step4 = first_step3 + number_of_steps3;
+  fill(number_of_steps4, first_step4, *trajectory);
+  fill(number_of_steps4, first_step4, *present);
+  EXPECT_LT(trajectory->t_min(), present->t_min());
+  EXPECT_GE(checkpoint_time1, present->t_min());
+  EXPECT_EQ(trajectory->t_max(), present->t_max());
+  for (Instant time = present->t_min();
+       time <= present->t_max();
+       time += step / number_of_substeps) {
+    EXPECT_EQ(trajectory->EvaluateDegreesOfFreedom(time),
+              present->EvaluateDegreesOfFreedom(time));
+  }
+}
+
 }  // namespace internal_continuous_trajectory
 }  // namespace physics
 }  // namespace principia
@@ -3,7 +3,6 @@
 
 #include <functional>
 #include <list>
-#include <map>
 #include <memory>
 #include <optional>
 #include <vector>
@@ -13,6 +12,7 @@
 #include "geometry/grassmann.hpp"
 #include "geometry/named_quantities.hpp"
 #include "numerics/hermite3.hpp"
+#include "physics/chunked_timeline.hpp"
 #include "physics/degrees_of_freedom.hpp"
 #include "physics/forkable.hpp"
 #include "physics/trajectory.hpp"
@@ -33,7 +33,7 @@ using base::not_constructible;
 
 template<typename Frame>
 struct DiscreteTrajectoryTraits : not_constructible {
-  using Timeline = typename std::map<Instant, DegreesOfFreedom<Frame>>;
+  using Timeline = ChunkedTimeline<DegreesOfFreedom<Frame>>;
   using TimelineConstIterator = typename Timeline::const_iterator;
 
   static Instant const& time(TimelineConstIterator it);
@@ -165,6 +165,17 @@ class DiscreteTrajectory : public Forkable<DiscreteTrajectory<Frame>,
       not_null<serialization::DiscreteTrajectory*> message,
       std::vector<DiscreteTrajectory<Frame>*> const& forks) const;
 
+  // Same as |WriteToMessage|, but only the points at or after |tail_start| are
+  // written, e.g., because the earlier ones were written previously.  The
+  // |forks| must not be forked before |tail_start|.  The downsampling is
+  // written as for the entire trajectory, so the |message| is not a valid
+  // trajectory by itself if the start of the dense timeline precedes
+  // |tail_start|.
+  void WriteTailToMessage(
+      Instant const& tail_start,
+      not_null<serialization::DiscreteTrajectory*> message,
+      std::vector<DiscreteTrajectory<Frame>*> const& forks) const;
+
   // |forks| must have a size appropriate for the |message| being deserialized
   // and the orders of the |forks| must be consistent during serialization and
   // deserialization.  All pointers designated by the pointers in |forks| must
@@ -210,8 +221,7 @@ class DiscreteTrajectory : public Forkable<DiscreteTrajectory<Frame>,
                                  Timeline const& timeline);
 
     // Sets |dense_intervals_| to
-    // |std::distance(start_of_dense_timeline_, timeline.end()) - 1|.  This is
-    // linear in the value of |dense_intervals_|.
+    // |std::distance(start_of_dense_timeline_, timeline.end()) - 1|.
     void RecountDenseIntervals(Timeline const& timeline);
     // Increments |dense_intervals_|.  The caller must ensure that this is
     // equivalent to |RecountDenseIntervals(timeline)|.  This is checked in
@@ -240,9 +250,7 @@ class DiscreteTrajectory : public Forkable<DiscreteTrajectory<Frame>,
     // endpoint of a downsampled interval.  Not |timeline_.end()| if the
     // timeline is nonempty.
     TimelineConstIterator start_of_dense_timeline_;
-    // |std::distance(start_of_dense_timeline, timeline_.cend()) - 1|.  Kept as
-    // an optimization for |Append| as it can be maintained by incrementing,
-    // whereas |std::distance| is linear in the value of the result.
+    // |std::distance(start_of_dense_timeline, timeline_.cend()) - 1|.
     std::int64_t dense_intervals_;
   };
 
@@ -255,6 +263,14 @@ class DiscreteTrajectory : public Forkable<DiscreteTrajectory<Frame>,
       serialization::DiscreteTrajectory const& message,
       std::vector<DiscreteTrajectory<Frame>**> const& forks);
 
+  // Writes the |points|, a container of pairs (|Instant|,
+  // |DegreesOfFreedom<Frame>|) in increasing time order, to the timeline of
+  // |message|.
+  template<typename Points>
+  void WriteTimelineToMessage(
+      Points const& points,
+      not_null<serialization::DiscreteTrajectory*> message) const;
+
   // Returns the Hermite interpolation for the left-open, right-closed
   // trajectory segment containing the given |time|, or, if |time| is |t_min()|,
   // returns a first-degree polynomial which should be evaluated only at
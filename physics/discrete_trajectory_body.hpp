@@ -5,7 +5,6 @@
 
 #include <algorithm>
 #include <list>
-#include <map>
 #include <string>
 #include <vector>
 
@@ -16,6 +15,7 @@
 #include "geometry/named_quantities.hpp"
 #include "glog/logging.h"
 #include "numerics/fit_hermite_spline.hpp"
+#include "physics/timeline_codec.hpp"
 #include "quantities/quantities.hpp"
 #include "quantities/si.hpp"
 
@@ -183,7 +183,7 @@ void DiscreteTrajectory<Frame>::Append(
        << "Append at " << time << " which is before fork time "
        << this->Fork()->time;
 
-  if (!timeline_.empty() && timeline_.cbegin()->first == time) {
+  if (!timeline_.empty() && timeline_.begin()->first == time) {
     LOG(WARNING) << "Append at existing time " << time
                  << ", time range = [" << this->front().time << ", "
                  << this->back().time << "]";
@@ -192,7 +192,6 @@ void DiscreteTrajectory<Frame>::Append(
   auto it = timeline_.emplace_hint(timeline_.end(),
                                    time,
                                    degrees_of_freedom);
-  // Decrementing |end()| is much faster than incrementing |it|.  Don't ask.
   CHECK(--timeline_.end() == it)
       << "Append out of order at " << time << ", last time is "
       << (--timeline_.end())->first;
@@ -221,13 +220,33 @@ void DiscreteTrajectory<Frame>::Append(
         if (right_endpoints.empty()) {
           right_endpoints.push_back(dense_iterators.end() - 1);
         }
-        TimelineConstIterator left = downsampling_->start_of_dense_timeline();
-        for (const auto& it_in_dense_iterators : right_endpoints) {
-          TimelineConstIterator const right = *it_in_dense_iterators;
-          timeline_.erase(++left, right);
-          left = right;
+        // Only the right endpoints, and the points that follow the last one,
+        // are kept.  Erasing the points between successive endpoints one
+        // interval at a time would shift the rest of the dense timeline for
+        // each interval, so instead we copy the kept points, truncate the
+        // timeline after the start of the dense timeline, and append them
+        // again.
+        std::vector<typename Timeline::value_type> kept_points;
+        kept_points.reserve(right_endpoints.size() +
+                            (dense_iterators.end() - right_endpoints.back()));
+        for (auto const& it_in_dense_iterators : right_endpoints) {
+          kept_points.push_back(**it_in_dense_iterators);
         }
-        downsampling_->SetStartOfDenseTimeline(left, timeline_);
+        for (auto it = std::next(right_endpoints.back());
+             it != dense_iterators.end();
+             ++it) {
+          kept_points.push_back(**it);
+        }
+        std::int64_t const points_after_last_right_endpoint =
+            dense_iterators.end() - std::next(right_endpoints.back());
+        timeline_.erase(std::next(downsampling_->start_of_dense_timeline()),
+                        timeline_.end());
+        for (auto const& [time, degrees_of_freedom] : kept_points) {
+          timeline_.emplace_hint(timeline_.end(), time, degrees_of_freedom);
+        }
+        downsampling_->SetStartOfDenseTimeline(
+            std::prev(timeline_.end(), points_after_last_right_endpoint + 1),
+            timeline_);
       }
     }
   }
@@ -343,6 +362,34 @@ void DiscreteTrajectory<Frame>::WriteToMessage(
                     }));
 }
 
+template<typename Frame>
+void DiscreteTrajectory<Frame>::WriteTailToMessage(
+    Instant const& tail_start,
+    not_null<serialization::DiscreteTrajectory*> const message,
+    std::vector<DiscreteTrajectory<Frame>*> const& forks) const {
+  auto const tail_begin = timeline_.lower_bound(tail_start);
+  if (tail_begin == timeline_.begin()) {
+    WriteToMessage(message, forks);
+    return;
+  }
+  CHECK(this->is_root());
+
+  std::vector<DiscreteTrajectory<Frame>*> mutable_forks = forks;
+  Forkable<DiscreteTrajectory, Iterator, DiscreteTrajectoryTraits<Frame>>::
+      WriteSubTreeToMessage(message, mutable_forks);
+  CHECK(std::all_of(mutable_forks.begin(),
+                    mutable_forks.end(),
+                    [](DiscreteTrajectory<Frame>* const fork) {
+                      return fork == nullptr;
+                    }));
+  WriteTimelineToMessage(
+      std::vector<typename Timeline::value_type>(tail_begin, timeline_.end()),
+      message);
+  if (downsampling_.has_value()) {
+    downsampling_->WriteToMessage(message->mutable_downsampling(), timeline_);
+  }
+}
+
 template<typename Frame>
 template<typename, typename>
 not_null<std::unique_ptr<DiscreteTrajectory<Frame>>>
@@ -507,77 +554,7 @@ void DiscreteTrajectory<Frame>::WriteSubTreeToMessage(
     std::vector<DiscreteTrajectory<Frame>*>& forks) const {
   Forkable<DiscreteTrajectory, Iterator, DiscreteTrajectoryTraits<Frame>>::
       WriteSubTreeToMessage(message, forks);
-  if (Flags::IsPresent("zfp", "off")) {
-    for (auto const& [instant, degrees_of_freedom] : timeline_) {
-      auto const instantaneous_degrees_of_freedom = message->add_timeline();
-      instant.WriteToMessage(
-          instantaneous_degrees_of_freedom->mutable_instant());
-      degrees_of_freedom.WriteToMessage(
-          instantaneous_degrees_of_freedom->mutable_degrees_of_freedom());
-    }
-  } else {
-    int const timeline_size = timeline_.size();
-    auto* const zfp = message->mutable_zfp();
-    zfp->set_timeline_size(timeline_size);
-
-    // The timeline data is made dimensionless and stored in separate arrays per
-    // coordinate.  We expect strong correlations within a coordinate over time,
-    // but not between coordinates.
-    std::vector<double> t;
-    std::vector<double> qx;
-    std::vector<double> qy;
-    std::vector<double> qz;
-    std::vector<double> px;
-    std::vector<double> py;
-    std::vector<double> pz;
-    t.reserve(timeline_size);
-    qx.reserve(timeline_size);
-    qy.reserve(timeline_size);
-    qz.reserve(timeline_size);
-    px.reserve(timeline_size);
-    py.reserve(timeline_size);
-    pz.reserve(timeline_size);
-    std::optional<Instant> previous_instant;
-    Time max_Δt;
-    std::string* const zfp_timeline = zfp->mutable_timeline();
-    for (auto const& [instant, degrees_of_freedom] : timeline_) {
-      auto const q = degrees_of_freedom.position() - Frame::origin;
-      auto const p = degrees_of_freedom.velocity();
-      t.push_back((instant - Instant{}) / Second);
-      qx.push_back(q.coordinates().x / Metre);
-      qy.push_back(q.coordinates().y / Metre);
-      qz.push_back(q.coordinates().z / Metre);
-      px.push_back(p.coordinates().x / (Metre / Second));
-      py.push_back(p.coordinates().y / (Metre / Second));
-      pz.push_back(p.coordinates().z / (Metre / Second));
-      if (previous_instant.has_value()) {
-        max_Δt = std::max(max_Δt, instant - *previous_instant);
-      }
-      previous_instant = instant;
-    }
-
-    // Times are exact.
-    ZfpCompressor time_compressor(0);
-    // Lengths are approximated to the downsampling tolerance if downsampling is
-    // enabled, otherwise they are exact.
-    Length const length_tolerance =
-        downsampling_.has_value() ? downsampling_->tolerance() : Length();
-    ZfpCompressor length_compressor(length_tolerance / Metre);
-    // Speeds are approximated based on the length tolerance and the maximum
-    // step in the timeline.
-    ZfpCompressor const speed_compressor((length_tolerance / max_Δt) /
-                                         (Metre / Second));
-
-    ZfpCompressor::WriteVersion(message);
-    time_compressor.WriteToMessageMultidimensional<2>(t, zfp_timeline);
-    length_compressor.WriteToMessageMultidimensional<2>(qx, zfp_timeline);
-    length_compressor.WriteToMessageMultidimensional<2>(qy, zfp_timeline);
-    length_compressor.WriteToMessageMultidimensional<2>(qz, zfp_timeline);
-    speed_compressor.WriteToMessageMultidimensional<2>(px, zfp_timeline);
-    speed_compressor.WriteToMessageMultidimensional<2>(py, zfp_timeline);
-    speed_compressor.WriteToMessageMultidimensional<2>(pz, zfp_timeline);
-  }
-
+  WriteTimelineToMessage(timeline_, message);
   if (downsampling_.has_value()) {
     downsampling_->WriteToMessage(message->mutable_downsampling(), timeline_);
   }
@@ -587,14 +564,15 @@ template<typename Frame>
 void DiscreteTrajectory<Frame>::FillSubTreeFromMessage(
     serialization::DiscreteTrajectory const& message,
     std::vector<DiscreteTrajectory<Frame>**> const& forks) {
-  bool const is_pre_frobenius = !message.has_zfp();
+  bool const is_pre_frobenius = !message.has_zfp() && !message.has_columns();
+  bool const is_pre_green = !message.has_columns();
   if (is_pre_frobenius) {
     for (auto const& instantaneous_dof : message.timeline()) {
       Append(Instant::ReadFromMessage(instantaneous_dof.instant()),
              DegreesOfFreedom<Frame>::ReadFromMessage(
                  instantaneous_dof.degrees_of_freedom()));
     }
-  } else {
+  } else if (is_pre_green) {
     ZfpCompressor decompressor;
     ZfpCompressor::ReadVersion(message);
 
@@ -626,6 +604,13 @@ void DiscreteTrajectory<Frame>::FillSubTreeFromMessage(
                                pz[i] * (Metre / Second)});
       Append(Instant() + t[i] * Second, DegreesOfFreedom<Frame>(q, p));
     }
+  } else {
+    TimelineCodec<Frame>::ReadFromMessage(
+        message.columns(),
+        [this](Instant const& time,
+               DegreesOfFreedom<Frame> const& degrees_of_freedom) {
+          Append(time, degrees_of_freedom);
+        });
   }
   if (message.has_downsampling()) {
     CHECK(this->is_root());
@@ -636,6 +621,29 @@ void DiscreteTrajectory<Frame>::FillSubTreeFromMessage(
       FillSubTreeFromMessage(message, forks);
 }
 
+template<typename Frame>
+template<typename Points>
+void DiscreteTrajectory<Frame>::WriteTimelineToMessage(
+    Points const& points,
+    not_null<serialization::DiscreteTrajectory*> const message) const {
+  if (Flags::IsPresent("zfp", "off")) {
+    for (auto const& [instant, degrees_of_freedom] : points) {
+      auto const instantaneous_degrees_of_freedom = message->add_timeline();
+      instant.WriteToMessage(
+          instantaneous_degrees_of_freedom->mutable_instant());
+      degrees_of_freedom.WriteToMessage(
+          instantaneous_degrees_of_freedom->mutable_degrees_of_freedom());
+    }
+  } else {
+    // The degrees of freedom are approximated based on the downsampling
+    // tolerance if downsampling is enabled, otherwise they are exact.
+    TimelineCodec<Frame>::WriteToMessage(
+        points,
+        downsampling_.has_value() ? downsampling_->tolerance() : Length(),
+        message->mutable_columns());
+  }
+}
+
 template<typename Frame>
 Hermite3<Instant, Position<Frame>> DiscreteTrajectory<Frame>::GetInterpolation(
     Instant const& time) const {
@@ -5,6 +5,7 @@
 #include <functional>
 #include <list>
 #include <map>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -724,15 +725,52 @@ TEST_F(DiscreteTrajectoryTest, TrajectorySerializationSuccess) {
                                            deserialized_fork2});
   EXPECT_THAT(reference_message, EqualsProto(message));
   EXPECT_THAT(message.children_size(), Eq(2));
-  EXPECT_THAT(message.zfp().timeline_size(), Eq(3));
+  EXPECT_THAT(message.columns().timeline_size(), Eq(3));
   EXPECT_THAT(message.children(0).trajectories_size(), Eq(2));
   EXPECT_THAT(message.children(0).trajectories(0).children_size(), Eq(0));
-  EXPECT_THAT(message.children(0).trajectories(0).zfp().timeline_size(), Eq(1));
+  EXPECT_THAT(message.children(0).trajectories(0).columns().timeline_size(),
+              Eq(1));
   EXPECT_THAT(message.children(0).trajectories(1).children_size(), Eq(0));
-  EXPECT_THAT(message.children(0).trajectories(1).zfp().timeline_size(), Eq(2));
+  EXPECT_THAT(message.children(0).trajectories(1).columns().timeline_size(),
+              Eq(2));
   EXPECT_THAT(message.children(1).trajectories_size(), Eq(1));
   EXPECT_THAT(message.children(1).trajectories(0).children_size(), Eq(0));
-  EXPECT_THAT(message.children(1).trajectories(0).zfp().timeline_size(), Eq(1));
+  EXPECT_THAT(message.children(1).trajectories(0).columns().timeline_size(),
+              Eq(1));
+}
+
+TEST_F(DiscreteTrajectoryTest, TailSerialization) {
+  massive_trajectory_->Append(t1_, d1_);
+  massive_trajectory_->Append(t2_, d2_);
+  massive_trajectory_->Append(t3_, d3_);
+  not_null<DiscreteTrajectory<World>*> const fork =
+      massive_trajectory_->NewForkAtLast();
+  fork->Append(t4_, d4_);
+
+  // A tail that starts before the first point is the entire trajectory.
+  serialization::DiscreteTrajectory message;
+  serialization::DiscreteTrajectory reference_message;
+  massive_trajectory_->WriteTailToMessage(t1_ - 1 * Second, &message, {fork});
+  massive_trajectory_->WriteToMessage(&reference_message, {fork});
+  EXPECT_THAT(message, EqualsProto(reference_message));
+
+  // Otherwise only the points at or after the start of the tail are written,
+  // with the fork.
+  message.Clear();
+  massive_trajectory_->WriteTailToMessage(t2_, &message, {fork});
+  EXPECT_THAT(message.columns().timeline_size(), Eq(2));
+  EXPECT_THAT(message.children_size(), Eq(1));
+  EXPECT_THAT(message.children(0).trajectories(0).columns().timeline_size(),
+              Eq(1));
+
+  DiscreteTrajectory<World>* deserialized_fork = nullptr;
+  auto const deserialized_trajectory =
+      DiscreteTrajectory<World>::ReadFromMessage(message,
+                                                 {&deserialized_fork});
+  EXPECT_EQ(2, deserialized_trajectory->Size());
+  EXPECT_EQ(t2_, deserialized_trajectory->front().time);
+  EXPECT_EQ(t3_, deserialized_fork->Fork()->time);
+  EXPECT_EQ(t4_, deserialized_fork->back().time);
 }
 
 TEST_F(DiscreteTrajectoryDeathTest, LastError) {
@@ -865,6 +903,52 @@ TEST_F(DiscreteTrajectoryTest, Downsampling) {
       << *std::max_element(errors.begin(), errors.end());
 }
 
+// A dense timeline longer than a chunk of the timeline, where each fit
+// yields many right endpoints, so that points are erased in the middle of the
+// timeline before the following endpoints are processed.
+TEST_F(DiscreteTrajectoryTest, DownsamplingManyEndpoints) {
+  DiscreteTrajectory<World> circle;
+  DiscreteTrajectory<World> downsampled_circle;
+  downsampled_circle.SetDownsampling(/*max_dense_intervals=*/3000,
+                                     /*tolerance=*/1 * Micro(Metre));
+  AngularFrequency const ω = 3 * Radian / Second;
+  Length const r = 2 * Metre;
+  Speed const v = ω * r / Radian;
+  for (auto t = DoublePrecision<Instant>(t0_);
+       t.value <= t0_ + 100 * Second;
+       t.Increment(10 * Milli(Second))) {
+    DegreesOfFreedom<World> const dof =
+        {World::origin + Displacement<World>{{r * Cos(ω * (t.value - t0_)),
+                                              r * Sin(ω * (t.value - t0_)),
+                                              0 * Metre}},
+         Velocity<World>{{-v * Sin(ω * (t.value - t0_)),
+                          v * Cos(ω * (t.value - t0_)),
+                          0 * Metre / Second}}};
+    circle.Append(t.value, dof);
+    downsampled_circle.Append(t.value, dof);
+  }
+  EXPECT_THAT(circle.Size(), Eq(10001));
+  EXPECT_THAT(downsampled_circle.Size(), Lt(circle.Size() / 2));
+
+  // The surviving points are in order and are points of the original
+  // trajectory.
+  std::optional<Instant> previous_time;
+  for (auto const& [time, degrees_of_freedom] : downsampled_circle) {
+    if (previous_time.has_value()) {
+      EXPECT_LT(*previous_time, time);
+    }
+    previous_time = time;
+    EXPECT_THAT(degrees_of_freedom,
+                Eq(circle.Find(time)->degrees_of_freedom));
+  }
+  std::vector<Length> errors;
+  for (auto const& [time, degrees_of_freedom] : circle) {
+    errors.push_back((downsampled_circle.EvaluatePosition(time) -
+                      degrees_of_freedom.position()).Norm());
+  }
+  EXPECT_THAT(errors, Each(Lt(1 * Micro(Metre))));
+}
+
 TEST_F(DiscreteTrajectoryTest, DownsamplingSerialization) {
   DiscreteTrajectory<World> circle;
   auto deserialized_circle = make_not_null_unique<DiscreteTrajectory<World>>();
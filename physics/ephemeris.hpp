@@ -1,6 +1,9 @@
 ﻿
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <filesystem>
 #include <functional>
 #include <limits>
 #include <map>
@@ -11,6 +14,7 @@
 #include "base/jthread.hpp"
 #include "base/not_null.hpp"
 #include "base/status.hpp"
+#include "base/thread_pool.hpp"
 #include "geometry/grassmann.hpp"
 #include "geometry/named_quantities.hpp"
 #include "google/protobuf/repeated_field.h"
@@ -36,6 +40,7 @@ using base::Error;
 using base::jthread;
 using base::not_null;
 using base::Status;
+using base::ThreadPool;
 using geometry::Instant;
 using geometry::Position;
 using geometry::Vector;
@@ -141,6 +146,7 @@ class Ephemeris {
         FixedStepSizeIntegrator<NewtonianMotionEquation> const& integrator,
         Time const& step);
 
+    FixedStepSizeIntegrator<NewtonianMotionEquation> const& integrator() const;
     Time const& step() const;
 
     void WriteToMessage(
@@ -189,6 +195,16 @@ class Ephemeris {
   // Prolongs the ephemeris up to at least |t|.  After the call, |t_max() >= t|.
   virtual void Prolong(Instant const& t) EXCLUDES(lock_);
 
+  // If |thread_pool| is not null, the accelerations between the massive bodies
+  // are subsequently computed on its threads, with one task per row of the
+  // triangle of pairs of bodies.  The results are bit-for-bit identical to
+  // those of the sequential computation, because the contributions of the
+  // pairs are summed in the same order.  This only pays off for systems with
+  // many bodies, especially oblate ones.  |thread_pool| must outlive this
+  // object, or be replaced by null before it is destroyed.
+  void SetMassiveBodiesThreadPool(ThreadPool<void>* thread_pool)
+      EXCLUDES(lock_);
+
   // Creates an instance suitable for integrating the given |trajectories| with
   // their |intrinsic_accelerations| using a fixed-step integrator parameterized
   // by |parameters|.
@@ -272,10 +288,55 @@ class Ephemeris {
 
   virtual void WriteToMessage(
       not_null<serialization::Ephemeris*> message) const EXCLUDES(lock_);
+  // Same as above, but the trajectories are serialized in parallel on the
+  // threads of |thread_pool|.
+  virtual void WriteToMessage(not_null<serialization::Ephemeris*> message,
+                              ThreadPool<Status>& thread_pool) const
+      EXCLUDES(lock_);
+  // The past of the ephemeris is reanimated asynchronously from its
+  // checkpoints.  If |reanimation_thread_pool| is not null, the intervals
+  // between checkpoints are reanimated in parallel on its threads, otherwise
+  // they are reanimated sequentially.  |reanimation_thread_pool| must outlive
+  // the ephemeris.
   template<typename F = Frame,
            typename = std::enable_if_t<base::is_serializable_v<F>>>
   static not_null<std::unique_ptr<Ephemeris>> ReadFromMessage(
-      serialization::Ephemeris const& message) EXCLUDES(lock_);
+      serialization::Ephemeris const& message,
+      ThreadPool<Status>* reanimation_thread_pool = nullptr) EXCLUDES(lock_);
+
+  // The state of a deserialized ephemeris is restored from its most recent
+  // checkpoint, so that it may be prolonged right away.  Its past is
+  // reconstructed asynchronously from the older checkpoints, from the most
+  // recent to the oldest, which makes |t_min()| decrease over time.  This
+  // function blocks until |t_min()| is at or before |desired_t_min|, or until
+  // the reconstruction is over.  Clients that need the past of a deserialized
+  // ephemeris must call it.
+  virtual void AwaitReanimation(Instant const& desired_t_min) const
+      EXCLUDES(lock_);
+
+  // The fraction of the intervals between checkpoints that have been
+  // reconstructed, or 1 if the reconstruction is over.
+  virtual double reanimation_progress() const EXCLUDES(lock_);
+
+  // Writes to |path| a cache containing the polynomials of the trajectories up
+  // to the most recent checkpoint, together with the state needed to resume
+  // the integration at that checkpoint.  |fingerprint| must identify the system
+  // that this ephemeris integrates; it is combined with the parameters of this
+  // object to form the key of the cache.  May be called on a stoppable thread
+  // concurrently with |Prolong|, in which case it returns |CANCELLED| if the
+  // thread is stopped.
+  virtual Status WriteToCache(std::filesystem::path const& path,
+                              std::uint64_t fingerprint) const EXCLUDES(lock_);
+
+  // If there is at |path| a cache written for the same |fingerprint| and
+  // parameters, and if this object was just constructed or deserialized and
+  // has a state consistent with that of the cache, stops the reconstruction of
+  // the past, replaces the polynomials of the trajectories with those of the
+  // cache and resumes the integration at the end of the cache.  The
+  // polynomials are evaluated directly from a memory mapping of the cache.
+  // Returns true iff the cache was used.
+  virtual bool ReadFromCache(std::filesystem::path const& path,
+                             std::uint64_t fingerprint) EXCLUDES(lock_);
 
   // A |Guard| is an RAII object that protects a critical section against
   // changes to |t_min|.
@@ -309,8 +370,32 @@ class Ephemeris {
   Checkpointer<serialization::Ephemeris>::Reader MakeCheckpointerReader();
 
   // Called on a stoppable thread to reconstruct the past state of the ephemeris
-  // and its trajectories.
-  Status Reanimate();
+  // and its trajectories, which were restored from the checkpoint at |t_final|.
+  // The intervals between successive checkpoints are integrated on the
+  // |reanimation_thread_pool_|, if any, and prepended to the trajectories, from
+  // the most recent to the oldest, followed by |oldest_trajectories_|.  The
+  // prepending goes through the |protector_|.
+  Status Reanimate(Instant const& t_final);
+  Status ReanimateIntervals(Instant const& t_final);
+
+  // Reconstructs into |trajectories| the interval between the checkpoints
+  // |initial| and |final|.  Thread-safe.
+  Status ReanimateInterval(
+      serialization::Ephemeris::Checkpoint const& initial,
+      serialization::Ephemeris::Checkpoint const& final,
+      std::vector<not_null<std::unique_ptr<ContinuousTrajectory<Frame>>>>&
+          trajectories) const;
+
+  // Prepends |trajectories| to |trajectories_| when the |protector_| permits
+  // it, and waits until this is done.  Returns |CANCELLED| if the thread is
+  // stopped before, in which case |trajectories| are dropped.
+  Status PrependToTrajectories(
+      std::shared_ptr<std::vector<
+          not_null<std::unique_ptr<ContinuousTrajectory<Frame>>>>> const&
+          trajectories) EXCLUDES(lock_);
+
+  // Returns the key of a cache for this object, see |WriteToCache|.
+  std::uint64_t CacheKey(std::uint64_t fingerprint) const;
 
   // Callbacks for the integrators.
   void AppendMassiveBodiesState(
@@ -334,6 +419,31 @@ class Ephemeris {
 
   virtual Instant t_min_locked() const REQUIRES_SHARED(lock_);
 
+  // The contributions of the interaction between two bodies to their
+  // accelerations, in the order in which they are summed: the Newtonian term,
+  // then the effect of the geopotential of the first body if it is oblate,
+  // then that of the second body if it is oblate.  The terms that are
+  // subtracted in the sequential computation are stored negated, which yields
+  // the same sums.
+  struct PairwiseAccelerations final {
+    std::array<Vector<Acceleration, Frame>, 3> on_body1;
+    std::array<Vector<Acceleration, Frame>, 3> on_body2;
+    int size = 0;
+  };
+
+  // Computes the contributions of the interaction between |body1| and |body2|
+  // (with indices |b1| and |b2| in the |positions| array) to their
+  // accelerations.
+  template<bool body1_is_oblate, bool body2_is_oblate>
+  static PairwiseAccelerations ComputePairwiseAccelerations(
+      Instant const& t,
+      MassiveBody const& body1,
+      std::size_t b1,
+      MassiveBody const& body2,
+      std::size_t b2,
+      std::vector<Position<Frame>> const& positions,
+      std::vector<Geopotential<Frame>> const& geopotentials);
+
   // Computes the accelerations between one body, |body1| (with index |b1| in
   // the |positions| and |accelerations| arrays) and the bodies |bodies2| (with
   // indices [b2_begin, b2_end[ in the |bodies2|, |positions| and
@@ -375,6 +485,19 @@ class Ephemeris {
       std::vector<Vector<Acceleration, Frame>>& accelerations) const
       REQUIRES_SHARED(lock_);
 
+  // Same as above, but on the threads of |massive_bodies_thread_pool_|, which
+  // must not be null.
+  void ComputeMassiveBodiesGravitationalAccelerationsInParallel(
+      Instant const& t,
+      std::vector<Position<Frame>> const& positions,
+      std::vector<Vector<Acceleration, Frame>>& accelerations) const
+      REQUIRES_SHARED(lock_);
+
+  // Serializes the trajectories on the threads of |thread_pool| if it is not
+  // null, sequentially otherwise.
+  void WriteToMessage(not_null<serialization::Ephemeris*> message,
+                      ThreadPool<Status>* thread_pool) const EXCLUDES(lock_);
+
   // Computes the acceleration exerted by the massive bodies in |bodies_| on
   // massless bodies.  The massless bodies are at the given |positions|.
   // Returns false iff a collision occurred, i.e., the massless body is inside
@@ -433,6 +556,8 @@ class Ephemeris {
 
   // The techniques and terminology follow [Lov22].
   jthread reanimator_;
+  // Not owning, may be null.
+  ThreadPool<Status>* reanimation_thread_pool_ = nullptr;
 
   // The fields above this line are fixed at construction and therefore not
   // protected.  Note that |ContinuousTrajectory| is thread-safe.  |lock_| is
@@ -445,6 +570,16 @@ class Ephemeris {
 
   Status last_severe_integration_status_ GUARDED_BY(lock_);
 
+  // The trajectories deserialized up to the oldest checkpoint, to be prepended
+  // at the end of the reanimation.
+  std::vector<not_null<std::unique_ptr<ContinuousTrajectory<Frame>>>>
+      oldest_trajectories_ GUARDED_BY(lock_);
+  bool reanimating_ GUARDED_BY(lock_) = false;
+  int reanimated_intervals_ GUARDED_BY(lock_) = 0;
+  int intervals_to_reanimate_ GUARDED_BY(lock_) = 0;
+
+  ThreadPool<void>* massive_bodies_thread_pool_ GUARDED_BY(lock_) = nullptr;
+
   friend class Guard;
 };
 
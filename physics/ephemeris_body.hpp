@@ -5,23 +5,32 @@
 
 #include <algorithm>
 #include <functional>
+#include <future>
 #include <limits>
+#include <memory>
 #include <optional>
 #include <set>
+#include <thread>
 #include <utility>
 #include <vector>
 
+#include "absl/synchronization/notification.h"
 #include "astronomy/epoch.hpp"
+#include "base/fingerprint2011.hpp"
 #include "base/jthread.hpp"
 #include "base/macros.hpp"
 #include "base/map_util.hpp"
 #include "base/not_null.hpp"
+#include "base/serialization.hpp"
+#include "base/thread_pool.hpp"
 #include "geometry/grassmann.hpp"
 #include "geometry/r3_element.hpp"
 #include "integrators/integrators.hpp"
 #include "integrators/ordinary_differential_equations.hpp"
 #include "numerics/hermite3.hpp"
 #include "physics/continuous_trajectory.hpp"
+#include "physics/ephemeris_cache.hpp"
+#include "physics/massless_bodies_accelerations.hpp"
 #include "quantities/elementary_functions.hpp"
 #include "quantities/named_quantities.hpp"
 #include "quantities/quantities.hpp"
@@ -31,12 +40,18 @@ namespace principia {
 namespace physics {
 namespace internal_ephemeris {
 
+using astronomy::InfinitePast;
 using astronomy::J2000;
+using base::CallWithStopToken;
 using base::dynamic_cast_not_null;
 using base::Error;
 using base::FindOrDie;
+using base::Fingerprint2011;
+using base::FingerprintCat2011;
 using base::make_not_null_unique;
 using base::MakeStoppableThread;
+using base::SerializeAsBytes;
+using base::this_stoppable_thread;
 using geometry::Barycentre;
 using geometry::Displacement;
 using geometry::InnerProduct;
@@ -203,6 +218,13 @@ Ephemeris<Frame>::FixedStepParameters::FixedStepParameters(
   CHECK_LT(Time(), step);
 }
 
+template<typename Frame>
+inline FixedStepSizeIntegrator<
+    typename Ephemeris<Frame>::NewtonianMotionEquation> const&
+Ephemeris<Frame>::FixedStepParameters::integrator() const {
+  return *integrator_;
+}
+
 template<typename Frame>
 inline Time const& Ephemeris<Frame>::FixedStepParameters::step() const {
   return step_;
@@ -379,6 +401,13 @@ void Ephemeris<Frame>::Prolong(Instant const& t) {
   }
 }
 
+template<typename Frame>
+void Ephemeris<Frame>::SetMassiveBodiesThreadPool(
+    ThreadPool<void>* const thread_pool) {
+  absl::MutexLock l(&lock_);
+  massive_bodies_thread_pool_ = thread_pool;
+}
+
 template<typename Frame>
 not_null<std::unique_ptr<typename Integrator<
     typename Ephemeris<Frame>::NewtonianMotionEquation>::Instance>>
@@ -694,7 +723,24 @@ not_null<MassiveBody const*> Ephemeris<Frame>::body_for_serialization_index(
 template<typename Frame>
 void Ephemeris<Frame>::WriteToMessage(
     not_null<serialization::Ephemeris*> const message) const {
+  WriteToMessage(message, /*thread_pool=*/nullptr);
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::WriteToMessage(
+    not_null<serialization::Ephemeris*> const message,
+    ThreadPool<Status>& thread_pool) const {
+  WriteToMessage(message, &thread_pool);
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::WriteToMessage(
+    not_null<serialization::Ephemeris*> const message,
+    ThreadPool<Status>* const thread_pool) const {
   LOG(INFO) << __FUNCTION__;
+  // The trajectories are only serialized up to the oldest checkpoint, so their
+  // past must have been reconstructed.
+  AwaitReanimation(InfinitePast);
   absl::ReaderMutexLock l(&lock_);
 
   // Make sure that a checkpoint exists, otherwise we would not serialize some
@@ -708,9 +754,28 @@ void Ephemeris<Frame>::WriteToMessage(
     unowned_body->WriteToMessage(message->add_body());
   }
   // The trajectories are serialized in the order resulting from the separation
-  // between oblate and spherical bodies.
-  for (auto const& trajectory : trajectories_) {
-    trajectory->WriteToMessage(message->add_trajectory());
+  // between oblate and spherical bodies.  Their messages are created before
+  // being filled, possibly in parallel, since they are independent.
+  std::vector<not_null<serialization::ContinuousTrajectory*>>
+      trajectory_messages;
+  trajectory_messages.reserve(trajectories_.size());
+  for (int i = 0; i < trajectories_.size(); ++i) {
+    trajectory_messages.push_back(message->add_trajectory());
+  }
+  if (thread_pool == nullptr) {
+    for (int i = 0; i < trajectories_.size(); ++i) {
+      trajectories_[i]->WriteToMessage(trajectory_messages[i]);
+    }
+  } else {
+    auto batch = thread_pool->NewBatch();
+    batch.Reserve(trajectories_.size());
+    for (int i = 0; i < trajectories_.size(); ++i) {
+      batch.Add([trajectory = trajectories_[i],
+                 trajectory_message = trajectory_messages[i]]() {
+        trajectory->WriteToMessage(trajectory_message);
+      });
+    }
+    batch.SubmitAndJoin();
   }
   fixed_step_parameters_.WriteToMessage(
       message->mutable_fixed_step_parameters());
@@ -723,7 +788,8 @@ void Ephemeris<Frame>::WriteToMessage(
 template<typename Frame>
 template<typename, typename>
 not_null<std::unique_ptr<Ephemeris<Frame>>> Ephemeris<Frame>::ReadFromMessage(
-    serialization::Ephemeris const& message) {
+    serialization::Ephemeris const& message,
+    ThreadPool<Status>* const reanimation_thread_pool) {
   bool const is_pre_ἐρατοσθένης = !message.has_accuracy_parameters();
   bool const is_pre_fatou = !message.has_checkpoint_time();
   bool const is_pre_grassmann = message.checkpoint_size() == 0;
@@ -794,17 +860,202 @@ not_null<std::unique_ptr<Ephemeris<Frame>>> Ephemeris<Frame>::ReadFromMessage(
 
   // WriteToMessage always creates a checkpoint, and so does the compatibility
   // code.
-  ephemeris->checkpointer_->ReadFromOldestCheckpoint();
+  Instant const oldest_checkpoint =
+      ephemeris->checkpointer_->oldest_checkpoint();
+  Instant const newest_checkpoint =
+      ephemeris->checkpointer_->newest_checkpoint();
+  if (oldest_checkpoint == newest_checkpoint) {
+    // There is nothing to reconstruct.
+    ephemeris->checkpointer_->ReadFromOldestCheckpoint();
+    return ephemeris;
+  }
+
+  // The deserialized trajectories end at the oldest checkpoint.  Replace them
+  // with trajectories restored from the newest checkpoint, and keep them to be
+  // prepended once the intervening intervals have been reconstructed.
+  {
+    absl::MutexLock l(&ephemeris->lock_);
+    for (int i = 0; i < ephemeris->trajectories_.size(); ++i) {
+      auto& trajectory =
+          ephemeris->bodies_to_trajectories_.at(ephemeris->bodies_[i].get());
+      not_null<std::unique_ptr<ContinuousTrajectory<Frame>>>
+          newest_trajectory = make_not_null_unique<ContinuousTrajectory<Frame>>(
+              fixed_step_parameters.step_,
+              accuracy_parameters.fitting_tolerance_);
+      CHECK_OK(trajectory->ReadFromCheckpointAt(newest_checkpoint,
+                                                newest_trajectory.get()));
+      google::protobuf::RepeatedPtrField<
+          serialization::ContinuousTrajectory::Checkpoint> checkpoints;
+      trajectory->checkpointer().WriteToMessage(&checkpoints);
+      newest_trajectory->checkpointer().AddCheckpointsFromMessage(checkpoints);
+      ephemeris->oldest_trajectories_.push_back(std::move(trajectory));
+      trajectory = std::move(newest_trajectory);
+      ephemeris->trajectories_[i] = trajectory.get();
+    }
+    ephemeris->reanimating_ = true;
+    ephemeris->intervals_to_reanimate_ = message.checkpoint_size() - 1;
+  }
+  ephemeris->checkpointer_->ReadFromNewestCheckpoint();
 
   // Start a thread to asynchronously reconstruct the past using checkpoints.
-  ephemeris->reanimator_ =
-      MakeStoppableThread(std::bind(&Ephemeris::Reanimate, ephemeris.get()));
+  ephemeris->reanimation_thread_pool_ = reanimation_thread_pool;
+  ephemeris->reanimator_ = MakeStoppableThread(
+      std::bind(&Ephemeris::Reanimate, ephemeris.get(), newest_checkpoint));
 
   // The ephemeris will need to be prolonged as needed when deserializing the
   // plugin.
   return ephemeris;
 }
 
+template<typename Frame>
+void Ephemeris<Frame>::AwaitReanimation(Instant const& desired_t_min) const {
+  absl::MutexLock l(&lock_);
+  auto const reanimated = [this, &desired_t_min]() {
+    lock_.AssertReaderHeld();
+    return !reanimating_ || t_min_locked() <= desired_t_min;
+  };
+  lock_.Await(absl::Condition(&reanimated));
+}
+
+template<typename Frame>
+double Ephemeris<Frame>::reanimation_progress() const {
+  absl::ReaderMutexLock l(&lock_);
+  if (reanimating_) {
+    return static_cast<double>(reanimated_intervals_) /
+           std::max(1, intervals_to_reanimate_);
+  } else {
+    return 1;
+  }
+}
+
+template<typename Frame>
+Status Ephemeris<Frame>::WriteToCache(std::filesystem::path const& path,
+                                      std::uint64_t const fingerprint) const {
+  if constexpr (base::is_serializable_v<Frame>) {
+    // The trajectories are only serialized up to the oldest checkpoint; their
+    // polynomials up to the most recent checkpoint are written separately.
+    serialization::Ephemeris state;
+    WriteToMessage(&state);
+    CHECK_LT(0, state.checkpoint_size());
+    Instant const newest_checkpoint = Instant::ReadFromMessage(
+        state.checkpoint(state.checkpoint_size() - 1).time());
+
+    std::vector<
+        typename ContinuousTrajectory<Frame>::MappedPolynomials::Writer>
+        polynomials;
+    polynomials.reserve(trajectories_.size());
+    for (int i = 0; i < trajectories_.size(); ++i) {
+      RETURN_IF_STOPPED;
+      state.mutable_trajectory(i)->clear_instant_polynomial_pair();
+      polynomials.push_back(
+          trajectories_[i]->MakeMappedPolynomialsWriter(newest_checkpoint));
+    }
+    RETURN_IF_STOPPED;
+    return EphemerisCache<Frame>::Write(
+        path, CacheKey(fingerprint), state, polynomials);
+  } else {
+    return Status(Error::UNIMPLEMENTED, "Frame is not serializable");
+  }
+}
+
+template<typename Frame>
+bool Ephemeris<Frame>::ReadFromCache(std::filesystem::path const& path,
+                                     std::uint64_t const fingerprint) {
+  if constexpr (base::is_serializable_v<Frame>) {
+    auto const cache =
+        EphemerisCache<Frame>::Open(path, CacheKey(fingerprint));
+    if (cache == nullptr) {
+      return false;
+    }
+    serialization::Ephemeris const& state = cache->state();
+    if (state.checkpoint_size() == 0 ||
+        state.trajectory_size() != trajectories_.size()) {
+      return false;
+    }
+    auto const find_checkpoint = [](auto const& checkpoints,
+                                    Instant const& time) {
+      return std::find_if(checkpoints.begin(),
+                          checkpoints.end(),
+                          [&time](auto const& checkpoint) {
+                            return Instant::ReadFromMessage(
+                                       checkpoint.time()) == time;
+                          });
+    };
+
+    // The integration resumes at the most recent checkpoint of the cache,
+    // which must exist for all the trajectories.
+    auto const& newest_checkpoint =
+        state.checkpoint(state.checkpoint_size() - 1);
+    Instant const t_cache =
+        Instant::ReadFromMessage(newest_checkpoint.time());
+    std::vector<
+        not_null<serialization::ContinuousTrajectory::Checkpoint const*>>
+        trajectory_checkpoints;
+    for (auto const& trajectory : state.trajectory()) {
+      auto const it = find_checkpoint(trajectory.checkpoint(), t_cache);
+      if (it == trajectory.checkpoint().end() ||
+          !trajectory.has_first_time()) {
+        return false;
+      }
+      trajectory_checkpoints.push_back(&*it);
+    }
+
+    {
+      absl::ReaderMutexLock l(&lock_);
+      // The cache may only be used if this object has not been integrated
+      // since it was constructed or deserialized, i.e., if it is at its
+      // initial time or at its newest checkpoint.  Otherwise replacing its
+      // polynomials would lose information.
+      Instant const instance_time = instance_->time().value;
+      google::protobuf::RepeatedPtrField<serialization::Ephemeris::Checkpoint>
+          checkpoints;
+      checkpointer_->WriteToMessage(&checkpoints);
+      Instant const expected_instance_time =
+          checkpoints.empty()
+              ? Instant::ReadFromMessage(state.trajectory(0).first_time())
+              : Instant::ReadFromMessage(
+                    checkpoints[checkpoints.size() - 1].time());
+      if (instance_time != expected_instance_time) {
+        return false;
+      }
+      // The history covered by the cache must be the one of this object.
+      for (auto const& checkpoint : checkpoints) {
+        Instant const time = Instant::ReadFromMessage(checkpoint.time());
+        if (time > t_cache) {
+          break;
+        }
+        auto const it = find_checkpoint(state.checkpoint(), time);
+        if (it == state.checkpoint().end() ||
+            it->SerializeAsString() != checkpoint.SerializeAsString()) {
+          LOG(WARNING) << "Ephemeris cache " << path
+                       << " is inconsistent at " << time;
+          return false;
+        }
+      }
+    }
+
+    // The cache supersedes the reconstruction of the past, if any.
+    reanimator_ = jthread();
+    {
+      absl::MutexLock l(&lock_);
+      oldest_trajectories_.clear();
+    }
+
+    for (int i = 0; i < trajectories_.size(); ++i) {
+      trajectories_[i]->SetMappedPrefix(cache->polynomials(i),
+                                        *trajectory_checkpoints[i]);
+      trajectories_[i]->checkpointer().AddCheckpointsFromMessage(
+          state.trajectory(i).checkpoint());
+    }
+    checkpointer_->AddCheckpointsFromMessage(state.checkpoint());
+    CHECK_OK(MakeCheckpointerReader()(newest_checkpoint));
+    LOG(INFO) << "Read ephemeris cache " << path << " up to " << t_cache;
+    return true;
+  } else {
+    return false;
+  }
+}
+
 template<typename Frame>
 Ephemeris<Frame>::Guard::Guard(
     not_null<Ephemeris<Frame> const*> const ephemeris)
@@ -904,36 +1155,204 @@ Ephemeris<Frame>::MakeCheckpointerReader() {
 }
 
 template<typename Frame>
-Status Ephemeris<Frame>::Reanimate() {
-  std::vector<not_null<std::unique_ptr<ContinuousTrajectory<Frame>>>>
-      trajectories;
+Status Ephemeris<Frame>::Reanimate(Instant const& t_final) {
+  Status const status = ReanimateIntervals(t_final);
+  if (status.ok()) {
+    LOG(INFO) << "Reanimation complete";
+  } else {
+    LOG(WARNING) << "Reanimation stopped: " << status;
+  }
+  absl::MutexLock l(&lock_);
+  oldest_trajectories_.clear();
+  reanimating_ = false;
+  return status;
+}
 
-  auto append_massive_bodies_state =
-      [&trajectories](
-          typename NewtonianMotionEquation::SystemState const& state) {
-        AppendMassiveBodiesStateToTrajectories(state, trajectories);
-      };
+template<typename Frame>
+Status Ephemeris<Frame>::ReanimateIntervals(Instant const& t_final) {
+  // The checkpoints to reanimate, from the most recent to the oldest.  Note
+  // that |Prolong| may have created checkpoints after |t_final|.
+  std::vector<serialization::Ephemeris::Checkpoint> checkpoints;
+  RETURN_IF_ERROR(checkpointer_->ReadFromAllCheckpointsBackwards(
+      [&checkpoints, &t_final](
+          serialization::Ephemeris::Checkpoint const& checkpoint) {
+        if (Instant::ReadFromMessage(checkpoint.time()) <= t_final) {
+          checkpoints.push_back(checkpoint);
+        }
+        return Status::OK;
+      }));
+
+  // The interval |k| goes from |checkpoints[k + 1]| to |checkpoints[k]|.  The
+  // intervals are independent, so they may be reconstructed in parallel, but
+  // they must be prepended in order.  To bound the memory footprint and to
+  // leave threads of the pool to its other clients, at most |window| intervals
+  // are in flight at any time: interval |k + window| is started once interval
+  // |k| has been prepended.
+  using Trajectories =
+      std::vector<not_null<std::unique_ptr<ContinuousTrajectory<Frame>>>>;
+  std::int64_t const number_of_intervals = checkpoints.size() - 1;
+  std::int64_t const window =
+      reanimation_thread_pool_ == nullptr
+          ? 1
+          : std::max<std::int64_t>(1, std::thread::hardware_concurrency() / 2);
+  std::vector<std::shared_ptr<Trajectories>> intervals(number_of_intervals);
+  std::vector<std::future<Status>> statuses(number_of_intervals);
+  auto const stop_token = this_stoppable_thread::get_stop_token();
+  auto const reanimate_interval = [this, &checkpoints, &intervals, &statuses,
+                                   stop_token](std::int64_t const k) {
+    intervals[k] = std::make_shared<Trajectories>();
+    auto task = [this,
+                 &initial = checkpoints[k + 1],
+                 &final = checkpoints[k],
+                 trajectories = intervals[k],
+                 stop_token]() {
+      Status status;
+      CallWithStopToken(stop_token, [this, &initial, &final, &trajectories,
+                                     &status]() {
+        status = ReanimateInterval(initial, final, *trajectories);
+      });
+      return status;
+    };
+    if (reanimation_thread_pool_ == nullptr) {
+      std::promise<Status> promise;
+      promise.set_value(task());
+      statuses[k] = promise.get_future();
+    } else {
+      statuses[k] = reanimation_thread_pool_->Add(std::move(task));
+    }
+  };
 
-  auto reader = [this, &append_massive_bodies_state, &trajectories](
-                    serialization::Ephemeris::Checkpoint const& message) {
-    // Create or reset the trajectories.
-    for (int i = 0; i < trajectories_.size(); ++i) {
-      trajectories.emplace_back(
-            std::make_unique<ContinuousTrajectory<Frame>>(
-              fixed_step_parameters_.step_,
-              accuracy_parameters_.fitting_tolerance_));
+  std::int64_t started = 0;
+  Status status;
+  for (std::int64_t k = 0; k < number_of_intervals && status.ok(); ++k) {
+    for (; started < std::min(k + window, number_of_intervals); ++started) {
+      reanimate_interval(started);
+    }
+    status = statuses[k].get();
+    if (status.ok()) {
+      status = PrependToTrajectories(intervals[k]);
+    }
+    intervals[k].reset();
+    if (status.ok()) {
+      absl::MutexLock l(&lock_);
+      ++reanimated_intervals_;
+      LOG(INFO) << "Reanimated " << reanimated_intervals_ << " of "
+                << intervals_to_reanimate_ << " intervals, back to "
+                << Instant::ReadFromMessage(checkpoints[k + 1].time());
+    }
+  }
+  // The tasks refer to |checkpoints|, so we must wait for those in flight.
+  for (std::int64_t k = 0; k < started; ++k) {
+    if (statuses[k].valid()) {
+      statuses[k].wait();
     }
+  }
+  RETURN_IF_ERROR(status);
+
+  // Finally, prepend the trajectories that were deserialized.
+  auto const oldest_trajectories = std::make_shared<Trajectories>();
+  {
+    absl::MutexLock l(&lock_);
+    oldest_trajectories->swap(oldest_trajectories_);
+  }
+  return PrependToTrajectories(oldest_trajectories);
+}
+
+template<typename Frame>
+Status Ephemeris<Frame>::ReanimateInterval(
+    serialization::Ephemeris::Checkpoint const& initial,
+    serialization::Ephemeris::Checkpoint const& final,
+    std::vector<not_null<std::unique_ptr<ContinuousTrajectory<Frame>>>>&
+        trajectories) const {
+  RETURN_IF_STOPPED;
+  Instant const t_initial = Instant::ReadFromMessage(initial.time());
+  Instant const t_final = Instant::ReadFromMessage(final.time());
+
+  // Restore the trajectories at the initial checkpoint.
+  for (auto const& trajectory : trajectories_) {
+    auto& reanimated_trajectory = trajectories.emplace_back(
+        make_not_null_unique<ContinuousTrajectory<Frame>>(
+            fixed_step_parameters_.step_,
+            accuracy_parameters_.fitting_tolerance_));
+    RETURN_IF_ERROR(trajectory->ReadFromCheckpointAt(
+        t_initial, reanimated_trajectory.get()));
+  }
 
+  // The lock is only taken in shared mode, so that the intervals may be
+  // integrated concurrently.
+  NewtonianMotionEquation equation;
+  equation.compute_acceleration =
+      [this](Instant const& t,
+             std::vector<Position<Frame>> const& positions,
+             std::vector<Vector<Acceleration, Frame>>& accelerations) {
+        absl::ReaderMutexLock l(&lock_);
+        ComputeMassiveBodiesGravitationalAccelerations(t,
+                                                       positions,
+                                                       accelerations);
+        return Status::OK;
+      };
+  auto const instance =
+      FixedStepSizeIntegrator<NewtonianMotionEquation>::Instance::
+          ReadFromMessage(
+              initial.instance(),
+              equation,
+              [&trajectories](
+                  typename NewtonianMotionEquation::SystemState const& state) {
+                AppendMassiveBodiesStateToTrajectories(state, trajectories);
+              });
+
+  // Integrate by chunks so as to be able to stop.  The trajectories must end
+  // exactly at the final checkpoint for the prepending to work.
+  Time const chunk = 1000 * fixed_step_parameters_.step_;
+  for (Instant t = t_initial + chunk; t < t_final; t += chunk) {
     RETURN_IF_STOPPED;
-    auto instance = FixedStepSizeIntegrator<NewtonianMotionEquation>::Instance::
-        ReadFromMessage(message.instance(),
-                        MakeMassiveBodiesNewtonianMotionEquation(),
-                        append_massive_bodies_state);
+    RETURN_IF_ERROR(instance->Solve(t));
+  }
+  RETURN_IF_STOPPED;
+  RETURN_IF_ERROR(instance->Solve(t_final));
+  CHECK_EQ(t_final, instance->time().value);
+  return Status::OK;
+}
 
-    return Status::OK;
-  };
+template<typename Frame>
+Status Ephemeris<Frame>::PrependToTrajectories(
+    std::shared_ptr<std::vector<
+        not_null<std::unique_ptr<ContinuousTrajectory<Frame>>>>> const&
+        trajectories) {
+  // The callback may run on another thread, after this function has returned
+  // if the thread is stopped.  It does nothing once the reanimation is over.
+  auto const prepended = std::make_shared<absl::Notification>();
+  protector_->RunWhenUnprotected(
+      t_min(),
+      [this, trajectories, prepended]() {
+        {
+          absl::MutexLock l(&lock_);
+          if (reanimating_) {
+            for (int i = 0; i < trajectories_.size(); ++i) {
+              trajectories_[i]->Prepend(std::move(*(*trajectories)[i]));
+            }
+          }
+        }
+        prepended->Notify();
+      });
+  while (!prepended->WaitForNotificationWithTimeout(absl::Milliseconds(100))) {
+    RETURN_IF_STOPPED;
+  }
+  return Status::OK;
+}
 
-  return checkpointer_->ReadFromAllCheckpointsBackwards(reader);
+template<typename Frame>
+std::uint64_t Ephemeris<Frame>::CacheKey(
+    std::uint64_t const fingerprint) const {
+  serialization::Ephemeris message;
+  for (auto const& unowned_body : unowned_bodies_) {
+    unowned_body->WriteToMessage(message.add_body());
+  }
+  fixed_step_parameters_.WriteToMessage(
+      message.mutable_fixed_step_parameters());
+  accuracy_parameters_.WriteToMessage(message.mutable_accuracy_parameters());
+  return FingerprintCat2011(fingerprint,
+                            Fingerprint2011(SerializeAsBytes(message).get()));
 }
 
 template<typename Frame>
@@ -1025,6 +1444,69 @@ Instant Ephemeris<Frame>::t_min_locked() const {
   return t_min;
 }
 
+template<typename Frame>
+template<bool body1_is_oblate, bool body2_is_oblate>
+typename Ephemeris<Frame>::PairwiseAccelerations
+Ephemeris<Frame>::ComputePairwiseAccelerations(
+    Instant const& t,
+    MassiveBody const& body1,
+    std::size_t const b1,
+    MassiveBody const& body2,
+    std::size_t const b2,
+    std::vector<Position<Frame>> const& positions,
+    std::vector<Geopotential<Frame>> const& geopotentials) {
+  PairwiseAccelerations pair;
+  GravitationalParameter const& μ1 = body1.gravitational_parameter();
+  GravitationalParameter const& μ2 = body2.gravitational_parameter();
+
+  // A vector from the center of |b2| to the center of |b1|.
+  Displacement<Frame> const Δq = positions[b1] - positions[b2];
+
+  Square<Length> const Δq² = Δq.Norm²();
+  Length const Δq_norm = Sqrt(Δq²);
+  Exponentiation<Length, -3> const one_over_Δq³ = Δq_norm / (Δq² * Δq²);
+
+  auto const μ1_over_Δq³ = μ1 * one_over_Δq³;
+  pair.on_body2[pair.size] = Δq * μ1_over_Δq³;
+
+  // [New87], Lex. III. Actioni contrariam semper & æqualem esse reactionem:
+  // sive corporum duorum actiones in se mutuo semper esse æquales &
+  // in partes contrarias dirigi.
+  auto const μ2_over_Δq³ = μ2 * one_over_Δq³;
+  pair.on_body1[pair.size] = -(Δq * μ2_over_Δq³);
+  ++pair.size;
+
+  if (body1_is_oblate) {
+    Vector<Quotient<Acceleration,
+                    GravitationalParameter>, Frame> const
+        degree_2_zonal_effect1 =
+            geopotentials[b1].GeneralSphericalHarmonicsAcceleration(
+                t,
+                -Δq,
+                Δq_norm,
+                Δq²,
+                one_over_Δq³);
+    pair.on_body1[pair.size] = -(μ2 * degree_2_zonal_effect1);
+    pair.on_body2[pair.size] = μ1 * degree_2_zonal_effect1;
+    ++pair.size;
+  }
+  if (body2_is_oblate) {
+    Vector<Quotient<Acceleration,
+                    GravitationalParameter>, Frame> const
+        degree_2_zonal_effect2 =
+            geopotentials[b2].GeneralSphericalHarmonicsAcceleration(
+                t,
+                Δq,
+                Δq_norm,
+                Δq²,
+                one_over_Δq³);
+    pair.on_body1[pair.size] = μ2 * degree_2_zonal_effect2;
+    pair.on_body2[pair.size] = -(μ1 * degree_2_zonal_effect2);
+    ++pair.size;
+  }
+  return pair;
+}
+
 template<typename Frame>
 template<bool body1_is_oblate,
          bool body2_is_oblate,
@@ -1040,57 +1522,15 @@ void Ephemeris<Frame>::
         std::vector<Position<Frame>> const& positions,
         std::vector<Vector<Acceleration, Frame>>& accelerations,
         std::vector<Geopotential<Frame>> const& geopotentials) {
-  Position<Frame> const& position_of_b1 = positions[b1];
   Vector<Acceleration, Frame>& acceleration_on_b1 = accelerations[b1];
-  GravitationalParameter const& μ1 = body1.gravitational_parameter();
   for (std::size_t b2 = b2_begin; b2 < b2_end; ++b2) {
     Vector<Acceleration, Frame>& acceleration_on_b2 = accelerations[b2];
-    MassiveBody const& body2 = *bodies2[b2];
-    GravitationalParameter const& μ2 = body2.gravitational_parameter();
-
-    // A vector from the center of |b2| to the center of |b1|.
-    Displacement<Frame> const Δq = position_of_b1 - positions[b2];
-
-    Square<Length> const Δq² = Δq.Norm²();
-    Length const Δq_norm = Sqrt(Δq²);
-    Exponentiation<Length, -3> const one_over_Δq³ = Δq_norm / (Δq² * Δq²);
-
-    auto const μ1_over_Δq³ = μ1 * one_over_Δq³;
-    acceleration_on_b2 += Δq * μ1_over_Δq³;
-
-    // [New87], Lex. III. Actioni contrariam semper & æqualem esse reactionem:
-    // sive corporum duorum actiones in se mutuo semper esse æquales &
-    // in partes contrarias dirigi.
-    auto const μ2_over_Δq³ = μ2 * one_over_Δq³;
-    acceleration_on_b1 -= Δq * μ2_over_Δq³;
-
-    if (body1_is_oblate || body2_is_oblate) {
-      if (body1_is_oblate) {
-        Vector<Quotient<Acceleration,
-                        GravitationalParameter>, Frame> const
-            degree_2_zonal_effect1 =
-                geopotentials[b1].GeneralSphericalHarmonicsAcceleration(
-                    t,
-                    -Δq,
-                    Δq_norm,
-                    Δq²,
-                    one_over_Δq³);
-        acceleration_on_b1 -= μ2 * degree_2_zonal_effect1;
-        acceleration_on_b2 += μ1 * degree_2_zonal_effect1;
-      }
-      if (body2_is_oblate) {
-        Vector<Quotient<Acceleration,
-                        GravitationalParameter>, Frame> const
-            degree_2_zonal_effect2 =
-                geopotentials[b2].GeneralSphericalHarmonicsAcceleration(
-                    t,
-                    Δq,
-                    Δq_norm,
-                    Δq²,
-                    one_over_Δq³);
-        acceleration_on_b1 += μ2 * degree_2_zonal_effect2;
-        acceleration_on_b2 -= μ1 * degree_2_zonal_effect2;
-      }
+    PairwiseAccelerations const pair =
+        ComputePairwiseAccelerations<body1_is_oblate, body2_is_oblate>(
+            t, body1, b1, *bodies2[b2], b2, positions, geopotentials);
+    for (int i = 0; i < pair.size; ++i) {
+      acceleration_on_b1 += pair.on_body1[i];
+      acceleration_on_b2 += pair.on_body2[i];
     }
   }
 }
@@ -1112,6 +1552,23 @@ ComputeGravitationalAccelerationByMassiveBodyOnMasslessBodies(
       min_radius_tolerance * body1.min_radius();
   Error error = Error::OK;
 
+  // The arguments of the geopotential, which is evaluated for all the massless
+  // bodies in one call so that its per-instant work is shared.  Per-thread
+  // because this function may be called concurrently by multiple integrations.
+  thread_local std::vector<Displacement<Frame>> minus_Δqs;
+  thread_local std::vector<Length> Δq_norms;
+  thread_local std::vector<Square<Length>> Δq²s;
+  thread_local std::vector<Exponentiation<Length, -3>> one_over_Δq³s;
+  thread_local std::vector<
+      Vector<Quotient<Acceleration, GravitationalParameter>, Frame>>
+      degree_2_zonal_effects1;
+  if constexpr (body1_is_oblate) {
+    minus_Δqs.resize(positions.size());
+    Δq_norms.resize(positions.size());
+    Δq²s.resize(positions.size());
+    one_over_Δq³s.resize(positions.size());
+  }
+
   for (std::size_t b2 = 0; b2 < positions.size(); ++b2) {
     // A vector from the center of |b2| to the center of |b1|.
     Displacement<Frame> const Δq = position1 - positions[b2];
@@ -1125,17 +1582,24 @@ ComputeGravitationalAccelerationByMassiveBodyOnMasslessBodies(
     auto const μ1_over_Δq³ = μ1 * one_over_Δq³;
     accelerations[b2] += Δq * μ1_over_Δq³;
 
-    if (body1_is_oblate) {
-      Vector<Quotient<Acceleration,
-                      GravitationalParameter>, Frame> const
-          degree_2_zonal_effect1 =
-              geopotentials_[b1].GeneralSphericalHarmonicsAcceleration(
-                  t,
-                  -Δq,
-                  Δq_norm,
-                  Δq²,
-                  one_over_Δq³);
-      accelerations[b2] += μ1 * degree_2_zonal_effect1;
+    if constexpr (body1_is_oblate) {
+      minus_Δqs[b2] = -Δq;
+      Δq_norms[b2] = Δq_norm;
+      Δq²s[b2] = Δq²;
+      one_over_Δq³s[b2] = one_over_Δq³;
+    }
+  }
+
+  if constexpr (body1_is_oblate) {
+    geopotentials_[b1].GeneralSphericalHarmonicsAccelerations(
+        t,
+        minus_Δqs,
+        Δq_norms,
+        Δq²s,
+        one_over_Δq³s,
+        degree_2_zonal_effects1);
+    for (std::size_t b2 = 0; b2 < positions.size(); ++b2) {
+      accelerations[b2] += μ1 * degree_2_zonal_effects1[b2];
     }
   }
   return error;
@@ -1147,6 +1611,11 @@ void Ephemeris<Frame>::ComputeMassiveBodiesGravitationalAccelerations(
     std::vector<Position<Frame>> const& positions,
     std::vector<Vector<Acceleration, Frame>>& accelerations) const {
   lock_.AssertReaderHeld();
+  if (massive_bodies_thread_pool_ != nullptr) {
+    ComputeMassiveBodiesGravitationalAccelerationsInParallel(
+        t, positions, accelerations);
+    return;
+  }
   accelerations.assign(accelerations.size(), Vector<Acceleration, Frame>());
 
   for (std::size_t b1 = 0; b1 < number_of_oblate_bodies_; ++b1) {
@@ -1187,6 +1656,64 @@ void Ephemeris<Frame>::ComputeMassiveBodiesGravitationalAccelerations(
   }
 }
 
+template<typename Frame>
+void Ephemeris<Frame>::ComputeMassiveBodiesGravitationalAccelerationsInParallel(
+    Instant const& t,
+    std::vector<Position<Frame>> const& positions,
+    std::vector<Vector<Acceleration, Frame>>& accelerations) const {
+  lock_.AssertReaderHeld();
+  std::size_t const number_of_oblate_bodies = number_of_oblate_bodies_;
+  std::size_t const number_of_bodies =
+      number_of_oblate_bodies_ + number_of_spherical_bodies_;
+
+  // The pairs (b1, b2) with b1 < b2, in lexicographic order.  Each task fills a
+  // row, i.e., the pairs with a given b1.  The rows get shorter as b1
+  // increases, and the oblate bodies come first, so the most expensive tasks
+  // are submitted first.
+  std::vector<PairwiseAccelerations> pairs(
+      number_of_bodies * (number_of_bodies - 1) / 2);
+  auto batch = massive_bodies_thread_pool_->NewBatch();
+  batch.Reserve(number_of_bodies);
+  std::size_t row_begin = 0;
+  for (std::size_t b1 = 0; b1 < number_of_bodies; ++b1) {
+    batch.Add([this, b1, number_of_bodies, number_of_oblate_bodies,
+               pair = pairs.data() + row_begin, &t, &positions]() mutable {
+      MassiveBody const& body1 = *bodies_[b1];
+      for (std::size_t b2 = b1 + 1; b2 < number_of_bodies; ++b2, ++pair) {
+        MassiveBody const& body2 = *bodies_[b2];
+        if (b2 < number_of_oblate_bodies) {
+          *pair = ComputePairwiseAccelerations</*body1_is_oblate=*/true,
+                                               /*body2_is_oblate=*/true>(
+              t, body1, b1, body2, b2, positions, geopotentials_);
+        } else if (b1 < number_of_oblate_bodies) {
+          *pair = ComputePairwiseAccelerations</*body1_is_oblate=*/true,
+                                               /*body2_is_oblate=*/false>(
+              t, body1, b1, body2, b2, positions, geopotentials_);
+        } else {
+          *pair = ComputePairwiseAccelerations</*body1_is_oblate=*/false,
+                                               /*body2_is_oblate=*/false>(
+              t, body1, b1, body2, b2, positions, geopotentials_);
+        }
+      }
+    });
+    row_begin += number_of_bodies - b1 - 1;
+  }
+  batch.SubmitAndJoin();
+
+  // Sum the contributions in the order of the sequential computation.  This is
+  // cheap compared to the computation of the pairs.
+  accelerations.assign(accelerations.size(), Vector<Acceleration, Frame>());
+  auto pair = pairs.cbegin();
+  for (std::size_t b1 = 0; b1 < number_of_bodies; ++b1) {
+    for (std::size_t b2 = b1 + 1; b2 < number_of_bodies; ++b2, ++pair) {
+      for (int i = 0; i < pair->size; ++i) {
+        accelerations[b1] += pair->on_body1[i];
+        accelerations[b2] += pair->on_body2[i];
+      }
+    }
+  }
+}
+
 template<typename Frame>
 Error Ephemeris<Frame>::ComputeMasslessBodiesGravitationalAccelerations(
     Instant const& t,
@@ -1207,17 +1734,24 @@ Error Ephemeris<Frame>::ComputeMasslessBodiesGravitationalAccelerations(
                  positions,
                  accelerations);
   }
-  for (std::size_t b1 = number_of_oblate_bodies_;
-       b1 < number_of_oblate_bodies_ +
-            number_of_spherical_bodies_;
-       ++b1) {
-    MassiveBody const& body1 = *bodies_[b1];
-    error |= ComputeGravitationalAccelerationByMassiveBodyOnMasslessBodies<
-                 /*body1_is_oblate=*/false>(
-                 t,
-                 body1, b1,
-                 positions,
-                 accelerations);
+  if (number_of_spherical_bodies_ > 0) {
+    // The spherical bodies are processed on a structure-of-arrays
+    // representation of the massless bodies, which makes it possible to
+    // vectorize across massless bodies.  The workspace is per-thread because
+    // this function may be called concurrently by multiple integrations.
+    thread_local MasslessBodiesAccelerations<Frame> massless_bodies;
+    massless_bodies.Load(positions, accelerations);
+    for (std::size_t b1 = number_of_oblate_bodies_;
+         b1 < number_of_oblate_bodies_ +
+              number_of_spherical_bodies_;
+         ++b1) {
+      MassiveBody const& body1 = *bodies_[b1];
+      error |= massless_bodies.AddSphericalBodyAccelerations(
+                   trajectories_[b1]->EvaluatePosition(t),
+                   body1.gravitational_parameter(),
+                   min_radius_tolerance * body1.min_radius());
+    }
+    massless_bodies.Store(accelerations);
   }
   return error;
 }
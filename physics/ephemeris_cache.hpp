@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "base/array.hpp"
+#include "base/mapped_file.hpp"
+#include "base/not_null.hpp"
+#include "base/status.hpp"
+#include "physics/continuous_trajectory.hpp"
+#include "serialization/physics.pb.h"
+
+namespace principia {
+namespace physics {
+namespace internal_ephemeris_cache {
+
+using base::Array;
+using base::MappedFile;
+using base::not_null;
+using base::Status;
+
+// A file containing the polynomials of the trajectories of an ephemeris up to
+// some time, together with the state needed to resume the integration at that
+// time.  The polynomials are stored as flat arrays of doubles and are evaluated
+// directly from a memory mapping of the file, so that opening a cache is
+// essentially free, whatever its size.  The file has a header identifying its
+// format and its |key|, followed by the serialized |state| and by the
+// polynomials of each trajectory, all aligned on 8 bytes.
+// The file is not portable across architectures with different endianness,
+// which is fine since it is only a cache.
+template<typename Frame>
+class EphemerisCache final {
+ public:
+  using MappedPolynomials =
+      typename ContinuousTrajectory<Frame>::MappedPolynomials;
+
+  // Writes a cache to |path|.  The file is first written under a temporary
+  // name and then renamed, so that a cache is either complete or absent.
+  // Returns an error if the file cannot be written.
+  static Status Write(
+      std::filesystem::path const& path,
+      std::uint64_t key,
+      serialization::Ephemeris const& state,
+      std::vector<typename MappedPolynomials::Writer> const& polynomials);
+
+  // Returns null if there is no cache at |path|, or if it has an unexpected
+  // format or a different |key|.
+  static std::unique_ptr<EphemerisCache> Open(
+      std::filesystem::path const& path,
+      std::uint64_t key);
+
+  // The state of the ephemeris at the end of the cache.  The trajectories have
+  // checkpoints but no polynomials.
+  serialization::Ephemeris const& state() const;
+
+  // The polynomials of the trajectory with the given serialization |index|.
+  // They keep the file mapped as long as they are alive.
+  not_null<std::shared_ptr<MappedPolynomials const>> polynomials(
+      int index) const;
+
+ private:
+  EphemerisCache(std::shared_ptr<MappedFile const> file,
+                 serialization::Ephemeris state,
+                 std::vector<Array<std::uint8_t const>> trajectories);
+
+  std::shared_ptr<MappedFile const> const file_;
+  serialization::Ephemeris const state_;
+  std::vector<Array<std::uint8_t const>> const trajectories_;
+};
+
+}  // namespace internal_ephemeris_cache
+
+using internal_ephemeris_cache::EphemerisCache;
+
+}  // namespace physics
+}  // namespace principia
+
+#include "physics/ephemeris_cache_body.hpp"
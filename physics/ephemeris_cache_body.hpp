@@ -0,0 +1,194 @@
+#pragma once
+
+#include "physics/ephemeris_cache.hpp"
+
+#include <fstream>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "glog/logging.h"
+
+namespace principia {
+namespace physics {
+namespace internal_ephemeris_cache {
+
+using base::Error;
+
+// "PRINEPHC" when written in little-endian order.
+constexpr std::uint64_t magic = 0x4348'5045'4E49'5250;
+// To be incremented whenever the layout of the file changes.
+constexpr std::uint64_t format_version = 1;
+
+// The header is made of these words, followed by the offset and size of the
+// polynomials of each trajectory.
+constexpr int magic_index = 0;
+constexpr int format_version_index = 1;
+constexpr int key_index = 2;
+constexpr int state_offset_index = 3;
+constexpr int state_size_index = 4;
+constexpr int number_of_trajectories_index = 5;
+constexpr int first_trajectory_index = 6;
+
+inline std::uint64_t RoundUpToWord(std::uint64_t const size) {
+  return (size + sizeof(std::uint64_t) - 1) & ~(sizeof(std::uint64_t) - 1);
+}
+
+template<typename Frame>
+Status EphemerisCache<Frame>::Write(
+    std::filesystem::path const& path,
+    std::uint64_t const key,
+    serialization::Ephemeris const& state,
+    std::vector<typename MappedPolynomials::Writer> const& polynomials) {
+  std::string const serialized_state = state.SerializeAsString();
+
+  std::vector<std::uint64_t> header(
+      first_trajectory_index + 2 * polynomials.size());
+  header[magic_index] = magic;
+  header[format_version_index] = format_version;
+  header[key_index] = key;
+  std::uint64_t offset = header.size() * sizeof(std::uint64_t);
+  header[state_offset_index] = offset;
+  header[state_size_index] = serialized_state.size();
+  offset += RoundUpToWord(serialized_state.size());
+  header[number_of_trajectories_index] = polynomials.size();
+  for (int i = 0; i < polynomials.size(); ++i) {
+    std::uint64_t const size = polynomials[i].size_in_bytes();
+    header[first_trajectory_index + 2 * i] = offset;
+    header[first_trajectory_index + 2 * i + 1] = size;
+    offset += size;
+  }
+
+  std::error_code error;
+  std::filesystem::create_directories(path.parent_path(), error);
+  std::filesystem::path temporary_path = path;
+  temporary_path += ".tmp";
+  {
+    std::ofstream stream(temporary_path,
+                         std::ios::binary | std::ios::trunc);
+    if (!stream) {
+      return Status(Error::UNAVAILABLE,
+                    "Cannot create " + temporary_path.string());
+    }
+    stream.write(reinterpret_cast<char const*>(header.data()),
+                 header.size() * sizeof(std::uint64_t));
+    stream.write(serialized_state.data(), serialized_state.size());
+    std::string const padding(
+        RoundUpToWord(serialized_state.size()) - serialized_state.size(), '\0');
+    stream.write(padding.data(), padding.size());
+    for (auto const& writer : polynomials) {
+      writer.WriteTo(stream);
+    }
+    stream.close();
+    if (!stream) {
+      std::filesystem::remove(temporary_path, error);
+      return Status(Error::UNAVAILABLE,
+                    "Cannot write " + temporary_path.string());
+    }
+  }
+  std::filesystem::rename(temporary_path, path, error);
+  if (error) {
+    std::filesystem::remove(temporary_path, error);
+    return Status(Error::UNAVAILABLE, "Cannot rename to " + path.string());
+  }
+  return Status::OK;
+}
+
+template<typename Frame>
+std::unique_ptr<EphemerisCache<Frame>> EphemerisCache<Frame>::Open(
+    std::filesystem::path const& path,
+    std::uint64_t const key) {
+  std::shared_ptr<MappedFile const> file = MappedFile::Open(path);
+  if (file == nullptr) {
+    return nullptr;
+  }
+  Array<std::uint8_t const> const bytes = file->bytes();
+  std::uint64_t const file_size = bytes.size;
+  auto const* const header = reinterpret_cast<std::uint64_t const*>(bytes.data);
+  auto const header_size = [](std::uint64_t const number_of_trajectories) {
+    return (first_trajectory_index + 2 * number_of_trajectories) *
+           sizeof(std::uint64_t);
+  };
+  // Returns the given region of the file, or nothing if it is out of bounds or
+  // misaligned.
+  auto const region = [&bytes, file_size](std::uint64_t const offset,
+                                          std::uint64_t const size)
+      -> std::optional<Array<std::uint8_t const>> {
+    if (offset % sizeof(std::uint64_t) != 0 || offset > file_size ||
+        size > file_size - offset) {
+      return std::nullopt;
+    }
+    return Array<std::uint8_t const>(bytes.data + offset, size);
+  };
+
+  if (file_size < header_size(0) ||
+      header[magic_index] != magic ||
+      header[format_version_index] != format_version) {
+    LOG(WARNING) << "Unexpected format for ephemeris cache " << path;
+    return nullptr;
+  }
+  if (header[key_index] != key) {
+    LOG(INFO) << "Ephemeris cache " << path << " has a different key";
+    return nullptr;
+  }
+  std::uint64_t const number_of_trajectories =
+      header[number_of_trajectories_index];
+  if (number_of_trajectories > file_size ||
+      file_size < header_size(number_of_trajectories)) {
+    LOG(WARNING) << "Truncated ephemeris cache " << path;
+    return nullptr;
+  }
+
+  serialization::Ephemeris state;
+  auto const serialized_state =
+      region(header[state_offset_index], header[state_size_index]);
+  if (!serialized_state.has_value() ||
+      !state.ParseFromArray(serialized_state->data, serialized_state->size) ||
+      state.trajectory_size() !=
+          static_cast<std::int64_t>(number_of_trajectories)) {
+    LOG(WARNING) << "Invalid state in ephemeris cache " << path;
+    return nullptr;
+  }
+
+  std::vector<Array<std::uint8_t const>> trajectories;
+  for (int i = 0; i < number_of_trajectories; ++i) {
+    auto const trajectory =
+        region(header[first_trajectory_index + 2 * i],
+               header[first_trajectory_index + 2 * i + 1]);
+    if (!trajectory.has_value()) {
+      LOG(WARNING) << "Invalid trajectory " << i << " in ephemeris cache "
+                   << path;
+      return nullptr;
+    }
+    trajectories.push_back(*trajectory);
+  }
+
+  return std::unique_ptr<EphemerisCache>(new EphemerisCache(
+      std::move(file), std::move(state), std::move(trajectories)));
+}
+
+template<typename Frame>
+serialization::Ephemeris const& EphemerisCache<Frame>::state() const {
+  return state_;
+}
+
+template<typename Frame>
+auto EphemerisCache<Frame>::polynomials(int const index) const
+    -> not_null<std::shared_ptr<MappedPolynomials const>> {
+  return std::make_shared<MappedPolynomials const>(file_,
+                                                   trajectories_.at(index));
+}
+
+template<typename Frame>
+EphemerisCache<Frame>::EphemerisCache(
+    std::shared_ptr<MappedFile const> file,
+    serialization::Ephemeris state,
+    std::vector<Array<std::uint8_t const>> trajectories)
+    : file_(std::move(file)),
+      state_(std::move(state)),
+      trajectories_(std::move(trajectories)) {}
+
+}  // namespace internal_ephemeris_cache
+}  // namespace physics
+}  // namespace principia
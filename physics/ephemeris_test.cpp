@@ -1,6 +1,8 @@
 ﻿
 #include "physics/ephemeris.hpp"
 
+#include <cstdint>
+#include <filesystem>
 #include <limits>
 #include <map>
 #include <optional>
@@ -10,6 +12,7 @@
 
 #include "astronomy/frames.hpp"
 #include "base/macros.hpp"
+#include "base/thread_pool.hpp"
 #include "geometry/barycentre_calculator.hpp"
 #include "geometry/frame.hpp"
 #include "gipfeli/gipfeli.h"
@@ -46,7 +49,9 @@ namespace physics {
 namespace internal_ephemeris {
 
 using astronomy::ICRS;
+using astronomy::InfinitePast;
 using base::not_null;
+using base::ThreadPool;
 using geometry::Barycentre;
 using geometry::AngularVelocity;
 using geometry::Displacement;
@@ -74,6 +79,7 @@ using quantities::astronomy::JulianYear;
 using quantities::astronomy::SolarGravitationalParameter;
 using quantities::astronomy::TerrestrialEquatorialRadius;
 using quantities::astronomy::TerrestrialPolarRadius;
+using quantities::si::Day;
 using quantities::si::Hour;
 using quantities::si::Kilo;
 using quantities::si::Kilogram;
@@ -629,7 +635,9 @@ TEST_P(EphemerisTest, Serialization) {
   ephemeris.WriteToMessage(&message);
 
   auto const ephemeris_read = Ephemeris<ICRS>::ReadFromMessage(message);
-  // After deserialization, the client must prolong as needed.
+  // After deserialization, the client must await the reconstruction of the past
+  // and prolong as needed.
+  ephemeris_read->AwaitReanimation(InfinitePast);
   ephemeris_read->Prolong(ephemeris.t_max());
 
   MassiveBody const* const earth_read = ephemeris_read->bodies()[0];
@@ -1091,6 +1099,167 @@ TEST(EphemerisTestNoFixture, DiscreteTrajectoryCompression) {
 }
 #endif
 
+// Checks that the parallel computation of the accelerations between massive
+// bodies doesn't change the results, even in the presence of oblate bodies.
+TEST(EphemerisTestNoFixture, ParallelProlong) {
+  SolarSystem<ICRS> solar_system(
+      SOLUTION_DIR / "astronomy" / "sol_gravity_model.proto.txt",
+      SOLUTION_DIR / "astronomy" /
+          "sol_initial_state_jd_2433282_500000000.proto.txt");
+  auto const make_ephemeris = [&solar_system]() {
+    return solar_system.MakeEphemeris(
+        /*accuracy_parameters=*/{/*fitting_tolerance=*/1 * Milli(Metre),
+                                 /*geopotential_tolerance=*/0x1p-24},
+        /*fixed_step_parameters=*/{
+            SymmetricLinearMultistepIntegrator<QuinlanTremaine1990Order12,
+                                               Position<ICRS>>(),
+            /*step=*/10 * Minute});
+  };
+  auto const sequential_ephemeris = make_ephemeris();
+  auto const parallel_ephemeris = make_ephemeris();
+  ThreadPool<void> pool(/*pool_size=*/4);
+  parallel_ephemeris->SetMassiveBodiesThreadPool(&pool);
+
+  Instant const t = solar_system.epoch() + 30 * Day;
+  sequential_ephemeris->Prolong(t);
+  parallel_ephemeris->Prolong(t);
+  parallel_ephemeris->SetMassiveBodiesThreadPool(nullptr);
+
+  for (auto const& name : solar_system.names()) {
+    EXPECT_EQ(
+        solar_system.trajectory(*sequential_ephemeris, name)
+            .EvaluateDegreesOfFreedom(t),
+        solar_system.trajectory(*parallel_ephemeris, name)
+            .EvaluateDegreesOfFreedom(t)) << name;
+  }
+}
+
+// Checks that the parallel serialization of the trajectories yields the same
+// message as the sequential one.
+TEST(EphemerisTestNoFixture, ParallelSerialization) {
+  SolarSystem<ICRS> solar_system(
+      SOLUTION_DIR / "astronomy" / "sol_gravity_model.proto.txt",
+      SOLUTION_DIR / "astronomy" /
+          "sol_initial_state_jd_2433282_500000000.proto.txt");
+  auto const ephemeris = solar_system.MakeEphemeris(
+      /*accuracy_parameters=*/{/*fitting_tolerance=*/1 * Milli(Metre),
+                               /*geopotential_tolerance=*/0x1p-24},
+      /*fixed_step_parameters=*/{
+          SymmetricLinearMultistepIntegrator<QuinlanTremaine1990Order12,
+                                             Position<ICRS>>(),
+          /*step=*/10 * Minute});
+  ephemeris->Prolong(solar_system.epoch() + 1 * Day);
+
+  serialization::Ephemeris sequential_message;
+  ephemeris->WriteToMessage(&sequential_message);
+  ThreadPool<Status> pool(/*pool_size=*/4);
+  serialization::Ephemeris parallel_message;
+  ephemeris->WriteToMessage(&parallel_message, pool);
+  EXPECT_THAT(parallel_message, EqualsProto(sequential_message));
+}
+
+// Checks that an ephemeris restored from a cache yields the same results as
+// the one that wrote the cache, both over the cached interval and after further
+// integration.
+TEST(EphemerisTestNoFixture, Cache) {
+  SolarSystem<ICRS> solar_system(
+      SOLUTION_DIR / "astronomy" / "sol_gravity_model.proto.txt",
+      SOLUTION_DIR / "astronomy" /
+          "sol_initial_state_jd_2433282_500000000.proto.txt");
+  auto const make_ephemeris = [&solar_system]() {
+    return solar_system.MakeEphemeris(
+        /*accuracy_parameters=*/{/*fitting_tolerance=*/1 * Milli(Metre),
+                                 /*geopotential_tolerance=*/0x1p-24},
+        /*fixed_step_parameters=*/{
+            SymmetricLinearMultistepIntegrator<QuinlanTremaine1990Order12,
+                                               Position<ICRS>>(),
+            /*step=*/10 * Minute});
+  };
+  std::filesystem::path const path = TEMP_DIR / "ephemeris_cache.generated";
+  std::uint64_t const fingerprint = 0xC0FFEE;
+
+  auto const original_ephemeris = make_ephemeris();
+  original_ephemeris->Prolong(solar_system.epoch() + 400 * Day);
+  EXPECT_OK(original_ephemeris->WriteToCache(path, fingerprint));
+
+  // A cache with a different fingerprint is ignored.
+  auto const cached_ephemeris = make_ephemeris();
+  EXPECT_FALSE(cached_ephemeris->ReadFromCache(path, fingerprint + 1));
+  EXPECT_TRUE(cached_ephemeris->ReadFromCache(path, fingerprint));
+  // The cache extends to the most recent checkpoint.
+  EXPECT_LT(solar_system.epoch() + 300 * Day, cached_ephemeris->t_max());
+  EXPECT_GE(original_ephemeris->t_max(), cached_ephemeris->t_max());
+
+  Instant const t_final = solar_system.epoch() + 500 * Day;
+  original_ephemeris->Prolong(t_final);
+  cached_ephemeris->Prolong(t_final);
+  for (auto const& name : solar_system.names()) {
+    for (Instant t = solar_system.epoch(); t <= t_final; t += 7 * Day) {
+      EXPECT_EQ(
+          solar_system.trajectory(*original_ephemeris, name)
+              .EvaluateDegreesOfFreedom(t),
+          solar_system.trajectory(*cached_ephemeris, name)
+              .EvaluateDegreesOfFreedom(t)) << name << " " << t;
+    }
+  }
+
+  // The restored ephemeris serializes like the original one.
+  serialization::Ephemeris original_message;
+  original_ephemeris->WriteToMessage(&original_message);
+  serialization::Ephemeris cached_message;
+  cached_ephemeris->WriteToMessage(&cached_message);
+  EXPECT_THAT(cached_message, EqualsProto(original_message));
+
+  std::filesystem::remove(path);
+}
+
+// Checks that the past of a deserialized ephemeris, which is reconstructed in
+// parallel from its checkpoints, is identical to that of the original one.
+TEST(EphemerisTestNoFixture, Reanimation) {
+  SolarSystem<ICRS> solar_system(
+      SOLUTION_DIR / "astronomy" / "sol_gravity_model.proto.txt",
+      SOLUTION_DIR / "astronomy" /
+          "sol_initial_state_jd_2433282_500000000.proto.txt");
+  auto const ephemeris = solar_system.MakeEphemeris(
+      /*accuracy_parameters=*/{/*fitting_tolerance=*/1 * Milli(Metre),
+                               /*geopotential_tolerance=*/0x1p-24},
+      /*fixed_step_parameters=*/{
+          SymmetricLinearMultistepIntegrator<QuinlanTremaine1990Order12,
+                                             Position<ICRS>>(),
+          /*step=*/10 * Minute});
+  // Long enough to have several checkpoints.
+  ephemeris->Prolong(solar_system.epoch() + 2 * JulianYear);
+
+  serialization::Ephemeris message;
+  ephemeris->WriteToMessage(&message);
+  EXPECT_LE(4, message.checkpoint_size());
+
+  ThreadPool<Status> pool(/*pool_size=*/4);
+  auto const ephemeris_read = Ephemeris<ICRS>::ReadFromMessage(message, &pool);
+  ephemeris_read->AwaitReanimation(solar_system.epoch() + 1 * JulianYear);
+  EXPECT_GE(solar_system.epoch() + 1 * JulianYear, ephemeris_read->t_min());
+  ephemeris_read->AwaitReanimation(InfinitePast);
+  EXPECT_EQ(1, ephemeris_read->reanimation_progress());
+  EXPECT_EQ(ephemeris->t_min(), ephemeris_read->t_min());
+  ephemeris_read->Prolong(ephemeris->t_max());
+
+  for (auto const& name : solar_system.names()) {
+    for (Instant t = ephemeris->t_min();
+         t <= ephemeris->t_max();
+         t += 7 * Day) {
+      EXPECT_EQ(
+          solar_system.trajectory(*ephemeris, name)
+              .EvaluateDegreesOfFreedom(t),
+          solar_system.trajectory(*ephemeris_read, name)
+              .EvaluateDegreesOfFreedom(t)) << name << " " << t;
+    }
+  }
+
+  serialization::Ephemeris second_message;
+  ephemeris_read->WriteToMessage(&second_message);
+  EXPECT_THAT(second_message, EqualsProto(message));
+}
+
 INSTANTIATE_TEST_CASE_P(
     AllEphemerisTests,
     EphemerisTest,
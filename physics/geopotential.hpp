@@ -96,6 +96,22 @@ class Geopotential {
       Square<Length> const& r²,
       Exponentiation<Length, -3> const& one_over_r³) const;
 
+  // Equivalent to calling |GeneralSphericalHarmonicsAcceleration| for each
+  // element of the vectors, which must have the same size, and storing the
+  // results in |accelerations|, which is resized as needed.  The work that only
+  // depends on |t|, notably the rotation of the body, is done once for all the
+  // points.  The points are otherwise evaluated one at a time, not vectorized
+  // across points, so the gain is limited to that per-instant work; see
+  // |BM_ComputeGeopotentialCppBatched|.
+  void GeneralSphericalHarmonicsAccelerations(
+      Instant const& t,
+      std::vector<Displacement<Frame>> const& r,
+      std::vector<Length> const& r_norm,
+      std::vector<Square<Length>> const& r²,
+      std::vector<Exponentiation<Length, -3>> const& one_over_r³,
+      std::vector<Vector<Quotient<Acceleration, GravitationalParameter>,
+                         Frame>>& accelerations) const;
+
   std::vector<HarmonicDamping> const& degree_damping() const;
   HarmonicDamping const& sectoral_damping() const;
 
@@ -115,6 +131,13 @@ class Geopotential {
 
   using UnitVector = Vector<double, Frame>;
 
+  // The axes used to compute the latitude and longitude of a point.
+  struct Axes {
+    UnitVector x̂;
+    UnitVector ŷ;
+    UnitVector ẑ;
+  };
+
   // Holds precomputed data for one evaluation of the acceleration.
   struct Precomputations;
 
@@ -126,6 +149,28 @@ class Geopotential {
   template<typename>
   struct AllDegrees;
 
+  // True if the sectoral and tesseral harmonics may be ignored at distance
+  // |r_norm|.
+  bool IsZonal(Length const& r_norm) const;
+  // The highest degree whose harmonics are not fully damped at distance
+  // |r_norm|.
+  int MaxDegree(Length const& r_norm) const;
+
+  // The axes to use when |IsZonal| is true, and otherwise, respectively.  In
+  // the zonal case the rotation of the body is of no importance.
+  Axes ZonalAxes() const;
+  Axes SurfaceAxes(Instant const& t) const;
+
+  // Computes the acceleration from the harmonics up to |max_degree|.
+  Vector<Quotient<Acceleration, GravitationalParameter>, Frame>
+  AccelerationUpToDegree(int max_degree,
+                         Axes const& axes,
+                         bool is_zonal,
+                         Displacement<Frame> const& r,
+                         Length const& r_norm,
+                         Square<Length> const& r²,
+                         Exponentiation<Length, -3> const& one_over_r³) const;
+
   // If z is a unit vector along the axis of rotation, and r a vector from the
   // center of |body_| to some point in space, the acceleration computed here
   // is:
@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <optional>
 #include <queue>
 #include <vector>
 
@@ -146,7 +147,8 @@ template<typename Frame>
 template<int... degrees>
 struct Geopotential<Frame>::AllDegrees<std::integer_sequence<int, degrees...>> {
   static auto Acceleration(Geopotential<Frame> const& geopotential,
-                           Instant const& t,
+                           Axes const& axes,
+                           bool is_zonal,
                            Displacement<Frame> const& r,
                            Length const& r_norm,
                            Square<Length> const& r²,
@@ -393,7 +395,8 @@ template<typename Frame>
 template<int... degrees>
 auto Geopotential<Frame>::AllDegrees<std::integer_sequence<int, degrees...>>::
 Acceleration(Geopotential<Frame> const& geopotential,
-             Instant const& t,
+             Axes const& axes,
+             bool const is_zonal,
              Displacement<Frame> const& r,
              Length const& r_norm,
              Square<Length> const& r²,
@@ -401,9 +404,6 @@ Acceleration(Geopotential<Frame> const& geopotential,
     -> Vector<ReducedAcceleration, Frame> {
   constexpr int size = sizeof...(degrees);
   OblateBody<Frame> const& body = *geopotential.body_;
-  const bool is_zonal =
-      body.is_zonal() ||
-      r_norm > geopotential.sectoral_damping_.outer_threshold();
 
   Precomputations precomputations;
 
@@ -426,20 +426,9 @@ Acceleration(Geopotential<Frame> const& geopotential,
 
   auto& DmPn_of_sin_β = precomputations.DmPn_of_sin_β;
 
-  // In the zonal case the rotation of the body is of no importance, so any pair
-  // of equatorial vectors will do.
-  UnitVector x̂;
-  UnitVector ŷ;
-  UnitVector const ẑ = body.polar_axis();
-  if (is_zonal) {
-    x̂ = body.equatorial();
-    ŷ = body.biequatorial();
-  } else {
-    auto const from_surface_frame =
-      body.template FromSurfaceFrame<SurfaceFrame>(t);
-    x̂ = from_surface_frame(x_);
-    ŷ = from_surface_frame(y_);
-  }
+  UnitVector const& x̂ = axes.x̂;
+  UnitVector const& ŷ = axes.ŷ;
+  UnitVector const& ẑ = axes.ẑ;
 
   Length const x = InnerProduct(r, x̂);
   Length const y = InnerProduct(r, ŷ);
@@ -579,11 +568,6 @@ Geopotential<Frame>::SphericalHarmonicsAcceleration(
   return Degree2ZonalAcceleration(axis, r, one_over_r², one_over_r³);
 }
 
-#define PRINCIPIA_CASE_SPHERICAL_HARMONICS(d)                                  \
-  case (d):                                                                    \
-    return AllDegrees<std::make_integer_sequence<int, (d) + 1>>::Acceleration( \
-        *this, t, r, r_norm, r², one_over_r³)
-
 template<typename Frame>
 Vector<Quotient<Acceleration, GravitationalParameter>, Frame>
 Geopotential<Frame>::GeneralSphericalHarmonicsAcceleration(
@@ -597,6 +581,57 @@ Geopotential<Frame>::GeneralSphericalHarmonicsAcceleration(
     // |r_norm| when finding the partition point below.
     return NaN<ReducedAcceleration> * Vector<double, Frame>{};
   }
+  bool const is_zonal = IsZonal(r_norm);
+  return AccelerationUpToDegree(MaxDegree(r_norm),
+                                is_zonal ? ZonalAxes() : SurfaceAxes(t),
+                                is_zonal,
+                                r, r_norm, r², one_over_r³);
+}
+
+template<typename Frame>
+void Geopotential<Frame>::GeneralSphericalHarmonicsAccelerations(
+    Instant const& t,
+    std::vector<Displacement<Frame>> const& r,
+    std::vector<Length> const& r_norm,
+    std::vector<Square<Length>> const& r²,
+    std::vector<Exponentiation<Length, -3>> const& one_over_r³,
+    std::vector<Vector<Quotient<Acceleration, GravitationalParameter>, Frame>>&
+        accelerations) const {
+  std::size_t const size = r.size();
+  DCHECK_EQ(size, r_norm.size());
+  DCHECK_EQ(size, r².size());
+  DCHECK_EQ(size, one_over_r³.size());
+  accelerations.resize(size);
+
+  // The axes only depend on |t|, so they are computed once for all the points.
+  // The surface axes require the rotation of the body, so they are only
+  // computed if needed.
+  Axes const zonal_axes = ZonalAxes();
+  std::optional<Axes> surface_axes;
+  for (std::size_t i = 0; i < size; ++i) {
+    if (r_norm[i] != r_norm[i]) {
+      accelerations[i] = NaN<ReducedAcceleration> * Vector<double, Frame>{};
+      continue;
+    }
+    bool const is_zonal = IsZonal(r_norm[i]);
+    if (!is_zonal && !surface_axes.has_value()) {
+      surface_axes = SurfaceAxes(t);
+    }
+    accelerations[i] =
+        AccelerationUpToDegree(MaxDegree(r_norm[i]),
+                               is_zonal ? zonal_axes : *surface_axes,
+                               is_zonal,
+                               r[i], r_norm[i], r²[i], one_over_r³[i]);
+  }
+}
+
+template<typename Frame>
+bool Geopotential<Frame>::IsZonal(Length const& r_norm) const {
+  return body_->is_zonal() || r_norm > sectoral_damping_.outer_threshold();
+}
+
+template<typename Frame>
+int Geopotential<Frame>::MaxDegree(Length const& r_norm) const {
   // |limiting_degree| is the first degree such that
   // |r_norm >= degree_damping_[limiting_degree].outer_threshold()|, or is
   // |degree_damping_.size()| if |r_norm| is below all thresholds.
@@ -610,7 +645,38 @@ Geopotential<Frame>::GeneralSphericalHarmonicsAcceleration(
             return r_norm < degree_damping.outer_threshold();
           }) - degree_damping_.begin();
   // We have |max_degree > 0|.
-  int const max_degree = limiting_degree - 1;
+  return limiting_degree - 1;
+}
+
+template<typename Frame>
+auto Geopotential<Frame>::ZonalAxes() const -> Axes {
+  // In the zonal case the rotation of the body is of no importance, so any pair
+  // of equatorial vectors will do.
+  return {body_->equatorial(), body_->biequatorial(), body_->polar_axis()};
+}
+
+template<typename Frame>
+auto Geopotential<Frame>::SurfaceAxes(Instant const& t) const -> Axes {
+  auto const from_surface_frame =
+      body_->template FromSurfaceFrame<SurfaceFrame>(t);
+  return {from_surface_frame(x_), from_surface_frame(y_), body_->polar_axis()};
+}
+
+#define PRINCIPIA_CASE_SPHERICAL_HARMONICS(d)                                  \
+  case (d):                                                                    \
+    return AllDegrees<std::make_integer_sequence<int, (d) + 1>>::Acceleration( \
+        *this, axes, is_zonal, r, r_norm, r², one_over_r³)
+
+template<typename Frame>
+Vector<Quotient<Acceleration, GravitationalParameter>, Frame>
+Geopotential<Frame>::AccelerationUpToDegree(
+    int const max_degree,
+    Axes const& axes,
+    bool const is_zonal,
+    Displacement<Frame> const& r,
+    Length const& r_norm,
+    Square<Length> const& r²,
+    Exponentiation<Length, -3> const& one_over_r³) const {
   switch (max_degree) {
     PRINCIPIA_CASE_SPHERICAL_HARMONICS(2);
     PRINCIPIA_CASE_SPHERICAL_HARMONICS(3);
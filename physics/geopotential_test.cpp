@@ -1,6 +1,7 @@
 ﻿
 #include "physics/geopotential.hpp"
 
+#include <cmath>
 #include <random>
 #include <vector>
 
@@ -383,6 +384,50 @@ TEST_F(GeopotentialTest, CppF90Comparison) {
   }
 }
 
+// Checks that the batched evaluation yields the same results as the evaluation
+// point by point, at distances where different degrees are damped and where the
+// geopotential is zonal or not.
+TEST_F(GeopotentialTest, Batched) {
+  SolarSystem<ICRS> solar_system_2000(
+            SOLUTION_DIR / "astronomy" / "sol_gravity_model.proto.txt",
+            SOLUTION_DIR / "astronomy" /
+                "sol_initial_state_jd_2451545_000000000.proto.txt");
+  solar_system_2000.LimitOblatenessToDegree("Earth", /*max_degree=*/10);
+  auto earth_message = solar_system_2000.gravity_model_message("Earth");
+  auto const earth = solar_system_2000.MakeOblateBody(earth_message);
+  Geopotential<ICRS> const geopotential(earth.get(), /*tolerance=*/0x1p-24);
+
+  Instant const t = Instant() + 1000 * Second;
+  std::vector<Displacement<ICRS>> r;
+  std::vector<Length> r_norm;
+  std::vector<Square<Length>> r²;
+  std::vector<Exponentiation<Length, -3>> one_over_r³;
+  std::mt19937_64 random(42);
+  std::uniform_real_distribution<double> direction_distribution(-1, 1);
+  std::uniform_real_distribution<double> log_distance_distribution(6.5, 9);
+  for (int i = 0; i < 1000; ++i) {
+    Vector<double, ICRS> const direction({direction_distribution(random),
+                                          direction_distribution(random),
+                                          direction_distribution(random)});
+    r.push_back(std::pow(10, log_distance_distribution(random)) * Metre *
+                direction / direction.Norm());
+    r².push_back(r.back().Norm²());
+    r_norm.push_back(Sqrt(r².back()));
+    one_over_r³.push_back(r_norm.back() / (r².back() * r².back()));
+  }
+
+  std::vector<Vector<Quotient<Acceleration, GravitationalParameter>, ICRS>>
+      accelerations;
+  geopotential.GeneralSphericalHarmonicsAccelerations(
+      t, r, r_norm, r², one_over_r³, accelerations);
+  ASSERT_EQ(r.size(), accelerations.size());
+  for (int i = 0; i < r.size(); ++i) {
+    EXPECT_EQ(geopotential.GeneralSphericalHarmonicsAcceleration(
+                  t, r[i], r_norm[i], r²[i], one_over_r³[i]),
+              accelerations[i]) << i;
+  }
+}
+
 TEST_F(GeopotentialTest, HarmonicDamping) {
   HarmonicDamping σ(1 * Metre);
   EXPECT_THAT(σ.inner_threshold(), Eq(1 * Metre));
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "base/status.hpp"
+#include "geometry/grassmann.hpp"
+#include "geometry/named_quantities.hpp"
+#include "quantities/named_quantities.hpp"
+#include "quantities/quantities.hpp"
+
+namespace principia {
+namespace physics {
+namespace internal_massless_bodies_accelerations {
+
+using base::Error;
+using geometry::Position;
+using geometry::Vector;
+using quantities::Acceleration;
+using quantities::GravitationalParameter;
+using quantities::Length;
+
+// A structure-of-arrays representation of the positions of a set of massless
+// bodies and of the accelerations that they undergo.  The coordinates are
+// stored as SI magnitudes in separate arrays so that the acceleration exerted
+// by a spherical body may be computed for several massless bodies at once.
+// The results are bit-identical to those obtained by the scalar computation
+// in |Ephemeris| because the same operations are performed in the same order
+// in each lane.
+template<typename Frame>
+class MasslessBodiesAccelerations final {
+ public:
+  // Loads the |positions| of the massless bodies, and initializes their
+  // accelerations to the given |accelerations|, which must have the same size.
+  void Load(std::vector<Position<Frame>> const& positions,
+            std::vector<Vector<Acceleration, Frame>> const& accelerations);
+
+  // Adds to the accelerations of the massless bodies the acceleration exerted
+  // by a spherical body of gravitational parameter |μ| located at |position|.
+  // Returns |OUT_OF_RANGE| if one of the massless bodies is within
+  // |collision_radius| of that body.
+  Error AddSphericalBodyAccelerations(Position<Frame> const& position,
+                                      GravitationalParameter const& μ,
+                                      Length const& collision_radius);
+
+  // Stores the accelerations of the massless bodies into |accelerations|,
+  // which must have the size of the vectors passed to |Load|.
+  void Store(std::vector<Vector<Acceleration, Frame>>& accelerations) const;
+
+  std::size_t size() const;
+
+ private:
+  // The coordinates of the positions, in metres.
+  std::vector<double> x_;
+  std::vector<double> y_;
+  std::vector<double> z_;
+  // The coordinates of the accelerations, in metres per second squared.
+  std::vector<double> ax_;
+  std::vector<double> ay_;
+  std::vector<double> az_;
+};
+
+// The frame-independent kernel.  Processes the |size| massless bodies whose
+// coordinates are given by |x|, |y|, |z|, and accumulates into |ax|, |ay|,
+// |az|.  All quantities are SI magnitudes.  Returns true iff one of the
+// massless bodies is within |collision_radius| of the spherical body.
+inline bool AddSphericalBodyAccelerationsKernel(double x1,
+                                                double y1,
+                                                double z1,
+                                                double μ1,
+                                                double collision_radius,
+                                                std::size_t size,
+                                                double const* x,
+                                                double const* y,
+                                                double const* z,
+                                                double* ax,
+                                                double* ay,
+                                                double* az);
+
+}  // namespace internal_massless_bodies_accelerations
+
+using internal_massless_bodies_accelerations::MasslessBodiesAccelerations;
+
+}  // namespace physics
+}  // namespace principia
+
+#include "physics/massless_bodies_accelerations_body.hpp"
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "physics/massless_bodies_accelerations.hpp"
+
+#include <pmmintrin.h>
+
+#include <cmath>
+#include <vector>
+
+#include "base/macros.hpp"
+#include "glog/logging.h"
+#include "quantities/si.hpp"
+
+namespace principia {
+namespace physics {
+namespace internal_massless_bodies_accelerations {
+
+using geometry::Displacement;
+namespace si = quantities::si;
+
+template<typename Frame>
+void MasslessBodiesAccelerations<Frame>::Load(
+    std::vector<Position<Frame>> const& positions,
+    std::vector<Vector<Acceleration, Frame>> const& accelerations) {
+  CHECK_EQ(positions.size(), accelerations.size());
+  std::size_t const size = positions.size();
+  x_.resize(size);
+  y_.resize(size);
+  z_.resize(size);
+  ax_.resize(size);
+  ay_.resize(size);
+  az_.resize(size);
+  for (std::size_t i = 0; i < size; ++i) {
+    auto const q = (positions[i] - Frame::origin).coordinates();
+    x_[i] = q.x / si::Unit<Length>;
+    y_[i] = q.y / si::Unit<Length>;
+    z_[i] = q.z / si::Unit<Length>;
+    auto const a = accelerations[i].coordinates();
+    ax_[i] = a.x / si::Unit<Acceleration>;
+    ay_[i] = a.y / si::Unit<Acceleration>;
+    az_[i] = a.z / si::Unit<Acceleration>;
+  }
+}
+
+template<typename Frame>
+Error MasslessBodiesAccelerations<Frame>::AddSphericalBodyAccelerations(
+    Position<Frame> const& position,
+    GravitationalParameter const& μ,
+    Length const& collision_radius) {
+  auto const q1 = (position - Frame::origin).coordinates();
+  bool const collision = AddSphericalBodyAccelerationsKernel(
+      q1.x / si::Unit<Length>,
+      q1.y / si::Unit<Length>,
+      q1.z / si::Unit<Length>,
+      μ / si::Unit<GravitationalParameter>,
+      collision_radius / si::Unit<Length>,
+      x_.size(),
+      x_.data(), y_.data(), z_.data(),
+      ax_.data(), ay_.data(), az_.data());
+  return collision ? Error::OUT_OF_RANGE : Error::OK;
+}
+
+template<typename Frame>
+void MasslessBodiesAccelerations<Frame>::Store(
+    std::vector<Vector<Acceleration, Frame>>& accelerations) const {
+  CHECK_EQ(ax_.size(), accelerations.size());
+  for (std::size_t i = 0; i < ax_.size(); ++i) {
+    accelerations[i] = Vector<Acceleration, Frame>(
+        {ax_[i] * si::Unit<Acceleration>,
+         ay_[i] * si::Unit<Acceleration>,
+         az_[i] * si::Unit<Acceleration>});
+  }
+}
+
+template<typename Frame>
+std::size_t MasslessBodiesAccelerations<Frame>::size() const {
+  return x_.size();
+}
+
+inline bool AddSphericalBodyAccelerationsKernel(double const x1,
+                                                double const y1,
+                                                double const z1,
+                                                double const μ1,
+                                                double const collision_radius,
+                                                std::size_t const size,
+                                                double const* const x,
+                                                double const* const y,
+                                                double const* const z,
+                                                double* const ax,
+                                                double* const ay,
+                                                double* const az) {
+  bool collision = false;
+  std::size_t i = 0;
+
+#if PRINCIPIA_USE_SSE3_INTRINSICS
+  // Two massless bodies per iteration.  SSE2 is part of x86-64, so no runtime
+  // dispatch is needed.  Note that the operations mirror those of the scalar
+  // loop below, and that there is no fused multiply-add, so the lanes produce
+  // the same bits as the scalar code.
+  __m128d const x1_128d = _mm_set1_pd(x1);
+  __m128d const y1_128d = _mm_set1_pd(y1);
+  __m128d const z1_128d = _mm_set1_pd(z1);
+  __m128d const μ1_128d = _mm_set1_pd(μ1);
+  __m128d const collision_radius_128d = _mm_set1_pd(collision_radius);
+  __m128d collided = _mm_setzero_pd();
+  for (; i + 2 <= size; i += 2) {
+    // A vector from the massless bodies to the centre of the massive body.
+    __m128d const Δx = _mm_sub_pd(x1_128d, _mm_loadu_pd(x + i));
+    __m128d const Δy = _mm_sub_pd(y1_128d, _mm_loadu_pd(y + i));
+    __m128d const Δz = _mm_sub_pd(z1_128d, _mm_loadu_pd(z + i));
+
+    __m128d const Δq² = _mm_add_pd(
+        _mm_add_pd(_mm_mul_pd(Δx, Δx), _mm_mul_pd(Δy, Δy)),
+        _mm_mul_pd(Δz, Δz));
+    __m128d const Δq_norm = _mm_sqrt_pd(Δq²);
+    // Not-greater-than is true for NaNs, like the scalar test.
+    collided =
+        _mm_or_pd(collided, _mm_cmpngt_pd(Δq_norm, collision_radius_128d));
+
+    __m128d const one_over_Δq³ = _mm_div_pd(Δq_norm, _mm_mul_pd(Δq², Δq²));
+    __m128d const μ1_over_Δq³ = _mm_mul_pd(μ1_128d, one_over_Δq³);
+
+    _mm_storeu_pd(ax + i,
+                  _mm_add_pd(_mm_loadu_pd(ax + i),
+                             _mm_mul_pd(Δx, μ1_over_Δq³)));
+    _mm_storeu_pd(ay + i,
+                  _mm_add_pd(_mm_loadu_pd(ay + i),
+                             _mm_mul_pd(Δy, μ1_over_Δq³)));
+    _mm_storeu_pd(az + i,
+                  _mm_add_pd(_mm_loadu_pd(az + i),
+                             _mm_mul_pd(Δz, μ1_over_Δq³)));
+  }
+  collision = _mm_movemask_pd(collided) != 0;
+#endif
+
+  for (; i < size; ++i) {
+    double const Δx = x1 - x[i];
+    double const Δy = y1 - y[i];
+    double const Δz = z1 - z[i];
+
+    double const Δq² = Δx * Δx + Δy * Δy + Δz * Δz;
+    double const Δq_norm = std::sqrt(Δq²);
+    collision |= !(Δq_norm > collision_radius);
+
+    double const one_over_Δq³ = Δq_norm / (Δq² * Δq²);
+    double const μ1_over_Δq³ = μ1 * one_over_Δq³;
+
+    ax[i] += Δx * μ1_over_Δq³;
+    ay[i] += Δy * μ1_over_Δq³;
+    az[i] += Δz * μ1_over_Δq³;
+  }
+  return collision;
+}
+
+}  // namespace internal_massless_bodies_accelerations
+}  // namespace physics
+}  // namespace principia
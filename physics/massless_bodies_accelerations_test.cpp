@@ -0,0 +1,133 @@
+#include "physics/massless_bodies_accelerations.hpp"
+
+#include <random>
+#include <vector>
+
+#include "geometry/frame.hpp"
+#include "geometry/grassmann.hpp"
+#include "geometry/named_quantities.hpp"
+#include "gtest/gtest.h"
+#include "quantities/elementary_functions.hpp"
+#include "quantities/named_quantities.hpp"
+#include "quantities/quantities.hpp"
+#include "quantities/si.hpp"
+
+namespace principia {
+namespace physics {
+
+using base::Error;
+using geometry::Displacement;
+using geometry::Frame;
+using geometry::Inertial;
+using geometry::Position;
+using geometry::Vector;
+using quantities::Acceleration;
+using quantities::Exponentiation;
+using quantities::GravitationalParameter;
+using quantities::Length;
+using quantities::Sqrt;
+using quantities::Square;
+using quantities::si::Kilo;
+using quantities::si::Metre;
+using quantities::si::Second;
+namespace si = quantities::si;
+
+class MasslessBodiesAccelerationsTest : public ::testing::Test {
+ protected:
+  using World = Frame<enum class WorldTag, Inertial>;
+
+  // The computation performed by |Ephemeris| on one massless body.
+  static Vector<Acceleration, World> ScalarAcceleration(
+      Position<World> const& position1,
+      GravitationalParameter const& μ1,
+      Position<World> const& position) {
+    Displacement<World> const Δq = position1 - position;
+    Square<Length> const Δq² = Δq.Norm²();
+    Length const Δq_norm = Sqrt(Δq²);
+    Exponentiation<Length, -3> const one_over_Δq³ = Δq_norm / (Δq² * Δq²);
+    auto const μ1_over_Δq³ = μ1 * one_over_Δq³;
+    return Δq * μ1_over_Δq³;
+  }
+
+  std::vector<Position<World>> RandomPositions(int const size) {
+    std::uniform_real_distribution<> distribution(-1e7, 1e7);
+    std::vector<Position<World>> positions;
+    for (int i = 0; i < size; ++i) {
+      positions.push_back(
+          World::origin + Displacement<World>({distribution(random_) * Metre,
+                                               distribution(random_) * Metre,
+                                               distribution(random_) * Metre}));
+    }
+    return positions;
+  }
+
+  std::mt19937_64 random_{42};
+  MasslessBodiesAccelerations<World> massless_bodies_;
+};
+
+// Checks that the results are bit-identical to the scalar computation for all
+// sizes, including those that leave a remainder after vectorization.
+TEST_F(MasslessBodiesAccelerationsTest, BitIdentical) {
+  GravitationalParameter const μ1 =
+      3.986004418e14 * si::Unit<GravitationalParameter>;
+  GravitationalParameter const μ2 =
+      4.9028e12 * si::Unit<GravitationalParameter>;
+  Position<World> const position1 =
+      World::origin + Displacement<World>({1 * Kilo(Metre),
+                                           -2 * Kilo(Metre),
+                                           3 * Kilo(Metre)});
+  Position<World> const position2 =
+      World::origin + Displacement<World>({3.8e8 * Metre,
+                                           1e7 * Metre,
+                                           -2e6 * Metre});
+  for (int size = 0; size <= 9; ++size) {
+    auto const positions = RandomPositions(size);
+    std::vector<Vector<Acceleration, World>> initial_accelerations;
+    for (int i = 0; i < size; ++i) {
+      initial_accelerations.push_back(Vector<Acceleration, World>(
+          {i * si::Unit<Acceleration>,
+           -i * si::Unit<Acceleration>,
+           0.5 * i * si::Unit<Acceleration>}));
+    }
+
+    massless_bodies_.Load(positions, initial_accelerations);
+    EXPECT_EQ(size, massless_bodies_.size());
+    EXPECT_EQ(Error::OK,
+              massless_bodies_.AddSphericalBodyAccelerations(
+                  position1, μ1, /*collision_radius=*/1 * Metre));
+    EXPECT_EQ(Error::OK,
+              massless_bodies_.AddSphericalBodyAccelerations(
+                  position2, μ2, /*collision_radius=*/1 * Metre));
+    std::vector<Vector<Acceleration, World>> accelerations(size);
+    massless_bodies_.Store(accelerations);
+
+    for (int i = 0; i < size; ++i) {
+      Vector<Acceleration, World> expected = initial_accelerations[i];
+      expected += ScalarAcceleration(position1, μ1, positions[i]);
+      expected += ScalarAcceleration(position2, μ2, positions[i]);
+      EXPECT_EQ(expected, accelerations[i]) << size << " " << i;
+    }
+  }
+}
+
+TEST_F(MasslessBodiesAccelerationsTest, Collision) {
+  GravitationalParameter const μ1 =
+      3.986004418e14 * si::Unit<GravitationalParameter>;
+  for (int size = 1; size <= 5; ++size) {
+    for (int colliding = 0; colliding < size; ++colliding) {
+      auto const positions = RandomPositions(size);
+      std::vector<Vector<Acceleration, World>> accelerations(size);
+      massless_bodies_.Load(positions, accelerations);
+      EXPECT_EQ(Error::OUT_OF_RANGE,
+                massless_bodies_.AddSphericalBodyAccelerations(
+                    positions[colliding] +
+                        Displacement<World>({1 * Metre, 0 * Metre, 0 * Metre}),
+                    μ1,
+                    /*collision_radius=*/10 * Metre))
+          << size << " " << colliding;
+    }
+  }
+}
+
+}  // namespace physics
+}  // namespace principia
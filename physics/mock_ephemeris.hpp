@@ -86,6 +86,12 @@ class MockEphemeris : public Ephemeris<Frame> {
 
   MOCK_CONST_METHOD1_T(WriteToMessage,
                        void(not_null<serialization::Ephemeris*> message));
+  MOCK_CONST_METHOD2_T(WriteToMessage,
+                       void(not_null<serialization::Ephemeris*> message,
+                            ThreadPool<Status>& thread_pool));
+
+  MOCK_CONST_METHOD1_T(AwaitReanimation, void(Instant const& desired_t_min));
+  MOCK_CONST_METHOD0_T(reanimation_progress, double());
 
   MOCK_CONST_METHOD0_T(t_min_locked, Instant());
 };
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+
+#include "base/not_constructible.hpp"
+#include "base/not_null.hpp"
+#include "geometry/named_quantities.hpp"
+#include "quantities/quantities.hpp"
+#include "serialization/physics.pb.h"
+
+namespace principia {
+namespace physics {
+namespace internal_timeline_codec {
+
+using base::not_constructible;
+using base::not_null;
+using geometry::Instant;
+using quantities::Length;
+
+// A columnar codec for the timeline of a |DiscreteTrajectory|.  The times are
+// encoded exactly, as the deltas of deltas of their binary representations,
+// which take about one byte per point when the steps are regular.  Each
+// coordinate of the degrees of freedom is encoded as its own 1-dimensional zfp
+// stream.
+template<typename Frame>
+class TimelineCodec : not_constructible {
+ public:
+  // |timeline| must be a container of pairs (|Instant|,
+  // |DegreesOfFreedom<Frame>|) in increasing time order.  The positions are
+  // approximated to |length_tolerance|, and the velocities to
+  // |length_tolerance| divided by the largest step of the timeline.  The
+  // encoding is lossless if |length_tolerance| is zero.
+  template<typename Timeline>
+  static void WriteToMessage(
+      Timeline const& timeline,
+      Length const& length_tolerance,
+      not_null<serialization::DiscreteTrajectory::Columns*> message);
+
+  // Calls |append(time, degrees_of_freedom)| for each point of |message|, in
+  // increasing time order, as soon as it has been decoded.
+  template<typename Append>
+  static void ReadFromMessage(
+      serialization::DiscreteTrajectory::Columns const& message,
+      Append const& append);
+};
+
+}  // namespace internal_timeline_codec
+
+using internal_timeline_codec::TimelineCodec;
+
+}  // namespace physics
+}  // namespace principia
+
+#include "physics/timeline_codec_body.hpp"
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "physics/timeline_codec.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <optional>
+
+#include "base/zfp_compressor.hpp"
+#include "geometry/grassmann.hpp"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/wire_format_lite.h"
+#include "physics/degrees_of_freedom.hpp"
+#include "quantities/si.hpp"
+
+namespace principia {
+namespace physics {
+namespace internal_timeline_codec {
+
+using base::ZfpStreamReader;
+using base::ZfpStreamWriter;
+using geometry::Displacement;
+using geometry::Position;
+using geometry::Velocity;
+using google::protobuf::internal::WireFormatLite;
+using google::protobuf::io::CodedInputStream;
+using google::protobuf::io::CodedOutputStream;
+using google::protobuf::io::StringOutputStream;
+using quantities::Time;
+using quantities::si::Metre;
+using quantities::si::Second;
+
+// The binary representation of the time, mapped to an integer so that the
+// order of the times is preserved.  The mapping is reversible.
+inline std::uint64_t OrderedBits(Instant const& time) {
+  double const seconds = (time - Instant()) / Second;
+  std::int64_t bits;
+  std::memcpy(&bits, &seconds, sizeof(bits));
+  // The negative doubles are in reverse order of their representations.
+  if (bits < 0) {
+    bits ^= std::numeric_limits<std::int64_t>::max();
+  }
+  return static_cast<std::uint64_t>(bits);
+}
+
+inline Instant FromOrderedBits(std::uint64_t const ordered_bits) {
+  auto bits = static_cast<std::int64_t>(ordered_bits);
+  if (bits < 0) {
+    bits ^= std::numeric_limits<std::int64_t>::max();
+  }
+  double seconds;
+  std::memcpy(&seconds, &bits, sizeof(seconds));
+  return Instant() + seconds * Second;
+}
+
+template<typename Frame>
+template<typename Timeline>
+void TimelineCodec<Frame>::WriteToMessage(
+    Timeline const& timeline,
+    Length const& length_tolerance,
+    not_null<serialization::DiscreteTrajectory::Columns*> const message) {
+  std::int64_t const timeline_size = timeline.size();
+  message->set_codec_version(ZFP_CODEC);
+  message->set_library_version(ZFP_VERSION);
+  message->set_timeline_size(timeline_size);
+
+  // The integer differences are computed modulo 2⁶⁴, which is reversible.
+  Time max_Δt;
+  {
+    StringOutputStream string_stream(message->mutable_times());
+    CodedOutputStream times(&string_stream);
+    std::optional<Instant> previous_time;
+    std::uint64_t previous_bits = 0;
+    std::uint64_t previous_delta = 0;
+    for (auto const& [time, _] : timeline) {
+      std::uint64_t const bits = OrderedBits(time);
+      std::uint64_t const delta = bits - previous_bits;
+      times.WriteVarint64(WireFormatLite::ZigZagEncode64(
+          static_cast<std::int64_t>(delta - previous_delta)));
+      previous_bits = bits;
+      previous_delta = delta;
+      if (previous_time.has_value()) {
+        max_Δt = std::max(max_Δt, time - *previous_time);
+      }
+      previous_time = time;
+    }
+  }
+
+  if (timeline_size == 0) {
+    return;
+  }
+
+  // The coordinates are made dimensionless.  We expect strong correlations
+  // within a coordinate over time, but not between coordinates.
+  double const length_accuracy = length_tolerance / Metre;
+  double const speed_accuracy =
+      max_Δt == Time() ? 0 : (length_tolerance / max_Δt) / (Metre / Second);
+  ZfpStreamWriter qx(length_accuracy, timeline_size);
+  ZfpStreamWriter qy(length_accuracy, timeline_size);
+  ZfpStreamWriter qz(length_accuracy, timeline_size);
+  ZfpStreamWriter px(speed_accuracy, timeline_size);
+  ZfpStreamWriter py(speed_accuracy, timeline_size);
+  ZfpStreamWriter pz(speed_accuracy, timeline_size);
+  for (auto const& [_, degrees_of_freedom] : timeline) {
+    auto const q =
+        (degrees_of_freedom.position() - Frame::origin).coordinates();
+    auto const p = degrees_of_freedom.velocity().coordinates();
+    qx.Put(q.x / Metre);
+    qy.Put(q.y / Metre);
+    qz.Put(q.z / Metre);
+    px.Put(p.x / (Metre / Second));
+    py.Put(p.y / (Metre / Second));
+    pz.Put(p.z / (Metre / Second));
+  }
+  for (ZfpStreamWriter* const coordinate : {&qx, &qy, &qz, &px, &py, &pz}) {
+    coordinate->WriteToMessage(message->add_coordinates());
+  }
+}
+
+template<typename Frame>
+template<typename Append>
+void TimelineCodec<Frame>::ReadFromMessage(
+    serialization::DiscreteTrajectory::Columns const& message,
+    Append const& append) {
+  CHECK_EQ(ZFP_CODEC, message.codec_version());
+  CHECK_EQ(ZFP_VERSION, message.library_version());
+  std::int64_t const timeline_size = message.timeline_size();
+  if (timeline_size == 0) {
+    return;
+  }
+  CHECK_EQ(6, message.coordinates_size());
+
+  CodedInputStream times(
+      reinterpret_cast<std::uint8_t const*>(message.times().data()),
+      message.times().size());
+  ZfpStreamReader qx(message.coordinates(0), timeline_size);
+  ZfpStreamReader qy(message.coordinates(1), timeline_size);
+  ZfpStreamReader qz(message.coordinates(2), timeline_size);
+  ZfpStreamReader px(message.coordinates(3), timeline_size);
+  ZfpStreamReader py(message.coordinates(4), timeline_size);
+  ZfpStreamReader pz(message.coordinates(5), timeline_size);
+  std::uint64_t bits = 0;
+  std::uint64_t delta = 0;
+  for (std::int64_t i = 0; i < timeline_size; ++i) {
+    std::uint64_t zigzag;
+    CHECK(times.ReadVarint64(&zigzag)) << "Truncated times at " << i;
+    delta += static_cast<std::uint64_t>(WireFormatLite::ZigZagDecode64(zigzag));
+    bits += delta;
+
+    double const qx_i = qx.Get();
+    double const qy_i = qy.Get();
+    double const qz_i = qz.Get();
+    double const px_i = px.Get();
+    double const py_i = py.Get();
+    double const pz_i = pz.Get();
+    Position<Frame> const q =
+        Frame::origin +
+        Displacement<Frame>({qx_i * Metre, qy_i * Metre, qz_i * Metre});
+    Velocity<Frame> const p({px_i * (Metre / Second),
+                             py_i * (Metre / Second),
+                             pz_i * (Metre / Second)});
+    append(FromOrderedBits(bits), DegreesOfFreedom<Frame>(q, p));
+  }
+}
+
+}  // namespace internal_timeline_codec
+}  // namespace physics
+}  // namespace principia
@@ -0,0 +1,130 @@
+#include "physics/timeline_codec.hpp"
+
+#include <utility>
+#include <vector>
+
+#include "geometry/frame.hpp"
+#include "geometry/grassmann.hpp"
+#include "geometry/named_quantities.hpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "physics/degrees_of_freedom.hpp"
+#include "quantities/elementary_functions.hpp"
+#include "quantities/quantities.hpp"
+#include "quantities/si.hpp"
+#include "serialization/physics.pb.h"
+
+namespace principia {
+namespace physics {
+
+using geometry::Displacement;
+using geometry::Frame;
+using geometry::Handedness;
+using geometry::Inertial;
+using geometry::Instant;
+using geometry::Velocity;
+using quantities::Cos;
+using quantities::Length;
+using quantities::Sin;
+using quantities::si::Metre;
+using quantities::si::Radian;
+using quantities::si::Second;
+using ::testing::IsEmpty;
+using ::testing::Le;
+using ::testing::Lt;
+using ::testing::SizeIs;
+
+class TimelineCodecTest : public ::testing::Test {
+ protected:
+  using World = Frame<serialization::Frame::TestTag,
+                      Inertial,
+                      Handedness::Right,
+                      serialization::Frame::TEST>;
+  using Timeline = std::vector<std::pair<Instant, DegreesOfFreedom<World>>>;
+
+  // A circular orbit of radius 7000 km, sampled at the given |times|.
+  static Timeline CircularOrbit(std::vector<Instant> const& times) {
+    Length const r = 7'000'000 * Metre;
+    auto const ω = 1e-3 * Radian / Second;
+    Timeline timeline;
+    for (Instant const& t : times) {
+      auto const θ = ω * (t - Instant());
+      timeline.emplace_back(
+          t,
+          DegreesOfFreedom<World>(
+              World::origin + Displacement<World>({r * Cos(θ),
+                                                   r * Sin(θ),
+                                                   0 * Metre}),
+              Velocity<World>({-r * ω * Sin(θ) / Radian,
+                               r * ω * Cos(θ) / Radian,
+                               0 * Metre / Second})));
+    }
+    return timeline;
+  }
+
+  static Timeline WriteAndRead(Timeline const& timeline,
+                               Length const& length_tolerance,
+                               serialization::DiscreteTrajectory::Columns&
+                                   message) {
+    TimelineCodec<World>::WriteToMessage(timeline, length_tolerance, &message);
+    Timeline read;
+    TimelineCodec<World>::ReadFromMessage(
+        message,
+        [&read](Instant const& time,
+                DegreesOfFreedom<World> const& degrees_of_freedom) {
+          read.emplace_back(time, degrees_of_freedom);
+        });
+    return read;
+  }
+};
+
+TEST_F(TimelineCodecTest, Empty) {
+  serialization::DiscreteTrajectory::Columns message;
+  EXPECT_THAT(WriteAndRead(Timeline(), 1 * Metre, message), IsEmpty());
+  EXPECT_EQ(0, message.timeline_size());
+  EXPECT_THAT(message.coordinates(), IsEmpty());
+}
+
+TEST_F(TimelineCodecTest, Lossless) {
+  // Irregular steps, some times before the epoch, and a partial zfp block at
+  // the end.
+  std::vector<Instant> times;
+  for (int i = -7; i < 30; ++i) {
+    times.push_back(Instant() + (i * 10.1 + i * i * 0.25) * Second);
+  }
+  Timeline const timeline = CircularOrbit(times);
+  serialization::DiscreteTrajectory::Columns message;
+  Timeline const read = WriteAndRead(timeline, Length(), message);
+  EXPECT_EQ(timeline.size(), message.timeline_size());
+  EXPECT_THAT(message.coordinates(), SizeIs(6));
+  EXPECT_EQ(timeline, read);
+}
+
+TEST_F(TimelineCodecTest, Lossy) {
+  std::vector<Instant> times;
+  for (int i = 0; i < 1000; ++i) {
+    times.push_back(Instant() + 1e8 * Second + i * 10 * Second);
+  }
+  Timeline const timeline = CircularOrbit(times);
+  Length const tolerance = 10 * Metre;
+  serialization::DiscreteTrajectory::Columns message;
+  Timeline const read = WriteAndRead(timeline, tolerance, message);
+  ASSERT_EQ(timeline.size(), read.size());
+  for (int i = 0; i < timeline.size(); ++i) {
+    auto const& [expected_time, expected_degrees_of_freedom] = timeline[i];
+    auto const& [actual_time, actual_degrees_of_freedom] = read[i];
+    // The times are exact.
+    EXPECT_EQ(expected_time, actual_time);
+    EXPECT_THAT((actual_degrees_of_freedom.position() -
+                 expected_degrees_of_freedom.position()).Norm(),
+                Lt(tolerance));
+    EXPECT_THAT((actual_degrees_of_freedom.velocity() -
+                 expected_degrees_of_freedom.velocity()).Norm(),
+                Lt(tolerance / (10 * Second)));
+  }
+  // Apart from the first two, the regular steps take one byte per point.
+  EXPECT_THAT(message.times().size(), Le(timeline.size() + 20));
+}
+
+}  // namespace physics
+}  // namespace principia
@@ -593,6 +593,54 @@ void JournalProtoProcessor::ProcessRequiredFixed64Field(
       [](std::string const& expr) {
         return "SerializePointer(" + expr + ")";
       };
+
+  // Special handling for arrays allocated by the caller: these are seen from
+  // the C# as arrays, marshaled in both directions.  Only their address is
+  // journalled, and on replay we allocate an array of the journalled size.
+  if (options.HasExtension(journal::serialization::array_size)) {
+    CHECK(options.HasExtension(journal::serialization::pointer_to))
+        << descriptor->full_name()
+        << " must have a (pointer_to) option to have an (array_size) option";
+    CHECK(!options.HasExtension(journal::serialization::disposable) &&
+          !options.HasExtension(journal::serialization::is_subject) &&
+          !Contains(field_cxx_deleter_fn_, descriptor) &&
+          !Contains(field_cxx_inserter_fn_, descriptor))
+        << descriptor->full_name()
+        << " cannot be disposable, a subject, consumed or produced and have an "
+        << "(array_size) option";
+    std::string const array_size =
+        options.GetExtension(journal::serialization::array_size);
+    FieldDescriptor const* const array_size_descriptor =
+        descriptor->containing_type()->FindFieldByName(array_size);
+    CHECK(array_size_descriptor != nullptr &&
+          array_size_descriptor->type() == FieldDescriptor::TYPE_INT32)
+        << descriptor->full_name() << " has incorrect (array_size) option";
+
+    field_cs_type_[descriptor] = pointer_to + "[]";
+    field_cs_mode_fn_[descriptor] =
+        [](std::string const& type) {
+          return "[In, Out] " + type;
+        };
+
+    std::string const storage_name = descriptor->name() + "_storage";
+    field_cxx_deserialization_storage_name_[descriptor] = storage_name;
+    field_cxx_deserialization_storage_type_[descriptor] =
+        "std::vector<" + pointer_to + ">";
+    field_cxx_deserializer_fn_[descriptor] =
+        [descriptor, array_size, storage_name](std::string const& expr) {
+          // |expr| is the getter for this field, from which we derive the
+          // getter for the size.
+          std::string const getter = descriptor->name() + "()";
+          CHECK_EQ(getter, expr.substr(expr.size() - getter.size())) << expr;
+          std::string const array_size_getter =
+              expr.substr(0, expr.size() - getter.size()) + array_size + "()";
+          // Yes, this lambda generates a lambda.
+          return "[&" + storage_name + "](int const size) {\n"
+                 "            " + storage_name + ".resize(size);\n"
+                 "            return " + storage_name + ".data();\n"
+                 "          }(" + array_size_getter + ")";
+        };
+  }
 }
 
 void JournalProtoProcessor::ProcessRequiredMessageField(